@@ -31,6 +31,12 @@
 #import "CDVLocalStorage.h"
 #import "CDVScreenOrientationDelegate.h"
 #import "CDVTimer.h"
+#import "CDVBlobStore.h"
+#import "CDVStartupProfile.h"
+#import "CDVMemoryPressure.h"
+#import "CDVBridgeBenchmark.h"
+#import "CDVTrace.h"
+#import "CDVMetrics.h"
 
 #import "NSArray+Comparisons.h"
 #import "NSData+Base64.h"
@@ -0,0 +1,45 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+// Path prefix under which CDVURLProtocol serves blobs ("/!gap_blob/<token>").
+// JS uploads binary arguments by POSTing to the same path without a token.
+extern NSString* const kCDVBlobPathPrefix;
+
+// Holds binary payloads that move between native and JS outside of the
+// JSON bridge, so they don't need to be base64 encoded. Each blob is keyed
+// by a random token and can be taken exactly once; blobs that are never
+// claimed are dropped after a short timeout.
+@interface CDVBlobStore : NSObject
+
++ (CDVBlobStore*)sharedStore;
+
+// Stores the data and returns the token it can be retrieved with.
+- (NSString*)addData:(NSData*)data mimeType:(NSString*)mimeType;
+
+// Removes and returns the data for the token, or nil if there is none.
+- (NSData*)takeDataForToken:(NSString*)token mimeType:(NSString**)mimeType;
+
+- (BOOL)hasDataForToken:(NSString*)token;
+
+// Returns the URL path that CDVURLProtocol serves the token's data at.
+- (NSString*)URLPathForToken:(NSString*)token;
+
+@end
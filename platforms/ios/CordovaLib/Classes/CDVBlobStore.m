@@ -0,0 +1,134 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import "CDVBlobStore.h"
+
+NSString* const kCDVBlobPathPrefix = @"/!gap_blob/";
+
+// Blobs that haven't been claimed after this many seconds are discarded.
+#define CDV_BLOB_TIMEOUT 60.0
+
+@interface CDVBlobEntry : NSObject
+@property (nonatomic, strong) NSData* data;
+@property (nonatomic, copy) NSString* mimeType;
+@property (nonatomic, assign) CFAbsoluteTime created;
+@end
+
+@implementation CDVBlobEntry
+@end
+
+@interface CDVBlobStore () {
+    NSMutableDictionary* _entries;
+}
+@end
+
+@implementation CDVBlobStore
+
++ (CDVBlobStore*)sharedStore
+{
+    static CDVBlobStore* sharedStore = nil;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        sharedStore = [[CDVBlobStore alloc] init];
+    });
+    return sharedStore;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self != nil) {
+        _entries = [[NSMutableDictionary alloc] initWithCapacity:4];
+    }
+    return self;
+}
+
+- (void)purgeExpiredEntries:(CFAbsoluteTime)now
+{
+    NSMutableArray* expired = nil;
+
+    for (NSString* token in _entries) {
+        CDVBlobEntry* entry = [_entries objectForKey:token];
+        if (now - entry.created > CDV_BLOB_TIMEOUT) {
+            if (expired == nil) {
+                expired = [NSMutableArray array];
+            }
+            [expired addObject:token];
+        }
+    }
+    if (expired != nil) {
+        [_entries removeObjectsForKeys:expired];
+    }
+}
+
+- (NSString*)addData:(NSData*)data mimeType:(NSString*)mimeType
+{
+    CFUUIDRef uuidRef = CFUUIDCreate(kCFAllocatorDefault);
+    NSString* token = (__bridge_transfer NSString*)CFUUIDCreateString(kCFAllocatorDefault, uuidRef);
+
+    CFRelease(uuidRef);
+
+    CDVBlobEntry* entry = [[CDVBlobEntry alloc] init];
+    entry.data = data ? data : [NSData data];
+    entry.mimeType = mimeType ? mimeType : @"application/octet-stream";
+    entry.created = CFAbsoluteTimeGetCurrent();
+
+    @synchronized(self) {
+        [self purgeExpiredEntries:entry.created];
+        [_entries setObject:entry forKey:token];
+    }
+    return token;
+}
+
+- (NSData*)takeDataForToken:(NSString*)token mimeType:(NSString**)mimeType
+{
+    CDVBlobEntry* entry = nil;
+
+    if (token == nil) {
+        return nil;
+    }
+    @synchronized(self) {
+        entry = [_entries objectForKey:token];
+        if (entry != nil) {
+            [_entries removeObjectForKey:token];
+        }
+    }
+    if ((entry != nil) && (mimeType != NULL)) {
+        *mimeType = entry.mimeType;
+    }
+    return entry.data;
+}
+
+- (BOOL)hasDataForToken:(NSString*)token
+{
+    if (token == nil) {
+        return NO;
+    }
+    @synchronized(self) {
+        return [_entries objectForKey:token] != nil;
+    }
+}
+
+- (NSString*)URLPathForToken:(NSString*)token
+{
+    return [kCDVBlobPathPrefix stringByAppendingString:token];
+}
+
+@end
@@ -0,0 +1,55 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import <Foundation/Foundation.h>
+#import "CDVPlugin.h"
+
+// Native end of the bridge benchmark (www/bench.html), registered in debug
+// builds only. Each bridge action does as little work as possible, so the
+// timings measured in JS are dominated by cordova.exec, CDVCommandQueue and
+// sendPluginResult:callbackId:.
+//
+//   cordova.exec(win, fail, "BridgeBenchmark", "echo", [payload]);
+//     Returns payload unchanged. Strings come back as strings, ArrayBuffers
+//     as ArrayBuffers.
+//   cordova.exec(win, fail, "BridgeBenchmark", "generate", ["string" | "arraybuffer", size, count]);
+//     Sends count results of size bytes, all but the last with keepCallback,
+//     measuring native to JS throughput. At most 1000 results and 16 MB in
+//     all. The payload is built once per call and has the same content on
+//     every run.
+//   cordova.exec(win, fail, "BridgeBenchmark", "base64", [size, passes]);
+//     Encodes and decodes the same size pseudo random bytes passes times with
+//     the NEON and the scalar base64 loops, timed natively on a background
+//     thread. Returns { "size", "passes", "neon", "match", "neonEncodeUs",
+//     "neonDecodeUs", "scalarEncodeUs", "scalarDecodeUs" }, times averaged per
+//     pass; "neon" is false where the build has no NEON path, so both time the
+//     scalar loops. At most 16 MB, 1000 passes and 256 MB in all.
+//   cordova.exec(win, fail, "BridgeBenchmark", "getEnvironment", []);
+//     Returns { "model", "systemVersion", "appVersion", "debug" } to label a
+//     report with.
+@interface CDVBridgeBenchmarkPlugin : CDVPlugin
+
+- (void)echo:(CDVInvokedUrlCommand*)command;
+- (void)generate:(CDVInvokedUrlCommand*)command;
+#ifdef DEBUG
+- (void)base64:(CDVInvokedUrlCommand*)command;
+#endif
+- (void)getEnvironment:(CDVInvokedUrlCommand*)command;
+
+@end
@@ -0,0 +1,211 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import "CDVBridgeBenchmark.h"
+#import <UIKit/UIKit.h>
+#include <mach/mach_time.h>
+#include <sys/sysctl.h>
+#import "NSData+Base64.h"
+
+// Largest payload generate will build, 8 MB.
+#define CDV_BENCHMARK_MAX_PAYLOAD (8 * 1024 * 1024)
+// Most results and bytes one generate call sends, the whole burst is sent before the main thread
+// is free again.
+#define CDV_BENCHMARK_MAX_COUNT 1000
+#define CDV_BENCHMARK_MAX_TOTAL (16 * 1024 * 1024)
+// Largest input, most passes and bytes one base64 call runs, it keeps a background thread busy
+// until it is done.
+#define CDV_BENCHMARK_MAX_CODEC_INPUT (16 * 1024 * 1024)
+#define CDV_BENCHMARK_MAX_PASSES 1000
+#define CDV_BENCHMARK_MAX_CODED (256 * 1024 * 1024)
+
+@implementation CDVBridgeBenchmarkPlugin
+
+// Returns the hardware model, such as "iPhone5,2", which unlike
+// UIDevice model tells device generations apart.
+static NSString* CDVHardwareModel(void)
+{
+    size_t size = 0;
+
+    if ((sysctlbyname("hw.machine", NULL, &size, NULL, 0) != 0) || (size == 0)) {
+        return [[UIDevice currentDevice] model];
+    }
+    char* machine = malloc(size);
+    NSString* model = nil;
+    if (sysctlbyname("hw.machine", machine, &size, NULL, 0) == 0) {
+        model = [NSString stringWithUTF8String:machine];
+    }
+    free(machine);
+    return model ? model : [[UIDevice currentDevice] model];
+}
+
+// Fills bytes with 'a' to 'z' repeated, which is the same as a string
+// payload and needs no escaping in JSON.
+static void CDVFillBenchmarkPayload(char* bytes, NSUInteger size)
+{
+    for (NSUInteger i = 0; i < size; ++i) {
+        bytes[i] = 'a' + (i % 26);
+    }
+}
+
+- (void)echo:(CDVInvokedUrlCommand*)command
+{
+    id payload = [command.arguments count] > 0 ? [command.arguments objectAtIndex:0] : nil;
+    CDVPluginResult* result;
+
+    if ([payload isKindOfClass:[NSData class]]) {
+        result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsArrayBuffer:payload];
+    } else if ([payload isKindOfClass:[NSString class]]) {
+        result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsString:payload];
+    } else {
+        result = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:@"string or ArrayBuffer payload expected"];
+    }
+    [self.commandDelegate sendPluginResult:result callbackId:command.callbackId];
+}
+
+- (void)generate:(CDVInvokedUrlCommand*)command
+{
+    NSString* type = [command argumentAtIndex:0 withDefault:@"string" andClass:[NSString class]];
+    NSInteger size = [[command argumentAtIndex:1 withDefault:[NSNumber numberWithInt:10] andClass:[NSNumber class]] integerValue];
+    NSInteger count = [[command argumentAtIndex:2 withDefault:[NSNumber numberWithInt:1] andClass:[NSNumber class]] integerValue];
+    BOOL binary = [type isEqualToString:@"arraybuffer"];
+
+    if ((!binary && ![type isEqualToString:@"string"]) || (size < 0) || (size > CDV_BENCHMARK_MAX_PAYLOAD) ||
+        (count < 1) || (count > CDV_BENCHMARK_MAX_COUNT) || ((long long)size * count > CDV_BENCHMARK_MAX_TOTAL)) {
+        CDVPluginResult* result = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:@"invalid payload type, size or count"];
+        [self.commandDelegate sendPluginResult:result callbackId:command.callbackId];
+        return;
+    }
+
+    NSMutableData* bytes = [NSMutableData dataWithLength:size];
+    CDVFillBenchmarkPayload([bytes mutableBytes], size);
+    NSString* string = binary ? nil : [[NSString alloc] initWithData:bytes encoding:NSASCIIStringEncoding];
+
+    for (NSInteger i = 0; i < count; ++i) {
+        CDVPluginResult* result = binary ?
+            [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsArrayBuffer:bytes] :
+            [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsString:string];
+        [result setKeepCallbackAsBool:(i + 1 < count)];
+        [self.commandDelegate sendPluginResult:result callbackId:command.callbackId];
+    }
+}
+
+#ifdef DEBUG
+
+// Microseconds between two mach_absolute_time readings.
+static double CDVBenchmarkMicroseconds(uint64_t start, uint64_t end)
+{
+    mach_timebase_info_data_t timebase;
+
+    mach_timebase_info(&timebase);
+    return (double)(end - start) * timebase.numer / timebase.denom / 1000.0;
+}
+
+- (void)base64:(CDVInvokedUrlCommand*)command
+{
+    NSInteger size = [[command argumentAtIndex:0 withDefault:[NSNumber numberWithInt:64 * 1024] andClass:[NSNumber class]] integerValue];
+    NSInteger passes = [[command argumentAtIndex:1 withDefault:[NSNumber numberWithInt:20] andClass:[NSNumber class]] integerValue];
+
+    if ((size < 1) || (size > CDV_BENCHMARK_MAX_CODEC_INPUT) || (passes < 1) || (passes > CDV_BENCHMARK_MAX_PASSES) ||
+        ((long long)size * passes > CDV_BENCHMARK_MAX_CODED)) {
+        CDVPluginResult* result = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:@"invalid size or passes"];
+        [self.commandDelegate sendPluginResult:result callbackId:command.callbackId];
+        return;
+    }
+
+    [self.commandDelegate runInBackground:^{
+        // the same pseudo random bytes on every run, so every byte value and block layout occurs
+        unsigned char* input = malloc(size);
+        uint32_t seed = 2463534242u;
+        for (NSInteger i = 0; i < size; ++i) {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            input[i] = (unsigned char)seed;
+        }
+        size_t encodedCapacity = ((size + 2) / 3) * 4 + 1;
+        char* encoded[2] = {malloc(encodedCapacity), malloc(encodedCapacity)};
+        unsigned char* decoded[2] = {malloc(size), malloc(size)};
+        size_t encodedLength[2] = {0, 0};
+        size_t decodedLength[2] = {0, 0};
+        double encodeUs[2] = {0, 0};
+        double decodeUs[2] = {0, 0};
+
+        // index 0 is the NEON path, 1 the scalar one; passes alternate so both see the same cache state
+        for (NSInteger pass = 0; pass < passes; ++pass) {
+            for (int path = 0; path < 2; ++path) {
+                uint64_t start = mach_absolute_time();
+                encodedLength[path] = CDVBase64EncodeForBenchmark(input, size, encoded[path], path == 0);
+                uint64_t encodedAt = mach_absolute_time();
+                decodedLength[path] = CDVBase64DecodeForBenchmark(encoded[path], encodedLength[path], decoded[path], path == 0);
+                uint64_t end = mach_absolute_time();
+                encodeUs[path] += CDVBenchmarkMicroseconds(start, encodedAt);
+                decodeUs[path] += CDVBenchmarkMicroseconds(encodedAt, end);
+            }
+        }
+
+        BOOL match = (encodedLength[0] == encodedLength[1]) && (memcmp(encoded[0], encoded[1], encodedLength[0]) == 0) &&
+            (decodedLength[0] == (size_t)size) && (decodedLength[1] == (size_t)size) &&
+            (memcmp(decoded[0], input, size) == 0) && (memcmp(decoded[1], input, size) == 0);
+        free(input);
+        for (int path = 0; path < 2; ++path) {
+            free(encoded[path]);
+            free(decoded[path]);
+        }
+
+        NSDictionary* report = [NSDictionary dictionaryWithObjectsAndKeys:
+            [NSNumber numberWithInteger:size], @"size",
+            [NSNumber numberWithInteger:passes], @"passes",
+            [NSNumber numberWithBool:CDVBase64HasNEON()], @"neon",
+            [NSNumber numberWithBool:match], @"match",
+            [NSNumber numberWithDouble:encodeUs[0] / passes], @"neonEncodeUs",
+            [NSNumber numberWithDouble:decodeUs[0] / passes], @"neonDecodeUs",
+            [NSNumber numberWithDouble:encodeUs[1] / passes], @"scalarEncodeUs",
+            [NSNumber numberWithDouble:decodeUs[1] / passes], @"scalarDecodeUs",
+            nil];
+        CDVPluginResult* result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:report];
+        [self.commandDelegate sendPluginResult:result callbackId:command.callbackId];
+    }];
+}
+
+#endif
+
+- (void)getEnvironment:(CDVInvokedUrlCommand*)command
+{
+    NSDictionary* info = [[NSBundle mainBundle] infoDictionary];
+    NSString* appVersion = [info objectForKey:@"CFBundleShortVersionString"];
+
+#ifdef DEBUG
+    BOOL debug = YES;
+#else
+    BOOL debug = NO;
+#endif
+
+    NSDictionary* environment = [NSDictionary dictionaryWithObjectsAndKeys:
+        CDVHardwareModel(), @"model",
+        [[UIDevice currentDevice] systemVersion], @"systemVersion",
+        appVersion ? appVersion : @"", @"appVersion",
+        [NSNumber numberWithBool:debug], @"debug",
+        nil];
+    CDVPluginResult* result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:environment];
+
+    [self.commandDelegate sendPluginResult:result callbackId:command.callbackId];
+}
+
+@end
@@ -28,6 +28,9 @@
     __weak CDVViewController* _viewController;
     @protected
     __weak CDVCommandQueue* _commandQueue;
+    @private
+    NSMutableArray* _pendingJs;
+    BOOL _flushScheduled;
 }
 - (id)initWithViewController:(CDVViewController*)viewController;
 @end
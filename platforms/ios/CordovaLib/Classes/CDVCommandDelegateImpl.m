@@ -21,6 +21,7 @@
 #import "CDVJSON.h"
 #import "CDVCommandQueue.h"
 #import "CDVPluginResult.h"
+#import "CDVTrace.h"
 #import "CDVViewController.h"
 
 @implementation CDVCommandDelegateImpl
@@ -31,6 +32,7 @@
     if (self != nil) {
         _viewController = viewController;
         _commandQueue = _viewController.commandQueue;
+        _pendingJs = [[NSMutableArray alloc] init];
     }
     return self;
 }
@@ -55,6 +57,7 @@
 
 - (void)evalJsHelper2:(NSString*)js
 {
+    CDV_TRACE_SCOPE("CDVCommandDelegateImpl evalJsHelper2");
     CDV_EXEC_LOG(@"Exec: evalling: %@", [js substringToIndex:MIN([js length], 160)]);
     NSString* commandsJSON = [_viewController.webView stringByEvaluatingJavaScriptFromString:js];
     if ([commandsJSON length] > 0) {
@@ -64,19 +67,59 @@
     [_commandQueue enqueCommandBatch:commandsJSON];
 }
 
+// Takes all queued scripts and combines them into one. Every queued script evaluates to the
+// commands JS queued meanwhile, the combined script returns them all as one batch. Each script
+// runs in its own try block, so a callback that throws doesn't lose the ones after it. The
+// commands it queued before throwing are fetched in the catch, and the error is rethrown from a
+// timeout to still show up as uncaught.
+- (NSString*)takePendingJs
+{
+    NSArray* pending;
+
+    @synchronized(self) {
+        pending = [_pendingJs copy];
+        [_pendingJs removeAllObjects];
+        _flushScheduled = NO;
+    }
+    if ([pending count] <= 1) {
+        return [pending lastObject];
+    }
+
+    NSMutableString* js = [NSMutableString stringWithString:
+        @"(function(){var r=[];function q(s){if(s)r.push(s.substring(1,s.length-1));}"];
+    for (NSString* pendingJs in pending) {
+        [js appendFormat:@"try{q(%@);}catch(e){q(cordova.require('cordova/exec').nativeFetchMessages());setTimeout(function(){throw e;},0);}", pendingJs];
+    }
+    [js appendString:@"return r.length?'['+r.join(',')+']':'';})()"];
+    return js;
+}
+
+- (void)flushPendingJs
+{
+    NSString* js = [self takePendingJs];
+
+    if (js != nil) {
+        [self evalJsHelper2:js];
+    }
+}
+
 - (void)evalJsHelper:(NSString*)js
 {
-    // Cycle the run-loop before executing the JS.
-    // This works around a bug where sometimes alerts() within callbacks can cause
-    // dead-lock.
-    // If the commandQueue is currently executing, then we know that it is safe to
-    // execute the callback immediately.
+    // Scripts are queued and evaluated together once the run-loop comes around, so a burst of
+    // results costs a single evaluation.
+    // Cycling the run-loop before executing the JS also works around a bug where sometimes
+    // alerts() within callbacks can cause dead-lock.
     // Using    (dispatch_get_main_queue()) does *not* fix deadlocks for some reaon,
     // but performSelectorOnMainThread: does.
-    if (![NSThread isMainThread] || !_commandQueue.currentlyExecuting) {
-        [self performSelectorOnMainThread:@selector(evalJsHelper2:) withObject:js waitUntilDone:NO];
-    } else {
-        [self evalJsHelper2:js];
+    BOOL scheduleFlush;
+
+    @synchronized(self) {
+        [_pendingJs addObject:js];
+        scheduleFlush = !_flushScheduled;
+        _flushScheduled = YES;
+    }
+    if (scheduleFlush) {
+        [self performSelectorOnMainThread:@selector(flushPendingJs) withObject:nil waitUntilDone:NO];
     }
 }
 
@@ -87,11 +130,15 @@
     if ([@"INVALID" isEqualToString : callbackId]) {
         return;
     }
-    int status = [result.status intValue];
-    BOOL keepCallback = [result.keepCallback boolValue];
-    NSString* argumentsAsJSON = [result argumentsAsJSON];
-
-    NSString* js = [NSString stringWithFormat:@"cordova.require('cordova/exec').nativeCallback('%@',%d,%@,%d)", callbackId, status, argumentsAsJSON, keepCallback];
+    // The whole call is written into one buffer, with no intermediate strings for the message.
+    NSMutableString* js = [NSMutableString stringWithCapacity:[callbackId length] + 96];
+    [js appendString:@"cordova.require('cordova/exec').nativeCallback('"];
+    [js appendString:callbackId];
+    [js appendFormat:@"',%d,", [result.status intValue]];
+    if (![result appendMessageJSONToBuffer:js]) {
+        [js appendString:@"null"];
+    }
+    [js appendString:[result.keepCallback boolValue] ? @",1)" : @",0)"];
 
     [self evalJsHelper:js];
 }
@@ -107,7 +154,11 @@
     if (scheduledOnRunLoop) {
         [self evalJsHelper:js];
     } else {
-        [self evalJsHelper2:js];
+        // Scripts that are still queued have to run first to keep the order.
+        @synchronized(self) {
+            [_pendingJs addObject:js];
+        }
+        [self flushPendingJs];
     }
 }
 
@@ -37,4 +37,7 @@
 - (void)executePending;
 - (BOOL)execute:(CDVInvokedUrlCommand*)command;
 
+// Forgets the resolved plugin instances and methods, to be called when plugins get replaced.
+- (void)invalidateDispatchCache;
+
 @end
@@ -17,20 +17,106 @@
  under the License.
  */
 
-#include <objc/message.h>
+#include <ctype.h>
 #import "CDV.h"
 #import "CDVCommandQueue.h"
 #import "CDVViewController.h"
 #import "CDVCommandDelegateImpl.h"
+#import "CDVMetrics.h"
 
 @interface CDVCommandQueue () {
     NSInteger _lastCommandQueueFlushRequestId;
     __weak CDVViewController* _viewController;
     NSMutableArray* _queue;
     BOOL _currentlyExecuting;
+    NSMutableDictionary* _pluginQueues;
+    NSMutableDictionary* _dispatchCache;
 }
 @end
 
+typedef void (*CDVPluginMethod)(id, SEL, CDVInvokedUrlCommand*);
+
+// The resolved target of a (className, methodName) pair, such that repeated commands skip the
+// plugin and selector lookups.
+@interface CDVCommandDispatch : NSObject
+
+@property (nonatomic, strong) CDVPlugin* plugin;
+@property (nonatomic, assign) SEL selector;
+@property (nonatomic, assign) CDVPluginMethod method;
+@property (nonatomic, assign) dispatch_queue_t queue;
+
+@end
+
+@implementation CDVCommandDispatch
+
+@synthesize plugin, selector, method, queue;
+
+@end
+
+/*
+ * Calls block with the UTF-8 bytes of every top-level element of the JSON array in json, without
+ * building the array itself. Only the nesting of brackets and strings is tracked, the elements are
+ * validated when they are parsed. Returns NO if json is not a complete array.
+ */
+static BOOL CDVEnumerateJSONArrayElements(NSString* json, void (^block)(const char* bytes, NSUInteger length))
+{
+    const char* p = [json UTF8String];
+
+    if (p == NULL) {
+        return NO;
+    }
+    while (isspace((unsigned char)*p)) {
+        ++p;
+    }
+    if (*p++ != '[') {
+        return NO;
+    }
+
+    for (;;) {
+        while (isspace((unsigned char)*p)) {
+            ++p;
+        }
+        if (*p == ']') {
+            return YES;
+        }
+
+        const char* start = p;
+        NSInteger depth = 0;
+        BOOL inString = NO;
+        for (; *p != '\0'; ++p) {
+            char c = *p;
+            if (inString) {
+                if (c == '\\') {
+                    if (*++p == '\0') {
+                        return NO;
+                    }
+                } else if (c == '"') {
+                    inString = NO;
+                }
+            } else if (c == '"') {
+                inString = YES;
+            } else if ((c == '[') || (c == '{')) {
+                ++depth;
+            } else if ((c == ']') || (c == '}')) {
+                if (depth == 0) {
+                    break;
+                }
+                --depth;
+            } else if ((c == ',') && (depth == 0)) {
+                break;
+            }
+        }
+        if (*p == '\0') {
+            return NO;
+        }
+
+        block(start, p - start);
+        if (*p++ == ']') {
+            return YES;
+        }
+    }
+}
+
 @implementation CDVCommandQueue
 
 @synthesize currentlyExecuting = _currentlyExecuting;
@@ -41,14 +127,50 @@
     if (self != nil) {
         _viewController = viewController;
         _queue = [[NSMutableArray alloc] init];
+        _pluginQueues = [[NSMutableDictionary alloc] init];
+        _dispatchCache = [[NSMutableDictionary alloc] init];
     }
     return self;
 }
 
+- (void)dealloc
+{
+    for (NSValue* queue in [_pluginQueues allValues]) {
+        dispatch_release((dispatch_queue_t)[queue pointerValue]);
+    }
+}
+
+// Returns the serial queue for a plugin that runs its commands in the background, or NULL for
+// plugins that run on the main thread.
+- (dispatch_queue_t)backgroundQueueForPlugin:(CDVPlugin*)plugin command:(CDVInvokedUrlCommand*)command
+{
+    NSString* className = NSStringFromClass([plugin class]);
+    NSValue* queue = [_pluginQueues objectForKey:className];
+
+    if (queue != nil) {
+        return (dispatch_queue_t)[queue pointerValue];
+    }
+    if (![[plugin class] runsCommandsInBackground] &&
+        ![_viewController.backgroundPluginNames containsObject:[command.className lowercaseString]]) {
+        return NULL;
+    }
+
+    NSString* label = [NSString stringWithFormat:@"org.apache.cordova.plugin.%@", className];
+    dispatch_queue_t pluginQueue = dispatch_queue_create([label UTF8String], DISPATCH_QUEUE_SERIAL);
+    [_pluginQueues setObject:[NSValue valueWithPointer:pluginQueue] forKey:className];
+    return pluginQueue;
+}
+
 - (void)dispose
 {
     // TODO(agrieve): Make this a zeroing weak ref once we drop support for 4.3.
     _viewController = nil;
+    [_dispatchCache removeAllObjects];
+}
+
+- (void)invalidateDispatchCache
+{
+    [_dispatchCache removeAllObjects];
 }
 
 - (void)resetRequestId
@@ -60,6 +182,8 @@
 {
     if ([batchJSON length] > 0) {
         [_queue addObject:batchJSON];
+        // batches waiting behind the one that is executing, if any, plus this one
+        CDV_METRICS_RECORD("bridge.queueDepth", [_queue count]);
         [self executePending];
     }
 }
@@ -97,18 +221,26 @@
         _currentlyExecuting = YES;
 
         for (NSUInteger i = 0; i < [_queue count]; ++i) {
-            // Parse the returned JSON array.
-            NSArray* commandBatch = [[_queue objectAtIndex:i] JSONObject];
-
-            // Iterate over and execute all of the commands.
-            for (NSArray* jsonEntry in commandBatch) {
+            // Commands are parsed and executed one at a time straight from the batch string, so
+            // replaying a large batch never holds more than one parsed command in memory.
+            NSString* batchJSON = [_queue objectAtIndex:i];
+            BOOL complete = CDVEnumerateJSONArrayElements(batchJSON, ^(const char* bytes, NSUInteger length) {
                 @autoreleasepool {
+                    NSData* entryData = [NSData dataWithBytesNoCopy:(void*)bytes length:length freeWhenDone:NO];
+                    NSError* error = nil;
+                    NSArray* jsonEntry = [NSJSONSerialization JSONObjectWithData:entryData options:kNilOptions error:&error];
+                    if (![jsonEntry isKindOfClass:[NSArray class]]) {
+                        NSLog(@"ERROR: Invalid command in batch: %@", [error localizedDescription]);
+                        return;
+                    }
+
                     CDVInvokedUrlCommand* command = [CDVInvokedUrlCommand commandFromJson:jsonEntry];
+                    CDV_METRICS_COUNT("bridge.commands", 1);
                     CDV_EXEC_LOG(@"Exec(%@): Calling %@.%@", command.callbackId, command.className, command.methodName);
 
                     if (![self execute:command]) {
 #ifdef DEBUG
-                            NSString* commandJson = [jsonEntry JSONString];
+                            NSString* commandJson = [[NSString alloc] initWithData:entryData encoding:NSUTF8StringEncoding];
                             static NSUInteger maxLogLength = 1024;
                             NSString* commandString = ([commandJson length] > maxLogLength) ?
                                 [NSString stringWithFormat:@"%@[...]", [commandJson substringToIndex:maxLogLength]] :
@@ -118,6 +250,9 @@
 #endif
                     }
                 }
+            });
+            if (!complete) {
+                NSLog(@"ERROR: Command batch is not a complete JSON array, remaining commands were dropped.");
             }
         }
 
@@ -128,11 +263,14 @@
     }
 }
 
-- (BOOL)execute:(CDVInvokedUrlCommand*)command
+// Resolves the plugin instance and method of a command, from the cache if it was seen before.
+- (CDVCommandDispatch*)dispatchForCommand:(CDVInvokedUrlCommand*)command
 {
-    if ((command.className == nil) || (command.methodName == nil)) {
-        NSLog(@"ERROR: Classname and/or methodName not found for command.");
-        return NO;
+    NSMutableDictionary* methods = [_dispatchCache objectForKey:command.className];
+    CDVCommandDispatch* dispatch = [methods objectForKey:command.methodName];
+
+    if (dispatch != nil) {
+        return dispatch;
     }
 
     // Fetch an instance of this class
@@ -140,26 +278,65 @@
 
     if (!([obj isKindOfClass:[CDVPlugin class]])) {
         NSLog(@"ERROR: Plugin '%@' not found, or is not a CDVPlugin. Check your plugin mapping in config.xml.", command.className);
-        return NO;
+        return nil;
     }
-    BOOL retVal = YES;
-    double started = [[NSDate date] timeIntervalSince1970] * 1000.0;
     // Find the proper selector to call.
     NSString* methodName = [NSString stringWithFormat:@"%@:", command.methodName];
     SEL normalSelector = NSSelectorFromString(methodName);
-    if ([obj respondsToSelector:normalSelector]) {
-        // [obj performSelector:normalSelector withObject:command];
-        objc_msgSend(obj, normalSelector, command);
-    } else {
+    if (![obj respondsToSelector:normalSelector]) {
         // There's no method to call, so throw an error.
         NSLog(@"ERROR: Method '%@' not defined in Plugin '%@'", methodName, command.className);
-        retVal = NO;
+        return nil;
     }
+
+    dispatch = [[CDVCommandDispatch alloc] init];
+    dispatch.plugin = obj;
+    dispatch.selector = normalSelector;
+    dispatch.method = (CDVPluginMethod)[obj methodForSelector:normalSelector];
+    dispatch.queue = [self backgroundQueueForPlugin:obj command:command];
+
+    // Loading the plugin may have invalidated the cache.
+    methods = [_dispatchCache objectForKey:command.className];
+    if (methods == nil) {
+        methods = [[NSMutableDictionary alloc] init];
+        [_dispatchCache setObject:methods forKey:command.className];
+    }
+    [methods setObject:dispatch forKey:command.methodName];
+    return dispatch;
+}
+
+- (BOOL)execute:(CDVInvokedUrlCommand*)command
+{
+    if ((command.className == nil) || (command.methodName == nil)) {
+        NSLog(@"ERROR: Classname and/or methodName not found for command.");
+        return NO;
+    }
+
+    CDVCommandDispatch* dispatch = [self dispatchForCommand:command];
+    if (dispatch == nil) {
+        return NO;
+    }
+
+    CDVPlugin* obj = dispatch.plugin;
+    SEL selector = dispatch.selector;
+    CDVPluginMethod method = dispatch.method;
+    if (dispatch.queue != NULL) {
+        // Commands of the plugin keep their order, but not relative to other plugins.
+        dispatch_async(dispatch.queue, ^{
+            CDV_TRACE_DETAIL_SCOPE("CDVCommandQueue execute", sel_getName(selector));
+            method(obj, selector, command);
+        });
+        return YES;
+    }
+
+    CDV_TRACE_DETAIL_SCOPE("CDVCommandQueue execute", sel_getName(selector));
+    double started = [[NSDate date] timeIntervalSince1970] * 1000.0;
+    method(obj, selector, command);
     double elapsed = [[NSDate date] timeIntervalSince1970] * 1000.0 - started;
     if (elapsed > 10) {
         NSLog(@"THREAD WARNING: ['%@'] took '%f' ms. Plugin should use a background thread.", command.className, elapsed);
     }
-    return retVal;
+    return YES;
 }
 
 @end
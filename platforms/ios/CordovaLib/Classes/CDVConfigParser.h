@@ -26,6 +26,7 @@
 @property (nonatomic, readonly, strong) NSMutableDictionary* settings;
 @property (nonatomic, readonly, strong) NSMutableArray* whitelistHosts;
 @property (nonatomic, readonly, strong) NSMutableArray* startupPluginNames;
+@property (nonatomic, readonly, strong) NSMutableSet* backgroundPluginNames;
 @property (nonatomic, readonly, strong) NSString* startPage;
 
 @end
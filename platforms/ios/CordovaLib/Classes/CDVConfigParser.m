@@ -25,13 +25,14 @@
 @property (nonatomic, readwrite, strong) NSMutableDictionary* settings;
 @property (nonatomic, readwrite, strong) NSMutableArray* whitelistHosts;
 @property (nonatomic, readwrite, strong) NSMutableArray* startupPluginNames;
+@property (nonatomic, readwrite, strong) NSMutableSet* backgroundPluginNames;
 @property (nonatomic, readwrite, strong) NSString* startPage;
 
 @end
 
 @implementation CDVConfigParser
 
-@synthesize pluginsDict, settings, whitelistHosts, startPage, startupPluginNames;
+@synthesize pluginsDict, settings, whitelistHosts, startPage, startupPluginNames, backgroundPluginNames;
 
 - (id)init
 {
@@ -44,6 +45,7 @@
         [self.whitelistHosts addObject:@"content:///*"];
         [self.whitelistHosts addObject:@"data:///*"];
         self.startupPluginNames = [[NSMutableArray alloc] initWithCapacity:8];
+        self.backgroundPluginNames = [[NSMutableSet alloc] initWithCapacity:8];
         featureName = nil;
     }
     return self;
@@ -66,6 +68,9 @@
         if (paramIsOnload || attribIsOnload) {
             [self.startupPluginNames addObject:featureName];
         }
+        if ([paramName isEqualToString:@"background"] && [@"true" isEqualToString : value]) {
+            [self.backgroundPluginNames addObject:featureName];
+        }
     } else if ([elementName isEqualToString:@"access"]) {
         [whitelistHosts addObject:attributeDict[@"origin"]];
     } else if ([elementName isEqualToString:@"content"]) {
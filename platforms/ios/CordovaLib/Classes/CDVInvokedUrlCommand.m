@@ -20,6 +20,7 @@
 #import "CDVInvokedUrlCommand.h"
 #import "CDVJSON.h"
 #import "NSData+Base64.h"
+#import "CDVBlobStore.h"
 
 @implementation CDVInvokedUrlCommand
 
@@ -74,18 +75,25 @@
         }
         NSDictionary* dict = arg;
         NSString* type = [dict objectForKey:@"CDVType"];
-        if (!type || ![type isEqualToString:@"ArrayBuffer"]) {
-            continue;
-        }
-        NSString* data = [dict objectForKey:@"data"];
-        if (!data) {
+        id value = nil;
+        if ([type isEqualToString:@"ArrayBuffer"]) {
+            NSString* data = [dict objectForKey:@"data"];
+            if (!data) {
+                continue;
+            }
+            value = [NSData dataFromBase64String:data];
+        } else if ([type isEqualToString:@"Blob"]) {
+            // Large buffers are uploaded to CDVURLProtocol ahead of the exec call.
+            NSData* data = [[CDVBlobStore sharedStore] takeDataForToken:[dict objectForKey:@"token"] mimeType:NULL];
+            value = data ? data : [NSNull null];
+        } else {
             continue;
         }
         if (newArgs == nil) {
             newArgs = [NSMutableArray arrayWithArray:_arguments];
             _arguments = newArgs;
         }
-        [newArgs replaceObjectAtIndex:i withObject:[NSData dataFromBase64String:data]];
+        [newArgs replaceObjectAtIndex:i withObject:value];
     }
 }
 
@@ -28,3 +28,8 @@
 @interface NSString (CDVJSONSerializing)
 - (id)JSONObject;
 @end
+
+// Appends the compact JSON encoding of obj to buffer. obj may be built from
+// NSDictionary (with NSString keys), NSArray, NSString, NSNumber and NSNull.
+// Returns NO, leaving buffer partially written, if it contains anything else.
+FOUNDATION_EXPORT BOOL CDVJSONAppendObject(NSMutableString* buffer, id obj);
@@ -19,6 +19,152 @@
 
 #import "CDVJSON.h"
 #import <Foundation/NSJSONSerialization.h>
+#include <math.h>
+
+#define CDV_JSON_ESCAPE_BUFFER_SIZE 256
+
+static inline BOOL CDVJSONCharacterNeedsEscape(UniChar c)
+{
+    // U+2028 and U+2029 are valid in JSON but terminate JS string literals,
+    // and our output is evaluated as script.
+    return c < 0x20 || c == '"' || c == '\\' || c == 0x2028 || c == 0x2029;
+}
+
+static void CDVJSONAppendString(NSMutableString* buffer, NSString* string)
+{
+    CFStringRef cfString = (__bridge CFStringRef)string;
+    CFIndex length = CFStringGetLength(cfString);
+    CFStringInlineBuffer inlineBuffer;
+    CFIndex i = 0;
+
+    CFStringInitInlineBuffer(cfString, &inlineBuffer, CFRangeMake(0, length));
+    while (i < length && !CDVJSONCharacterNeedsEscape(CFStringGetCharacterFromInlineBuffer(&inlineBuffer, i))) {
+        ++i;
+    }
+
+    [buffer appendString:@"\""];
+    if (i == length) {
+        // Nearly every string goes this way.
+        [buffer appendString:string];
+    } else {
+        UniChar escaped[CDV_JSON_ESCAPE_BUFFER_SIZE + 6];
+        CFIndex count = 0;
+        [buffer appendString:[string substringToIndex:i]];
+        for (; i < length; ++i) {
+            UniChar c = CFStringGetCharacterFromInlineBuffer(&inlineBuffer, i);
+            if (!CDVJSONCharacterNeedsEscape(c)) {
+                escaped[count++] = c;
+            } else if ((c == '"') || (c == '\\')) {
+                escaped[count++] = '\\';
+                escaped[count++] = c;
+            } else if (c == '\n') {
+                escaped[count++] = '\\';
+                escaped[count++] = 'n';
+            } else if (c == '\r') {
+                escaped[count++] = '\\';
+                escaped[count++] = 'r';
+            } else if (c == '\t') {
+                escaped[count++] = '\\';
+                escaped[count++] = 't';
+            } else {
+                static const char hex[] = "0123456789abcdef";
+                escaped[count++] = '\\';
+                escaped[count++] = 'u';
+                escaped[count++] = hex[(c >> 12) & 0xF];
+                escaped[count++] = hex[(c >> 8) & 0xF];
+                escaped[count++] = hex[(c >> 4) & 0xF];
+                escaped[count++] = hex[c & 0xF];
+            }
+            if (count >= CDV_JSON_ESCAPE_BUFFER_SIZE) {
+                CFStringAppendCharacters((__bridge CFMutableStringRef)buffer, escaped, count);
+                count = 0;
+            }
+        }
+        CFStringAppendCharacters((__bridge CFMutableStringRef)buffer, escaped, count);
+    }
+    [buffer appendString:@"\""];
+}
+
+static void CDVJSONAppendNumber(NSMutableString* buffer, NSNumber* number)
+{
+    if (CFGetTypeID((__bridge CFTypeRef)number) == CFBooleanGetTypeID()) {
+        [buffer appendString:[number boolValue] ? @"true" : @"false"];
+        return;
+    }
+
+    switch ([number objCType][0]) {
+        case 'f':
+        case 'd': {
+            double value = [number doubleValue];
+            if (!isfinite(value)) {
+                // JSON has no representation for these.
+                [buffer appendString:@"null"];
+            } else if ((fabs(value) < 1e15) && (value == (double)(long long)value)) {
+                [buffer appendFormat:@"%lld", (long long)value];
+            } else {
+                // Use the shortest form that reads back as the same double.
+                char text[32];
+                snprintf(text, sizeof(text), "%.15g", value);
+                if (strtod(text, NULL) != value) {
+                    snprintf(text, sizeof(text), "%.17g", value);
+                }
+                CFStringAppendCString((__bridge CFMutableStringRef)buffer, text, kCFStringEncodingASCII);
+            }
+            break;
+        }
+        case 'Q':
+            [buffer appendFormat:@"%llu", [number unsignedLongLongValue]];
+            break;
+        default:
+            [buffer appendFormat:@"%lld", [number longLongValue]];
+            break;
+    }
+}
+
+BOOL CDVJSONAppendObject(NSMutableString* buffer, id obj)
+{
+    if ([obj isKindOfClass:[NSString class]]) {
+        CDVJSONAppendString(buffer, obj);
+    } else if ([obj isKindOfClass:[NSNumber class]]) {
+        CDVJSONAppendNumber(buffer, obj);
+    } else if ([obj isKindOfClass:[NSDictionary class]]) {
+        BOOL first = YES;
+        [buffer appendString:@"{"];
+        for (id key in obj) {
+            if (![key isKindOfClass:[NSString class]]) {
+                return NO;
+            }
+            if (!first) {
+                [buffer appendString:@","];
+            }
+            first = NO;
+            CDVJSONAppendString(buffer, key);
+            [buffer appendString:@":"];
+            if (!CDVJSONAppendObject(buffer, [obj objectForKey:key])) {
+                return NO;
+            }
+        }
+        [buffer appendString:@"}"];
+    } else if ([obj isKindOfClass:[NSArray class]]) {
+        BOOL first = YES;
+        [buffer appendString:@"["];
+        for (id element in obj) {
+            if (!first) {
+                [buffer appendString:@","];
+            }
+            first = NO;
+            if (!CDVJSONAppendObject(buffer, element)) {
+                return NO;
+            }
+        }
+        [buffer appendString:@"]"];
+    } else if ((obj == nil) || (obj == [NSNull null])) {
+        [buffer appendString:@"null"];
+    } else {
+        return NO;
+    }
+    return YES;
+}
 
 @implementation NSArray (CDVJSONSerializing)
 
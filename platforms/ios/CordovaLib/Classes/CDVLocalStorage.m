@@ -19,6 +19,49 @@
 
 #import "CDVLocalStorage.h"
 #import "CDV.h"
+#include <dlfcn.h>
+
+/*
+ * Copy-on-write copy of a file or directory with clonefile(2), which exists on
+ * APFS volumes from iOS 10.3. It is looked up at runtime since older SDKs do
+ * not declare it; returns NO when it is unavailable or the clone fails, and
+ * the caller falls back to a regular copy.
+ */
+static BOOL CDVCloneFile(NSString* src, NSString* dest)
+{
+    typedef int (*CDVCloneFileFunc)(const char* src, const char* dst, uint32_t flags);
+    static CDVCloneFileFunc cloneFile = NULL;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        cloneFile = (CDVCloneFileFunc)dlsym(RTLD_DEFAULT, "clonefile");
+    });
+
+    return (cloneFile != NULL) && (cloneFile([src fileSystemRepresentation], [dest fileSystemRepresentation], 0) == 0);
+}
+
+/*
+ * A file is newer if its modification date is later, or if the dates match but
+ * the sizes do not (dates have one second granularity on HFS+). Copies keep the
+ * modification date, so an unchanged file compares as not newer.
+ */
+static BOOL CDVFileIsNewerThanFile(NSFileManager* fileManager, NSString* aPath, NSString* bPath)
+{
+    NSDictionary* aPathAttribs = [fileManager attributesOfItemAtPath:aPath error:nil];
+    NSDictionary* bPathAttribs = [fileManager attributesOfItemAtPath:bPath error:nil];
+
+    NSDate* aPathModDate = [aPathAttribs fileModificationDate];
+    NSDate* bPathModDate = [bPathAttribs fileModificationDate];
+
+    if ((nil == aPathModDate) && (nil == bPathModDate)) {
+        return NO;
+    }
+    if ((nil == bPathModDate) || ([aPathModDate compare:bPathModDate] == NSOrderedDescending)) {
+        return YES;
+    }
+
+    return [aPathModDate isEqualToDate:bPathModDate] && ([aPathAttribs fileSize] != [bPathAttribs fileSize]);
+}
 
 @interface CDVLocalStorage ()
 
@@ -146,48 +189,86 @@
         return NO;
     }
 
-    // generate unique filepath in temp directory
+    // generate unique filepaths in temp directory, for the new copy and for the old dest
     CFUUIDRef uuidRef = CFUUIDCreate(kCFAllocatorDefault);
     CFStringRef uuidString = CFUUIDCreateString(kCFAllocatorDefault, uuidRef);
-    NSString* tempBackup = [[NSTemporaryDirectory() stringByAppendingPathComponent:(__bridge NSString*)uuidString] stringByAppendingPathExtension:@"bak"];
+    NSString* tempBase = [NSTemporaryDirectory() stringByAppendingPathComponent:(__bridge NSString*)uuidString];
+    NSString* tempCopy = [tempBase stringByAppendingPathExtension:@"new"];
+    NSString* tempBackup = [tempBase stringByAppendingPathExtension:@"bak"];
     CFRelease(uuidString);
     CFRelease(uuidRef);
 
-    BOOL destExists = [fileManager fileExistsAtPath:dest];
-
-    // backup the dest
-    if (destExists && ![fileManager copyItemAtPath:dest toPath:tempBackup error:error]) {
+    // copy src next to dest first, so a failed copy leaves dest untouched
+    if (!CDVCloneFile(src, tempCopy) && ![fileManager copyItemAtPath:src toPath:tempCopy error:error]) {
         return NO;
     }
 
-    // remove the dest
-    if (destExists && ![fileManager removeItemAtPath:dest error:error]) {
-        return NO;
-    }
+    BOOL destExists = [fileManager fileExistsAtPath:dest];
 
     // create path to dest
     if (!destExists && ![fileManager createDirectoryAtPath:[dest stringByDeletingLastPathComponent] withIntermediateDirectories:YES attributes:nil error:error]) {
+        [fileManager removeItemAtPath:tempCopy error:nil];
+        return NO;
+    }
+
+    // move the dest aside, a rename rather than a copy
+    if (destExists && ![fileManager moveItemAtPath:dest toPath:tempBackup error:error]) {
+        [fileManager removeItemAtPath:tempCopy error:nil];
         return NO;
     }
 
-    // copy src to dest
-    if ([fileManager copyItemAtPath:src toPath:dest error:error]) {
-        // success - cleanup - delete the backup to the dest
-        if ([fileManager fileExistsAtPath:tempBackup]) {
-            [fileManager removeItemAtPath:tempBackup error:error];
+    if ([fileManager moveItemAtPath:tempCopy toPath:dest error:error]) {
+        // success - cleanup - delete the old dest
+        if (destExists) {
+            [fileManager removeItemAtPath:tempBackup error:nil];
         }
         return YES;
     } else {
-        // failure - we restore the temp backup file to dest
-        [fileManager copyItemAtPath:tempBackup toPath:dest error:error];
-        // cleanup - delete the backup to the dest
-        if ([fileManager fileExistsAtPath:tempBackup]) {
-            [fileManager removeItemAtPath:tempBackup error:error];
+        // failure - we put the old dest back
+        if (destExists) {
+            [fileManager moveItemAtPath:tempBackup toPath:dest error:nil];
         }
+        [fileManager removeItemAtPath:tempCopy error:nil];
         return NO;
     }
 }
 
++ (BOOL)copyChangesFrom:(NSString*)src to:(NSString*)dest error:(NSError* __autoreleasing*)error
+{
+    NSFileManager* fileManager = [NSFileManager defaultManager];
+    BOOL srcIsDir = NO, destIsDir = NO;
+
+    if (!([fileManager fileExistsAtPath:src isDirectory:&srcIsDir] && srcIsDir &&
+        [fileManager fileExistsAtPath:dest isDirectory:&destIsDir] && destIsDir)) {
+        return [self copyFrom:src to:dest error:error];
+    }
+
+    // both are directories: copy the files that changed, and drop the ones that are gone from src
+    NSDirectoryEnumerator* directoryEnumerator = [fileManager enumeratorAtPath:src];
+    NSString* path;
+
+    while ((path = [directoryEnumerator nextObject])) {
+        if ([[[directoryEnumerator fileAttributes] fileType] isEqualToString:NSFileTypeDirectory]) {
+            continue;
+        }
+        NSString* srcFile = [src stringByAppendingPathComponent:path];
+        NSString* destFile = [dest stringByAppendingPathComponent:path];
+        if (CDVFileIsNewerThanFile(fileManager, srcFile, destFile) && ![self copyFrom:srcFile to:destFile error:error]) {
+            return NO;
+        }
+    }
+
+    directoryEnumerator = [fileManager enumeratorAtPath:dest];
+    while ((path = [directoryEnumerator nextObject])) {
+        if (![fileManager fileExistsAtPath:[src stringByAppendingPathComponent:path]]) {
+            [fileManager removeItemAtPath:[dest stringByAppendingPathComponent:path] error:nil];
+            [directoryEnumerator skipDescendants];
+        }
+    }
+
+    return YES;
+}
+
 - (BOOL)shouldBackup
 {
     for (CDVBackupInfo* info in self.backupInfo) {
@@ -221,7 +302,7 @@
 
     for (CDVBackupInfo* info in self.backupInfo) {
         if ([info shouldBackup]) {
-            [[self class] copyFrom:info.original to:info.backup error:&error];
+            [[self class] copyChangesFrom:info.original to:info.backup error:&error];
 
             if (callbackId) {
                 if (error == nil) {
@@ -251,7 +332,7 @@
 
     for (CDVBackupInfo* info in self.backupInfo) {
         if ([info shouldRestore]) {
-            [[self class] copyFrom:info.backup to:info.original error:&error];
+            [[self class] copyChangesFrom:info.backup to:info.original error:&error];
 
             if (error == nil) {
                 message = [NSString stringWithFormat:@"Restored: %@", info.label];
@@ -419,20 +500,7 @@
 
 - (BOOL)file:(NSString*)aPath isNewerThanFile:(NSString*)bPath
 {
-    NSFileManager* fileManager = [NSFileManager defaultManager];
-    NSError* __autoreleasing error = nil;
-
-    NSDictionary* aPathAttribs = [fileManager attributesOfItemAtPath:aPath error:&error];
-    NSDictionary* bPathAttribs = [fileManager attributesOfItemAtPath:bPath error:&error];
-
-    NSDate* aPathModDate = [aPathAttribs objectForKey:NSFileModificationDate];
-    NSDate* bPathModDate = [bPathAttribs objectForKey:NSFileModificationDate];
-
-    if ((nil == aPathModDate) && (nil == bPathModDate)) {
-        return NO;
-    }
-
-    return [aPathModDate compare:bPathModDate] == NSOrderedDescending || bPathModDate == nil;
+    return CDVFileIsNewerThanFile([NSFileManager defaultManager], aPath, bPath);
 }
 
 - (BOOL)item:(NSString*)aPath isNewerThanItem:(NSString*)bPath
@@ -0,0 +1,66 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import <Foundation/Foundation.h>
+#import "CDVPlugin.h"
+
+// What a memory pressure handler gives up, in the order it is released.
+typedef enum {
+    // decoded images and frames that are made again when needed
+    CDVMemoryPressureLevelCaches = 0,
+    // objects kept alive only to start faster, such as a prepared camera picker
+    CDVMemoryPressureLevelWarmObjects = 1,
+    // pages of data caches that are read back from disk
+    CDVMemoryPressureLevelDataCaches = 2
+} CDVMemoryPressureLevel;
+
+@protocol CDVMemoryPressureHandler <NSObject>
+
+// Called on the main thread to release what the handler registered for.
+- (void)releaseMemoryForPressureLevel:(CDVMemoryPressureLevel)level;
+
+@end
+
+// Releases memory in tiers on memory warnings: a first warning releases the
+// caches and warm objects, further warnings within 30 seconds also the data
+// cache pages. The resident size freed by each handler is measured and kept
+// in a report.
+@interface CDVMemoryPressure : NSObject
+
+// Handlers are held weakly and called lowest level first, in the order they registered.
+- (void)registerHandler:(id <CDVMemoryPressureHandler>)handler level:(CDVMemoryPressureLevel)level name:(NSString*)name;
+- (void)unregisterHandler:(id <CDVMemoryPressureHandler>)handler;
+
+// Runs the handlers for a memory warning. Returns the bytes freed.
+- (int64_t)relieve;
+
+// Returns { "warnings": <count>, "bytesReleased": <total>,
+//           "releases": [ { "name", "level", "bytes", "time" }, ... ] }
+// with the most recent releases last.
+- (NSDictionary*)report;
+
+@end
+
+// Exposes the controller's memory pressure report to JS:
+//   cordova.exec(win, fail, "MemoryPressure", "getReport", []);
+@interface CDVMemoryPressurePlugin : CDVPlugin
+
+- (void)getReport:(CDVInvokedUrlCommand*)command;
+
+@end
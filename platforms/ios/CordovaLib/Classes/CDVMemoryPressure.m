@@ -0,0 +1,181 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import "CDVMemoryPressure.h"
+#import "CDVViewController.h"
+#import "CDVMetrics.h"
+#include <mach/mach.h>
+
+// Warnings closer together than this escalate to the next level.
+#define CDV_MEMORY_PRESSURE_ESCALATION_INTERVAL 30
+// Releases kept in the report.
+#define CDV_MEMORY_PRESSURE_REPORT_LENGTH 32
+
+// Returns the resident size of the process in bytes, or 0 if it can't be determined.
+static int64_t CDVResidentBytes(void)
+{
+    struct task_basic_info info;
+    mach_msg_type_number_t count = TASK_BASIC_INFO_COUNT;
+
+    if (task_info(mach_task_self(), TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return info.resident_size;
+}
+
+@interface CDVMemoryPressureEntry : NSObject
+@property (nonatomic, weak) id <CDVMemoryPressureHandler> handler;
+@property (nonatomic, assign) CDVMemoryPressureLevel level;
+@property (nonatomic, copy) NSString* name;
+@end
+
+@implementation CDVMemoryPressureEntry
+@synthesize handler, level, name;
+@end
+
+@interface CDVMemoryPressure () {
+    NSMutableArray* _entries;
+    NSMutableArray* _releases;
+    CFAbsoluteTime _lastWarning;
+    CDVMemoryPressureLevel _level;
+    NSUInteger _warnings;
+    int64_t _bytesReleased;
+}
+@end
+
+@implementation CDVMemoryPressure
+
+- (id)init
+{
+    self = [super init];
+    if (self != nil) {
+        _entries = [[NSMutableArray alloc] initWithCapacity:8];
+        _releases = [[NSMutableArray alloc] initWithCapacity:CDV_MEMORY_PRESSURE_REPORT_LENGTH];
+    }
+    return self;
+}
+
+- (void)registerHandler:(id <CDVMemoryPressureHandler>)handler level:(CDVMemoryPressureLevel)level name:(NSString*)name
+{
+    CDVMemoryPressureEntry* entry = [[CDVMemoryPressureEntry alloc] init];
+
+    entry.handler = handler;
+    entry.level = level;
+    entry.name = name;
+
+    @synchronized(self) {
+        // keep the entries sorted by level, registration order within a level
+        NSUInteger i = [_entries count];
+        while ((i > 0) && (((CDVMemoryPressureEntry*)[_entries objectAtIndex:i - 1]).level > level)) {
+            i--;
+        }
+        [_entries insertObject:entry atIndex:i];
+    }
+}
+
+- (void)unregisterHandler:(id <CDVMemoryPressureHandler>)handler
+{
+    @synchronized(self) {
+        for (NSInteger i = [_entries count] - 1; i >= 0; i--) {
+            id <CDVMemoryPressureHandler> registered = ((CDVMemoryPressureEntry*)[_entries objectAtIndex:i]).handler;
+            if ((registered == nil) || (registered == handler)) {
+                [_entries removeObjectAtIndex:i];
+            }
+        }
+    }
+}
+
+- (int64_t)relieve
+{
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    NSArray* entries;
+    CDVMemoryPressureLevel level;
+
+    @synchronized(self) {
+        if ((_warnings > 0) && (now - _lastWarning < CDV_MEMORY_PRESSURE_ESCALATION_INTERVAL)) {
+            _level = MIN(_level + 1, CDVMemoryPressureLevelDataCaches);
+        } else {
+            _level = CDVMemoryPressureLevelWarmObjects;
+        }
+        _lastWarning = now;
+        _warnings++;
+        level = _level;
+        entries = [_entries copy];
+    }
+
+    int64_t total = 0;
+    for (CDVMemoryPressureEntry* entry in entries) {
+        id <CDVMemoryPressureHandler> handler = entry.handler;
+        if ((handler == nil) || (entry.level > level)) {
+            continue;
+        }
+
+        int64_t before = CDVResidentBytes();
+        @autoreleasepool {
+            [handler releaseMemoryForPressureLevel:entry.level];
+        }
+        int64_t released = MAX(before - CDVResidentBytes(), 0);
+        total += released;
+
+        @synchronized(self) {
+            if ([_releases count] == CDV_MEMORY_PRESSURE_REPORT_LENGTH) {
+                [_releases removeObjectAtIndex:0];
+            }
+            [_releases addObject:@{
+                 @"name" : entry.name,
+                 @"level" : [NSNumber numberWithInt:entry.level],
+                 @"bytes" : [NSNumber numberWithLongLong:released],
+                 @"time" : [NSNumber numberWithDouble:[[NSDate date] timeIntervalSince1970] * 1000.0]
+             }];
+        }
+        NSLog(@"Memory warning: %@ released %lld KB at level %d.", entry.name, released / 1024, entry.level);
+    }
+
+    @synchronized(self) {
+        _bytesReleased += total;
+    }
+    CDV_METRICS_COUNT("memory.warnings", 1);
+    CDV_METRICS_RECORD("memory.released.kb", total / 1024);
+    return total;
+}
+
+- (NSDictionary*)report
+{
+    @synchronized(self) {
+        return @{
+                   @"warnings" : [NSNumber numberWithUnsignedInteger:_warnings],
+                   @"bytesReleased" : [NSNumber numberWithLongLong:_bytesReleased],
+                   @"releases" : [_releases copy]
+        };
+    }
+}
+
+@end
+
+@implementation CDVMemoryPressurePlugin
+
+- (void)getReport:(CDVInvokedUrlCommand*)command
+{
+    NSDictionary* report = [((CDVViewController*)self.viewController).memoryPressure report];
+    CDVPluginResult* result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:report];
+
+    [self.commandDelegate sendPluginResult:result callbackId:command.callbackId];
+}
+
+@end
@@ -0,0 +1,99 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import <Foundation/Foundation.h>
+#import "CDVPlugin.h"
+
+// Counters and histograms that survive relaunches, for percentiles over a
+// whole fleet of devices rather than logs of one.
+//
+// All metrics live in one memory-mapped file, Library/NoCloud/Cordova/metrics.bin,
+// so recording a value touches a few words of memory and leaves writing them
+// to the kernel. Histograms have fixed log-linear buckets, 8 per power of
+// two (HDR style, within 12.5% of the value), so the buckets of many devices
+// can be summed and percentiles taken over the sum.
+//
+// Metrics are looked up by name once per call site and then recorded with
+// atomic adds only:
+//
+//   CDV_METRICS_COUNT("bridge.commands", 1);
+//   CDV_METRICS_RECORD("scan.firstResult.us", elapsedMicroseconds);
+
+typedef struct CDVMetric CDVMetric;
+
+// Returns the counter or histogram of the given name, creating it. Returns
+// NULL once all 48 slots are taken or the file can't be opened.
+CDVMetric* CDVMetricsCounter(const char* name);
+CDVMetric* CDVMetricsHistogram(const char* name);
+
+// Both accept NULL.
+void CDVMetricsIncrement(CDVMetric* counter, int64_t delta);
+void CDVMetricsRecord(CDVMetric* histogram, int64_t value);
+
+#define CDV_METRICS_COUNT(name, delta) do { \
+        static CDVMetric* _cdvMetric; \
+        static dispatch_once_t _cdvMetricOnce; \
+        dispatch_once(&_cdvMetricOnce, ^{ _cdvMetric = CDVMetricsCounter(name); }); \
+        CDVMetricsIncrement(_cdvMetric, (delta)); \
+    } while (0)
+
+#define CDV_METRICS_RECORD(name, value) do { \
+        static CDVMetric* _cdvMetric; \
+        static dispatch_once_t _cdvMetricOnce; \
+        dispatch_once(&_cdvMetricOnce, ^{ _cdvMetric = CDVMetricsHistogram(name); }); \
+        CDVMetricsRecord(_cdvMetric, (value)); \
+    } while (0)
+
+@interface CDVMetrics : NSObject
+
+// Where snapshots are POSTed, gzipped, from the MetricsUploadURL preference.
+// Nothing is uploaded without it.
+@property (nonatomic, copy) NSURL* uploadURL;
+// Seconds between uploads, from the MetricsUploadInterval preference, an hour by default.
+@property (nonatomic, assign) NSTimeInterval uploadInterval;
+
++ (CDVMetrics*)sharedMetrics;
+
+// Returns { "install", "since", "model", "systemVersion", "appVersion",
+//           "counters": { name: value },
+//           "histograms": { name: { "count", "sum", "max", "p50", "p90", "p99",
+//                                   "buckets": [ [ lowerBound, count ], ... ] } } }
+// with the values recorded since the last successful upload.
+- (NSDictionary*)snapshot;
+
+// Writes the mapped file back to disk.
+- (void)sync;
+
+// Uploads a snapshot if the interval has passed since the last upload, as a
+// background task. What was uploaded is subtracted afterwards, so values
+// recorded meanwhile are kept for the next upload.
+- (void)uploadIfDue;
+- (void)uploadWithCompletion:(void (^)(BOOL uploaded))completion;
+
+@end
+
+// Exposes the metrics to JS:
+//   cordova.exec(win, fail, "Metrics", "getSnapshot", []);
+//   cordova.exec(win, fail, "Metrics", "upload", []);
+@interface CDVMetricsPlugin : CDVPlugin
+
+- (void)getSnapshot:(CDVInvokedUrlCommand*)command;
+- (void)upload:(CDVInvokedUrlCommand*)command;
+
+@end
@@ -0,0 +1,456 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import "CDVMetrics.h"
+#import <UIKit/UIKit.h>
+#include <libkern/OSAtomic.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#define CDV_METRICS_MAGIC 0x314D4443 // "CDM1"
+#define CDV_METRICS_SLOTS 48
+#define CDV_METRICS_NAME_LENGTH 48
+// Buckets per power of two, and in all. Values of 16e9 and more share the last bucket.
+#define CDV_METRICS_SUB_BUCKETS 8
+#define CDV_METRICS_BUCKETS 256
+#define CDV_METRICS_DEFAULT_UPLOAD_INTERVAL (60 * 60)
+
+enum {
+    CDVMetricTypeFree = 0,
+    CDVMetricTypeCounter = 1,
+    CDVMetricTypeHistogram = 2
+};
+
+struct CDVMetric {
+    char name[CDV_METRICS_NAME_LENGTH];
+    int32_t type;
+    int32_t reserved;
+    // the counter's value, or the number of values in the histogram
+    volatile int64_t count;
+    volatile int64_t sum;
+    volatile int64_t max;
+    volatile int64_t buckets[CDV_METRICS_BUCKETS];
+};
+
+typedef struct {
+    uint32_t magic;
+    uint32_t slotCount;
+    uint32_t used;
+    uint32_t reserved;
+    // when the values were last uploaded, or the file created
+    double since;
+    double lastUpload;
+    char install[40];
+    struct CDVMetric slots[CDV_METRICS_SLOTS];
+} CDVMetricsFile;
+
+static CDVMetricsFile* gCDVMetricsFile = NULL;
+static BOOL gCDVMetricsFailed = NO;
+static pthread_mutex_t gCDVMetricsLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Maps the metrics file, with gCDVMetricsLock held.
+static CDVMetricsFile* CDVMetricsOpen(void)
+{
+    if ((gCDVMetricsFile != NULL) || gCDVMetricsFailed) {
+        return gCDVMetricsFile;
+    }
+
+    @autoreleasepool {
+        NSString* library = [NSSearchPathForDirectoriesInDomains(NSLibraryDirectory, NSUserDomainMask, YES) objectAtIndex:0];
+        NSString* directory = [library stringByAppendingPathComponent:@"NoCloud/Cordova"];
+        [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:nil];
+        NSString* path = [directory stringByAppendingPathComponent:@"metrics.bin"];
+
+        int fd = open([path fileSystemRepresentation], O_RDWR | O_CREAT, 0644);
+        struct stat info;
+        if ((fd < 0) || (fstat(fd, &info) != 0)) {
+            NSLog(@"CDVMetrics: cannot open %@", path);
+            if (fd >= 0) {
+                close(fd);
+            }
+            gCDVMetricsFailed = YES;
+            return NULL;
+        }
+
+        BOOL fresh = (info.st_size != sizeof(CDVMetricsFile));
+        if (fresh && ((ftruncate(fd, 0) != 0) || (ftruncate(fd, sizeof(CDVMetricsFile)) != 0))) {
+            close(fd);
+            gCDVMetricsFailed = YES;
+            return NULL;
+        }
+        void* map = mmap(NULL, sizeof(CDVMetricsFile), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+            gCDVMetricsFailed = YES;
+            return NULL;
+        }
+
+        CDVMetricsFile* file = map;
+        if (fresh || (file->magic != CDV_METRICS_MAGIC) || (file->slotCount != CDV_METRICS_SLOTS) || (file->used > CDV_METRICS_SLOTS)) {
+            memset(file, 0, sizeof(CDVMetricsFile));
+            file->magic = CDV_METRICS_MAGIC;
+            file->slotCount = CDV_METRICS_SLOTS;
+            file->since = [[NSDate date] timeIntervalSince1970];
+
+            // identifies the install, not the device or the user
+            CFUUIDRef uuid = CFUUIDCreate(NULL);
+            CFStringRef install = CFUUIDCreateString(NULL, uuid);
+            CFStringGetCString(install, file->install, sizeof(file->install), kCFStringEncodingASCII);
+            CFRelease(install);
+            CFRelease(uuid);
+        }
+        gCDVMetricsFile = file;
+    }
+    return gCDVMetricsFile;
+}
+
+static CDVMetric* CDVMetricsLookup(const char* name, int32_t type)
+{
+    CDVMetric* metric = NULL;
+
+    pthread_mutex_lock(&gCDVMetricsLock);
+    CDVMetricsFile* file = CDVMetricsOpen();
+    if (file != NULL) {
+        uint32_t i;
+        for (i = 0; i < file->used; ++i) {
+            if (strncmp(file->slots[i].name, name, CDV_METRICS_NAME_LENGTH - 1) == 0) {
+                break;
+            }
+        }
+        if (i < file->used) {
+            metric = (file->slots[i].type == type) ? &file->slots[i] : NULL;
+        } else if (file->used < CDV_METRICS_SLOTS) {
+            metric = &file->slots[file->used];
+            strlcpy(metric->name, name, CDV_METRICS_NAME_LENGTH);
+            metric->type = type;
+            OSMemoryBarrier();
+            file->used++;
+        }
+    }
+    pthread_mutex_unlock(&gCDVMetricsLock);
+
+    if (metric == NULL) {
+        NSLog(@"CDVMetrics: no slot for metric '%s'", name);
+    }
+    return metric;
+}
+
+CDVMetric* CDVMetricsCounter(const char* name)
+{
+    return CDVMetricsLookup(name, CDVMetricTypeCounter);
+}
+
+CDVMetric* CDVMetricsHistogram(const char* name)
+{
+    return CDVMetricsLookup(name, CDVMetricTypeHistogram);
+}
+
+void CDVMetricsIncrement(CDVMetric* counter, int64_t delta)
+{
+    if (counter != NULL) {
+        OSAtomicAdd64(delta, &counter->count);
+    }
+}
+
+// Values below 8 have a bucket each, above that every power of two is split into 8 buckets.
+static int CDVMetricsBucketForValue(int64_t value)
+{
+    if (value < CDV_METRICS_SUB_BUCKETS) {
+        return (int)value;
+    }
+    int exponent = 63 - __builtin_clzll((uint64_t)value);
+    int index = (exponent - 2) * CDV_METRICS_SUB_BUCKETS + (int)((value >> (exponent - 3)) & (CDV_METRICS_SUB_BUCKETS - 1));
+    return MIN(index, CDV_METRICS_BUCKETS - 1);
+}
+
+static int64_t CDVMetricsBucketLowerBound(int index)
+{
+    if (index < CDV_METRICS_SUB_BUCKETS) {
+        return index;
+    }
+    int exponent = index / CDV_METRICS_SUB_BUCKETS + 2;
+    return (int64_t)(CDV_METRICS_SUB_BUCKETS + index % CDV_METRICS_SUB_BUCKETS) << (exponent - 3);
+}
+
+void CDVMetricsRecord(CDVMetric* histogram, int64_t value)
+{
+    if (histogram == NULL) {
+        return;
+    }
+    value = MAX(value, 0);
+    OSAtomicIncrement64(&histogram->buckets[CDVMetricsBucketForValue(value)]);
+    OSAtomicIncrement64(&histogram->count);
+    OSAtomicAdd64(value, &histogram->sum);
+
+    int64_t max;
+    while (((max = histogram->max) < value) && !OSAtomicCompareAndSwap64(max, value, &histogram->max)) {
+    }
+}
+
+// The lower bound of the bucket holding the p-th percentile.
+static int64_t CDVMetricsPercentile(const struct CDVMetric* histogram, double p)
+{
+    int64_t rank = (int64_t)ceil(histogram->count * p / 100.0);
+    int64_t seen = 0;
+
+    for (int i = 0; i < CDV_METRICS_BUCKETS; ++i) {
+        seen += histogram->buckets[i];
+        if ((seen >= rank) && (seen > 0)) {
+            return CDVMetricsBucketLowerBound(i);
+        }
+    }
+    return 0;
+}
+
+static NSData* CDVMetricsGzip(NSData* data)
+{
+    z_stream stream;
+
+    memset(&stream, 0, sizeof(stream));
+    // 16 added to the window bits asks for a gzip header
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return nil;
+    }
+    NSMutableData* compressed = [NSMutableData dataWithLength:deflateBound(&stream, [data length])];
+    stream.next_in = (Bytef*)[data bytes];
+    stream.avail_in = (uInt)[data length];
+    stream.next_out = [compressed mutableBytes];
+    stream.avail_out = (uInt)[compressed length];
+    int status = deflate(&stream, Z_FINISH);
+    [compressed setLength:stream.total_out];
+    deflateEnd(&stream);
+    return (status == Z_STREAM_END) ? compressed : nil;
+}
+
+@interface CDVMetrics () {
+    BOOL _uploading;
+}
+@end
+
+@implementation CDVMetrics
+
+@synthesize uploadURL, uploadInterval;
+
++ (CDVMetrics*)sharedMetrics
+{
+    static CDVMetrics* sharedMetrics = nil;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        sharedMetrics = [[CDVMetrics alloc] init];
+    });
+    return sharedMetrics;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self != nil) {
+        self.uploadInterval = CDV_METRICS_DEFAULT_UPLOAD_INTERVAL;
+    }
+    return self;
+}
+
+// A copy of the used slots, so a snapshot and what is subtracted after its upload agree.
+- (NSData*)copySlots
+{
+    NSData* slots = nil;
+
+    pthread_mutex_lock(&gCDVMetricsLock);
+    CDVMetricsFile* file = CDVMetricsOpen();
+    if (file != NULL) {
+        slots = [NSData dataWithBytes:file->slots length:file->used * sizeof(struct CDVMetric)];
+    }
+    pthread_mutex_unlock(&gCDVMetricsLock);
+    return slots;
+}
+
+- (NSDictionary*)snapshotOfSlots:(NSData*)slots
+{
+    CDVMetricsFile* file = gCDVMetricsFile;
+    NSMutableDictionary* counters = [NSMutableDictionary dictionary];
+    NSMutableDictionary* histograms = [NSMutableDictionary dictionary];
+    const struct CDVMetric* metrics = [slots bytes];
+    NSUInteger count = [slots length] / sizeof(struct CDVMetric);
+
+    for (NSUInteger i = 0; i < count; ++i) {
+        const struct CDVMetric* metric = &metrics[i];
+        NSString* name = [NSString stringWithUTF8String:metric->name];
+        if (metric->type == CDVMetricTypeCounter) {
+            [counters setObject:[NSNumber numberWithLongLong:metric->count] forKey:name];
+            continue;
+        }
+
+        // only the buckets that hold values, as [lower bound, count]
+        NSMutableArray* buckets = [NSMutableArray array];
+        for (int b = 0; b < CDV_METRICS_BUCKETS; ++b) {
+            if (metric->buckets[b] != 0) {
+                [buckets addObject:[NSArray arrayWithObjects:
+                    [NSNumber numberWithLongLong:CDVMetricsBucketLowerBound(b)],
+                    [NSNumber numberWithLongLong:metric->buckets[b]], nil]];
+            }
+        }
+        [histograms setObject:[NSDictionary dictionaryWithObjectsAndKeys:
+            [NSNumber numberWithLongLong:metric->count], @"count",
+            [NSNumber numberWithLongLong:metric->sum], @"sum",
+            [NSNumber numberWithLongLong:metric->max], @"max",
+            [NSNumber numberWithLongLong:CDVMetricsPercentile(metric, 50)], @"p50",
+            [NSNumber numberWithLongLong:CDVMetricsPercentile(metric, 90)], @"p90",
+            [NSNumber numberWithLongLong:CDVMetricsPercentile(metric, 99)], @"p99",
+            buckets, @"buckets",
+            nil]
+                       forKey:name];
+    }
+
+    NSString* appVersion = [[[NSBundle mainBundle] infoDictionary] objectForKey:@"CFBundleShortVersionString"];
+    return [NSDictionary dictionaryWithObjectsAndKeys:
+        [NSString stringWithUTF8String:file->install], @"install",
+        [NSNumber numberWithDouble:file->since], @"since",
+        [[UIDevice currentDevice] model], @"model",
+        [[UIDevice currentDevice] systemVersion], @"systemVersion",
+        appVersion ? appVersion : @"", @"appVersion",
+        counters, @"counters",
+        histograms, @"histograms",
+        nil];
+}
+
+- (NSDictionary*)snapshot
+{
+    NSData* slots = [self copySlots];
+
+    return (slots != nil) ? [self snapshotOfSlots:slots] : nil;
+}
+
+// Takes the uploaded values off the live ones.
+- (void)subtractSlots:(NSData*)slots
+{
+    CDVMetricsFile* file = gCDVMetricsFile;
+    const struct CDVMetric* uploaded = [slots bytes];
+    NSUInteger count = [slots length] / sizeof(struct CDVMetric);
+
+    for (NSUInteger i = 0; i < count; ++i) {
+        struct CDVMetric* metric = &file->slots[i];
+        OSAtomicAdd64(-uploaded[i].count, &metric->count);
+        OSAtomicAdd64(-uploaded[i].sum, &metric->sum);
+        OSAtomicCompareAndSwap64(uploaded[i].max, 0, &metric->max);
+        for (int b = 0; b < CDV_METRICS_BUCKETS; ++b) {
+            if (uploaded[i].buckets[b] != 0) {
+                OSAtomicAdd64(-uploaded[i].buckets[b], &metric->buckets[b]);
+            }
+        }
+    }
+    file->since = file->lastUpload = [[NSDate date] timeIntervalSince1970];
+}
+
+- (void)sync
+{
+    if (gCDVMetricsFile != NULL) {
+        msync(gCDVMetricsFile, sizeof(CDVMetricsFile), MS_ASYNC);
+    }
+}
+
+- (void)uploadIfDue
+{
+    CDVMetricsFile* file = gCDVMetricsFile;
+
+    if ((self.uploadURL == nil) || (file == NULL) ||
+        ([[NSDate date] timeIntervalSince1970] - file->lastUpload < self.uploadInterval)) {
+        return;
+    }
+
+    UIApplication* application = [UIApplication sharedApplication];
+    __block UIBackgroundTaskIdentifier task = [application beginBackgroundTaskWithExpirationHandler:^{
+        [application endBackgroundTask:task];
+        task = UIBackgroundTaskInvalid;
+    }];
+    [self uploadWithCompletion:^(BOOL uploaded) {
+        if (task != UIBackgroundTaskInvalid) {
+            [application endBackgroundTask:task];
+            task = UIBackgroundTaskInvalid;
+        }
+    }];
+}
+
+- (void)uploadWithCompletion:(void (^)(BOOL uploaded))completion
+{
+    NSData* slots = [self copySlots];
+    NSData* body = nil;
+
+    if ((slots != nil) && (self.uploadURL != nil) && !_uploading) {
+        NSData* json = [NSJSONSerialization dataWithJSONObject:[self snapshotOfSlots:slots] options:0 error:nil];
+        body = (json != nil) ? CDVMetricsGzip(json) : nil;
+    }
+    if (body == nil) {
+        completion(NO);
+        return;
+    }
+
+    NSMutableURLRequest* request = [NSMutableURLRequest requestWithURL:self.uploadURL];
+    [request setHTTPMethod:@"POST"];
+    [request setValue:@"application/json" forHTTPHeaderField:@"Content-Type"];
+    [request setValue:@"gzip" forHTTPHeaderField:@"Content-Encoding"];
+    [request setHTTPBody:body];
+    [request setTimeoutInterval:30];
+
+    _uploading = YES;
+    [NSURLConnection sendAsynchronousRequest:request queue:[NSOperationQueue mainQueue] completionHandler:^(NSURLResponse* response, NSData* data, NSError* error) {
+        NSInteger status = [response isKindOfClass:[NSHTTPURLResponse class]] ? [(NSHTTPURLResponse*)response statusCode] : 0;
+        BOOL uploaded = (error == nil) && (status >= 200) && (status < 300);
+        if (uploaded) {
+            [self subtractSlots:slots];
+            [self sync];
+        } else {
+            NSLog(@"CDVMetrics: upload failed (%d), the values are kept for the next one", (int)status);
+        }
+        _uploading = NO;
+        completion(uploaded);
+    }];
+}
+
+@end
+
+@implementation CDVMetricsPlugin
+
+- (void)getSnapshot:(CDVInvokedUrlCommand*)command
+{
+    NSDictionary* snapshot = [[CDVMetrics sharedMetrics] snapshot];
+    CDVPluginResult* result = (snapshot != nil) ?
+        [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:snapshot] :
+        [CDVPluginResult resultWithStatus:CDVCommandStatus_IO_EXCEPTION messageAsString:@"metrics file unavailable"];
+
+    [self.commandDelegate sendPluginResult:result callbackId:command.callbackId];
+}
+
+- (void)upload:(CDVInvokedUrlCommand*)command
+{
+    NSString* callbackId = command.callbackId;
+
+    [[CDVMetrics sharedMetrics] uploadWithCompletion:^(BOOL uploaded) {
+        CDVPluginResult* result = uploaded ?
+            [CDVPluginResult resultWithStatus:CDVCommandStatus_OK] :
+            [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:@"not uploaded"];
+        [self.commandDelegate sendPluginResult:result callbackId:callbackId];
+    }];
+}
+
+@end
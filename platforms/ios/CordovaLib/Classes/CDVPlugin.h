@@ -39,7 +39,17 @@ extern NSString* const CDVLocalNotification;
 - (CDVPlugin*)initWithWebView:(UIWebView*)theWebView;
 - (void)pluginInitialize;
 
+// Override to return YES to have the plugin's commands executed in order on a serial background
+// queue of the plugin instead of the main thread. Same as <param name="background" value="true" />
+// in the plugin's feature in config.xml.
++ (BOOL)runsCommandsInBackground;
+
 - (void)handleOpenURL:(NSNotification*)notification;
+
+// The app delegate hands over the completion handler of a background NSURLSession here; the
+// plugin that owns the session takes it once the session has delivered all its events.
++ (void)setCompletionHandler:(void (^)(void))handler forBackgroundURLSession:(NSString*)identifier;
++ (void (^)(void))takeCompletionHandlerForBackgroundURLSession:(NSString*)identifier;
 - (void)onAppTerminate;
 - (void)onMemoryWarning;
 - (void)onReset;
@@ -24,6 +24,9 @@ NSString* const CDVPluginHandleOpenURLNotification = @"CDVPluginHandleOpenURLNot
 NSString* const CDVPluginResetNotification = @"CDVPluginResetNotification";
 NSString* const CDVLocalNotification = @"CDVLocalNotification";
 
+// Completion handlers of background NSURLSessions by their identifier.
+static NSMutableDictionary* gBackgroundURLSessionHandlers = nil;
+
 @interface CDVPlugin ()
 
 @property (readwrite, assign) BOOL hasPendingOperation;
@@ -53,6 +56,11 @@ NSString* const CDVLocalNotification = @"CDVLocalNotification";
     return self;
 }
 
++ (BOOL)runsCommandsInBackground
+{
+    return NO;
+}
+
 - (void)pluginInitialize
 {
     // You can listen to more app notifications, see:
@@ -100,6 +108,27 @@ NSString* const CDVLocalNotification = @"CDVLocalNotification";
     }
 }
 
++ (void)setCompletionHandler:(void (^)(void))handler forBackgroundURLSession:(NSString*)identifier
+{
+    @synchronized([CDVPlugin class]) {
+        if (gBackgroundURLSessionHandlers == nil) {
+            gBackgroundURLSessionHandlers = [[NSMutableDictionary alloc] init];
+        }
+        [gBackgroundURLSessionHandlers setObject:[handler copy] forKey:identifier];
+    }
+}
+
++ (void (^)(void))takeCompletionHandlerForBackgroundURLSession:(NSString*)identifier
+{
+    void (^ handler)(void) = nil;
+
+    @synchronized([CDVPlugin class]) {
+        handler = [gBackgroundURLSessionHandlers objectForKey:identifier];
+        [gBackgroundURLSessionHandlers removeObjectForKey:identifier];
+    }
+    return handler;
+}
+
 /* NOTE: calls into JavaScript must not call or trigger any blocking UI, like alerts */
 - (void)onAppTerminate
 {
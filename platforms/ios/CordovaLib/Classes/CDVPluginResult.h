@@ -51,6 +51,9 @@ typedef enum {
 + (CDVPluginResult*)resultWithStatus:(CDVCommandStatus)statusOrdinal messageAsDictionary:(NSDictionary*)theMessage;
 + (CDVPluginResult*)resultWithStatus:(CDVCommandStatus)statusOrdinal messageAsArrayBuffer:(NSData*)theMessage;
 + (CDVPluginResult*)resultWithStatus:(CDVCommandStatus)statusOrdinal messageAsMultipart:(NSArray*)theMessages;
+// Hands the data to JS as the URL of a one-shot blob served by CDVURLProtocol
+// rather than as base64, which is cheaper for images and other large payloads.
++ (CDVPluginResult*)resultWithStatus:(CDVCommandStatus)statusOrdinal messageAsBlob:(NSData*)theMessage mimeType:(NSString*)mimeType;
 + (CDVPluginResult*)resultWithStatus:(CDVCommandStatus)statusOrdinal messageToErrorObject:(int)errorCode;
 
 + (void)setVerbose:(BOOL)verbose;
@@ -59,6 +62,9 @@ typedef enum {
 - (void)setKeepCallbackAsBool:(BOOL)bKeepCallback;
 
 - (NSString*)argumentsAsJSON;
+// Appends the message as compact JSON to buffer, so callers can build a script without an
+// intermediate string. Returns NO if the message can't be serialized.
+- (BOOL)appendMessageJSONToBuffer:(NSMutableString*)buffer;
 
 // These methods are used by the legacy plugin return result method
 - (NSString*)toJSONString;
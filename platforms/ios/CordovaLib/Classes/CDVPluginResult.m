@@ -21,6 +21,7 @@
 #import "CDVJSON.h"
 #import "CDVDebug.h"
 #import "NSData+Base64.h"
+#import "CDVBlobStore.h"
 
 @interface CDVPluginResult ()
 
@@ -32,6 +33,10 @@
 @synthesize status, message, keepCallback, associatedObject;
 
 static NSArray* org_apache_cordova_CommandStatusMsgs;
+// Boxed once, so results don't allocate NSNumbers for their status and keepCallback.
+static NSArray* org_apache_cordova_CommandStatusNumbers;
+static NSNumber* org_apache_cordova_KeepCallbackYes;
+static NSNumber* org_apache_cordova_KeepCallbackNo;
 
 id messageFromArrayBuffer(NSData* data)
 {
@@ -41,6 +46,17 @@ id messageFromArrayBuffer(NSData* data)
     };
 }
 
+id messageFromBlob(NSData* data, NSString* mimeType)
+{
+    CDVBlobStore* store = [CDVBlobStore sharedStore];
+    NSString* token = [store addData:data mimeType:mimeType];
+
+    return @{
+               @"CDVType" : @"Blob",
+               @"url" :[store URLPathForToken:token]
+    };
+}
+
 id massageMessage(id message)
 {
     if ([message isKindOfClass:[NSData class]]) {
@@ -76,6 +92,14 @@ id messageFromMultipart(NSArray* theMessages)
         @"JSON error",
         @"Error",
         nil];
+
+    NSMutableArray* statusNumbers = [NSMutableArray arrayWithCapacity:[org_apache_cordova_CommandStatusMsgs count]];
+    for (int i = 0; i < (int)[org_apache_cordova_CommandStatusMsgs count]; ++i) {
+        [statusNumbers addObject:[NSNumber numberWithInt:i]];
+    }
+    org_apache_cordova_CommandStatusNumbers = [statusNumbers copy];
+    org_apache_cordova_KeepCallbackYes = [NSNumber numberWithBool:YES];
+    org_apache_cordova_KeepCallbackNo = [NSNumber numberWithBool:NO];
 }
 
 - (CDVPluginResult*)init
@@ -87,9 +111,10 @@ id messageFromMultipart(NSArray* theMessages)
 {
     self = [super init];
     if (self) {
-        status = [NSNumber numberWithInt:statusOrdinal];
+        status = ((NSUInteger)statusOrdinal < [org_apache_cordova_CommandStatusNumbers count]) ?
+            [org_apache_cordova_CommandStatusNumbers objectAtIndex:statusOrdinal] : [NSNumber numberWithInt:statusOrdinal];
         message = theMessage;
-        keepCallback = [NSNumber numberWithBool:NO];
+        keepCallback = org_apache_cordova_KeepCallbackNo;
     }
     return self;
 }
@@ -139,6 +164,11 @@ id messageFromMultipart(NSArray* theMessages)
     return [[self alloc] initWithStatus:statusOrdinal message:messageFromMultipart(theMessages)];
 }
 
++ (CDVPluginResult*)resultWithStatus:(CDVCommandStatus)statusOrdinal messageAsBlob:(NSData*)theMessage mimeType:(NSString*)mimeType
+{
+    return [[self alloc] initWithStatus:statusOrdinal message:messageFromBlob(theMessage, mimeType)];
+}
+
 + (CDVPluginResult*)resultWithStatus:(CDVCommandStatus)statusOrdinal messageToErrorObject:(int)errorCode
 {
     NSDictionary* errDict = @{@"code" :[NSNumber numberWithInt:errorCode]};
@@ -148,41 +178,66 @@ id messageFromMultipart(NSArray* theMessages)
 
 - (void)setKeepCallbackAsBool:(BOOL)bKeepCallback
 {
-    [self setKeepCallback:[NSNumber numberWithBool:bKeepCallback]];
+    [self setKeepCallback:bKeepCallback ? org_apache_cordova_KeepCallbackYes : org_apache_cordova_KeepCallbackNo];
+}
+
+// Writes the message as compact JSON onto the end of buffer.
+- (BOOL)appendMessageJSONToBuffer:(NSMutableString*)buffer
+{
+    if (!CDVJSONAppendObject(buffer, self.message)) {
+        NSLog(@"CDVPluginResult: message of class %@ cannot be serialized to JSON", [self.message class]);
+        return NO;
+    }
+    return YES;
 }
 
 - (NSString*)argumentsAsJSON
 {
-    id arguments = (self.message == nil ? [NSNull null] : self.message);
-    NSArray* argumentsWrappedInArray = [NSArray arrayWithObject:arguments];
+    NSMutableString* buffer = [NSMutableString stringWithCapacity:64];
 
-    NSString* argumentsJSON = [argumentsWrappedInArray JSONString];
+    if (![self appendMessageJSONToBuffer:buffer]) {
+        return nil;
+    }
+    return buffer;
+}
 
-    argumentsJSON = [argumentsJSON substringWithRange:NSMakeRange(1, [argumentsJSON length] - 2)];
+- (BOOL)appendJSONToBuffer:(NSMutableString*)buffer
+{
+    [buffer appendString:@"{\"status\":"];
+    [buffer appendString:[self.status stringValue]];
+    [buffer appendString:@",\"message\":"];
+    if (![self appendMessageJSONToBuffer:buffer]) {
+        return NO;
+    }
+    if (self.keepCallback != nil) {
+        [buffer appendString:[self.keepCallback boolValue] ? @",\"keepCallback\":true}" : @",\"keepCallback\":false}"];
+    } else {
+        [buffer appendString:@"}"];
+    }
+    return YES;
+}
 
-    return argumentsJSON;
+// Builds "<function>('<callbackId>',<result JSON>);" in a single buffer.
+- (NSString*)callbackStringWithFunction:(NSString*)function callbackId:(NSString*)callbackId
+{
+    NSMutableString* buffer = [NSMutableString stringWithCapacity:[function length] + [callbackId length] + 96];
+
+    [buffer appendString:function];
+    [buffer appendString:@"('"];
+    [buffer appendString:callbackId];
+    [buffer appendString:@"',"];
+    if (![self appendJSONToBuffer:buffer]) {
+        [buffer appendString:@"null"];
+    }
+    [buffer appendString:@");"];
+    return buffer;
 }
 
 // These methods are used by the legacy plugin return result method
 - (NSString*)toJSONString
 {
-    NSDictionary* dict = [NSDictionary dictionaryWithObjectsAndKeys:
-        self.status, @"status",
-        self.message ? self.                                message:[NSNull null], @"message",
-        self.keepCallback, @"keepCallback",
-        nil];
-
-    NSError* error = nil;
-    NSData* jsonData = [NSJSONSerialization dataWithJSONObject:dict
-                                                       options:NSJSONWritingPrettyPrinted
-                                                         error:&error];
-    NSString* resultString = nil;
-
-    if (error != nil) {
-        NSLog(@"toJSONString error: %@", [error localizedDescription]);
-    } else {
-        resultString = [[NSString alloc] initWithData:jsonData encoding:NSUTF8StringEncoding];
-    }
+    NSMutableString* buffer = [NSMutableString stringWithCapacity:96];
+    NSString* resultString = [self appendJSONToBuffer:buffer] ? buffer : nil;
 
     if ([[self class] isVerbose]) {
         NSLog(@"PluginResult:toJSONString - %@", resultString);
@@ -192,7 +247,7 @@ id messageFromMultipart(NSArray* theMessages)
 
 - (NSString*)toSuccessCallbackString:(NSString*)callbackId
 {
-    NSString* successCB = [NSString stringWithFormat:@"cordova.callbackSuccess('%@',%@);", callbackId, [self toJSONString]];
+    NSString* successCB = [self callbackStringWithFunction:@"cordova.callbackSuccess" callbackId:callbackId];
 
     if ([[self class] isVerbose]) {
         NSLog(@"PluginResult toSuccessCallbackString: %@", successCB);
@@ -202,7 +257,7 @@ id messageFromMultipart(NSArray* theMessages)
 
 - (NSString*)toErrorCallbackString:(NSString*)callbackId
 {
-    NSString* errorCB = [NSString stringWithFormat:@"cordova.callbackError('%@',%@);", callbackId, [self toJSONString]];
+    NSString* errorCB = [self callbackStringWithFunction:@"cordova.callbackError" callbackId:callbackId];
 
     if ([[self class] isVerbose]) {
         NSLog(@"PluginResult toErrorCallbackString: %@", errorCB);
@@ -0,0 +1,52 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import <Foundation/Foundation.h>
+#import "CDVPlugin.h"
+
+// Records how long each step of bringing up a CDVViewController takes:
+// config.xml parsing, whitelist construction, each plugin's creation and the
+// WebView's first page load. Times are in milliseconds, measured from the
+// moment the profile was created. Plugins marked onload are created once the
+// first page load has finished or failed, each as a stage named after its
+// class within the "onloadPlugins" stage.
+@interface CDVStartupProfile : NSObject
+
+- (void)beginStage:(NSString*)name;
+- (void)endStage:(NSString*)name;
+// Records a stage that began when the profile was created and ends now,
+// for milestones such as the page's deviceready.
+- (void)markStage:(NSString*)name;
+
+// Returns { "sinceProcessStart": <ms from process launch to profile creation>,
+//           "stages": [ { "name", "start", "duration" }, ... ] }
+// with stages in the order they finished.
+- (NSDictionary*)profile;
+
+@end
+
+// Exposes the controller's startup profile to JS:
+//   cordova.exec(win, fail, "StartupProfile", "getStartupProfile", []);
+//   cordova.exec(win, fail, "StartupProfile", "mark", ["deviceready"]);
+@interface CDVStartupProfilePlugin : CDVPlugin
+
+- (void)getStartupProfile:(CDVInvokedUrlCommand*)command;
+- (void)mark:(CDVInvokedUrlCommand*)command;
+
+@end
@@ -0,0 +1,133 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import "CDVStartupProfile.h"
+#import "CDVViewController.h"
+#include <sys/sysctl.h>
+#include <unistd.h>
+
+@interface CDVStartupProfile () {
+    CFAbsoluteTime _created;
+    double _sinceProcessStart;
+    NSMutableDictionary* _openStages;
+    NSMutableArray* _stages;
+}
+@end
+
+@implementation CDVStartupProfile
+
+// Returns the time since the kernel started this process, in milliseconds,
+// or -1 if it can't be determined.
+static double CDVMillisecondsSinceProcessStart(void)
+{
+    struct kinfo_proc info;
+    size_t size = sizeof(info);
+    int mib[4] = {CTL_KERN, KERN_PROC, KERN_PROC_PID, getpid()};
+
+    if ((sysctl(mib, 4, &info, &size, NULL, 0) != 0) || (size == 0)) {
+        return -1;
+    }
+
+    struct timeval started = info.kp_proc.p_starttime;
+    NSTimeInterval startedSince1970 = started.tv_sec + started.tv_usec / 1000000.0;
+    return ([[NSDate date] timeIntervalSince1970] - startedSince1970) * 1000.0;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self != nil) {
+        _created = CFAbsoluteTimeGetCurrent();
+        _sinceProcessStart = CDVMillisecondsSinceProcessStart();
+        _openStages = [[NSMutableDictionary alloc] initWithCapacity:4];
+        _stages = [[NSMutableArray alloc] initWithCapacity:16];
+    }
+    return self;
+}
+
+- (void)beginStage:(NSString*)name
+{
+    @synchronized(self) {
+        [_openStages setObject:[NSNumber numberWithDouble:CFAbsoluteTimeGetCurrent()] forKey:name];
+    }
+}
+
+- (void)endStage:(NSString*)name
+{
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+
+    @synchronized(self) {
+        NSNumber* began = [_openStages objectForKey:name];
+        if (began == nil) {
+            return;
+        }
+        [_openStages removeObjectForKey:name];
+        [_stages addObject:@{
+             @"name" : name,
+             @"start" : [NSNumber numberWithDouble:([began doubleValue] - _created) * 1000.0],
+             @"duration" : [NSNumber numberWithDouble:(now - [began doubleValue]) * 1000.0]
+         }];
+    }
+}
+
+- (void)markStage:(NSString*)name
+{
+    @synchronized(self) {
+        [_openStages setObject:[NSNumber numberWithDouble:_created] forKey:name];
+    }
+    [self endStage:name];
+}
+
+- (NSDictionary*)profile
+{
+    @synchronized(self) {
+        return @{
+                   @"sinceProcessStart" : [NSNumber numberWithDouble:_sinceProcessStart],
+                   @"stages" : [_stages copy]
+        };
+    }
+}
+
+@end
+
+@implementation CDVStartupProfilePlugin
+
+- (void)getStartupProfile:(CDVInvokedUrlCommand*)command
+{
+    NSDictionary* profile = [((CDVViewController*)self.viewController).startupProfile profile];
+    CDVPluginResult* result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:profile];
+
+    [self.commandDelegate sendPluginResult:result callbackId:command.callbackId];
+}
+
+- (void)mark:(CDVInvokedUrlCommand*)command
+{
+    NSString* name = [command.arguments objectAtIndex:0];
+    CDVPluginResult* result;
+
+    if ([name isKindOfClass:[NSString class]]) {
+        [((CDVViewController*)self.viewController).startupProfile markStage:name];
+        result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+    } else {
+        result = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:@"stage name expected"];
+    }
+    [self.commandDelegate sendPluginResult:result callbackId:command.callbackId];
+}
+
+@end
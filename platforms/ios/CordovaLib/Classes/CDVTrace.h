@@ -0,0 +1,95 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import <Foundation/Foundation.h>
+#include <mach/mach_time.h>
+#import "CDVPlugin.h"
+
+// Spans on the hot paths of the bridge and the plugins, exported in the
+// Chrome trace event format for chrome://tracing or Perfetto.
+//
+// Each thread writes its spans into a buffer of its own, without locks, that
+// keeps its last 4096 spans. While tracing is off a span costs one load and a
+// branch. Names and details must be string literals or other strings that
+// live forever, such as the result of sel_getName; they are not copied.
+//
+//   - (void)work
+//   {
+//       CDV_TRACE_SCOPE("MyPlugin work");
+//       ...  // the span ends when the scope is left, by any return
+//   }
+
+extern volatile int32_t gCDVTraceEnabled;
+
+typedef struct {
+    const char* name;
+    const char* detail;
+    uint64_t start;
+} CDVTraceScope;
+
+// Records a span that started at start (mach_absolute_time) and ends now.
+void CDVTraceRecord(const char* name, const char* detail, uint64_t start);
+
+static inline CDVTraceScope CDVTraceScopeBegin(const char* name, const char* detail)
+{
+    CDVTraceScope scope = {name, detail, gCDVTraceEnabled ? mach_absolute_time() : 0};
+
+    return scope;
+}
+
+static inline void CDVTraceScopeEnd(CDVTraceScope* scope)
+{
+    if (scope->start != 0) {
+        CDVTraceRecord(scope->name, scope->detail, scope->start);
+    }
+}
+
+// A span from here to the end of the enclosing scope. detail is shown as the
+// span's argument, or NULL.
+#define CDV_TRACE_DETAIL_SCOPE(name, detail) \
+    CDVTraceScope _cdvTraceScope __attribute__((cleanup(CDVTraceScopeEnd), unused)) = CDVTraceScopeBegin(name, detail)
+#define CDV_TRACE_SCOPE(name) CDV_TRACE_DETAIL_SCOPE(name, NULL)
+
+@interface CDVTrace : NSObject
+
+// Tracing is off until enabled here or with the TraceEnabled preference.
++ (void)setEnabled:(BOOL)enabled;
++ (BOOL)isEnabled;
+
+// Drops the spans recorded so far.
++ (void)clear;
+
+// The spans of all threads as a Chrome trace: { "traceEvents": [...] }.
++ (NSData*)chromeTraceJSON;
+
+@end
+
+// Controls tracing from JS:
+//   cordova.exec(win, fail, "Trace", "start", [clear]);
+//   cordova.exec(win, fail, "Trace", "stop", []);
+//   cordova.exec(win, fail, "Trace", "dump", []);
+// dump writes the trace to a file in the temp directory and returns its file
+// URL; copy it off the device with Xcode's container download.
+@interface CDVTracePlugin : CDVPlugin
+
+- (void)start:(CDVInvokedUrlCommand*)command;
+- (void)stop:(CDVInvokedUrlCommand*)command;
+- (void)dump:(CDVInvokedUrlCommand*)command;
+
+@end
@@ -0,0 +1,207 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import "CDVTrace.h"
+#include <libkern/OSAtomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// Spans kept per thread, the oldest are overwritten.
+#define CDV_TRACE_BUFFER_SPANS 4096
+
+typedef struct {
+    const char* name;
+    const char* detail;
+    uint64_t start;
+    uint64_t end;
+} CDVTraceSpan;
+
+// Written only by its thread. count is published after the span it counts,
+// so a reader sees complete spans up to count.
+typedef struct CDVTraceBuffer {
+    struct CDVTraceBuffer* next;
+    uint32_t thread;
+    char threadName[64];
+    volatile int64_t count;
+    CDVTraceSpan spans[CDV_TRACE_BUFFER_SPANS];
+} CDVTraceBuffer;
+
+volatile int32_t gCDVTraceEnabled = 0;
+
+// Buffers are never freed, so a dump still has the spans of threads that ended.
+static CDVTraceBuffer* volatile gCDVTraceBuffers = NULL;
+static pthread_key_t gCDVTraceBufferKey;
+static pthread_once_t gCDVTraceOnce = PTHREAD_ONCE_INIT;
+// Spans that started before this were cleared.
+static volatile uint64_t gCDVTraceEpoch = 0;
+
+static void CDVTraceInitialize(void)
+{
+    pthread_key_create(&gCDVTraceBufferKey, NULL);
+}
+
+static CDVTraceBuffer* CDVTraceBufferForCurrentThread(void)
+{
+    CDVTraceBuffer* buffer = pthread_getspecific(gCDVTraceBufferKey);
+
+    if (buffer != NULL) {
+        return buffer;
+    }
+
+    buffer = calloc(1, sizeof(CDVTraceBuffer));
+    if (buffer == NULL) {
+        return NULL;
+    }
+    buffer->thread = pthread_mach_thread_np(pthread_self());
+    if (pthread_main_np()) {
+        strlcpy(buffer->threadName, "main", sizeof(buffer->threadName));
+    } else {
+        pthread_getname_np(pthread_self(), buffer->threadName, sizeof(buffer->threadName));
+    }
+    pthread_setspecific(gCDVTraceBufferKey, buffer);
+
+    CDVTraceBuffer* head;
+    do {
+        head = gCDVTraceBuffers;
+        buffer->next = head;
+    } while (!OSAtomicCompareAndSwapPtrBarrier(head, buffer, (void* volatile*)&gCDVTraceBuffers));
+    return buffer;
+}
+
+void CDVTraceRecord(const char* name, const char* detail, uint64_t start)
+{
+    uint64_t end = mach_absolute_time();
+    CDVTraceBuffer* buffer = CDVTraceBufferForCurrentThread();
+
+    if (buffer == NULL) {
+        return;
+    }
+
+    int64_t count = buffer->count;
+    CDVTraceSpan* span = &buffer->spans[count % CDV_TRACE_BUFFER_SPANS];
+    span->name = name;
+    span->detail = detail;
+    span->start = start;
+    span->end = end;
+    OSMemoryBarrier();
+    buffer->count = count + 1;
+}
+
+@implementation CDVTrace
+
++ (void)setEnabled:(BOOL)enabled
+{
+    // The key must exist before the first span can be recorded.
+    pthread_once(&gCDVTraceOnce, CDVTraceInitialize);
+    OSMemoryBarrier();
+    gCDVTraceEnabled = enabled ? 1 : 0;
+}
+
++ (BOOL)isEnabled
+{
+    return gCDVTraceEnabled != 0;
+}
+
++ (void)clear
+{
+    gCDVTraceEpoch = mach_absolute_time();
+    OSMemoryBarrier();
+}
+
++ (NSData*)chromeTraceJSON
+{
+    mach_timebase_info_data_t timebase;
+
+    mach_timebase_info(&timebase);
+    double microsecondsPerTick = (double)timebase.numer / timebase.denom / 1000.0;
+    int pid = getpid();
+    uint64_t epoch = gCDVTraceEpoch;
+
+    NSMutableString* json = [NSMutableString stringWithCapacity:64 * 1024];
+    [json appendString:@"{\"displayTimeUnit\":\"ms\",\"traceEvents\":["];
+    BOOL first = YES;
+
+    for (CDVTraceBuffer* buffer = gCDVTraceBuffers; buffer != NULL; buffer = buffer->next) {
+        [json appendFormat:@"%@{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+            first ? @"" : @",", pid, buffer->thread, buffer->threadName[0] != '\0' ? buffer->threadName : "thread"];
+        first = NO;
+
+        int64_t count = buffer->count;
+        OSMemoryBarrier();
+        for (int64_t i = MAX(0, count - CDV_TRACE_BUFFER_SPANS); i < count; ++i) {
+            CDVTraceSpan span = buffer->spans[i % CDV_TRACE_BUFFER_SPANS];
+            OSMemoryBarrier();
+            // skip spans the thread overwrote while they were copied
+            if (buffer->count - CDV_TRACE_BUFFER_SPANS > i) {
+                continue;
+            }
+            if (span.start < epoch) {
+                continue;
+            }
+            [json appendFormat:@",{\"name\":\"%s\",\"cat\":\"cordova\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u",
+                span.name, span.start * microsecondsPerTick, (span.end - span.start) * microsecondsPerTick, pid, buffer->thread];
+            if (span.detail != NULL) {
+                [json appendFormat:@",\"args\":{\"detail\":\"%s\"}", span.detail];
+            }
+            [json appendString:@"}"];
+        }
+    }
+    [json appendString:@"]}"];
+    return [json dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+@end
+
+@implementation CDVTracePlugin
+
+- (void)start:(CDVInvokedUrlCommand*)command
+{
+    if ([[command argumentAtIndex:0 withDefault:nil andClass:[NSNumber class]] boolValue]) {
+        [CDVTrace clear];
+    }
+    [CDVTrace setEnabled:YES];
+    [self.commandDelegate sendPluginResult:[CDVPluginResult resultWithStatus:CDVCommandStatus_OK] callbackId:command.callbackId];
+}
+
+- (void)stop:(CDVInvokedUrlCommand*)command
+{
+    [CDVTrace setEnabled:NO];
+    [self.commandDelegate sendPluginResult:[CDVPluginResult resultWithStatus:CDVCommandStatus_OK] callbackId:command.callbackId];
+}
+
+- (void)dump:(CDVInvokedUrlCommand*)command
+{
+    NSString* callbackId = command.callbackId;
+
+    [self.commandDelegate runInBackground:^{
+        NSString* name = [NSString stringWithFormat:@"cordova-trace-%.0f.json", [[NSDate date] timeIntervalSince1970]];
+        NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:name];
+        NSError* error = nil;
+        CDVPluginResult* result;
+
+        if ([[CDVTrace chromeTraceJSON] writeToFile:path options:NSDataWritingAtomic error:&error]) {
+            result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsString:[[NSURL fileURLWithPath:path] absoluteString]];
+        } else {
+            result = [CDVPluginResult resultWithStatus:CDVCommandStatus_IO_EXCEPTION messageAsString:[error localizedDescription]];
+        }
+        [self.commandDelegate sendPluginResult:result callbackId:callbackId];
+    }];
+}
+
+@end
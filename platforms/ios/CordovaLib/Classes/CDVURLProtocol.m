@@ -21,21 +21,176 @@
 #import <AssetsLibrary/ALAssetRepresentation.h>
 #import <AssetsLibrary/ALAssetsLibrary.h>
 #import <MobileCoreServices/MobileCoreServices.h>
+#import <ImageIO/ImageIO.h>
 #import "CDVURLProtocol.h"
 #import "CDVCommandQueue.h"
 #import "CDVWhitelist.h"
 #import "CDVViewController.h"
+#import "CDVBlobStore.h"
+#import "CDVTrace.h"
 
 @interface CDVHTTPURLResponse : NSHTTPURLResponse
 @property (nonatomic) NSInteger statusCode;
 @end
 
+@interface CDVURLProtocol ()
+// Set by stopLoading, which runs on another thread than the asset callbacks.
+@property (atomic) BOOL stopped;
+@end
+
 static CDVWhitelist* gWhitelist = nil;
 // Contains a set of NSNumbers of addresses of controllers. It doesn't store
 // the actual pointer to avoid retaining.
 static NSMutableSet* gRegisteredControllers = nil;
 
 NSString* const kCDVAssetsLibraryPrefixs = @"assets-library://";
+static NSString* const kCDVBlobUploadPath = @"/!gap_blob";
+static NSString* const kCDVAppConfigPath = @"/!gap_config.js";
+// Query parameter asking for a scaled down asset, e.g. assets-library://asset/asset.JPG?id=...&ext=JPG&thumb=160x120
+static NSString* const kCDVAssetsLibraryThumbParameter = @"thumb";
+// Assets are sent in chunks of this size rather than read into memory whole.
+static const NSUInteger kCDVAssetChunkSize = 256 * 1024;
+static const CGFloat kCDVAssetThumbnailQuality = 0.8;
+// The script that defines window.appConfig, built from the first controller's config.
+static NSData* gAppConfigScript = nil;
+// The start page of the first controller if it's not a local file, its origin may load the config too.
+static NSURL* gAppConfigOrigin = nil;
+
+// Returns the token of a blob download request, or nil if it's not one.
+static NSString* blobTokenForURL(NSURL* url)
+{
+    NSString* path = [url path];
+
+    if (![path hasPrefix:kCDVBlobPathPrefix]) {
+        return nil;
+    }
+    return [path substringFromIndex:[kCDVBlobPathPrefix length]];
+}
+
+static BOOL isBlobUploadRequest(NSURLRequest* request)
+{
+    return [[request HTTPMethod] isEqualToString:@"POST"] &&
+           [[[request URL] path] isEqualToString:kCDVBlobUploadPath];
+}
+
+// UIWebView sometimes hands the POST body over as a stream rather than as data.
+static NSData* bodyForRequest(NSURLRequest* request)
+{
+    NSData* body = [request HTTPBody];
+    NSInputStream* stream = [request HTTPBodyStream];
+
+    if ((body != nil) || (stream == nil)) {
+        return body;
+    }
+
+    NSMutableData* data = [NSMutableData data];
+    uint8_t buffer[16384];
+    [stream open];
+    while (YES) {
+        NSInteger count = [stream read:buffer maxLength:sizeof(buffer)];
+        if (count <= 0) {
+            break;
+        }
+        [data appendBytes:buffer length:count];
+    }
+    [stream close];
+    return data;
+}
+
+// Whether the request is for the app config script. It holds API keys, so it's only served to
+// local pages and to the origin of a remote start page, never to other pages in the web view.
+static BOOL isAppConfigRequest(NSURL* url)
+{
+    if ((gAppConfigScript == nil) || ![[url path] isEqualToString:kCDVAppConfigPath]) {
+        return NO;
+    }
+    if ([url isFileURL]) {
+        return YES;
+    }
+    if ((gAppConfigOrigin == nil) || ![gWhitelist URLIsAllowed:url]) {
+        return NO;
+    }
+    return [[[url scheme] lowercaseString] isEqualToString:[[gAppConfigOrigin scheme] lowercaseString]] &&
+           [[[url host] lowercaseString] isEqualToString:[[gAppConfigOrigin host] lowercaseString]] &&
+           (([url port] == [gAppConfigOrigin port]) || [[url port] isEqualToNumber:[gAppConfigOrigin port]]);
+}
+
+// Returns the URL without its thumb parameter, setting the requested size, or nil if
+// the URL has no valid thumb parameter.
+static NSURL* assetURLForThumbnailURL(NSURL* url, CGSize* size)
+{
+    NSString* query = [url query];
+
+    if (query == nil) {
+        return nil;
+    }
+    NSMutableArray* parameters = [NSMutableArray array];
+    NSString* thumb = nil;
+    for (NSString* parameter in [query componentsSeparatedByString:@"&"]) {
+        if ([parameter hasPrefix:[kCDVAssetsLibraryThumbParameter stringByAppendingString:@"="]]) {
+            thumb = [parameter substringFromIndex:[kCDVAssetsLibraryThumbParameter length] + 1];
+        } else {
+            [parameters addObject:parameter];
+        }
+    }
+
+    NSArray* dimensions = [[thumb lowercaseString] componentsSeparatedByString:@"x"];
+    if ([dimensions count] != 2) {
+        return nil;
+    }
+    *size = CGSizeMake([[dimensions objectAtIndex:0] floatValue], [[dimensions objectAtIndex:1] floatValue]);
+    if ((size->width <= 0) || (size->height <= 0)) {
+        return nil;
+    }
+
+    NSString* absolute = [url absoluteString];
+    NSRange queryRange = [absolute rangeOfString:@"?"];
+    NSString* base = [absolute substringToIndex:queryRange.location];
+    if ([parameters count] > 0) {
+        base = [base stringByAppendingFormat:@"?%@", [parameters componentsJoinedByString:@"&"]];
+    }
+    return [NSURL URLWithString:base];
+}
+
+// JPEG data of the asset scaled to fit into size. The aspect ratio thumbnail is
+// drawn scaled down when it's large enough, otherwise ImageIO decodes a scaled
+// down image from the representation without loading the full image.
+static NSData* thumbnailDataForAsset(ALAsset* asset, CGSize size)
+{
+    CGImageRef thumbnail = [asset aspectRatioThumbnail];
+
+    if (thumbnail == NULL) {
+        return nil;
+    }
+    CGFloat width = CGImageGetWidth(thumbnail);
+    CGFloat height = CGImageGetHeight(thumbnail);
+    CGFloat scale = MIN(size.width / width, size.height / height);
+
+    UIImage* image = nil;
+    if (scale < 1) {
+        // the thumbnail is larger than the box, draw it scaled down to fit
+        CGSize fitted = CGSizeMake(MAX(floorf(width * scale), 1), MAX(floorf(height * scale), 1));
+        UIGraphicsBeginImageContextWithOptions(fitted, YES, 1.0);
+        [[UIImage imageWithCGImage:thumbnail] drawInRect:CGRectMake(0, 0, fitted.width, fitted.height)];
+        image = UIGraphicsGetImageFromCurrentImageContext();
+        UIGraphicsEndImageContext();
+    } else if (scale == 1) {
+        image = [UIImage imageWithCGImage:thumbnail];
+    } else {
+        // the thumbnail has the aspect ratio of the original, so it tells the longer side when fit into size
+        NSDictionary* options = [NSDictionary dictionaryWithObjectsAndKeys:
+            (id)kCFBooleanTrue, (id)kCGImageSourceCreateThumbnailFromImageAlways,
+            (id)kCFBooleanTrue, (id)kCGImageSourceCreateThumbnailWithTransform,
+            [NSNumber numberWithFloat:floorf(MAX(width, height) * scale)], (id)kCGImageSourceThumbnailMaxPixelSize,
+            nil];
+        CGImageRef scaled = [[asset defaultRepresentation] CGImageWithOptions:options];
+        if (scaled == NULL) {
+            return nil;
+        }
+        image = [UIImage imageWithCGImage:scaled];
+    }
+    return UIImageJPEGRepresentation(image, kCDVAssetThumbnailQuality);
+}
 
 // Returns the registered view controller that sent the given request.
 // If the user-agent is not from a UIWebView, or if it's from an unregistered one,
@@ -91,6 +246,16 @@ static CDVViewController *viewControllerForRequest(NSURLRequest* request)
         if (gWhitelist == nil) {
             NSLog(@"WARNING: NO whitelist has been set in CDVURLProtocol.");
         }
+
+        NSDictionary* appConfig = viewController.appConfig;
+        NSData* json = (appConfig != nil) ? [NSJSONSerialization dataWithJSONObject:appConfig options:0 error:nil] : nil;
+        NSMutableData* script = [NSMutableData dataWithData:[@"window.appConfig = " dataUsingEncoding:NSUTF8StringEncoding]];
+        [script appendData:(json != nil) ? json : [@"null" dataUsingEncoding:NSUTF8StringEncoding]];
+        [script appendData:[@";" dataUsingEncoding:NSUTF8StringEncoding]];
+        gAppConfigScript = script;
+        if ([viewController.startPage rangeOfString:@"://"].location != NSNotFound) {
+            gAppConfigOrigin = [NSURL URLWithString:viewController.startPage];
+        }
     }
 
     @synchronized(gRegisteredControllers) {
@@ -107,12 +272,21 @@ static CDVViewController *viewControllerForRequest(NSURLRequest* request)
 
 + (BOOL)canInitWithRequest:(NSURLRequest*)theRequest
 {
+    CDV_TRACE_SCOPE("CDVURLProtocol canInitWithRequest");
     NSURL* theUrl = [theRequest URL];
     CDVViewController* viewController = viewControllerForRequest(theRequest);
 
     if ([[theUrl absoluteString] hasPrefix:kCDVAssetsLibraryPrefixs]) {
         return YES;
+    } else if ([[CDVBlobStore sharedStore] hasDataForToken:blobTokenForURL(theUrl)]) {
+        return YES;
+    } else if (isAppConfigRequest(theUrl)) {
+        // file: requests carry no User-Agent, so this is served without knowing the controller
+        return YES;
     } else if (viewController != nil) {
+        if (isBlobUploadRequest(theRequest)) {
+            return YES;
+        }
         if ([[theUrl path] isEqualToString:@"/!gap_exec"]) {
             NSString* queuedCommandsJSON = [theRequest valueForHTTPHeaderField:@"cmds"];
             NSString* requestId = [theRequest valueForHTTPHeaderField:@"rc"];
@@ -159,19 +333,39 @@ static CDVViewController *viewControllerForRequest(NSURLRequest* request)
     if ([[url path] isEqualToString:@"/!gap_exec"]) {
         [self sendResponseWithResponseCode:200 data:nil mimeType:nil];
         return;
+    } else if (isBlobUploadRequest([self request])) {
+        NSString* token = [[CDVBlobStore sharedStore] addData:bodyForRequest([self request]) mimeType:nil];
+        [self sendResponseWithResponseCode:200 data:[token dataUsingEncoding:NSUTF8StringEncoding] mimeType:nil];
+        return;
+    } else if (isAppConfigRequest(url)) {
+        [self sendResponseWithResponseCode:200 data:gAppConfigScript mimeType:@"text/javascript"];
+        return;
+    } else if (blobTokenForURL(url) != nil) {
+        NSString* mimeType = nil;
+        NSData* data = [[CDVBlobStore sharedStore] takeDataForToken:blobTokenForURL(url) mimeType:&mimeType];
+        if (data != nil) {
+            [self sendResponseWithResponseCode:200 data:data mimeType:mimeType];
+        } else {
+            [self sendResponseWithResponseCode:404 data:nil mimeType:nil];
+        }
+        return;
     } else if ([[url absoluteString] hasPrefix:kCDVAssetsLibraryPrefixs]) {
+        CGSize thumbnailSize = CGSizeZero;
+        NSURL* assetURL = assetURLForThumbnailURL(url, &thumbnailSize);
         ALAssetsLibraryAssetForURLResultBlock resultBlock = ^(ALAsset* asset) {
-            if (asset) {
-                // We have the asset!  Get the data and send it along.
-                ALAssetRepresentation* assetRepresentation = [asset defaultRepresentation];
-                NSString* MIMEType = (__bridge_transfer NSString*)UTTypeCopyPreferredTagWithClass((__bridge CFStringRef)[assetRepresentation UTI], kUTTagClassMIMEType);
-                Byte* buffer = (Byte*)malloc([assetRepresentation size]);
-                NSUInteger bufferSize = [assetRepresentation getBytes:buffer fromOffset:0.0 length:[assetRepresentation size] error:nil];
-                NSData* data = [NSData dataWithBytesNoCopy:buffer length:bufferSize freeWhenDone:YES];
-                [self sendResponseWithResponseCode:200 data:data mimeType:MIMEType];
-            } else {
+            if (asset == nil) {
                 // Retrieving the asset failed for some reason.  Send an error.
                 [self sendResponseWithResponseCode:404 data:nil mimeType:nil];
+            } else if (assetURL != nil) {
+                NSData* data = thumbnailDataForAsset(asset, thumbnailSize);
+                if (data != nil) {
+                    [self sendResponseWithResponseCode:200 data:data mimeType:@"image/jpeg"];
+                } else {
+                    [self sendResponseWithResponseCode:415 data:nil mimeType:nil];
+                }
+            } else {
+                // We have the asset!  Send it along without holding all of it in memory.
+                [self sendResponseWithAssetRepresentation:[asset defaultRepresentation]];
             }
         };
         ALAssetsLibraryAccessFailureBlock failureBlock = ^(NSError* error) {
@@ -180,7 +374,7 @@ static CDVViewController *viewControllerForRequest(NSURLRequest* request)
         };
 
         ALAssetsLibrary* assetsLibrary = [[ALAssetsLibrary alloc] init];
-        [assetsLibrary assetForURL:url resultBlock:resultBlock failureBlock:failureBlock];
+        [assetsLibrary assetForURL:(assetURL ? assetURL : url) resultBlock:resultBlock failureBlock:failureBlock];
         return;
     }
 
@@ -191,6 +385,7 @@ static CDVViewController *viewControllerForRequest(NSURLRequest* request)
 - (void)stopLoading
 {
     // do any cleanup here
+    self.stopped = YES;
 }
 
 + (BOOL)requestIsCacheEquivalent:(NSURLRequest*)requestA toRequest:(NSURLRequest*)requestB
@@ -218,6 +413,43 @@ static CDVViewController *viewControllerForRequest(NSURLRequest* request)
     [[self client] URLProtocolDidFinishLoading:self];
 }
 
+- (void)sendResponseWithAssetRepresentation:(ALAssetRepresentation*)assetRepresentation
+{
+    NSString* MIMEType = (__bridge_transfer NSString*)UTTypeCopyPreferredTagWithClass((__bridge CFStringRef)[assetRepresentation UTI], kUTTagClassMIMEType);
+    long long size = [assetRepresentation size];
+    CDVHTTPURLResponse* response =
+        [[CDVHTTPURLResponse alloc] initWithURL:[[self request] URL]
+                                       MIMEType:(MIMEType ? MIMEType : @"application/octet-stream")
+                          expectedContentLength:size
+                               textEncodingName:nil];
+
+    response.statusCode = 200;
+
+    [[self client] URLProtocol:self didReceiveResponse:response cacheStoragePolicy:NSURLCacheStorageNotAllowed];
+    for (long long offset = 0; offset < size && !self.stopped; ) {
+        @autoreleasepool {
+            NSUInteger length = (NSUInteger)MIN((long long)kCDVAssetChunkSize, size - offset);
+            NSError* error = nil;
+            // each chunk gets its own buffer, the client may keep the data it's given
+            NSMutableData* chunk = [NSMutableData dataWithLength:length];
+            length = [assetRepresentation getBytes:[chunk mutableBytes] fromOffset:offset length:length error:&error];
+            if (length == 0) {
+                if (error == nil) {
+                    error = [NSError errorWithDomain:NSURLErrorDomain code:NSURLErrorCannotDecodeContentData userInfo:nil];
+                }
+                [[self client] URLProtocol:self didFailWithError:error];
+                return;
+            }
+            [chunk setLength:length];
+            [[self client] URLProtocol:self didLoadData:chunk];
+            offset += length;
+        }
+    }
+    if (!self.stopped) {
+        [[self client] URLProtocolDidFinishLoading:self];
+    }
+}
+
 @end
 
 @implementation CDVHTTPURLResponse
@@ -26,6 +26,8 @@
 #import "CDVWhitelist.h"
 #import "CDVScreenOrientationDelegate.h"
 #import "CDVPlugin.h"
+#import "CDVStartupProfile.h"
+#import "CDVMemoryPressure.h"
 
 @interface CDVViewController : UIViewController <UIWebViewDelegate, CDVScreenOrientationDelegate>{
     @protected
@@ -39,6 +41,7 @@
 
 @property (nonatomic, readonly, strong) NSMutableDictionary* pluginObjects;
 @property (nonatomic, readonly, strong) NSDictionary* pluginsMap;
+@property (nonatomic, readonly, strong) NSSet* backgroundPluginNames;
 @property (nonatomic, readonly, strong) NSMutableDictionary* settings;
 @property (nonatomic, readonly, strong) NSXMLParser* configParser;
 @property (nonatomic, readonly, strong) CDVWhitelist* whitelist; // readonly for public
@@ -49,6 +52,12 @@
 @property (nonatomic, readonly, strong) CDVCommandQueue* commandQueue;
 @property (nonatomic, readonly, strong) id <CDVCommandDelegate> commandDelegate;
 @property (nonatomic, readonly) NSString* userAgent;
+@property (nonatomic, readonly, strong) CDVStartupProfile* startupProfile;
+// Plugins register here to release memory in tiers on memory warnings.
+@property (nonatomic, readonly, strong) CDVMemoryPressure* memoryPressure;
+// The JSON object in the www file named by the AppConfigFile preference, parsed at startup. Pages
+// get it synchronously as window.appConfig by loading the script /!gap_config.js.
+@property (nonatomic, readonly, strong) NSDictionary* appConfig;
 
 + (NSDictionary*)getBundlePlist:(NSString*)plistName;
 + (NSString*)applicationDocumentsDirectory;
@@ -60,6 +69,11 @@
 - (void)javascriptAlert:(NSString*)text;
 - (NSString*)appURLScheme;
 
+// Bit mask (1 << UIInterfaceOrientation) of the UIInterfaceOrientation names, portrait when there are none.
++ (NSUInteger)interfaceOrientationMaskForOrientations:(NSArray*)orientations;
+// The mask of UISupportedInterfaceOrientations in -Info.plist, read once.
++ (NSUInteger)supportedInterfaceOrientationMask;
+
 - (NSArray*)parseInterfaceOrientations:(NSArray*)orientations;
 - (BOOL)supportsOrientation:(UIInterfaceOrientation)orientation;
 
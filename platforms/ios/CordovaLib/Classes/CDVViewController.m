@@ -30,6 +30,8 @@
 @interface CDVViewController () {
     NSInteger _userAgentLockToken;
     CDVWebViewDelegate* _webViewDelegate;
+    BOOL _finishedFirstLoad;
+    BOOL _needsLocalStorage;
 }
 
 @property (nonatomic, readwrite, strong) NSXMLParser* configParser;
@@ -38,10 +40,14 @@
 @property (nonatomic, readwrite, strong) NSMutableDictionary* pluginObjects;
 @property (nonatomic, readwrite, strong) NSArray* startupPluginNames;
 @property (nonatomic, readwrite, strong) NSDictionary* pluginsMap;
+@property (nonatomic, readwrite, strong) NSSet* backgroundPluginNames;
 @property (nonatomic, readwrite, strong) NSArray* supportedOrientations;
 @property (nonatomic, readwrite, assign) BOOL loadFromString;
 
 @property (readwrite, assign) BOOL initialized;
+@property (nonatomic, readwrite, strong) CDVStartupProfile* startupProfile;
+@property (nonatomic, readwrite, strong) CDVMemoryPressure* memoryPressure;
+@property (nonatomic, readwrite, strong) NSDictionary* appConfig;
 
 @property (atomic, strong) NSURL* openURL;
 
@@ -50,15 +56,17 @@
 @implementation CDVViewController
 
 @synthesize webView, supportedOrientations;
-@synthesize pluginObjects, pluginsMap, whitelist, startupPluginNames;
+@synthesize pluginObjects, pluginsMap, whitelist, startupPluginNames, backgroundPluginNames;
 @synthesize configParser, settings, loadFromString;
-@synthesize wwwFolderName, startPage, initialized, openURL;
+@synthesize wwwFolderName, startPage, initialized, openURL, startupProfile, appConfig, memoryPressure;
 @synthesize commandDelegate = _commandDelegate;
 @synthesize commandQueue = _commandQueue;
 
 - (void)__init
 {
     if ((self != nil) && !self.initialized) {
+        self.startupProfile = [[CDVStartupProfile alloc] init];
+        self.memoryPressure = [[CDVMemoryPressure alloc] init];
         _commandQueue = [[CDVCommandQueue alloc] initWithViewController:self];
         _commandDelegate = [[CDVCommandDelegateImpl alloc] initWithViewController:self];
         [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(onAppWillTerminate:)
@@ -261,14 +269,53 @@ CGFloat gAccessoryBarHeight = 0.0;
         return;
     }
     [configParser setDelegate:((id < NSXMLParserDelegate >)delegate)];
+    [self.startupProfile beginStage:@"configParse"];
     [configParser parse];
+    [self.startupProfile endStage:@"configParse"];
+
+    // The startup profile, the memory pressure report, tracing and metrics are always reachable from JS,
+    // the bridge benchmark only in debug builds.
+    if (delegate.pluginsDict[@"startupprofile"] == nil) {
+        delegate.pluginsDict[@"startupprofile"] = NSStringFromClass([CDVStartupProfilePlugin class]);
+    }
+    if (delegate.pluginsDict[@"memorypressure"] == nil) {
+        delegate.pluginsDict[@"memorypressure"] = NSStringFromClass([CDVMemoryPressurePlugin class]);
+    }
+#ifdef DEBUG
+    if (delegate.pluginsDict[@"bridgebenchmark"] == nil) {
+        delegate.pluginsDict[@"bridgebenchmark"] = NSStringFromClass([CDVBridgeBenchmarkPlugin class]);
+    }
+#endif
+    if (delegate.pluginsDict[@"trace"] == nil) {
+        delegate.pluginsDict[@"trace"] = NSStringFromClass([CDVTracePlugin class]);
+    }
+    if (delegate.pluginsDict[@"metrics"] == nil) {
+        delegate.pluginsDict[@"metrics"] = NSStringFromClass([CDVMetricsPlugin class]);
+    }
 
     // Get the plugin dictionary, whitelist and settings from the delegate.
     self.pluginsMap = delegate.pluginsDict;
     self.startupPluginNames = delegate.startupPluginNames;
+    self.backgroundPluginNames = delegate.backgroundPluginNames;
+    [self.startupProfile beginStage:@"whitelist"];
     self.whitelist = [[CDVWhitelist alloc] initWithArray:delegate.whitelistHosts];
+    [self.startupProfile endStage:@"whitelist"];
     self.settings = delegate.settings;
 
+    // Tracing from launch on, so startup shows up in the trace as well.
+    if ([[self settingForKey:@"TraceEnabled"] boolValue]) {
+        [CDVTrace setEnabled:YES];
+    }
+
+    // Metrics are uploaded when the app goes to the background, if there is somewhere to upload them.
+    NSString* metricsUploadURL = [self settingForKey:@"MetricsUploadURL"];
+    if ([metricsUploadURL length] > 0) {
+        [CDVMetrics sharedMetrics].uploadURL = [NSURL URLWithString:metricsUploadURL];
+    }
+    if ([[self settingForKey:@"MetricsUploadInterval"] doubleValue] > 0) {
+        [CDVMetrics sharedMetrics].uploadInterval = [[self settingForKey:@"MetricsUploadInterval"] doubleValue];
+    }
+
     // And the start folder/page.
     self.wwwFolderName = @"www";
     self.startPage = delegate.startPage;
@@ -276,10 +323,32 @@ CGFloat gAccessoryBarHeight = 0.0;
         self.startPage = @"index.html";
     }
 
+    // And the app's own configuration, so plugins and the page have it before the page loads.
+    [self.startupProfile beginStage:@"appConfig"];
+    self.appConfig = [self appConfigFromFile:[self settingForKey:@"AppConfigFile"]];
+    [self.startupProfile endStage:@"appConfig"];
+
     // Initialize the plugin objects dict.
     self.pluginObjects = [[NSMutableDictionary alloc] initWithCapacity:20];
 }
 
+- (NSDictionary*)appConfigFromFile:(NSString*)fileName
+{
+    if (fileName == nil) {
+        return nil;
+    }
+
+    NSString* path = [[NSBundle mainBundle] pathForResource:fileName ofType:nil inDirectory:self.wwwFolderName];
+    NSData* data = (path != nil) ? [NSData dataWithContentsOfFile:path] : nil;
+    id config = (data != nil) ? [NSJSONSerialization JSONObjectWithData:data options:0 error:nil] : nil;
+
+    if (![config isKindOfClass:[NSDictionary class]]) {
+        NSLog(@"AppConfigFile '%@' is missing or does not hold a JSON object.", fileName);
+        return nil;
+    }
+    return config;
+}
+
 // Implement viewDidLoad to do additional setup after loading the view, typically from a nib.
 - (void)viewDidLoad
 {
@@ -378,12 +447,11 @@ CGFloat gAccessoryBarHeight = 0.0;
     }];
 
     /*
-     * Fire up CDVLocalStorage to work-around WebKit storage limitations: on all iOS 5.1+ versions for local-only backups, but only needed on iOS 5.1 for cloud backup.
+     * CDVLocalStorage works around WebKit storage limitations: on all iOS 5.1+ versions for local-only backups, but only needed on iOS 5.1 for cloud backup.
+     * It is only needed once the app is backgrounded, so it is started with the other deferred plugins.
      */
-    if (IsAtLeastiOSVersion(@"5.1") && (([backupWebStorageType isEqualToString:@"local"]) ||
-        ([backupWebStorageType isEqualToString:@"cloud"] && !IsAtLeastiOSVersion(@"6.0")))) {
-        [self registerPlugin:[[CDVLocalStorage alloc] initWithWebView:self.webView] withClassName:NSStringFromClass([CDVLocalStorage class])];
-    }
+    _needsLocalStorage = IsAtLeastiOSVersion(@"5.1") && (([backupWebStorageType isEqualToString:@"local"]) ||
+        ([backupWebStorageType isEqualToString:@"cloud"] && !IsAtLeastiOSVersion(@"6.0")));
 
     /*
      * This is for iOS 4.x, where you can allow inline <video> and <audio>, and also autoplay them
@@ -525,22 +593,18 @@ CGFloat gAccessoryBarHeight = 0.0;
         }
     }
 
-    if ([self.startupPluginNames count] > 0) {
-        [CDVTimer start:@"TotalPluginStartup"];
-
-        for (NSString* pluginName in self.startupPluginNames) {
-            [CDVTimer start:pluginName];
-            [self getCommandInstance:pluginName];
-            [CDVTimer stop:pluginName];
-        }
-
-        [CDVTimer stop:@"TotalPluginStartup"];
+    // Plugins are created on their first exec() call. Those marked onload are
+    // started once the start page has loaded, unless DeferOnloadPlugins is
+    // false, so they don't hold up the first paint.
+    if (![self shouldDeferOnloadPlugins]) {
+        [self startOnloadPlugins];
     }
 
     // /////////////////
     [CDVUserAgentUtil acquireLock:^(NSInteger lockToken) {
         _userAgentLockToken = lockToken;
         [CDVUserAgentUtil setUserAgent:self.userAgent lockToken:lockToken];
+        [self.startupProfile beginStage:@"firstPageLoad"];
         if (!loadErr) {
             NSURLRequest* appReq = [NSURLRequest requestWithURL:appURL cachePolicy:NSURLRequestUseProtocolCachePolicy timeoutInterval:20.0];
             [self.webView loadRequest:appReq];
@@ -551,6 +615,34 @@ CGFloat gAccessoryBarHeight = 0.0;
     }];
 }
 
+- (BOOL)shouldDeferOnloadPlugins
+{
+    id defer = [self settingForKey:@"DeferOnloadPlugins"];
+
+    return (defer == nil) || [defer boolValue];
+}
+
+- (void)startOnloadPlugins
+{
+    if (_needsLocalStorage) {
+        _needsLocalStorage = NO;
+        NSString* className = NSStringFromClass([CDVLocalStorage class]);
+        [self.startupProfile beginStage:className];
+        [self registerPlugin:[[CDVLocalStorage alloc] initWithWebView:self.webView] withClassName:className];
+        [self.startupProfile endStage:className];
+    }
+
+    NSArray* pluginNames = self.startupPluginNames;
+    self.startupPluginNames = nil;
+    if ([pluginNames count] > 0) {
+        [self.startupProfile beginStage:@"onloadPlugins"];
+        for (NSString* pluginName in pluginNames) {
+            [self getCommandInstance:pluginName];
+        }
+        [self.startupProfile endStage:@"onloadPlugins"];
+    }
+}
+
 - (id)settingForKey:(NSString*)key
 {
     return [[self settings] objectForKey:[key lowercaseString]];
@@ -561,30 +653,56 @@ CGFloat gAccessoryBarHeight = 0.0;
     [[self settings] setObject:setting forKey:[key lowercaseString]];
 }
 
-- (NSArray*)parseInterfaceOrientations:(NSArray*)orientations
++ (NSUInteger)interfaceOrientationMaskForOrientations:(NSArray*)orientations
 {
-    NSMutableArray* result = [[NSMutableArray alloc] init];
-
-    if (orientations != nil) {
-        NSEnumerator* enumerator = [orientations objectEnumerator];
-        NSString* orientationString;
-
-        while (orientationString = [enumerator nextObject]) {
-            if ([orientationString isEqualToString:@"UIInterfaceOrientationPortrait"]) {
-                [result addObject:[NSNumber numberWithInt:UIInterfaceOrientationPortrait]];
-            } else if ([orientationString isEqualToString:@"UIInterfaceOrientationPortraitUpsideDown"]) {
-                [result addObject:[NSNumber numberWithInt:UIInterfaceOrientationPortraitUpsideDown]];
-            } else if ([orientationString isEqualToString:@"UIInterfaceOrientationLandscapeLeft"]) {
-                [result addObject:[NSNumber numberWithInt:UIInterfaceOrientationLandscapeLeft]];
-            } else if ([orientationString isEqualToString:@"UIInterfaceOrientationLandscapeRight"]) {
-                [result addObject:[NSNumber numberWithInt:UIInterfaceOrientationLandscapeRight]];
-            }
+    NSUInteger mask = 0;
+
+    for (NSString* orientationString in orientations) {
+        if ([orientationString isEqualToString:@"UIInterfaceOrientationPortrait"]) {
+            mask |= (1 << UIInterfaceOrientationPortrait);
+        } else if ([orientationString isEqualToString:@"UIInterfaceOrientationPortraitUpsideDown"]) {
+            mask |= (1 << UIInterfaceOrientationPortraitUpsideDown);
+        } else if ([orientationString isEqualToString:@"UIInterfaceOrientationLandscapeLeft"]) {
+            mask |= (1 << UIInterfaceOrientationLandscapeLeft);
+        } else if ([orientationString isEqualToString:@"UIInterfaceOrientationLandscapeRight"]) {
+            mask |= (1 << UIInterfaceOrientationLandscapeRight);
         }
     }
 
     // default
-    if ([result count] == 0) {
-        [result addObject:[NSNumber numberWithInt:UIInterfaceOrientationPortrait]];
+    if (mask == 0) {
+        mask = (1 << UIInterfaceOrientationPortrait);
+    }
+
+    return mask;
+}
+
++ (NSUInteger)supportedInterfaceOrientationMask
+{
+    static NSUInteger mask = 0;
+    static dispatch_once_t onceToken;
+
+    // the infoDictionary already resolves UISupportedInterfaceOrientations~ipad on an iPad
+    dispatch_once(&onceToken, ^{
+        mask = [self interfaceOrientationMaskForOrientations:
+            [[NSBundle mainBundle] objectForInfoDictionaryKey:@"UISupportedInterfaceOrientations"]];
+    });
+    return mask;
+}
+
+- (NSArray*)parseInterfaceOrientations:(NSArray*)orientations
+{
+    NSUInteger mask = [[self class] interfaceOrientationMaskForOrientations:orientations];
+    NSMutableArray* result = [[NSMutableArray alloc] init];
+    UIInterfaceOrientation all[] = {
+        UIInterfaceOrientationPortrait, UIInterfaceOrientationPortraitUpsideDown,
+        UIInterfaceOrientationLandscapeLeft, UIInterfaceOrientationLandscapeRight
+    };
+
+    for (size_t i = 0; i < sizeof(all) / sizeof(all[0]); ++i) {
+        if (mask & (1 << all[i])) {
+            [result addObject:[NSNumber numberWithInt:all[i]]];
+        }
     }
 
     return result;
@@ -715,6 +833,7 @@ CGFloat gAccessoryBarHeight = 0.0;
     }
 
     // Release any cached data, images, etc. that aren't in use.
+    [self.memoryPressure relieve];
 }
 
 - (void)viewDidUnload
@@ -754,16 +873,66 @@ CGFloat gAccessoryBarHeight = 0.0;
      */
     [[UIApplication sharedApplication] setNetworkActivityIndicatorVisible:NO];
 
+    [self finishFirstLoadOfWebView:theWebView];
+
     [self processOpenUrl];
+    [self applyJsToNativeBridgeMode];
 
     [[NSNotificationCenter defaultCenter] postNotification:[NSNotification notificationWithName:CDVPageDidLoadNotification object:self.webView]];
 }
 
+/**
+ Switches the JS side to the exec bridge named by the JsToNativeBridgeMode
+ preference (iframe, xhr, xhr-payload, xhr-optional-payload or iframe-payload).
+ Without the preference, cordova.js picks its default.
+ */
+- (void)applyJsToNativeBridgeMode
+{
+    NSString* modeName = [[self settingForKey:@"JsToNativeBridgeMode"] lowercaseString];
+
+    if (modeName == nil) {
+        return;
+    }
+
+    NSDictionary* modes = @{
+        @"iframe" : @"IFRAME_NAV",
+        @"xhr" : @"XHR_NO_PAYLOAD",
+        @"xhr-payload" : @"XHR_WITH_PAYLOAD",
+        @"xhr-optional-payload" : @"XHR_OPTIONAL_PAYLOAD",
+        @"iframe-payload" : @"IFRAME_WITH_PAYLOAD"
+    };
+    NSString* mode = [modes objectForKey:modeName];
+    if (mode == nil) {
+        NSLog(@"Unknown JsToNativeBridgeMode '%@'.", modeName);
+        return;
+    }
+
+    NSString* js = [NSString stringWithFormat:
+        @"(function(){var e=window.cordova&&cordova.require('cordova/exec');if(e&&e.setJsToNativeBridgeMode){e.setJsToNativeBridgeMode(e.jsToNativeModes.%@);}})()", mode];
+    [self.webView stringByEvaluatingJavaScriptFromString:js];
+}
+
 - (void)webView:(UIWebView*)theWebView didFailLoadWithError:(NSError*)error
 {
     [CDVUserAgentUtil releaseLock:&_userAgentLockToken];
 
     NSLog(@"Failed to load webpage with error: %@", [error localizedDescription]);
+
+    // A start page that fails to load still ends the first load, or the
+    // deferred plugins would never start.
+    [self finishFirstLoadOfWebView:theWebView];
+}
+
+// Ends the firstPageLoad stage and starts the deferred onload plugins once the
+// first top-level load is over, whether it finished or failed. A load that was
+// cancelled by the next one leaves the web view loading and is skipped.
+- (void)finishFirstLoadOfWebView:(UIWebView*)theWebView
+{
+    if (!_finishedFirstLoad && ![theWebView isLoading]) {
+        _finishedFirstLoad = YES;
+        [self.startupProfile endStage:@"firstPageLoad"];
+        [self startOnloadPlugins];
+    }
 }
 
 - (BOOL)webView:(UIWebView*)theWebView shouldStartLoadWithRequest:(NSURLRequest*)request navigationType:(UIWebViewNavigationType)navigationType
@@ -772,10 +941,19 @@ CGFloat gAccessoryBarHeight = 0.0;
 
     /*
      * Execute any commands queued with cordova.exec() on the JS side.
-     * The part of the URL after gap:// is irrelevant.
+     * In IFRAME_WITH_PAYLOAD mode, gap://exec carries the commands in its
+     * fragment; otherwise the part of the URL after gap:// is irrelevant.
      */
     if ([[url scheme] isEqualToString:@"gap"]) {
-        [_commandQueue fetchCommandsFromJs];
+        NSString* payload = nil;
+        if ([[url host] isEqualToString:@"exec"]) {
+            payload = [[url fragment] stringByReplacingPercentEscapesUsingEncoding:NSUTF8StringEncoding];
+        }
+        if ([payload length] > 0) {
+            [_commandQueue enqueCommandBatch:payload];
+        } else {
+            [_commandQueue fetchCommandsFromJs];
+        }
         return NO;
     }
 
@@ -895,6 +1073,7 @@ CGFloat gAccessoryBarHeight = 0.0;
     }
 
     [self.pluginObjects setObject:plugin forKey:className];
+    [_commandQueue invalidateDispatchCache];
     [plugin pluginInitialize];
 }
 
@@ -911,6 +1090,7 @@ CGFloat gAccessoryBarHeight = 0.0;
     NSString* className = NSStringFromClass([plugin class]);
     [self.pluginObjects setObject:plugin forKey:className];
     [self.pluginsMap setValue:className forKey:[pluginName lowercaseString]];
+    [_commandQueue invalidateDispatchCache];
     [plugin pluginInitialize];
 }
 
@@ -932,10 +1112,12 @@ CGFloat gAccessoryBarHeight = 0.0;
 
     id obj = [self.pluginObjects objectForKey:className];
     if (!obj) {
+        [self.startupProfile beginStage:className];
         obj = [[NSClassFromString(className)alloc] initWithWebView:webView];
 
         if (obj != nil) {
             [self registerPlugin:obj withClassName:className];
+            [self.startupProfile endStage:className];
         } else {
             NSLog(@"CDVPlugin class %@ (pluginName: %@) does not exist.", className, pluginName);
         }
@@ -1044,6 +1226,8 @@ CGFloat gAccessoryBarHeight = 0.0;
 {
     // NSLog(@"%@",@"applicationDidEnterBackground");
     [self.commandDelegate evalJs:@"cordova.fireDocumentEvent('pause', null, true);" scheduledOnRunLoop:NO];
+    [[CDVMetrics sharedMetrics] sync];
+    [[CDVMetrics sharedMetrics] uploadIfDue];
 }
 
 // ///////////////////////
@@ -30,7 +30,6 @@
     NSInteger _loadCount;
     NSInteger _state;
     NSInteger _curLoadToken;
-    NSInteger _loadStartPollCount;
 }
 
 - (id)initWithDelegate:(NSObject <UIWebViewDelegate>*)delegate;
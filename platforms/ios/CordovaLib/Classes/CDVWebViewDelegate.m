@@ -86,8 +86,8 @@ typedef enum {
     STATE_IDLE,
     STATE_WAITING_FOR_LOAD_START,
     STATE_WAITING_FOR_LOAD_FINISH,
-    STATE_IOS5_POLLING_FOR_LOAD_START,
-    STATE_IOS5_POLLING_FOR_LOAD_FINISH,
+    STATE_IOS5_WAITING_FOR_LOAD_START,
+    STATE_IOS5_WAITING_FOR_LOAD_FINISH,
     STATE_CANCELLED
 } State;
 
@@ -163,43 +163,49 @@ typedef enum {
     [webView stringByEvaluatingJavaScriptFromString:[NSString stringWithFormat:@"window.__cordovaLoadToken=%d", _curLoadToken]];
 }
 
-- (void)pollForPageLoadStart:(UIWebView*)webView
+// Pre-iOS6 only: the navigation replaced the page that had the load token.
+- (void)pageDidStartLoad:(UIWebView*)webView
 {
-    if (_state != STATE_IOS5_POLLING_FOR_LOAD_START) {
-        return;
-    }
-    if (![self isJsLoadTokenSet:webView]) {
-        VerboseLog(@"Polled for page load start. result = YES!");
-        _state = STATE_IOS5_POLLING_FOR_LOAD_FINISH;
-        [self setLoadToken:webView];
-        if ([_delegate respondsToSelector:@selector(webViewDidStartLoad:)]) {
-            [_delegate webViewDidStartLoad:webView];
-        }
-        [self pollForPageLoadFinish:webView];
-    } else {
-        VerboseLog(@"Polled for page load start. result = NO");
-        // Poll only for 1 second, and then fall back on checking only when delegate methods are called.
-        ++_loadStartPollCount;
-        if (_loadStartPollCount < (1000 * .05)) {
-            [self performSelector:@selector(pollForPageLoadStart:) withObject:webView afterDelay:.05];
-        }
+    VerboseLog(@"Detected page load start.");
+    _state = STATE_IOS5_WAITING_FOR_LOAD_FINISH;
+    [self setLoadToken:webView];
+    if ([_delegate respondsToSelector:@selector(webViewDidStartLoad:)]) {
+        [_delegate webViewDidStartLoad:webView];
     }
+    [self checkForPageLoadFinish:webView];
 }
 
-- (void)pollForPageLoadFinish:(UIWebView*)webView
+// Pages without cordova.js don't report their load state, for them
+// the state is looked at whenever one of the delegate methods is called.
+- (void)checkForPageLoadStart:(UIWebView*)webView
 {
-    if (_state != STATE_IOS5_POLLING_FOR_LOAD_FINISH) {
-        return;
+    if ((_state == STATE_IOS5_WAITING_FOR_LOAD_START) && ![self isJsLoadTokenSet:webView]) {
+        [self pageDidStartLoad:webView];
     }
-    if ([self isPageLoaded:webView]) {
-        VerboseLog(@"Polled for page load finish. result = YES!");
+}
+
+- (void)checkForPageLoadFinish:(UIWebView*)webView
+{
+    if ((_state == STATE_IOS5_WAITING_FOR_LOAD_FINISH) && [self isPageLoaded:webView]) {
+        VerboseLog(@"Detected page load finish.");
         _state = STATE_IDLE;
         if ([_delegate respondsToSelector:@selector(webViewDidFinishLoad:)]) {
             [_delegate webViewDidFinishLoad:webView];
         }
-    } else {
-        VerboseLog(@"Polled for page load finish. result = NO");
-        [self performSelector:@selector(pollForPageLoadFinish:) withObject:webView afterDelay:.05];
+    }
+}
+
+// cordova.js reports "interactive" on DOMContentLoaded and "complete" on load through
+// gap://pageload navigations. Only the pre-iOS6 history navigation case needs them.
+- (void)webView:(UIWebView*)webView didReportLoadState:(NSString*)loadState
+{
+    VerboseLog(@"Page reported load state %@. state=%d", loadState, _state);
+    if (_state == STATE_IOS5_WAITING_FOR_LOAD_START) {
+        // only a new page can run script that reports
+        [self pageDidStartLoad:webView];
+    }
+    if ([loadState isEqualToString:@"complete"]) {
+        [self checkForPageLoadFinish:webView];
     }
 }
 
@@ -207,6 +213,11 @@ typedef enum {
 {
     BOOL shouldLoad = YES;
 
+    if ([[request.URL scheme] isEqualToString:@"gap"] && [[request.URL host] isEqualToString:@"pageload"]) {
+        [self webView:webView didReportLoadState:[request.URL fragment]];
+        return NO;
+    }
+
     if ([_delegate respondsToSelector:@selector(webView:shouldStartLoadWithRequest:navigationType:)]) {
         shouldLoad = [_delegate webView:webView shouldStartLoadWithRequest:request navigationType:navigationType];
     }
@@ -226,7 +237,7 @@ typedef enum {
                     break;
 
                 case STATE_IDLE:
-                case STATE_IOS5_POLLING_FOR_LOAD_START:
+                case STATE_IOS5_WAITING_FOR_LOAD_START:
                     // Page navigation start.
                     _loadCount = 0;
                     _state = STATE_WAITING_FOR_LOAD_START;
@@ -271,11 +282,10 @@ typedef enum {
             // We could try to distinguish using [UIWebView canGoForward], but that's too much complexity,
             // and would work only on the first time it was used.
 
-            // Our work-around is to set a JS variable and poll until it disappears (from a naviagtion).
-            _state = STATE_IOS5_POLLING_FOR_LOAD_START;
-            _loadStartPollCount = 0;
+            // Our work-around is to set a JS variable on the current page, and to wait for the new
+            // page to report its load state, or for the variable to disappear (from a naviagtion).
+            _state = STATE_IOS5_WAITING_FOR_LOAD_START;
             [self setLoadToken:webView];
-            [self pollForPageLoadStart:webView];
             break;
 
         case STATE_CANCELLED:
@@ -297,12 +307,12 @@ typedef enum {
             _loadCount += 1;
             break;
 
-        case STATE_IOS5_POLLING_FOR_LOAD_START:
-            [self pollForPageLoadStart:webView];
+        case STATE_IOS5_WAITING_FOR_LOAD_START:
+            [self checkForPageLoadStart:webView];
             break;
 
-        case STATE_IOS5_POLLING_FOR_LOAD_FINISH:
-            [self pollForPageLoadFinish:webView];
+        case STATE_IOS5_WAITING_FOR_LOAD_FINISH:
+            [self checkForPageLoadFinish:webView];
             break;
 
         default:
@@ -334,12 +344,12 @@ typedef enum {
             _loadCount -= 1;
             break;
 
-        case STATE_IOS5_POLLING_FOR_LOAD_START:
-            [self pollForPageLoadStart:webView];
+        case STATE_IOS5_WAITING_FOR_LOAD_START:
+            [self checkForPageLoadStart:webView];
             break;
 
-        case STATE_IOS5_POLLING_FOR_LOAD_FINISH:
-            [self pollForPageLoadFinish:webView];
+        case STATE_IOS5_WAITING_FOR_LOAD_FINISH:
+            [self checkForPageLoadFinish:webView];
             break;
     }
     VerboseLog(@"webView didFinishLoad (after). state=%d loadCount=%d fireCallback=%d", _state, _loadCount, fireCallback);
@@ -376,12 +386,12 @@ typedef enum {
             }
             break;
 
-        case STATE_IOS5_POLLING_FOR_LOAD_START:
-            [self pollForPageLoadStart:webView];
+        case STATE_IOS5_WAITING_FOR_LOAD_START:
+            [self checkForPageLoadStart:webView];
             break;
 
-        case STATE_IOS5_POLLING_FOR_LOAD_FINISH:
-            [self pollForPageLoadFinish:webView];
+        case STATE_IOS5_WAITING_FOR_LOAD_FINISH:
+            [self checkForPageLoadFinish:webView];
             break;
     }
     VerboseLog(@"webView didFailLoad (after). state=%d loadCount=%d, fireCallback=%d", _state, _loadCount, fireCallback);
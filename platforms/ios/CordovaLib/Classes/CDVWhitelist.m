@@ -22,22 +22,30 @@
 NSString* const kCDVDefaultWhitelistRejectionString = @"ERROR whitelist rejection: url='%@'";
 NSString* const kCDVDefaultSchemeName = @"cdv-default-scheme";
 
+// Number of decisions kept in each generation of the decision cache.
+#define CDV_WHITELIST_CACHE_SIZE 64
+
+// A whitelist entry, expressed as a regex over the string
+// "<scheme>://<host>:<port><path>" (the port part may be empty). All entries
+// are OR'ed together into one expression so a URL is checked in a single match.
 @interface CDVWhitelistPattern : NSObject {
     @private
-    NSRegularExpression* _scheme;
-    NSRegularExpression* _host;
-    NSNumber* _port;
-    NSRegularExpression* _path;
+    NSString* _regex;
+    BOOL _constrainsPath;
 }
 
+@property (nonatomic, readonly) NSString* regex;
+@property (nonatomic, readonly) BOOL constrainsPath;
+
 + (NSString*)regexFromPattern:(NSString*)pattern allowWildcards:(bool)allowWildcards;
 - (id)initWithScheme:(NSString*)scheme host:(NSString*)host port:(NSString*)port path:(NSString*)path;
-- (bool)matches:(NSURL*)url;
 
 @end
 
 @implementation CDVWhitelistPattern
 
+@synthesize regex = _regex, constrainsPath = _constrainsPath;
+
 + (NSString*)regexFromPattern:(NSString*)pattern allowWildcards:(bool)allowWildcards
 {
     NSString* regex = [NSRegularExpression escapedPatternForString:pattern];
@@ -45,51 +53,56 @@ NSString* const kCDVDefaultSchemeName = @"cdv-default-scheme";
     if (allowWildcards) {
         regex = [regex stringByReplacingOccurrencesOfString:@"\\*" withString:@".*"];
     }
-    return [NSString stringWithFormat:@"%@$", regex];
+    return regex;
 }
 
 - (id)initWithScheme:(NSString*)scheme host:(NSString*)host port:(NSString*)port path:(NSString*)path
 {
     self = [super init];  // Potentially change "self"
     if (self) {
+        NSString* schemeRegex, * hostRegex, * portRegex, * pathRegex;
         if ((scheme == nil) || [scheme isEqualToString:@"*"]) {
-            _scheme = nil;
+            schemeRegex = @"[^:/]*";
         } else {
-            _scheme = [NSRegularExpression regularExpressionWithPattern:[CDVWhitelistPattern regexFromPattern:scheme allowWildcards:NO] options:0 error:nil];
+            schemeRegex = [CDVWhitelistPattern regexFromPattern:scheme allowWildcards:NO];
         }
-        if ([host isEqualToString:@"*"]) {
-            _host = nil;
+        if ((host == nil) || [host isEqualToString:@"*"]) {
+            hostRegex = @".*";
         } else if ([host hasPrefix:@"*."]) {
-            _host = [NSRegularExpression regularExpressionWithPattern:[NSString stringWithFormat:@"([a-z0-9.-]*\\.)?%@", [CDVWhitelistPattern regexFromPattern:[host substringFromIndex:2] allowWildcards:false]] options:0 error:nil];
+            hostRegex = [NSString stringWithFormat:@"(?:[a-z0-9.-]*\\.)?%@", [CDVWhitelistPattern regexFromPattern:[host substringFromIndex:2] allowWildcards:false]];
         } else {
-            _host = [NSRegularExpression regularExpressionWithPattern:[CDVWhitelistPattern regexFromPattern:host allowWildcards:NO] options:0 error:nil];
+            hostRegex = [CDVWhitelistPattern regexFromPattern:host allowWildcards:NO];
         }
         if ((port == nil) || [port isEqualToString:@"*"]) {
-            _port = nil;
+            portRegex = @"[0-9]*";
         } else {
-            _port = [[NSNumber alloc] initWithInteger:[port integerValue]];
+            portRegex = [NSString stringWithFormat:@"%ld", (long)[port integerValue]];
         }
         if ((path == nil) || [path isEqualToString:@"/*"]) {
-            _path = nil;
+            pathRegex = @".*";
+            _constrainsPath = NO;
         } else {
-            _path = [NSRegularExpression regularExpressionWithPattern:[CDVWhitelistPattern regexFromPattern:path allowWildcards:YES] options:0 error:nil];
+            pathRegex = [CDVWhitelistPattern regexFromPattern:path allowWildcards:YES];
+            _constrainsPath = YES;
         }
+        _regex = [NSString stringWithFormat:@"%@://%@:%@%@", schemeRegex, hostRegex, portRegex, pathRegex];
     }
     return self;
 }
 
-- (bool)matches:(NSURL*)url
-{
-    return (_scheme == nil || [_scheme numberOfMatchesInString:[url scheme] options:NSMatchingAnchored range:NSMakeRange(0, [[url scheme] length])]) &&
-           (_host == nil || [_host numberOfMatchesInString:[url host] options:NSMatchingAnchored range:NSMakeRange(0, [[url host] length])]) &&
-           (_port == nil || [[url port] isEqualToNumber:_port]) &&
-           (_path == nil || [_path numberOfMatchesInString:[url path] options:NSMatchingAnchored range:NSMakeRange(0, [[url path] length])])
-    ;
-}
-
 @end
 
-@interface CDVWhitelist ()
+@interface CDVWhitelist () {
+    // Every whitelist pattern compiled into one expression; built lazily.
+    NSRegularExpression* _matcher;
+    // Whether any pattern looks at the path. If none does, decisions are
+    // cached per scheme, host and port rather than per URL.
+    BOOL _matchesPaths;
+    // A two-generation approximation of an LRU: hits in the old generation
+    // are promoted, and a full current generation replaces the old one.
+    NSMutableDictionary* _decisions;
+    NSMutableDictionary* _previousDecisions;
+}
 
 @property (nonatomic, readwrite, strong) NSMutableArray* whitelist;
 @property (nonatomic, readwrite, strong) NSMutableSet* permittedSchemes;
@@ -110,6 +123,8 @@ NSString* const kCDVDefaultSchemeName = @"cdv-default-scheme";
         self.permittedSchemes = [[NSMutableSet alloc] init];
         self.whitelistRejectionFormatString = kCDVDefaultWhitelistRejectionString;
 
+        _decisions = [[NSMutableDictionary alloc] initWithCapacity:CDV_WHITELIST_CACHE_SIZE];
+
         for (NSString* pattern in array) {
             [self addWhiteListEntry:pattern];
         }
@@ -157,6 +172,12 @@ NSString* const kCDVDefaultSchemeName = @"cdv-default-scheme";
         return;
     }
 
+    @synchronized(self) {
+        _matcher = nil;
+        [_decisions removeAllObjects];
+        _previousDecisions = nil;
+    }
+
     if ([origin isEqualToString:@"*"]) {
         NSLog(@"Unlimited access to network resources");
         self.whitelist = nil;
@@ -231,6 +252,50 @@ NSString* const kCDVDefaultSchemeName = @"cdv-default-scheme";
     return [self URLIsAllowed:url logFailure:YES];
 }
 
+- (NSRegularExpression*)matcher
+{
+    if (_matcher == nil) {
+        NSMutableArray* alternatives = [NSMutableArray arrayWithCapacity:[self.whitelist count]];
+        _matchesPaths = NO;
+        for (CDVWhitelistPattern* p in self.whitelist) {
+            [alternatives addObject:[NSString stringWithFormat:@"(?:%@)", p.regex]];
+            _matchesPaths = _matchesPaths || p.constrainsPath;
+        }
+        // An empty alternation would match everything, so use a never-matching
+        // expression for an empty whitelist.
+        NSString* pattern = [alternatives count] > 0 ? [alternatives componentsJoinedByString:@"|"] : @"(?!)";
+        _matcher = [NSRegularExpression regularExpressionWithPattern:[NSString stringWithFormat:@"^(?:%@)$", pattern] options:0 error:nil];
+    }
+    return _matcher;
+}
+
+- (BOOL)matcherAllowsScheme:(NSString*)scheme host:(NSString*)host port:(NSNumber*)port path:(NSString*)path
+{
+    NSString* subject = [NSString stringWithFormat:@"%@://%@:%@%@",
+        scheme ? scheme : @"", host ? host : @"", port ? [port stringValue] : @"", path ? path : @""];
+    NSRegularExpression* matcher = [self matcher];
+
+    return [matcher numberOfMatchesInString:subject options:NSMatchingAnchored range:NSMakeRange(0, [subject length])] > 0;
+}
+
+- (BOOL)decideURL:(NSURL*)url
+{
+    NSString* scheme = [url scheme];
+    NSString* host = [url host];
+    NSString* path = [url path];
+
+    // http[s] and ftp[s] should also validate against the common set in the kCDVDefaultSchemeName list
+    if ([scheme isEqualToString:@"http"] || [scheme isEqualToString:@"https"] || [scheme isEqualToString:@"ftp"] || [scheme isEqualToString:@"ftps"]) {
+        // If it is allowed, we are done.  If not, continue to check for the actual scheme-specific list
+        if ([self matcherAllowsScheme:kCDVDefaultSchemeName host:host port:nil path:path]) {
+            return YES;
+        }
+    }
+
+    // Check the url against patterns in the whitelist
+    return [self matcherAllowsScheme:scheme host:host port:[url port] path:path];
+}
+
 - (BOOL)URLIsAllowed:(NSURL*)url logFailure:(BOOL)logFailure
 {
     // Shortcut acceptance: Are all urls whitelisted ("*" in whitelist)?
@@ -247,27 +312,34 @@ NSString* const kCDVDefaultSchemeName = @"cdv-default-scheme";
         return NO;
     }
 
-    // http[s] and ftp[s] should also validate against the common set in the kCDVDefaultSchemeName list
-    if ([scheme isEqualToString:@"http"] || [scheme isEqualToString:@"https"] || [scheme isEqualToString:@"ftp"] || [scheme isEqualToString:@"ftps"]) {
-        NSURL* newUrl = [NSURL URLWithString:[NSString stringWithFormat:@"%@://%@%@", kCDVDefaultSchemeName, [url host], [url path]]];
-        // If it is allowed, we are done.  If not, continue to check for the actual scheme-specific list
-        if ([self URLIsAllowed:newUrl logFailure:NO]) {
-            return YES;
+    NSNumber* decision = nil;
+    @synchronized(self) {
+        [self matcher];
+        NSString* key = [NSString stringWithFormat:@"%@://%@:%@%@", scheme, [url host], [url port],
+            _matchesPaths ? [url path] : @""];
+
+        decision = [_decisions objectForKey:key];
+        if (decision == nil) {
+            decision = [_previousDecisions objectForKey:key];
+            if (decision == nil) {
+                decision = [NSNumber numberWithBool:[self decideURL:url]];
+            }
+            if ([_decisions count] >= CDV_WHITELIST_CACHE_SIZE) {
+                _previousDecisions = _decisions;
+                _decisions = [[NSMutableDictionary alloc] initWithCapacity:CDV_WHITELIST_CACHE_SIZE];
+            }
+            [_decisions setObject:decision forKey:key];
         }
     }
 
-    // Check the url against patterns in the whitelist
-    for (CDVWhitelistPattern* p in self.whitelist) {
-        if ([p matches:url]) {
-            return YES;
+    if (![decision boolValue]) {
+        if (logFailure) {
+            NSLog(@"%@", [self errorStringForURL:url]);
         }
+        // if we got here, the url host is not in the white-list, do nothing
+        return NO;
     }
-
-    if (logFailure) {
-        NSLog(@"%@", [self errorStringForURL:url]);
-    }
-    // if we got here, the url host is not in the white-list, do nothing
-    return NO;
+    return YES;
 }
 
 - (NSString*)errorStringForURL:(NSURL*)url
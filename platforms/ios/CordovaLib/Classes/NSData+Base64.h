@@ -25,6 +25,29 @@ char *CDVNewBase64Encode(
     bool      separateLines,
     size_t    * outputLength);
 
+#ifdef DEBUG
+// For the bridge benchmark, debug builds only. Decode and encode like
+// CDVNewBase64Decode and CDVNewBase64Encode (without line breaks) into a
+// caller provided buffer, using the NEON loops only if useNEON is set and
+// skipping the debug self-checks, so both paths can be timed on one input.
+// The buffers must hold ((length + 3) / 4) * 3 decoded bytes and
+// ((length + 2) / 3) * 4 + 1 encoded characters respectively.
+size_t CDVBase64DecodeForBenchmark(
+    const char*    inputBuffer,
+    size_t         length,
+    unsigned char* outputBuffer,
+    bool           useNEON);
+
+size_t CDVBase64EncodeForBenchmark(
+    const void* inputBuffer,
+    size_t    length,
+    char*     outputBuffer,
+    bool      useNEON);
+
+// Whether this build has the NEON paths.
+bool CDVBase64HasNEON(void);
+#endif
+
 @interface NSData (CDVBase64)
 
 + (NSData*)dataFromBase64String:(NSString*)aString;
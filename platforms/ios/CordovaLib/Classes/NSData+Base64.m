@@ -54,34 +54,126 @@ static unsigned char cdvbase64DecodeLookup[256] =
 #define CDV_BINARY_UNIT_SIZE 3
 #define CDV_BASE64_UNIT_SIZE 4
 
+#if defined(__aarch64__)
+
 //
-// NewBase64Decode
+// NEON versions of the inner loops. The lookup tables are split into 64 byte
+// chunks so that a single TBL instruction can map sixteen 6 bit values (or
+// sixteen ASCII characters) at once.
 //
-// Decodes the base64 ASCII string in the inputBuffer to a newly malloced
-// output buffer.
-//
-//  inputBuffer - the source ASCII string for the decode
-//	length - the length of the string or -1 (to specify strlen should be used)
-//	outputLength - if not-NULL, on output will contain the decoded length
+#import <arm_neon.h>
+
+#define CDV_NEON_BINARY_BLOCK_SIZE 48
+#define CDV_NEON_BASE64_BLOCK_SIZE 64
+
+static inline uint8x16x4_t CDVBase64LoadTable(const unsigned char* table)
+{
+    uint8x16x4_t result;
+
+    result.val[0] = vld1q_u8(table);
+    result.val[1] = vld1q_u8(table + 16);
+    result.val[2] = vld1q_u8(table + 32);
+    result.val[3] = vld1q_u8(table + 48);
+    return result;
+}
+
 //
-// returns the decoded buffer. Must be freed by caller. Length is given by
-//	outputLength.
+// Encodes whole 48 byte blocks from input to output, stopping before end.
+// Returns the number of input bytes consumed; 64 characters are written for
+// every 48 bytes.
 //
-void *CDVNewBase64Decode(
-    const char* inputBuffer,
-    size_t    length,
-    size_t    * outputLength)
+static size_t CDVBase64EncodeNEON(const unsigned char* input, size_t length, char* output)
 {
-    if (length == -1) {
-        length = strlen(inputBuffer);
+    const uint8x16x4_t table = CDVBase64LoadTable(cdvbase64EncodeLookup);
+    const uint8x16_t mask = vdupq_n_u8(0x3F);
+    size_t i = 0;
+
+    for (; i + CDV_NEON_BINARY_BLOCK_SIZE <= length; i += CDV_NEON_BINARY_BLOCK_SIZE) {
+        uint8x16x3_t in = vld3q_u8(input + i);
+        uint8x16x4_t out;
+
+        out.val[0] = vshrq_n_u8(in.val[0], 2);
+        out.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[0], 4), vshrq_n_u8(in.val[1], 4)), mask);
+        out.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[1], 2), vshrq_n_u8(in.val[2], 6)), mask);
+        out.val[3] = vandq_u8(in.val[2], mask);
+
+        out.val[0] = vqtbl4q_u8(table, out.val[0]);
+        out.val[1] = vqtbl4q_u8(table, out.val[1]);
+        out.val[2] = vqtbl4q_u8(table, out.val[2]);
+        out.val[3] = vqtbl4q_u8(table, out.val[3]);
+
+        vst4q_u8((uint8_t*)output + (i / CDV_BINARY_UNIT_SIZE) * CDV_BASE64_UNIT_SIZE, out);
     }
+    return i;
+}
 
-    size_t outputBufferSize = (length / CDV_BASE64_UNIT_SIZE) * CDV_BINARY_UNIT_SIZE;
-    unsigned char* outputBuffer = (unsigned char*)malloc(outputBufferSize);
+//
+// Maps 16 ASCII characters to their 6 bit values. Characters outside the
+// base64 alphabet produce a value above 63 in the returned vector.
+//
+static inline uint8x16_t CDVBase64DecodeLaneNEON(uint8x16_t chars, uint8x16x4_t low, uint8x16x4_t high)
+{
+    // TBL yields 0 for out of range indices, so each lookup only contributes
+    // for its own half of the 7 bit range; the high bit is folded back in so
+    // that non-ASCII input is rejected too.
+    uint8x16_t value = vorrq_u8(vqtbl4q_u8(low, chars),
+        vqtbl4q_u8(high, vsubq_u8(chars, vdupq_n_u8(64))));
 
+    return vorrq_u8(value, vandq_u8(chars, vdupq_n_u8(0x80)));
+}
+
+//
+// Decodes whole 64 character blocks from input to output. Stops at the first
+// block that contains anything other than the 64 base64 characters (padding,
+// whitespace) and leaves the rest to the scalar loop. Returns the number of
+// characters consumed; 48 bytes are written for every 64 characters.
+//
+static size_t CDVBase64DecodeNEON(const unsigned char* input, size_t length, unsigned char* output)
+{
+    const uint8x16x4_t low = CDVBase64LoadTable(cdvbase64DecodeLookup);
+    const uint8x16x4_t high = CDVBase64LoadTable(cdvbase64DecodeLookup + 64);
     size_t i = 0;
-    size_t j = 0;
 
+    for (; i + CDV_NEON_BASE64_BLOCK_SIZE <= length; i += CDV_NEON_BASE64_BLOCK_SIZE) {
+        uint8x16x4_t in = vld4q_u8(input + i);
+        uint8x16x3_t out;
+
+        in.val[0] = CDVBase64DecodeLaneNEON(in.val[0], low, high);
+        in.val[1] = CDVBase64DecodeLaneNEON(in.val[1], low, high);
+        in.val[2] = CDVBase64DecodeLaneNEON(in.val[2], low, high);
+        in.val[3] = CDVBase64DecodeLaneNEON(in.val[3], low, high);
+
+        uint8x16_t invalid = vorrq_u8(vorrq_u8(in.val[0], in.val[1]), vorrq_u8(in.val[2], in.val[3]));
+        if (vmaxvq_u8(invalid) > 0x3F) {
+            break;
+        }
+
+        out.val[0] = vorrq_u8(vshlq_n_u8(in.val[0], 2), vshrq_n_u8(in.val[1], 4));
+        out.val[1] = vorrq_u8(vshlq_n_u8(in.val[1], 4), vshrq_n_u8(in.val[2], 2));
+        out.val[2] = vorrq_u8(vshlq_n_u8(in.val[2], 6), in.val[3]);
+
+        vst3q_u8(output + (i / CDV_BASE64_UNIT_SIZE) * CDV_BINARY_UNIT_SIZE, out);
+    }
+    return i;
+}
+
+#endif
+
+//
+// Base64DecodeScalar
+//
+// Decodes from inputBuffer[i] onwards into outputBuffer[j] onwards, skipping
+// any characters that are not part of the base64 alphabet.
+//
+// returns the total decoded length.
+//
+static size_t CDVBase64DecodeScalar(
+    const unsigned char* inputBuffer,
+    size_t               length,
+    unsigned char*       outputBuffer,
+    size_t               i,
+    size_t               j)
+{
     while (i < length) {
         //
         // Accumulate 4 valid characters (ignore everything else)
@@ -102,6 +194,13 @@ void *CDVNewBase64Decode(
             }
         }
 
+        //
+        // Trailing padding or whitespace adds no output
+        //
+        if (accumulateIndex < 2) {
+            break;
+        }
+
         //
         // Store the 6 bits from each of the 4 characters as 3 bytes
         //
@@ -110,67 +209,105 @@ void *CDVNewBase64Decode(
         outputBuffer[j + 2] = (accumulated[2] << 6) | accumulated[3];
         j += accumulateIndex - 1;
     }
+    return j;
+}
 
-    if (outputLength) {
-        *outputLength = j;
+//
+// Base64DecodedCapacity
+//
+// returns an upper bound on the decoded size of length base64 characters.
+//
+static size_t CDVBase64DecodedCapacity(size_t length)
+{
+    return ((length + CDV_BASE64_UNIT_SIZE - 1) / CDV_BASE64_UNIT_SIZE) * CDV_BINARY_UNIT_SIZE;
+}
+
+//
+// Base64DecodeInto
+//
+// Decodes the base64 ASCII string in the inputBuffer into outputBuffer, which
+// must hold at least CDVBase64DecodedCapacity(length) bytes. Uses NEON for
+// the bulk of the input where available; debug builds check the result
+// against the scalar decoder.
+//
+// returns the decoded length.
+//
+static size_t CDVBase64DecodeInto(
+    const char*    inputBuffer,
+    size_t         length,
+    unsigned char* outputBuffer)
+{
+    const unsigned char* input = (const unsigned char*)inputBuffer;
+    size_t i = 0;
+
+#if defined(__aarch64__)
+    i = CDVBase64DecodeNEON(input, length, outputBuffer);
+#endif
+    size_t j = CDVBase64DecodeScalar(input, length, outputBuffer, i, (i / CDV_BASE64_UNIT_SIZE) * CDV_BINARY_UNIT_SIZE);
+
+#if defined(__aarch64__) && defined(DEBUG)
+    if (i > 0) {
+        unsigned char* check = (unsigned char*)malloc(CDVBase64DecodedCapacity(length));
+        size_t checkLength = CDVBase64DecodeScalar(input, length, check, 0, 0);
+        NSCAssert(checkLength == j && memcmp(check, outputBuffer, j) == 0, @"NEON base64 decode does not match the scalar decoder");
+        free(check);
     }
-    return outputBuffer;
+#endif
+    return j;
 }
 
 //
 // NewBase64Decode
 //
-// Encodes the arbitrary data in the inputBuffer as base64 into a newly malloced
+// Decodes the base64 ASCII string in the inputBuffer to a newly malloced
 // output buffer.
 //
-//  inputBuffer - the source data for the encode
-//	length - the length of the input in bytes
-//  separateLines - if zero, no CR/LF characters will be added. Otherwise
-//		a CR/LF pair will be added every 64 encoded chars.
-//	outputLength - if not-NULL, on output will contain the encoded length
-//		(not including terminating 0 char)
+//  inputBuffer - the source ASCII string for the decode
+//	length - the length of the string or -1 (to specify strlen should be used)
+//	outputLength - if not-NULL, on output will contain the decoded length
 //
-// returns the encoded buffer. Must be freed by caller. Length is given by
+// returns the decoded buffer. Must be freed by caller. Length is given by
 //	outputLength.
 //
-char *CDVNewBase64Encode(
-    const void* buffer,
+void *CDVNewBase64Decode(
+    const char* inputBuffer,
     size_t    length,
-    bool      separateLines,
     size_t    * outputLength)
 {
-    const unsigned char* inputBuffer = (const unsigned char*)buffer;
+    if (length == -1) {
+        length = strlen(inputBuffer);
+    }
+
+    unsigned char* outputBuffer = (unsigned char*)malloc(CDVBase64DecodedCapacity(length));
+    size_t j = CDVBase64DecodeInto(inputBuffer, length, outputBuffer);
+
+    if (outputLength) {
+        *outputLength = j;
+    }
+    return outputBuffer;
+}
 
 #define MAX_NUM_PADDING_CHARS 2
 #define OUTPUT_LINE_LENGTH 64
 #define INPUT_LINE_LENGTH ((OUTPUT_LINE_LENGTH / CDV_BASE64_UNIT_SIZE) * CDV_BINARY_UNIT_SIZE)
 #define CR_LF_SIZE 0
 
-    //
-    // Byte accurate calculation of final buffer size
-    //
-    size_t outputBufferSize =
-        ((length / CDV_BINARY_UNIT_SIZE)
-        + ((length % CDV_BINARY_UNIT_SIZE) ? 1 : 0))
-        * CDV_BASE64_UNIT_SIZE;
-    if (separateLines) {
-        outputBufferSize +=
-            (outputBufferSize / OUTPUT_LINE_LENGTH) * CR_LF_SIZE;
-    }
-
-    //
-    // Include space for a terminating zero
-    //
-    outputBufferSize += 1;
-
-    //
-    // Allocate the output buffer
-    //
-    char* outputBuffer = (char*)malloc(outputBufferSize);
-    if (!outputBuffer) {
-        return NULL;
-    }
-
+//
+// Base64EncodeInto
+//
+// Encodes the inputBuffer into outputBuffer, which must be large enough for the
+// encoded characters and a terminating zero. Uses NEON for the whole blocks of
+// each line where available and useNEON is set.
+//
+// returns the encoded length (not including terminating 0 char).
+//
+static size_t CDVBase64EncodeInto(
+    const unsigned char* inputBuffer,
+    size_t               length,
+    bool                 separateLines,
+    bool                 useNEON,
+    char*                outputBuffer)
+{
     size_t i = 0;
     size_t j = 0;
     const size_t lineLength = separateLines ? INPUT_LINE_LENGTH : length;
@@ -181,6 +318,14 @@ char *CDVNewBase64Encode(
             lineEnd = length;
         }
 
+#if defined(__aarch64__)
+        if (useNEON) {
+            size_t consumed = CDVBase64EncodeNEON(inputBuffer + i, lineEnd - i, outputBuffer + j);
+            i += consumed;
+            j += (consumed / CDV_BINARY_UNIT_SIZE) * CDV_BASE64_UNIT_SIZE;
+        }
+#endif
+
         for (; i + CDV_BINARY_UNIT_SIZE - 1 < lineEnd; i += CDV_BINARY_UNIT_SIZE) {
             //
             // Inner loop: turn 48 bytes into 64 base64 characters
@@ -224,6 +369,68 @@ char *CDVNewBase64Encode(
         outputBuffer[j++] = '=';
     }
     outputBuffer[j] = 0;
+    return j;
+}
+
+//
+// NewBase64Decode
+//
+// Encodes the arbitrary data in the inputBuffer as base64 into a newly malloced
+// output buffer.
+//
+//  inputBuffer - the source data for the encode
+//	length - the length of the input in bytes
+//  separateLines - if zero, no CR/LF characters will be added. Otherwise
+//		a CR/LF pair will be added every 64 encoded chars.
+//	outputLength - if not-NULL, on output will contain the encoded length
+//		(not including terminating 0 char)
+//
+// returns the encoded buffer. Must be freed by caller. Length is given by
+//	outputLength.
+//
+char *CDVNewBase64Encode(
+    const void* buffer,
+    size_t    length,
+    bool      separateLines,
+    size_t    * outputLength)
+{
+    const unsigned char* inputBuffer = (const unsigned char*)buffer;
+
+    //
+    // Byte accurate calculation of final buffer size
+    //
+    size_t outputBufferSize =
+        ((length / CDV_BINARY_UNIT_SIZE)
+        + ((length % CDV_BINARY_UNIT_SIZE) ? 1 : 0))
+        * CDV_BASE64_UNIT_SIZE;
+    if (separateLines) {
+        outputBufferSize +=
+            (outputBufferSize / OUTPUT_LINE_LENGTH) * CR_LF_SIZE;
+    }
+
+    //
+    // Include space for a terminating zero
+    //
+    outputBufferSize += 1;
+
+    //
+    // Allocate the output buffer
+    //
+    char* outputBuffer = (char*)malloc(outputBufferSize);
+    if (!outputBuffer) {
+        return NULL;
+    }
+
+    size_t j = CDVBase64EncodeInto(inputBuffer, length, separateLines, true, outputBuffer);
+
+#if defined(__aarch64__) && defined(DEBUG)
+    if (length >= CDV_NEON_BINARY_BLOCK_SIZE) {
+        unsigned char* check = (unsigned char*)malloc(CDVBase64DecodedCapacity(j));
+        size_t checkLength = CDVBase64DecodeScalar((const unsigned char*)outputBuffer, j, check, 0, 0);
+        NSCAssert(checkLength == length && memcmp(check, inputBuffer, length) == 0, @"NEON base64 encode does not round-trip through the scalar decoder");
+        free(check);
+    }
+#endif
 
     //
     // Set the output length and return the buffer
@@ -234,6 +441,45 @@ char *CDVNewBase64Encode(
     return outputBuffer;
 }
 
+#ifdef DEBUG
+
+size_t CDVBase64DecodeForBenchmark(
+    const char*    inputBuffer,
+    size_t         length,
+    unsigned char* outputBuffer,
+    bool           useNEON)
+{
+    const unsigned char* input = (const unsigned char*)inputBuffer;
+    size_t i = 0;
+
+#if defined(__aarch64__)
+    if (useNEON) {
+        i = CDVBase64DecodeNEON(input, length, outputBuffer);
+    }
+#endif
+    return CDVBase64DecodeScalar(input, length, outputBuffer, i, (i / CDV_BASE64_UNIT_SIZE) * CDV_BINARY_UNIT_SIZE);
+}
+
+size_t CDVBase64EncodeForBenchmark(
+    const void* inputBuffer,
+    size_t    length,
+    char*     outputBuffer,
+    bool      useNEON)
+{
+    return CDVBase64EncodeInto((const unsigned char*)inputBuffer, length, false, useNEON, outputBuffer);
+}
+
+bool CDVBase64HasNEON(void)
+{
+#if defined(__aarch64__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+#endif
+
 @implementation NSData (CDVBase64)
 
 //
@@ -249,10 +495,19 @@ char *CDVNewBase64Encode(
 //
 + (NSData*)dataFromBase64String:(NSString*)aString
 {
-    size_t outputLength = 0;
-    void* outputBuffer = CDVNewBase64Decode([aString UTF8String], [aString length], &outputLength);
+    // Base64 is pure ASCII, so when the string already stores its bytes that
+    // way, decode from them directly instead of copying out a UTF-8 buffer.
+    const char* inputBuffer = CFStringGetCStringPtr((__bridge CFStringRef)aString, kCFStringEncodingASCII);
+    size_t length = [aString length];
+
+    if (inputBuffer == NULL) {
+        inputBuffer = [aString UTF8String];
+        length = strlen(inputBuffer);
+    }
 
-    return [NSData dataWithBytesNoCopy:outputBuffer length:outputLength freeWhenDone:YES];
+    NSMutableData* data = [NSMutableData dataWithLength:CDVBase64DecodedCapacity(length)];
+    [data setLength:CDVBase64DecodeInto(inputBuffer, length, (unsigned char*)[data mutableBytes])];
+    return data;
 }
 
 //
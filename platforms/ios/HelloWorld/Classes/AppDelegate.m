@@ -117,6 +117,15 @@
     [[NSNotificationCenter defaultCenter] postNotificationName:CDVLocalNotification object:notification];
 }
 
+// the app was relaunched for the events of a background upload or download session; the plugin
+// that owns it (marked onload) reconnects to the session and calls the handler when it's done
+- (void)                         application:(UIApplication*)application
+    handleEventsForBackgroundURLSession:(NSString*)identifier
+                      completionHandler:(void (^)())completionHandler
+{
+    [CDVPlugin setCompletionHandler:completionHandler forBackgroundURLSession:identifier];
+}
+
 - (NSUInteger)application:(UIApplication*)application supportedInterfaceOrientationsForWindow:(UIWindow*)window
 {
     // iPhone doesn't support upside down by default, while the iPad does.  Override to allow all orientations always, and let the root view controller decide what's allowed (the supported orientations mask gets intersected).
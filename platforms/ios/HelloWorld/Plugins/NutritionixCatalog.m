@@ -0,0 +1,852 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import "NutritionixCatalog.h"
+#import "NutritionixClient.h"
+#include <libkern/OSByteOrder.h>
+#include <string.h>
+#include <zlib.h>
+
+#define NUTRITIONIX_GTIN_LENGTH 14
+#define NUTRITIONIX_CATALOG_BLOCK_SIZE 16
+#define NUTRITIONIX_CATALOG_HEADER_LENGTH 48
+#define NUTRITIONIX_CATALOG_PATCH_HEADER_LENGTH 20
+#define NUTRITIONIX_CATALOG_TRIGRAM_LENGTH 12
+// candidates checked against the typed words per search, so common trigrams cannot stall typing
+#define NUTRITIONIX_CATALOG_MAX_CANDIDATES 2048
+
+enum {
+    NutritionixCatalogUpsert = 1,
+    NutritionixCatalogRemove = 2
+};
+
+typedef struct {
+    uint32_t version;
+    uint32_t count;
+    uint32_t blockCount;
+    uint32_t blocksOffset;
+    uint32_t recordsOffset;
+    uint32_t recordsLength;
+    uint32_t trigramCount;
+    uint32_t trigramsOffset;
+    uint32_t postingsOffset;
+    uint32_t postingsLength;
+    uint32_t checksum;
+} NutritionixCatalogHeader;
+
+// A decoded record; name and brand point into the snapshot or patch they were read from.
+typedef struct {
+    char gtin[NUTRITIONIX_GTIN_LENGTH + 1];
+    uint32_t rank;
+    const uint8_t* name;
+    uint32_t nameLength;
+    const uint8_t* brand;
+    uint32_t brandLength;
+} NutritionixCatalogRecord;
+
+// A search hit, kept sorted by rank while searching.
+typedef struct {
+    uint32_t rank;
+    uint32_t index;
+} NutritionixCatalogHit;
+
+static NSError* NutritionixCatalogError(NSString* message)
+{
+    return [NSError errorWithDomain:kNutritionixErrorDomain code:0
+                           userInfo:[NSDictionary dictionaryWithObject:message forKey:NSLocalizedDescriptionKey]];
+}
+
+static BOOL NutritionixCatalogReadVarint(const uint8_t** p, const uint8_t* end, uint32_t* value)
+{
+    uint32_t result = 0;
+
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (*p >= end) {
+            return NO;
+        }
+        uint8_t byte = *(*p)++;
+        result |= (uint32_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return YES;
+        }
+    }
+    return NO;
+}
+
+static void NutritionixCatalogAppendVarint(NSMutableData* data, uint32_t value)
+{
+    uint8_t bytes[5];
+    int length = 0;
+
+    while (value >= 0x80) {
+        bytes[length++] = (uint8_t)((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    bytes[length++] = (uint8_t)value;
+    [data appendBytes:bytes length:length];
+}
+
+static void NutritionixCatalogAppendUInt32(NSMutableData* data, uint32_t value)
+{
+    uint32_t little = OSSwapHostToLittleInt32(value);
+
+    [data appendBytes:&little length:sizeof(little)];
+}
+
+// Reads the rank, name and brand that follow the GTIN of a record or upsert. Returns where they end, NULL if they
+// run past end.
+static const uint8_t* NutritionixCatalogReadFields(const uint8_t* p, const uint8_t* end, NutritionixCatalogRecord* record)
+{
+    if (!NutritionixCatalogReadVarint(&p, end, &record->rank) ||
+        !NutritionixCatalogReadVarint(&p, end, &record->nameLength) || ((size_t)(end - p) < record->nameLength)) {
+        return NULL;
+    }
+    record->name = p;
+    p += record->nameLength;
+    if (!NutritionixCatalogReadVarint(&p, end, &record->brandLength) || ((size_t)(end - p) < record->brandLength)) {
+        return NULL;
+    }
+    record->brand = p;
+    return p + record->brandLength;
+}
+
+// Reads the record at p into record, whose GTIN still holds the one of the record before. Returns where the next
+// record starts, NULL if the record runs past end.
+static const uint8_t* NutritionixCatalogReadRecord(const uint8_t* p, const uint8_t* end, NutritionixCatalogRecord* record)
+{
+    if (p >= end) {
+        return NULL;
+    }
+    uint32_t shared = *p++;
+    if ((shared > NUTRITIONIX_GTIN_LENGTH) || ((size_t)(end - p) < NUTRITIONIX_GTIN_LENGTH - shared)) {
+        return NULL;
+    }
+    memcpy(record->gtin + shared, p, NUTRITIONIX_GTIN_LENGTH - shared);
+    record->gtin[NUTRITIONIX_GTIN_LENGTH] = '\0';
+    return NutritionixCatalogReadFields(p + NUTRITIONIX_GTIN_LENGTH - shared, end, record);
+}
+
+static void NutritionixCatalogAppendRecord(NSMutableData* data, const NutritionixCatalogRecord* record, const char* previous)
+{
+    uint8_t shared = 0;
+
+    while ((previous != NULL) && (shared < NUTRITIONIX_GTIN_LENGTH) && (record->gtin[shared] == previous[shared])) {
+        shared++;
+    }
+    [data appendBytes:&shared length:1];
+    [data appendBytes:record->gtin + shared length:NUTRITIONIX_GTIN_LENGTH - shared];
+    NutritionixCatalogAppendVarint(data, record->rank);
+    NutritionixCatalogAppendVarint(data, record->nameLength);
+    [data appendBytes:record->name length:record->nameLength];
+    NutritionixCatalogAppendVarint(data, record->brandLength);
+    [data appendBytes:record->brand length:record->brandLength];
+}
+
+// Appends the words of the UTF-8 text to normalized: lowercased, without diacritics, separated by one space and
+// with a space in front of each, such that " word" finds the words starting with it.
+static void NutritionixCatalogAppendWords(NSMutableData* normalized, const uint8_t* utf8, NSUInteger length)
+{
+    NSUInteger i;
+
+    for (i = 0; (i < length) && (utf8[i] < 0x80); i++) {
+    }
+    NSString* folded = nil;
+    if (i < length) {
+        // only names with other than ASCII characters pay for folding
+        NSString* text = [[NSString alloc] initWithBytes:utf8 length:length encoding:NSUTF8StringEncoding];
+        folded = [text stringByFoldingWithOptions:(NSCaseInsensitiveSearch | NSDiacriticInsensitiveSearch | NSWidthInsensitiveSearch)
+                                           locale:nil];
+        length = [folded length];
+    }
+
+    BOOL inWord = NO;
+    for (i = 0; i < length; i++) {
+        unichar c = (folded != nil) ? [folded characterAtIndex:i] : utf8[i];
+        if ((c >= 'A') && (c <= 'Z')) {
+            c += 'a' - 'A';
+        }
+        if (((c >= 'a') && (c <= 'z')) || ((c >= '0') && (c <= '9'))) {
+            if (!inWord) {
+                [normalized appendBytes:" " length:1];
+                inWord = YES;
+            }
+            uint8_t byte = (uint8_t)c;
+            [normalized appendBytes:&byte length:1];
+        } else {
+            inWord = NO;
+        }
+    }
+}
+
+static NSData* NutritionixCatalogNormalizedRecord(const NutritionixCatalogRecord* record)
+{
+    NSMutableData* normalized = [NSMutableData dataWithCapacity:record->nameLength + record->brandLength + 8];
+
+    NutritionixCatalogAppendWords(normalized, record->name, record->nameLength);
+    NutritionixCatalogAppendWords(normalized, record->brand, record->brandLength);
+    return normalized;
+}
+
+// Calls block with the key of every trigram within the words of the normalized text.
+static void NutritionixCatalogEnumerateTrigrams(const uint8_t* text, NSUInteger length, void (^block)(uint32_t key))
+{
+    for (NSUInteger i = 0; i + 3 <= length; i++) {
+        if ((text[i] != ' ') && (text[i + 1] != ' ') && (text[i + 2] != ' ')) {
+            block(((uint32_t)text[i] << 16) | ((uint32_t)text[i + 1] << 8) | text[i + 2]);
+        }
+    }
+}
+
+static int NutritionixCatalogCompareUInt64(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+
+    return (x < y) ? -1 : ((x > y) ? 1 : 0);
+}
+
+// Builds a snapshot of the records, which have to be sorted by GTIN.
+static NSData* NutritionixCatalogBuildSnapshot(const NutritionixCatalogRecord* records, uint32_t count, uint32_t version)
+{
+    NSMutableData* blocks = [NSMutableData dataWithCapacity:(count / NUTRITIONIX_CATALOG_BLOCK_SIZE + 1) * 4];
+    NSMutableData* recordData = [NSMutableData dataWithCapacity:count * 40];
+    // trigram key << 32 | record number
+    __block uint64_t* pairs = malloc(sizeof(uint64_t) * 1024);
+    __block size_t pairCount = 0;
+    __block size_t pairCapacity = 1024;
+
+    for (uint32_t i = 0; i < count; i++) {
+        const char* previous = NULL;
+        if ((i % NUTRITIONIX_CATALOG_BLOCK_SIZE) == 0) {
+            NutritionixCatalogAppendUInt32(blocks, (uint32_t)[recordData length]);
+        } else {
+            previous = records[i - 1].gtin;
+        }
+        NutritionixCatalogAppendRecord(recordData, &records[i], previous);
+
+        size_t first = pairCount;
+        @autoreleasepool {
+            NSData* normalized = NutritionixCatalogNormalizedRecord(&records[i]);
+            NutritionixCatalogEnumerateTrigrams([normalized bytes], [normalized length], ^(uint32_t key) {
+                if (pairCount == pairCapacity) {
+                    pairCapacity *= 2;
+                    pairs = realloc(pairs, sizeof(uint64_t) * pairCapacity);
+                }
+                pairs[pairCount++] = ((uint64_t)key << 32) | i;
+            });
+        }
+        // a record is listed once per trigram
+        qsort(pairs + first, pairCount - first, sizeof(uint64_t), NutritionixCatalogCompareUInt64);
+        size_t unique = first;
+        for (size_t j = first; j < pairCount; j++) {
+            if ((j == first) || (pairs[j] != pairs[unique - 1])) {
+                pairs[unique++] = pairs[j];
+            }
+        }
+        pairCount = unique;
+    }
+    qsort(pairs, pairCount, sizeof(uint64_t), NutritionixCatalogCompareUInt64);
+
+    NSMutableData* trigrams = [NSMutableData data];
+    NSMutableData* postings = [NSMutableData dataWithCapacity:pairCount * 2];
+    uint32_t trigramCount = 0;
+    for (size_t j = 0; j < pairCount;) {
+        uint32_t key = (uint32_t)(pairs[j] >> 32);
+        size_t end = j;
+        while ((end < pairCount) && ((uint32_t)(pairs[end] >> 32) == key)) {
+            end++;
+        }
+        NutritionixCatalogAppendUInt32(trigrams, key);
+        NutritionixCatalogAppendUInt32(trigrams, (uint32_t)[postings length]);
+        NutritionixCatalogAppendUInt32(trigrams, (uint32_t)(end - j));
+        uint32_t last = 0;
+        for (; j < end; j++) {
+            uint32_t index = (uint32_t)pairs[j];
+            NutritionixCatalogAppendVarint(postings, index - last);
+            last = index;
+        }
+        trigramCount++;
+    }
+    free(pairs);
+
+    NSMutableData* body = [NSMutableData dataWithCapacity:[blocks length] + [recordData length] + [trigrams length] + [postings length]];
+    [body appendData:blocks];
+    [body appendData:recordData];
+    [body appendData:trigrams];
+    [body appendData:postings];
+
+    uint32_t blocksOffset = NUTRITIONIX_CATALOG_HEADER_LENGTH;
+    uint32_t recordsOffset = blocksOffset + (uint32_t)[blocks length];
+    uint32_t trigramsOffset = recordsOffset + (uint32_t)[recordData length];
+    uint32_t postingsOffset = trigramsOffset + (uint32_t)[trigrams length];
+    NSMutableData* snapshot = [NSMutableData dataWithCapacity:NUTRITIONIX_CATALOG_HEADER_LENGTH + [body length]];
+    [snapshot appendBytes:"NXC1" length:4];
+    NutritionixCatalogAppendUInt32(snapshot, version);
+    NutritionixCatalogAppendUInt32(snapshot, count);
+    NutritionixCatalogAppendUInt32(snapshot, (uint32_t)([blocks length] / 4));
+    NutritionixCatalogAppendUInt32(snapshot, blocksOffset);
+    NutritionixCatalogAppendUInt32(snapshot, recordsOffset);
+    NutritionixCatalogAppendUInt32(snapshot, (uint32_t)[recordData length]);
+    NutritionixCatalogAppendUInt32(snapshot, trigramCount);
+    NutritionixCatalogAppendUInt32(snapshot, trigramsOffset);
+    NutritionixCatalogAppendUInt32(snapshot, postingsOffset);
+    NutritionixCatalogAppendUInt32(snapshot, (uint32_t)[postings length]);
+    NutritionixCatalogAppendUInt32(snapshot, (uint32_t)crc32(0, [body bytes], (uInt)[body length]));
+    [snapshot appendData:body];
+    return snapshot;
+}
+
+#pragma mark -
+
+// One version of the catalog, immutable once opened.
+@interface NutritionixCatalogSnapshot : NSObject {
+    @public
+    NutritionixCatalogHeader _header;
+    NSData* _data;
+    const uint8_t* _bytes;
+}
+@end
+
+@implementation NutritionixCatalogSnapshot
+
+// Checks that the sections lie within the data, and with verify also the checksum, which reads every byte.
+- (id)initWithData:(NSData*)data verify:(BOOL)verify
+{
+    self = [super init];
+    if (self == nil) {
+        return nil;
+    }
+    _data = data;
+    _bytes = [data bytes];
+
+    uint64_t length = [data length];
+    if ((length < NUTRITIONIX_CATALOG_HEADER_LENGTH) || (memcmp(_bytes, "NXC1", 4) != 0)) {
+        return nil;
+    }
+    uint32_t* fields = &_header.version;
+    for (int i = 0; i < 11; i++) {
+        fields[i] = OSReadLittleInt32(_bytes, 4 + i * 4);
+    }
+
+    NutritionixCatalogHeader* h = &_header;
+    if ((h->blockCount != (h->count + NUTRITIONIX_CATALOG_BLOCK_SIZE - 1) / NUTRITIONIX_CATALOG_BLOCK_SIZE) ||
+        ((uint64_t)h->blocksOffset + (uint64_t)h->blockCount * 4 > length) ||
+        ((uint64_t)h->recordsOffset + h->recordsLength > length) ||
+        ((uint64_t)h->trigramsOffset + (uint64_t)h->trigramCount * NUTRITIONIX_CATALOG_TRIGRAM_LENGTH > length) ||
+        ((uint64_t)h->postingsOffset + h->postingsLength > length)) {
+        return nil;
+    }
+    if (verify && (crc32(0, _bytes + NUTRITIONIX_CATALOG_HEADER_LENGTH, (uInt)(length - NUTRITIONIX_CATALOG_HEADER_LENGTH)) != h->checksum)) {
+        return nil;
+    }
+    return self;
+}
+
+- (const uint8_t*)recordsEnd
+{
+    return _bytes + _header.recordsOffset + _header.recordsLength;
+}
+
+// The first record of the block, without the record before it.
+- (const uint8_t*)blockStart:(uint32_t)block
+{
+    uint32_t offset = OSReadLittleInt32(_bytes, _header.blocksOffset + block * 4);
+
+    return (offset < _header.recordsLength) ? _bytes + _header.recordsOffset + offset : NULL;
+}
+
+- (BOOL)getRecord:(NutritionixCatalogRecord*)record atIndex:(uint32_t)index
+{
+    if (index >= _header.count) {
+        return NO;
+    }
+    const uint8_t* p = [self blockStart:index / NUTRITIONIX_CATALOG_BLOCK_SIZE];
+    const uint8_t* end = [self recordsEnd];
+
+    memset(record->gtin, '0', NUTRITIONIX_GTIN_LENGTH);
+    for (uint32_t i = 0; (p != NULL) && (i <= index % NUTRITIONIX_CATALOG_BLOCK_SIZE); i++) {
+        p = NutritionixCatalogReadRecord(p, end, record);
+    }
+    return p != NULL;
+}
+
+// The last block whose first GTIN sorts before the prefix, the first block if none does.
+- (uint32_t)blockBeforePrefix:(const char*)prefix length:(size_t)length
+{
+    uint32_t low = 0;
+    uint32_t high = _header.blockCount;
+
+    while (high - low > 1) {
+        uint32_t middle = low + (high - low) / 2;
+        const uint8_t* start = [self blockStart:middle];
+        // a block starts with the shared count 0 and the whole GTIN
+        if ((start == NULL) || ([self recordsEnd] - start < 1 + NUTRITIONIX_GTIN_LENGTH) ||
+            (strncmp((const char*)start + 1, prefix, length) < 0)) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// Entry of the trigram in the table, NSNotFound if no record has it.
+- (NSUInteger)entryOfTrigram:(uint32_t)key
+{
+    NSUInteger low = 0;
+    NSUInteger high = _header.trigramCount;
+
+    while (low < high) {
+        NSUInteger middle = low + (high - low) / 2;
+        uint32_t middleKey = OSReadLittleInt32(_bytes, _header.trigramsOffset + middle * NUTRITIONIX_CATALOG_TRIGRAM_LENGTH);
+        if (middleKey == key) {
+            return middle;
+        }
+        if (middleKey < key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return NSNotFound;
+}
+
+- (uint32_t)postingsCountOfEntry:(NSUInteger)entry
+{
+    return OSReadLittleInt32(_bytes, _header.trigramsOffset + entry * NUTRITIONIX_CATALOG_TRIGRAM_LENGTH + 8);
+}
+
+// Decodes the ascending record numbers of the entry into indexes, which has room for postingsCountOfEntry.
+// Returns how many were decoded, fewer if the postings are corrupt.
+- (uint32_t)getPostings:(uint32_t*)indexes ofEntry:(NSUInteger)entry
+{
+    uint32_t offset = OSReadLittleInt32(_bytes, _header.trigramsOffset + entry * NUTRITIONIX_CATALOG_TRIGRAM_LENGTH + 4);
+    uint32_t count = [self postingsCountOfEntry:entry];
+
+    if (offset >= _header.postingsLength) {
+        return 0;
+    }
+    const uint8_t* p = _bytes + _header.postingsOffset + offset;
+    const uint8_t* end = _bytes + _header.postingsOffset + _header.postingsLength;
+    uint32_t index = 0;
+    uint32_t decoded = 0;
+    for (; decoded < count; decoded++) {
+        uint32_t delta;
+        if (!NutritionixCatalogReadVarint(&p, end, &delta) || ((decoded > 0) && (delta == 0)) ||
+            ((uint64_t)index + delta >= _header.count)) {
+            break;
+        }
+        index += delta;
+        indexes[decoded] = index;
+    }
+    return decoded;
+}
+
+@end
+
+#pragma mark -
+
+// Keeps the limit best ranked hits, the best first.
+static void NutritionixCatalogAddHit(NutritionixCatalogHit* hits, NSUInteger* hitCount, NSUInteger limit, uint32_t rank, uint32_t index)
+{
+    NSUInteger i = *hitCount;
+
+    if ((i == limit) && (hits[i - 1].rank <= rank)) {
+        return;
+    }
+    if (i == limit) {
+        i--;
+    } else {
+        (*hitCount)++;
+    }
+    while ((i > 0) && (hits[i - 1].rank > rank)) {
+        hits[i] = hits[i - 1];
+        i--;
+    }
+    hits[i].rank = rank;
+    hits[i].index = index;
+}
+
+static NSDictionary* NutritionixCatalogItem(const NutritionixCatalogRecord* record)
+{
+    NSString* name = [[NSString alloc] initWithBytes:record->name length:record->nameLength encoding:NSUTF8StringEncoding];
+    NSString* brand = [[NSString alloc] initWithBytes:record->brand length:record->brandLength encoding:NSUTF8StringEncoding];
+
+    return [NSDictionary dictionaryWithObjectsAndKeys:[NSString stringWithUTF8String:record->gtin], @"gtin",
+        (name != nil) ? name : @"", @"name", (brand != nil) ? brand : @"", @"brand", nil];
+}
+
+@interface NutritionixCatalog () {
+    NSString* _path;
+    // guarded by self, searches take it only to pick up the current snapshot
+    NutritionixCatalogSnapshot* _snapshot;
+    // serializes installs
+    NSObject* _installLock;
+}
+@end
+
+@implementation NutritionixCatalog
+
++ (NutritionixCatalog*)sharedCatalog
+{
+    static NutritionixCatalog* sharedCatalog = nil;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        // not in Caches, the catalog is only replaced as a whole or patched against the installed version
+        NSString* libraryFolder = [NSSearchPathForDirectoriesInDomains(NSLibraryDirectory, NSUserDomainMask, YES) objectAtIndex:0];
+        NSString* folder = [libraryFolder stringByAppendingPathComponent:@"NoCloud/Nutritionix"];
+        [[NSFileManager defaultManager] createDirectoryAtPath:folder withIntermediateDirectories:YES attributes:nil error:nil];
+        sharedCatalog = [[NutritionixCatalog alloc] initWithPath:[folder stringByAppendingPathComponent:@"catalog.snapshot"]];
+    });
+    return sharedCatalog;
+}
+
+- (id)initWithPath:(NSString*)path
+{
+    self = [super init];
+    if (self) {
+        _path = path;
+        _installLock = [[NSObject alloc] init];
+        if ([[NSFileManager defaultManager] fileExistsAtPath:path]) {
+            _snapshot = [self mappedSnapshot];
+            if (_snapshot == nil) {
+                NSLog(@"NutritionixCatalog: %@ is corrupt, the catalog is empty", path);
+            }
+        }
+    }
+    return self;
+}
+
+- (NutritionixCatalogSnapshot*)mappedSnapshot
+{
+    // the pages are read from the file as records are touched, nothing is copied up front
+    NSData* data = [NSData dataWithContentsOfFile:_path options:NSDataReadingMappedAlways error:nil];
+
+    return (data != nil) ? [[NutritionixCatalogSnapshot alloc] initWithData:data verify:NO] : nil;
+}
+
+- (NutritionixCatalogSnapshot*)currentSnapshot
+{
+    @synchronized(self) {
+        return _snapshot;
+    }
+}
+
+- (uint32_t)version
+{
+    NutritionixCatalogSnapshot* snapshot = [self currentSnapshot];
+
+    return (snapshot != nil) ? snapshot->_header.version : 0;
+}
+
+- (NSUInteger)count
+{
+    NutritionixCatalogSnapshot* snapshot = [self currentSnapshot];
+
+    return (snapshot != nil) ? snapshot->_header.count : 0;
+}
+
+- (NSDictionary*)itemForGtin:(NSString*)gtin
+{
+    NSArray* items = ([gtin length] == NUTRITIONIX_GTIN_LENGTH) ? [self itemsMatchingText:gtin limit:1] : nil;
+
+    return ([items count] > 0) ? [items objectAtIndex:0] : nil;
+}
+
+- (NSArray*)itemsMatchingText:(NSString*)text limit:(NSUInteger)limit
+{
+    NutritionixCatalogSnapshot* snapshot = [self currentSnapshot];
+
+    if ((snapshot == nil) || (snapshot->_header.count == 0) || ![text isKindOfClass:[NSString class]] || (limit == 0)) {
+        return [NSArray array];
+    }
+
+    const char* utf8 = [text UTF8String];
+    NSMutableData* query = [NSMutableData data];
+    NutritionixCatalogAppendWords(query, (const uint8_t*)utf8, strlen(utf8));
+
+    // there are never more hits than items
+    limit = MIN(limit, (NSUInteger)snapshot->_header.count);
+    NutritionixCatalogHit* hits = malloc(sizeof(NutritionixCatalogHit) * limit);
+    NSUInteger hitCount = 0;
+    size_t length = [query length];
+    const char* words = [query bytes];
+    if ((length >= 4) && (length <= NUTRITIONIX_GTIN_LENGTH + 1) && (strspn(words + 1, "0123456789") == length - 1)) {
+        [self findGtinPrefix:words + 1 length:length - 1 inSnapshot:snapshot hits:hits count:&hitCount limit:limit];
+    } else {
+        [self findWords:query inSnapshot:snapshot hits:hits count:&hitCount limit:limit];
+    }
+
+    NSMutableArray* items = [NSMutableArray arrayWithCapacity:hitCount];
+    for (NSUInteger i = 0; i < hitCount; i++) {
+        NutritionixCatalogRecord record;
+        if ([snapshot getRecord:&record atIndex:hits[i].index]) {
+            [items addObject:NutritionixCatalogItem(&record)];
+        }
+    }
+    free(hits);
+    return items;
+}
+
+// Typed digits are the start of a GTIN-14, or of an EAN-13 or UPC-A that the GTIN pads with one or two zeros.
+- (void)findGtinPrefix:(const char*)digits length:(size_t)length inSnapshot:(NutritionixCatalogSnapshot*)snapshot
+                  hits:(NutritionixCatalogHit*)hits count:(NSUInteger*)hitCount limit:(NSUInteger)limit
+{
+    const uint8_t* end = [snapshot recordsEnd];
+    NSUInteger candidates = 0;
+
+    for (size_t padding = 0; (padding <= 2) && (length + padding <= NUTRITIONIX_GTIN_LENGTH); padding++) {
+        char prefix[NUTRITIONIX_GTIN_LENGTH + 1];
+        size_t prefixLength = length + padding;
+        memset(prefix, '0', padding);
+        memcpy(prefix + padding, digits, length);
+        prefix[prefixLength] = '\0';
+
+        uint32_t index = [snapshot blockBeforePrefix:prefix length:prefixLength] * NUTRITIONIX_CATALOG_BLOCK_SIZE;
+        const uint8_t* p = [snapshot blockStart:index / NUTRITIONIX_CATALOG_BLOCK_SIZE];
+        NutritionixCatalogRecord record;
+        memset(record.gtin, '0', NUTRITIONIX_GTIN_LENGTH);
+        for (; (p != NULL) && (index < snapshot->_header.count) && (candidates < NUTRITIONIX_CATALOG_MAX_CANDIDATES); index++) {
+            p = NutritionixCatalogReadRecord(p, end, &record);
+            int order = (p != NULL) ? strncmp(record.gtin, prefix, prefixLength) : 1;
+            if (order > 0) {
+                break;
+            }
+            if (order == 0) {
+                NutritionixCatalogAddHit(hits, hitCount, limit, record.rank, index);
+                candidates++;
+            }
+        }
+    }
+}
+
+// Records having all trigrams of the typed words are candidates, those with a word starting with each typed word hits.
+- (void)findWords:(NSData*)query inSnapshot:(NutritionixCatalogSnapshot*)snapshot
+             hits:(NutritionixCatalogHit*)hits count:(NSUInteger*)hitCount limit:(NSUInteger)limit
+{
+    NSMutableArray* entries = [NSMutableArray array];
+    __block BOOL missing = NO;
+
+    NutritionixCatalogEnumerateTrigrams([query bytes], [query length], ^(uint32_t key) {
+        NSUInteger entry = [snapshot entryOfTrigram:key];
+        if (entry == NSNotFound) {
+            missing = YES;
+        } else {
+            [entries addObject:[NSNumber numberWithUnsignedInteger:entry]];
+        }
+    });
+    if (missing || ([entries count] == 0)) {
+        return;
+    }
+    // the rarest trigram gives the fewest candidates to start from
+    [entries sortUsingComparator:^NSComparisonResult (NSNumber* a, NSNumber* b) {
+        uint32_t x = [snapshot postingsCountOfEntry:[a unsignedIntegerValue]];
+        uint32_t y = [snapshot postingsCountOfEntry:[b unsignedIntegerValue]];
+        return (x < y) ? NSOrderedAscending : ((x > y) ? NSOrderedDescending : NSOrderedSame);
+    }];
+
+    NSUInteger first = [[entries objectAtIndex:0] unsignedIntegerValue];
+    uint32_t* candidates = malloc(sizeof(uint32_t) * MAX([snapshot postingsCountOfEntry:first], 1));
+    uint32_t candidateCount = [snapshot getPostings:candidates ofEntry:first];
+    for (NSUInteger e = 1; (e < [entries count]) && (candidateCount > 0); e++) {
+        NSUInteger entry = [[entries objectAtIndex:e] unsignedIntegerValue];
+        uint32_t* postings = malloc(sizeof(uint32_t) * MAX([snapshot postingsCountOfEntry:entry], 1));
+        uint32_t postingCount = [snapshot getPostings:postings ofEntry:entry];
+        uint32_t kept = 0;
+        for (uint32_t i = 0, j = 0; (i < candidateCount) && (j < postingCount);) {
+            if (candidates[i] < postings[j]) {
+                i++;
+            } else if (candidates[i] > postings[j]) {
+                j++;
+            } else {
+                candidates[kept++] = candidates[i];
+                i++;
+                j++;
+            }
+        }
+        candidateCount = kept;
+        free(postings);
+    }
+
+    // trigrams do not tell whether the typed words start words of the name, or appear in the same word
+    NSMutableArray* needles = [NSMutableArray array];
+    for (NSString* word in [[[NSString alloc] initWithData:query encoding:NSASCIIStringEncoding] componentsSeparatedByString:@" "]) {
+        if ([word length] > 0) {
+            [needles addObject:[[@" " stringByAppendingString:word] dataUsingEncoding:NSASCIIStringEncoding]];
+        }
+    }
+    for (uint32_t i = 0; (i < candidateCount) && (i < NUTRITIONIX_CATALOG_MAX_CANDIDATES); i++) {
+        NutritionixCatalogRecord record;
+        if (![snapshot getRecord:&record atIndex:candidates[i]]) {
+            continue;
+        }
+        BOOL matches = YES;
+        @autoreleasepool {
+            NSData* normalized = NutritionixCatalogNormalizedRecord(&record);
+            for (NSData* needle in needles) {
+                if (memmem([normalized bytes], [normalized length], [needle bytes], [needle length]) == NULL) {
+                    matches = NO;
+                    break;
+                }
+            }
+        }
+        if (matches) {
+            NutritionixCatalogAddHit(hits, hitCount, limit, record.rank, candidates[i]);
+        }
+    }
+    free(candidates);
+}
+
+- (BOOL)installData:(NSData*)data error:(NSError**)error
+{
+    @synchronized(_installLock) {
+        NutritionixCatalogSnapshot* current = [self currentSnapshot];
+
+        if (([data length] >= 4) && (memcmp([data bytes], "NXD1", 4) == 0)) {
+            data = [self snapshotDataByApplyingPatch:data toSnapshot:current error:error];
+            if (data == nil) {
+                return NO;
+            }
+        }
+        if ([[NutritionixCatalogSnapshot alloc] initWithData:data verify:YES] == nil) {
+            if (error != NULL) {
+                *error = NutritionixCatalogError(@"the catalog is corrupt");
+            }
+            return NO;
+        }
+
+        // searches still running on the old snapshot keep reading its pages after the rename
+        if (![data writeToFile:_path options:NSDataWritingAtomic error:error]) {
+            return NO;
+        }
+        NutritionixCatalogSnapshot* installed = [self mappedSnapshot];
+        if (installed == nil) {
+            if (error != NULL) {
+                *error = NutritionixCatalogError(@"the catalog could not be opened");
+            }
+            return NO;
+        }
+        @synchronized(self) {
+            _snapshot = installed;
+        }
+        return YES;
+    }
+}
+
+// Merges the sorted upserts and removals of the patch with the records of the snapshot.
+- (NSData*)snapshotDataByApplyingPatch:(NSData*)patch toSnapshot:(NutritionixCatalogSnapshot*)snapshot error:(NSError**)error
+{
+    const uint8_t* bytes = [patch bytes];
+    NSUInteger length = [patch length];
+
+    if ((length < NUTRITIONIX_CATALOG_PATCH_HEADER_LENGTH) ||
+        (crc32(0, bytes + NUTRITIONIX_CATALOG_PATCH_HEADER_LENGTH, (uInt)(length - NUTRITIONIX_CATALOG_PATCH_HEADER_LENGTH)) !=
+         OSReadLittleInt32(bytes, 16))) {
+        if (error != NULL) {
+            *error = NutritionixCatalogError(@"the catalog patch is corrupt");
+        }
+        return nil;
+    }
+    uint32_t base = OSReadLittleInt32(bytes, 4);
+    uint32_t version = OSReadLittleInt32(bytes, 8);
+    uint32_t opCount = OSReadLittleInt32(bytes, 12);
+    uint32_t installed = (snapshot != nil) ? snapshot->_header.version : 0;
+    if (base != installed) {
+        if (error != NULL) {
+            *error = NutritionixCatalogError([NSString stringWithFormat:@"the catalog patch is for version %u, version %u is installed", base, installed]);
+        }
+        return nil;
+    }
+
+    uint32_t count = (snapshot != nil) ? snapshot->_header.count : 0;
+    NutritionixCatalogRecord* merged = malloc(sizeof(NutritionixCatalogRecord) * ((size_t)count + opCount + 1));
+    uint32_t mergedCount = 0;
+    const uint8_t* p = (count > 0) ? [snapshot blockStart:0] : NULL;
+    const uint8_t* end = (count > 0) ? [snapshot recordsEnd] : NULL;
+    const uint8_t* op = bytes + NUTRITIONIX_CATALOG_PATCH_HEADER_LENGTH;
+    const uint8_t* opEnd = bytes + length;
+    NutritionixCatalogRecord record;
+    NutritionixCatalogRecord change;
+    uint32_t recordIndex = 0;
+    uint32_t opIndex = 0;
+    BOOL haveRecord = NO;
+    BOOL haveChange = NO;
+    BOOL corrupt = NO;
+    uint8_t kind = 0;
+    char previousGtin[NUTRITIONIX_GTIN_LENGTH + 1] = "";
+
+    memset(record.gtin, '0', NUTRITIONIX_GTIN_LENGTH);
+    while (!corrupt) {
+        if (!haveRecord && (recordIndex < count)) {
+            p = (p != NULL) ? NutritionixCatalogReadRecord(p, end, &record) : NULL;
+            corrupt = (p == NULL);
+            haveRecord = !corrupt;
+            recordIndex++;
+        }
+        if (!haveChange && (opIndex < opCount) && !corrupt) {
+            if ((opEnd - op < 1 + NUTRITIONIX_GTIN_LENGTH) || ((op[0] != NutritionixCatalogUpsert) && (op[0] != NutritionixCatalogRemove))) {
+                corrupt = YES;
+                break;
+            }
+            kind = op[0];
+            memcpy(change.gtin, op + 1, NUTRITIONIX_GTIN_LENGTH);
+            change.gtin[NUTRITIONIX_GTIN_LENGTH] = '\0';
+            op += 1 + NUTRITIONIX_GTIN_LENGTH;
+            if (kind == NutritionixCatalogUpsert) {
+                op = NutritionixCatalogReadFields(op, opEnd, &change);
+                corrupt = (op == NULL);
+            }
+            // ops have to be sorted for the merge
+            corrupt = corrupt || (strcmp(change.gtin, previousGtin) <= 0);
+            memcpy(previousGtin, change.gtin, sizeof(previousGtin));
+            haveChange = !corrupt;
+            opIndex++;
+        }
+        if (corrupt || (!haveRecord && !haveChange)) {
+            break;
+        }
+
+        int order = !haveChange ? -1 : (!haveRecord ? 1 : strcmp(record.gtin, change.gtin));
+        if (order < 0) {
+            merged[mergedCount++] = record;
+            haveRecord = NO;
+        } else {
+            if (kind == NutritionixCatalogUpsert) {
+                merged[mergedCount++] = change;
+            }
+            haveChange = NO;
+            haveRecord = haveRecord && (order != 0);
+        }
+    }
+
+    NSData* data = nil;
+    if (corrupt) {
+        if (error != NULL) {
+            *error = NutritionixCatalogError(@"the catalog patch is corrupt");
+        }
+    } else {
+        data = NutritionixCatalogBuildSnapshot(merged, mergedCount, version);
+    }
+    free(merged);
+    return data;
+}
+
+@end
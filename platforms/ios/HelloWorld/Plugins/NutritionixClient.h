@@ -0,0 +1,71 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#define kNutritionixErrorDomain @"NutritionixErrorDomain"
+// Error code of lookups dropped because a newer scan session started.
+#define kNutritionixErrorCancelled -1
+
+typedef void (^NutritionixLookupCompletion)(NSDictionary* item, NSError* error);
+
+/*
+ * Client for the Nutritionix item API.
+ *
+ * Requests share one keep-alive session. Lookups for a GTIN that is already
+ * being fetched wait for that request instead of sending another; answers
+ * are trimmed to the fields the app shows and written to the item cache.
+ *
+ * Misses go through a bounded queue that runs maxConcurrentLookups requests
+ * at a time. Each lookup also queues, behind the requested ones, a refresh of
+ * cached items of the same company prefix that are about to expire.
+ *
+ * Lookups can be tied to a scan session, a sequence number that grows with
+ * every scan. The first lookup of a newer session cancels the lookups of
+ * older ones, queued or running, and is queued ahead of untied lookups such
+ * as journal replays. Prefetches are found and sent at background priority
+ * and never take the last request slot.
+ */
+@interface NutritionixClient : NSObject
+
+@property (nonatomic, copy) NSString* appId;
+@property (nonatomic, copy) NSString* appKey;
+// Endpoint of the item API. The benchmark harness points it at a local stub server in debug builds.
+// Switching to an endpoint other than the one the persistent cache was filled from clears the cache.
+@property (nonatomic, copy) NSString* itemURL;
+// Seconds before a single request fails, 10 by default.
+@property (nonatomic, assign) NSTimeInterval timeout;
+// Requests sent at the same time, 3 by default.
+@property (nonatomic, assign) NSUInteger maxConcurrentLookups;
+// Lookups waiting for a request slot; beyond this, prefetches are dropped and lookups fail. 64 by default.
+@property (nonatomic, assign) NSUInteger maxQueuedLookups;
+
++ (NutritionixClient*)sharedClient;
+
+// Looks the 14 digit GTIN up, from the cache if it holds the item. The completion always runs on a
+// background queue, also for cache hits, with either the trimmed item or an error.
+- (void)lookupGtin:(NSString*)gtin completion:(NutritionixLookupCompletion)completion;
+// The same for a lookup of the scan session, 0 for none. Lookups of older sessions fail with
+// kNutritionixErrorCancelled as soon as a lookup of a newer one comes in, cached or not.
+- (void)lookupGtin:(NSString*)gtin session:(NSUInteger)session completion:(NutritionixLookupCompletion)completion;
+
+@end
+
+// The UPC-A (or EAN-13) code Nutritionix expects for a GTIN-14.
+NSString* NutritionixUpcForGtin(NSString* gtin);
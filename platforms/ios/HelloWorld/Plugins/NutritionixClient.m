@@ -0,0 +1,510 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import "NutritionixClient.h"
+#import "NutritionixCache.h"
+#import <Cordova/CDVMetrics.h>
+#include <mach/mach_time.h>
+
+#define NUTRITIONIX_ITEM_URL @"https://api.nutritionix.com/v1_1/item"
+// endpoint the persistent cache was filled from
+#define NUTRITIONIX_CACHE_ENDPOINT_KEY @"NutritionixCacheEndpoint"
+#define NUTRITIONIX_CACHE_TTL (7 * 24 * 60 * 60)
+#define NUTRITIONIX_MAX_CONNECTIONS 4
+// GS1 company prefix of a UPC-A code as a GTIN-14: two padding zeros, number system and manufacturer
+#define NUTRITIONIX_COMPANY_PREFIX_LENGTH 8
+// related items refreshed per lookup, and how close to expiry they have to be
+#define NUTRITIONIX_PREFETCH_LIMIT 4
+#define NUTRITIONIX_PREFETCH_HORIZON (24 * 60 * 60)
+// NSURLSessionTaskPriorityHigh and Low (iOS 8+), as literals so older systems do not need the symbols
+#define NUTRITIONIX_PRIORITY_HIGH 0.75f
+#define NUTRITIONIX_PRIORITY_LOW 0.25f
+
+NSString* NutritionixUpcForGtin(NSString* gtin)
+{
+    // strip the padding of the GTIN-14, UPC-A codes have two leading zeros and EAN-13 codes one
+    if ([gtin hasPrefix:@"00"]) {
+        return [gtin substringFromIndex:2];
+    }
+    return [gtin hasPrefix:@"0"] ? [gtin substringFromIndex:1] : gtin;
+}
+
+// Escapes a query parameter value. Unlike stringByAddingPercentEscapesUsingEncoding: this also
+// escapes the characters that delimit query parameters, so a key containing & or = stays one value.
+static NSString* NutritionixQueryEscape(NSString* value)
+{
+    if (value == nil) {
+        return @"";
+    }
+    return (__bridge_transfer NSString*)CFURLCreateStringByAddingPercentEscapes(kCFAllocatorDefault,
+        (__bridge CFStringRef)value, NULL, CFSTR("!*'();:@&=+$,/?%#[]"), kCFStringEncodingUTF8);
+}
+
+// The fields of an item response the app uses, everything else is dropped before it reaches JS.
+static NSDictionary* NutritionixTrimItem(NSDictionary* response)
+{
+    static NSArray* fields = nil;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        fields = [NSArray arrayWithObjects:@"item_id", @"item_name", @"brand_id", @"brand_name",
+            @"item_description", @"nf_calories", @"nf_total_fat", @"nf_saturated_fat", @"nf_sodium",
+            @"nf_total_carbohydrate", @"nf_sugars", @"nf_protein", @"nf_serving_size_qty",
+            @"nf_serving_size_unit", @"nf_serving_weight_grams", nil];
+    });
+
+    NSMutableDictionary* item = [NSMutableDictionary dictionaryWithCapacity:[fields count]];
+    for (NSString* field in fields) {
+        id value = [response objectForKey:field];
+        if ((value != nil) && (value != [NSNull null])) {
+            [item setObject:value forKey:field];
+        }
+    }
+    return item;
+}
+
+static NSError* NutritionixCancelledError(void)
+{
+    return [NSError errorWithDomain:kNutritionixErrorDomain code:kNutritionixErrorCancelled
+                           userInfo:[NSDictionary dictionaryWithObject:@"a newer scan was made" forKey:NSLocalizedDescriptionKey]];
+}
+
+// Answers without a request run on a background queue too, like those of requests.
+static void NutritionixComplete(NutritionixLookupCompletion completion, NSDictionary* item, NSError* error)
+{
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        completion(item, error);
+    });
+}
+
+// A lookup waiting for an answer, with the scan session it belongs to.
+@interface NutritionixWaiter : NSObject
+@property (nonatomic, copy) NutritionixLookupCompletion completion;
+@property (nonatomic, assign) NSUInteger session;
+@end
+
+@implementation NutritionixWaiter
+@end
+
+// One queued or running request for a GTIN and the lookups waiting for it, guarded by the client's _pending.
+@interface NutritionixRequest : NSObject
+@property (nonatomic, strong) NSMutableArray* waiters;
+// newest session of the waiters, 0 if none of them is tied to one
+@property (nonatomic, assign) NSUInteger session;
+// queued by a prefetch, nobody waits for it
+@property (nonatomic, assign) BOOL prefetch;
+@property (nonatomic, assign) BOOL running;
+@property (nonatomic, assign) BOOL cancelled;
+// the NSURLSessionDataTask once it has been sent, so it can be cancelled
+@property (nonatomic, strong) id task;
+// item API the request was sent to, its answer is only cached if that is still the client's
+@property (nonatomic, copy) NSString* endpoint;
+@end
+
+@implementation NutritionixRequest
+@end
+
+@interface NutritionixClient () {
+    // gtin -> NutritionixRequest queued or running for it; also guards the queues, the active count
+    // and the session
+    NSMutableDictionary* _pending;
+    // GTINs waiting for a request slot, those of the current scan session first, then untied lookups,
+    // then prefetches
+    NSMutableArray* _queued;
+    NSMutableArray* _prefetchQueued;
+    NSUInteger _active;
+    // newest scan session seen
+    NSUInteger _scanSession;
+    NSURLSession* _urlSession;
+    NSOperationQueue* _responseQueue;
+}
+@end
+
+@implementation NutritionixClient
+
+@synthesize appId, appKey, timeout, maxConcurrentLookups, maxQueuedLookups;
+
+- (void)setItemURL:(NSString*)itemURL
+{
+    NSUserDefaults* defaults = [NSUserDefaults standardUserDefaults];
+
+    _itemURL = [itemURL copy];
+    // the cache is keyed by GTIN only, so items from another endpoint must not outlive the switch
+    if (![_itemURL isEqualToString:[defaults stringForKey:NUTRITIONIX_CACHE_ENDPOINT_KEY]]) {
+        [[NutritionixCache sharedCache] removeAllItems];
+        [defaults setObject:_itemURL forKey:NUTRITIONIX_CACHE_ENDPOINT_KEY];
+    }
+}
+
++ (NutritionixClient*)sharedClient
+{
+    static NutritionixClient* sharedClient = nil;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        sharedClient = [[NutritionixClient alloc] init];
+    });
+    return sharedClient;
+}
+
+- (id)init
+{
+    self = [super init];
+    if (self) {
+        self.itemURL = NUTRITIONIX_ITEM_URL;
+        self.timeout = 10;
+        self.maxConcurrentLookups = 3;
+        self.maxQueuedLookups = 64;
+        _pending = [[NSMutableDictionary alloc] init];
+        _queued = [[NSMutableArray alloc] init];
+        _prefetchQueued = [[NSMutableArray alloc] init];
+        _responseQueue = [[NSOperationQueue alloc] init];
+        [_responseQueue setMaxConcurrentOperationCount:1];
+    }
+    return self;
+}
+
+// One session for all lookups so the TLS connection to the API is reused (iOS 7+).
+- (NSURLSession*)session
+{
+    if ((_urlSession == nil) && (NSClassFromString(@"NSURLSession") != nil)) {
+        NSURLSessionConfiguration* configuration = [NSURLSessionConfiguration defaultSessionConfiguration];
+        configuration.HTTPMaximumConnectionsPerHost = NUTRITIONIX_MAX_CONNECTIONS;
+        configuration.URLCache = nil;
+        _urlSession = [NSURLSession sessionWithConfiguration:configuration delegate:nil delegateQueue:_responseQueue];
+    }
+    return _urlSession;
+}
+
+- (NSURLRequest*)requestForGtin:(NSString*)gtin endpoint:(NSString*)endpoint prefetch:(BOOL)prefetch
+{
+    NSString* query = [NSString stringWithFormat:@"?upc=%@&appId=%@&appKey=%@",
+        NutritionixUpcForGtin(gtin),
+        NutritionixQueryEscape(self.appId),
+        NutritionixQueryEscape(self.appKey)];
+    NSMutableURLRequest* request = [NSMutableURLRequest requestWithURL:[NSURL URLWithString:[endpoint stringByAppendingString:query]]];
+
+    [request setTimeoutInterval:self.timeout];
+    [request setValue:@"application/json" forHTTPHeaderField:@"Accept"];
+    if (prefetch) {
+        // the system may hold background traffic back while the radio is busy with other requests
+        [request setNetworkServiceType:NSURLNetworkServiceTypeBackground];
+    }
+    return request;
+}
+
+- (void)lookupGtin:(NSString*)gtin completion:(NutritionixLookupCompletion)completion
+{
+    [self lookupGtin:gtin session:0 completion:completion];
+}
+
+- (void)lookupGtin:(NSString*)gtin session:(NSUInteger)session completion:(NutritionixLookupCompletion)completion
+{
+    NSArray* cancelled = nil;
+    BOOL stale = NO;
+    BOOL full = NO;
+
+    // a newer scan cancels the lookups of older ones even when its own is answered from the cache
+    @synchronized(_pending) {
+        if (session > _scanSession) {
+            _scanSession = session;
+            cancelled = [self cancelLookupsBeforeSession:session];
+        }
+    }
+    for (NutritionixWaiter* cancelledWaiter in cancelled) {
+        NutritionixComplete(cancelledWaiter.completion, nil, NutritionixCancelledError());
+    }
+
+    NSDictionary* cached = [[NutritionixCache sharedCache] itemForGtin:gtin];
+    if (cached != nil) {
+        CDV_METRICS_COUNT("lookup.cacheHits", 1);
+        NutritionixComplete(completion, cached, nil);
+        [self prefetchRelatedToGtin:gtin];
+        return;
+    }
+    CDV_METRICS_COUNT("lookup.cacheMisses", 1);
+
+    NutritionixWaiter* waiter = [[NutritionixWaiter alloc] init];
+    waiter.completion = completion;
+    waiter.session = session;
+
+    @synchronized(_pending) {
+        // the answer of a stale lookup would come after that of a newer scan
+        stale = (session != 0) && (session < _scanSession);
+
+        if (!stale) {
+            NutritionixRequest* request = [_pending objectForKey:gtin];
+            if (request != nil) {
+                // the same code was scanned again before the first answer came back, or it is being prefetched
+                [request.waiters addObject:waiter];
+                request.session = MAX(request.session, session);
+                if (!request.running && (request.prefetch || (session != 0))) {
+                    // requeued among the requested lookups, ahead of the untied ones if it belongs to a scan
+                    [(request.prefetch ? _prefetchQueued : _queued) removeObject:gtin];
+                    [self enqueueGtin:gtin session:request.session];
+                } else if (request.running && [request.task respondsToSelector:@selector(setPriority:)]) {
+                    // a running prefetch now answers a scan
+                    [(NSURLSessionTask*)request.task setPriority:NUTRITIONIX_PRIORITY_HIGH];
+                }
+                request.prefetch = NO;
+            } else {
+                if (([_queued count] + [_prefetchQueued count] >= self.maxQueuedLookups) && ([_prefetchQueued count] > 0)) {
+                    // requested lookups take the place of prefetches
+                    [_pending removeObjectForKey:[_prefetchQueued objectAtIndex:0]];
+                    [_prefetchQueued removeObjectAtIndex:0];
+                }
+                full = ([_queued count] >= self.maxQueuedLookups);
+                if (!full) {
+                    request = [[NutritionixRequest alloc] init];
+                    request.waiters = [NSMutableArray arrayWithObject:waiter];
+                    request.session = session;
+                    [_pending setObject:request forKey:gtin];
+                    [self enqueueGtin:gtin session:session];
+                }
+            }
+        }
+    }
+
+    if (stale) {
+        CDV_METRICS_COUNT("lookup.cancelled", 1);
+        NutritionixComplete(completion, nil, NutritionixCancelledError());
+        return;
+    }
+    if (full) {
+        NutritionixComplete(completion, nil, [NSError errorWithDomain:kNutritionixErrorDomain code:0
+                                                             userInfo:[NSDictionary dictionaryWithObject:@"too many lookups queued" forKey:NSLocalizedDescriptionKey]]);
+        return;
+    }
+    [self prefetchRelatedToGtin:gtin];
+    [self startQueuedLookups];
+}
+
+// Queues the GTIN behind the other lookups of the current session, ahead of untied ones. Called with _pending held.
+- (void)enqueueGtin:(NSString*)gtin session:(NSUInteger)session
+{
+    NSUInteger index = [_queued count];
+
+    if (session != 0) {
+        index = [_queued indexOfObjectPassingTest:^BOOL (id queuedGtin, NSUInteger i, BOOL* stop) {
+            return ((NutritionixRequest*)[_pending objectForKey:queuedGtin]).session == 0;
+        }];
+        if (index == NSNotFound) {
+            index = [_queued count];
+        }
+    }
+    [_queued insertObject:gtin atIndex:index];
+}
+
+// Takes the lookups of older sessions off their requests and returns them so they can be failed outside the lock.
+// Requests nobody waits for any more are dropped from the queue, or cancelled if they are running. Called with
+// _pending held.
+- (NSArray*)cancelLookupsBeforeSession:(NSUInteger)session
+{
+    NSMutableArray* cancelled = [NSMutableArray array];
+
+    for (NSString* gtin in [_pending allKeys]) {
+        NutritionixRequest* request = [_pending objectForKey:gtin];
+        NSMutableArray* waiters = [NSMutableArray arrayWithCapacity:[request.waiters count]];
+        NSUInteger newest = 0;
+
+        for (NutritionixWaiter* waiter in request.waiters) {
+            if ((waiter.session != 0) && (waiter.session < session)) {
+                [cancelled addObject:waiter];
+            } else {
+                [waiters addObject:waiter];
+                newest = MAX(newest, waiter.session);
+            }
+        }
+        if ([waiters count] == [request.waiters count]) {
+            continue;
+        }
+        request.waiters = waiters;
+        request.session = newest;
+        if ([waiters count] > 0) {
+            continue;
+        }
+
+        [_pending removeObjectForKey:gtin];
+        if (request.running) {
+            // without NSURLSession (iOS 6) the request runs to the end, its item is still cached
+            request.cancelled = YES;
+            [request.task cancel];
+        } else {
+            [_queued removeObject:gtin];
+        }
+    }
+    if ([cancelled count] > 0) {
+        CDV_METRICS_COUNT("lookup.cancelled", (int64_t)[cancelled count]);
+    }
+    return cancelled;
+}
+
+// Queues refreshes of cached items from the same company that expire soon, nobody waits for them.
+// The cache is searched on a background priority queue so it does not hold up the scan that asked.
+- (void)prefetchRelatedToGtin:(NSString*)gtin
+{
+    if ([gtin length] < NUTRITIONIX_COMPANY_PREFIX_LENGTH) {
+        return;
+    }
+
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+        NSArray* related = [[NutritionixCache sharedCache] gtinsWithPrefix:[gtin substringToIndex:NUTRITIONIX_COMPANY_PREFIX_LENGTH]
+                                                            expiringWithin:NUTRITIONIX_PREFETCH_HORIZON
+                                                                     limit:NUTRITIONIX_PREFETCH_LIMIT];
+        if ([related count] == 0) {
+            return;
+        }
+
+        @synchronized(_pending) {
+            for (NSString* relatedGtin in related) {
+                if ([_queued count] + [_prefetchQueued count] >= self.maxQueuedLookups) {
+                    break;
+                }
+                if ([_pending objectForKey:relatedGtin] == nil) {
+                    NutritionixRequest* request = [[NutritionixRequest alloc] init];
+                    request.waiters = [NSMutableArray array];
+                    request.prefetch = YES;
+                    [_pending setObject:request forKey:relatedGtin];
+                    [_prefetchQueued addObject:relatedGtin];
+                }
+            }
+        }
+        [self startQueuedLookups];
+    });
+}
+
+// Sends queued lookups while fewer than maxConcurrentLookups are running. Prefetches leave one slot free
+// for the next scan.
+- (void)startQueuedLookups
+{
+    while (YES) {
+        NSString* gtin = nil;
+        NutritionixRequest* request = nil;
+        @synchronized(_pending) {
+            NSUInteger limit = MAX(self.maxConcurrentLookups, 1);
+            if (_active >= limit) {
+                return;
+            }
+            NSMutableArray* queue = _queued;
+            if ([queue count] == 0) {
+                if ((limit > 1) && (_active + 1 >= limit)) {
+                    return;
+                }
+                queue = _prefetchQueued;
+            }
+            if ([queue count] == 0) {
+                return;
+            }
+            gtin = [queue objectAtIndex:0];
+            [queue removeObjectAtIndex:0];
+            request = [_pending objectForKey:gtin];
+            request.running = YES;
+            _active++;
+        }
+        [self sendRequest:request forGtin:gtin];
+    }
+}
+
+- (void)sendRequest:(NutritionixRequest*)request forGtin:(NSString*)gtin
+{
+    BOOL prefetch;
+    NSUInteger session;
+    NSString* endpoint = self.itemURL;
+
+    @synchronized(_pending) {
+        prefetch = request.prefetch;
+        session = request.session;
+        request.endpoint = endpoint;
+    }
+
+    NSURLRequest* urlRequest = [self requestForGtin:gtin endpoint:endpoint prefetch:prefetch];
+    uint64_t started = mach_absolute_time();
+    void (^handler)(NSData*, NSURLResponse*, NSError*) = ^(NSData* data, NSURLResponse* response, NSError* error) {
+        mach_timebase_info_data_t timebase;
+        mach_timebase_info(&timebase);
+        CDV_METRICS_RECORD("lookup.request.us", (int64_t)((mach_absolute_time() - started) * timebase.numer / timebase.denom / 1000));
+        if ((error != nil) && !([[error domain] isEqualToString:NSURLErrorDomain] && ([error code] == NSURLErrorCancelled))) {
+            CDV_METRICS_COUNT("lookup.requestErrors", 1);
+        }
+        [self finishRequest:request forGtin:gtin data:data response:response error:error];
+    };
+
+    NSURLSession* urlSession = [self session];
+    if (urlSession != nil) {
+        NSURLSessionDataTask* task = [urlSession dataTaskWithRequest:urlRequest completionHandler:handler];
+        if ([task respondsToSelector:@selector(setPriority:)]) {
+            task.priority = prefetch ? NUTRITIONIX_PRIORITY_LOW : ((session != 0) ? NUTRITIONIX_PRIORITY_HIGH : task.priority);
+        }
+        @synchronized(_pending) {
+            request.task = task;
+            if (request.cancelled) {
+                // a newer scan came in before the task was made
+                [task cancel];
+            }
+        }
+        [task resume];
+    } else {
+        [NSURLConnection sendAsynchronousRequest:urlRequest queue:_responseQueue completionHandler:^(NSURLResponse* response, NSData* data, NSError* error) {
+            handler(data, response, error);
+        }];
+    }
+}
+
+- (void)finishRequest:(NutritionixRequest*)request forGtin:(NSString*)gtin data:(NSData*)data response:(NSURLResponse*)response error:(NSError*)error
+{
+    NSDictionary* item = nil;
+
+    if (error == nil) {
+        NSDictionary* json = (data != nil) ? [NSJSONSerialization JSONObjectWithData:data options:0 error:nil] : nil;
+        NSInteger status = [response isKindOfClass:[NSHTTPURLResponse class]] ? [(NSHTTPURLResponse*)response statusCode] : 0;
+
+        if (![json isKindOfClass:[NSDictionary class]]) {
+            error = [NSError errorWithDomain:kNutritionixErrorDomain code:status
+                                    userInfo:[NSDictionary dictionaryWithObject:@"invalid response" forKey:NSLocalizedDescriptionKey]];
+        } else if ((status != 200) || ([json objectForKey:@"item_name"] == nil)) {
+            NSString* message = [json objectForKey:@"error_message"];
+            error = [NSError errorWithDomain:kNutritionixErrorDomain code:status
+                                    userInfo:[NSDictionary dictionaryWithObject:([message isKindOfClass:[NSString class]] ? message : @"item not found")
+                                                                         forKey:NSLocalizedDescriptionKey]];
+        } else {
+            item = NutritionixTrimItem(json);
+            // an answer from an endpoint switched away from while it was in flight is not cached
+            if ([request.endpoint isEqualToString:self.itemURL]) {
+                [[NutritionixCache sharedCache] setItem:item forGtin:gtin ttl:NUTRITIONIX_CACHE_TTL];
+            }
+        }
+    }
+
+    NSArray* waiters;
+    @synchronized(_pending) {
+        // a cancelled request is no longer pending, a new one for the same GTIN may be
+        if ([_pending objectForKey:gtin] == request) {
+            [_pending removeObjectForKey:gtin];
+        }
+        waiters = request.waiters;
+        request.task = nil;
+        _active--;
+    }
+    for (NutritionixWaiter* waiter in waiters) {
+        waiter.completion(item, error);
+    }
+    [self startQueuedLookups];
+}
+
+@end
@@ -0,0 +1,47 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+/*
+ * Durable journal of scanned GTINs that still have to be looked up.
+ *
+ * Scans are appended as fixed size records to a memory-mapped file, and the
+ * mapping is flushed to disk for a batch of appends at a time rather than for
+ * every scan. The header keeps a replay cursor in front of which every record
+ * is resolved, so pending scans are found without reading the whole journal.
+ * All methods are thread safe.
+ */
+@interface NutritionixJournal : NSObject
+
++ (NutritionixJournal*)sharedJournal;
+
+// Opens (or creates) the journal file at path.
+- (id)initWithPath:(NSString*)path;
+
+// Records a scan. Returns NO if gtin is not 14 digits or the journal is full.
+- (BOOL)appendGtin:(NSString*)gtin;
+// Marks the pending scans of gtin as looked up.
+- (void)resolveGtin:(NSString*)gtin;
+// The oldest pending scans, each GTIN once, at most limit.
+- (NSArray*)pendingGtinsWithLimit:(NSUInteger)limit;
+// Writes the appended scans to disk now.
+- (void)sync;
+
+@end
@@ -0,0 +1,303 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import "NutritionixJournal.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define NUTRITIONIX_JOURNAL_MAGIC 0x4e584a31 // 'NXJ1'
+#define NUTRITIONIX_JOURNAL_GROWTH 256       // records the file grows by
+#define NUTRITIONIX_JOURNAL_MAX_RECORDS 16384
+#define NUTRITIONIX_JOURNAL_SYNC_BATCH 32    // appends that are flushed right away
+#define NUTRITIONIX_JOURNAL_SYNC_DELAY 1     // seconds fewer appends wait for a flush
+#define NUTRITIONIX_GTIN_LENGTH 14
+
+enum {
+    NutritionixJournalPending = 0,
+    NutritionixJournalResolved = 1
+};
+
+typedef struct {
+    uint32_t magic;
+    uint32_t capacity;   // records the file has room for
+    uint32_t count;      // records appended
+    uint32_t replayed;   // every record before this one is resolved
+    uint32_t reserved[4];
+} NutritionixJournalHeader;
+
+typedef struct {
+    char gtin[16];       // 14 digits, NUL padded
+    uint32_t scanned;    // seconds since 1970
+    uint32_t state;
+    uint32_t reserved[2];
+} NutritionixJournalRecord;
+
+static BOOL NutritionixJournalIsGtin(NSString* gtin)
+{
+    if (![gtin isKindOfClass:[NSString class]] || ([gtin length] != NUTRITIONIX_GTIN_LENGTH)) {
+        return NO;
+    }
+    for (NSUInteger i = 0; i < NUTRITIONIX_GTIN_LENGTH; i++) {
+        unichar c = [gtin characterAtIndex:i];
+        if ((c < '0') || (c > '9')) {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+@interface NutritionixJournal () {
+    NSString* _path;
+    int _file;
+    size_t _mappedLength;
+    NutritionixJournalHeader* _header;
+    NutritionixJournalRecord* _records;
+    NSUInteger _unsynced;
+    BOOL _syncScheduled;
+    dispatch_queue_t _syncQueue;
+}
+@end
+
+@implementation NutritionixJournal
+
++ (NutritionixJournal*)sharedJournal
+{
+    static NutritionixJournal* sharedJournal = nil;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        // not in Caches, unresolved scans must survive the system purging it
+        NSString* libraryFolder = [NSSearchPathForDirectoriesInDomains(NSLibraryDirectory, NSUserDomainMask, YES) objectAtIndex:0];
+        NSString* folder = [libraryFolder stringByAppendingPathComponent:@"NoCloud/Nutritionix"];
+        [[NSFileManager defaultManager] createDirectoryAtPath:folder withIntermediateDirectories:YES attributes:nil error:nil];
+        sharedJournal = [[NutritionixJournal alloc] initWithPath:[folder stringByAppendingPathComponent:@"scans.journal"]];
+    });
+    return sharedJournal;
+}
+
+- (id)initWithPath:(NSString*)path
+{
+    self = [super init];
+    if (self) {
+        _path = path;
+        _file = -1;
+        _syncQueue = dispatch_queue_create("com.nutritionix.journal.sync", DISPATCH_QUEUE_SERIAL);
+        if (![self openFile]) {
+            NSLog(@"NutritionixJournal: could not open %@, scans are not kept", path);
+        }
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self sync];
+    [self closeFile];
+    dispatch_release(_syncQueue);
+}
+
+- (BOOL)openFile
+{
+    struct stat fileStat;
+
+    _file = open([_path fileSystemRepresentation], O_RDWR | O_CREAT, 0644);
+    if ((_file < 0) || (fstat(_file, &fileStat) != 0)) {
+        [self closeFile];
+        return NO;
+    }
+
+    NutritionixJournalHeader header;
+    BOOL valid = (fileStat.st_size >= (off_t)sizeof(header)) &&
+        (pread(_file, &header, sizeof(header), 0) == sizeof(header)) &&
+        (header.magic == NUTRITIONIX_JOURNAL_MAGIC) &&
+        (header.capacity <= NUTRITIONIX_JOURNAL_MAX_RECORDS) &&
+        (fileStat.st_size >= (off_t)(sizeof(header) + header.capacity * sizeof(NutritionixJournalRecord))) &&
+        (header.replayed <= header.count) && (header.count <= header.capacity);
+
+    if (!valid) {
+        // new, or written by another version
+        memset(&header, 0, sizeof(header));
+        header.magic = NUTRITIONIX_JOURNAL_MAGIC;
+        header.capacity = NUTRITIONIX_JOURNAL_GROWTH;
+        if ((ftruncate(_file, 0) != 0) || (pwrite(_file, &header, sizeof(header), 0) != sizeof(header))) {
+            [self closeFile];
+            return NO;
+        }
+    }
+    if (![self mapCapacity:header.capacity]) {
+        [self closeFile];
+        return NO;
+    }
+    return YES;
+}
+
+// Sizes the file for capacity records and maps it, replacing an existing mapping.
+- (BOOL)mapCapacity:(uint32_t)capacity
+{
+    size_t length = sizeof(NutritionixJournalHeader) + capacity * sizeof(NutritionixJournalRecord);
+
+    if (ftruncate(_file, length) != 0) {
+        return NO;
+    }
+    void* mapping = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, _file, 0);
+    if (mapping == MAP_FAILED) {
+        return NO;
+    }
+    if (_header != NULL) {
+        munmap(_header, _mappedLength);
+    }
+    _header = mapping;
+    _records = (NutritionixJournalRecord*)((char*)mapping + sizeof(NutritionixJournalHeader));
+    _mappedLength = length;
+    _header->capacity = capacity;
+    return YES;
+}
+
+- (void)closeFile
+{
+    if (_header != NULL) {
+        munmap(_header, _mappedLength);
+        _header = NULL;
+        _records = NULL;
+    }
+    if (_file >= 0) {
+        close(_file);
+        _file = -1;
+    }
+}
+
+// Moves the cursor past the resolved records, and starts over once all of them are.
+- (void)advanceCursor
+{
+    while ((_header->replayed < _header->count) && (_records[_header->replayed].state == NutritionixJournalResolved)) {
+        _header->replayed++;
+    }
+    if (_header->replayed == _header->count) {
+        _header->replayed = 0;
+        _header->count = 0;
+    }
+}
+
+// Flushes once enough appends have piled up, or a moment after the first of a batch.
+- (void)scheduleSync
+{
+    if (++_unsynced >= NUTRITIONIX_JOURNAL_SYNC_BATCH) {
+        dispatch_async(_syncQueue, ^{
+            [self sync];
+        });
+    } else if (!_syncScheduled) {
+        _syncScheduled = YES;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(NUTRITIONIX_JOURNAL_SYNC_DELAY * NSEC_PER_SEC)), _syncQueue, ^{
+            [self sync];
+        });
+    }
+}
+
+#pragma mark -
+#pragma mark Public interface
+
+- (BOOL)appendGtin:(NSString*)gtin
+{
+    if (!NutritionixJournalIsGtin(gtin)) {
+        return NO;
+    }
+
+    @synchronized(self) {
+        if (_header == NULL) {
+            return NO;
+        }
+        if (_header->count == _header->capacity) {
+            if (_header->replayed > 0) {
+                // reuse the space of the resolved records
+                uint32_t live = _header->count - _header->replayed;
+                memmove(_records, _records + _header->replayed, live * sizeof(NutritionixJournalRecord));
+                _header->count = live;
+                _header->replayed = 0;
+            } else if ((_header->capacity >= NUTRITIONIX_JOURNAL_MAX_RECORDS) ||
+                       ![self mapCapacity:MIN(_header->capacity + NUTRITIONIX_JOURNAL_GROWTH, NUTRITIONIX_JOURNAL_MAX_RECORDS)]) {
+                return NO;
+            }
+        }
+
+        NutritionixJournalRecord* record = &_records[_header->count];
+        memset(record, 0, sizeof(*record));
+        memcpy(record->gtin, [gtin UTF8String], NUTRITIONIX_GTIN_LENGTH);
+        record->scanned = (uint32_t)time(NULL);
+        record->state = NutritionixJournalPending;
+        // the count only covers the record once it is complete
+        _header->count++;
+        [self scheduleSync];
+    }
+    return YES;
+}
+
+- (void)resolveGtin:(NSString*)gtin
+{
+    if (!NutritionixJournalIsGtin(gtin)) {
+        return;
+    }
+    const char* digits = [gtin UTF8String];
+
+    @synchronized(self) {
+        if (_header == NULL) {
+            return;
+        }
+        BOOL resolved = NO;
+        for (uint32_t i = _header->replayed; i < _header->count; i++) {
+            if ((_records[i].state == NutritionixJournalPending) && (memcmp(_records[i].gtin, digits, NUTRITIONIX_GTIN_LENGTH) == 0)) {
+                _records[i].state = NutritionixJournalResolved;
+                resolved = YES;
+            }
+        }
+        if (resolved) {
+            [self advanceCursor];
+            [self scheduleSync];
+        }
+    }
+}
+
+- (NSArray*)pendingGtinsWithLimit:(NSUInteger)limit
+{
+    NSMutableOrderedSet* gtins = [NSMutableOrderedSet orderedSet];
+
+    @synchronized(self) {
+        for (uint32_t i = (_header != NULL) ? _header->replayed : 0; (_header != NULL) && (i < _header->count) && ([gtins count] < limit); i++) {
+            if (_records[i].state == NutritionixJournalPending) {
+                [gtins addObject:[[NSString alloc] initWithBytes:_records[i].gtin length:NUTRITIONIX_GTIN_LENGTH encoding:NSASCIIStringEncoding]];
+            }
+        }
+    }
+    return [gtins array];
+}
+
+- (void)sync
+{
+    @synchronized(self) {
+        _unsynced = 0;
+        _syncScheduled = NO;
+        if (_header != NULL) {
+            msync(_header, _mappedLength, MS_SYNC);
+            fsync(_file);
+        }
+    }
+}
+
+@end
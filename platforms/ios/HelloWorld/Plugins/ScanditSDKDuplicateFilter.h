@@ -0,0 +1,51 @@
+//
+//  Copyright 2010 Mirasense AG
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+//  ScanditSDKDuplicateFilter remembers the barcodes that were recently reported by the decoder,
+//  such that a code which stays in the camera frame is only passed on once.
+//
+
+#import <Foundation/Foundation.h>
+
+// Number of distinct barcodes remembered. The oldest entry is overwritten when it is full.
+#define SCANDIT_DUPLICATE_FILTER_SIZE 16
+
+@interface ScanditSDKDuplicateFilter : NSObject {
+    uint64_t hashes[SCANDIT_DUPLICATE_FILTER_SIZE];
+    CFAbsoluteTime lastSeen[SCANDIT_DUPLICATE_FILTER_SIZE];
+    NSUInteger count;
+    NSUInteger next;
+}
+
+/**
+ * Time in seconds during which a barcode is suppressed after it was last seen. A window of 0
+ * disables the filter.
+ */
+@property (nonatomic, assign) CFTimeInterval window;
+
+/**
+ * Forgets all barcodes seen so far.
+ */
+- (void)reset;
+
+/**
+ * Returns YES if the same barcode of the same symbology was seen within the window. Every call
+ * counts as a sighting, so a code that stays in frame keeps being suppressed until it was out of
+ * sight for the length of the window.
+ */
+- (BOOL)isDuplicateBarcode:(NSString *)barcode symbology:(NSString *)symbology;
+
+@end
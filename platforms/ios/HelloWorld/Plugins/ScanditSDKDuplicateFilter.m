@@ -0,0 +1,74 @@
+//
+//  Copyright 2010 Mirasense AG
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+
+#import "ScanditSDKDuplicateFilter.h"
+
+/**
+ * 64 bit FNV-1a hash over the UTF-8 bytes of the string, continued from the given hash.
+ */
+static uint64_t ScanditSDKHashString(uint64_t hash, NSString *string) {
+    const unsigned char *bytes = (const unsigned char *) [string UTF8String];
+    if (bytes == NULL) {
+        return hash;
+    }
+    while (*bytes != '\0') {
+        hash ^= *bytes++;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+
+@implementation ScanditSDKDuplicateFilter
+
+@synthesize window;
+
+- (void)reset {
+    count = 0;
+    next = 0;
+}
+
+- (BOOL)isDuplicateBarcode:(NSString *)barcode symbology:(NSString *)symbology {
+    if (self.window <= 0) {
+        return NO;
+    }
+    
+    // The separator keeps ("A", "BC") and ("AB", "C") apart.
+    uint64_t hash = ScanditSDKHashString(14695981039346656037ULL, symbology);
+    hash ^= 0xFF;
+    hash *= 1099511628211ULL;
+    hash = ScanditSDKHashString(hash, barcode);
+    
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < count; i++) {
+        if (hashes[i] == hash) {
+            BOOL duplicate = (now - lastSeen[i] < self.window);
+            lastSeen[i] = now;
+            return duplicate;
+        }
+    }
+    
+    hashes[next] = hash;
+    lastSeen[next] = now;
+    next = (next + 1) % SCANDIT_DUPLICATE_FILTER_SIZE;
+    if (count < SCANDIT_DUPLICATE_FILTER_SIZE) {
+        count++;
+    }
+    return NO;
+}
+
+@end
@@ -0,0 +1,154 @@
+//
+//  Copyright 2010 Mirasense AG
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+
+#import "ScanditSDKGtin.h"
+
+#define SCANDIT_GTIN_LENGTH 14
+
+/**
+ * Copies the code into digits as numbers, returns NO if it is longer than maxLength or contains
+ * anything but digits.
+ */
+static BOOL ScanditSDKParseDigits(NSString *code, int *digits, NSUInteger maxLength,
+                                  NSUInteger *length) {
+    NSUInteger n = [code length];
+    if (n == 0 || n > maxLength) {
+        return NO;
+    }
+    for (NSUInteger i = 0; i < n; i++) {
+        unichar c = [code characterAtIndex:i];
+        if (c < '0' || c > '9') {
+            return NO;
+        }
+        digits[i] = c - '0';
+    }
+    *length = n;
+    return YES;
+}
+
+/**
+ * Computes the check digit over the first length digits, weighting them 3 and 1 alternately
+ * starting from the rightmost.
+ */
+static int ScanditSDKCheckDigit(const int *digits, NSUInteger length) {
+    int sum = 0;
+    int weight = 3;
+    for (NSUInteger i = length; i > 0; i--) {
+        sum += digits[i - 1] * weight;
+        weight = 4 - weight;
+    }
+    return (10 - sum % 10) % 10;
+}
+
+/**
+ * Validates the check digit of an EAN-8, UPC-A, EAN-13 or GTIN-14 and writes it zero-padded to
+ * 14 digits into gtin.
+ */
+static BOOL ScanditSDKPadGtin(const int *digits, NSUInteger length, int *gtin) {
+    if (length != 8 && length != 12 && length != 13 && length != 14) {
+        return NO;
+    }
+    if (ScanditSDKCheckDigit(digits, length - 1) != digits[length - 1]) {
+        return NO;
+    }
+    NSUInteger padding = SCANDIT_GTIN_LENGTH - length;
+    for (NSUInteger i = 0; i < padding; i++) {
+        gtin[i] = 0;
+    }
+    memcpy(gtin + padding, digits, length * sizeof(int));
+    return YES;
+}
+
+/**
+ * Expands a UPC-E code to UPC-A. The code is given either as its six data digits, with the number
+ * system digit in front, or with the number system and check digits (6, 7 or 8 digits). The check
+ * digit is validated if present.
+ */
+static BOOL ScanditSDKExpandUpce(const int *digits, NSUInteger length, int *upca) {
+    if (length < 6 || length > 8) {
+        return NO;
+    }
+    int numberSystem = (length == 6) ? 0 : digits[0];
+    if (numberSystem > 1) {
+        return NO;
+    }
+    const int *d = (length == 6) ? digits : digits + 1;
+    
+    // Manufacturer code (5 digits) and product code (5 digits) of the UPC-A, zeros elsewhere.
+    int *manufacturer = upca + 1;
+    int *product = upca + 6;
+    memset(upca, 0, 12 * sizeof(int));
+    upca[0] = numberSystem;
+    switch (d[5]) {
+        case 0: case 1: case 2:
+            manufacturer[0] = d[0]; manufacturer[1] = d[1]; manufacturer[2] = d[5];
+            product[2] = d[2]; product[3] = d[3]; product[4] = d[4];
+            break;
+        case 3:
+            manufacturer[0] = d[0]; manufacturer[1] = d[1]; manufacturer[2] = d[2];
+            product[3] = d[3]; product[4] = d[4];
+            break;
+        case 4:
+            manufacturer[0] = d[0]; manufacturer[1] = d[1]; manufacturer[2] = d[2];
+            manufacturer[3] = d[3];
+            product[4] = d[4];
+            break;
+        default:
+            memcpy(manufacturer, d, 5 * sizeof(int));
+            product[4] = d[5];
+            break;
+    }
+    upca[11] = ScanditSDKCheckDigit(upca, 11);
+    return length < 8 || upca[11] == digits[7];
+}
+
+BOOL ScanditSDKIsGtinSymbology(NSString *symbology) {
+    return [symbology isEqualToString:@"EAN13"] || [symbology isEqualToString:@"UPC12"]
+        || [symbology isEqualToString:@"EAN8"] || [symbology isEqualToString:@"UPCE"];
+}
+
+NSString *ScanditSDKNormalizedGtin(NSString *barcode, NSString *symbology) {
+    int digits[SCANDIT_GTIN_LENGTH];
+    NSUInteger length = 0;
+    if (!ScanditSDKParseDigits(barcode, digits, SCANDIT_GTIN_LENGTH, &length)) {
+        return nil;
+    }
+    
+    int gtin[SCANDIT_GTIN_LENGTH];
+    int upca[12];
+    BOOL valid = NO;
+    if ([symbology isEqualToString:@"UPCE"]) {
+        valid = ScanditSDKExpandUpce(digits, length, upca) && ScanditSDKPadGtin(upca, 12, gtin);
+    } else if ([symbology isEqualToString:@"UNKNOWN"]) {
+        // Eight digits are either an EAN-8 or a UPC-E including number system and check digit.
+        valid = ScanditSDKPadGtin(digits, length, gtin);
+        if (!valid && length == 8 && ScanditSDKExpandUpce(digits, length, upca)) {
+            valid = ScanditSDKPadGtin(upca, 12, gtin);
+        }
+    } else if (ScanditSDKIsGtinSymbology(symbology)) {
+        valid = ScanditSDKPadGtin(digits, length, gtin);
+    }
+    if (!valid) {
+        return nil;
+    }
+    
+    unichar characters[SCANDIT_GTIN_LENGTH];
+    for (int i = 0; i < SCANDIT_GTIN_LENGTH; i++) {
+        characters[i] = '0' + gtin[i];
+    }
+    return [NSString stringWithCharacters:characters length:SCANDIT_GTIN_LENGTH];
+}
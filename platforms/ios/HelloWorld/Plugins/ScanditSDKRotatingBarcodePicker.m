@@ -21,10 +21,20 @@
 
 #import "ScanditSDKRotatingBarcodePicker.h"
 #import "ScanditSDKOverlayController.h"
+#import "Cordova/CDVViewController.h"
 #import <objc/runtime.h>
 
+/** The orientations of the project settings, read once instead of every time UIKit asks. */
+static NSUInteger supportedOrientationMask = 0;
+
 @implementation ScanditSDKRotatingBarcodePicker
 
++ (void)initialize {
+    if (self == [ScanditSDKRotatingBarcodePicker class]) {
+        supportedOrientationMask = [CDVViewController supportedInterfaceOrientationMask];
+    }
+}
+
 
 - (id)initWithAppKey:(NSString *)scanditSDKAppKey {
     id result = [super initWithAppKey:scanditSDKAppKey];
@@ -39,58 +49,13 @@
 }
 
 - (NSUInteger)supportedInterfaceOrientations {
-    // Check the project settings for screen orientation and only allow the specified ones.
-    
-    NSArray *orientations;
-    if (UI_USER_INTERFACE_IDIOM() != UIUserInterfaceIdiomPad) {
-        orientations = [[NSBundle mainBundle] objectForInfoDictionaryKey:@"UISupportedInterfaceOrientations"];
-    } else {
-        orientations = [[NSBundle mainBundle] objectForInfoDictionaryKey:@"UISupportedInterfaceOrientations"];
-    }
-    NSUInteger supportedOrientations = 0;
-    
-    if ([orientations containsObject:@"UIInterfaceOrientationPortrait"]) {
-        supportedOrientations = supportedOrientations | (1 << UIInterfaceOrientationPortrait);
-    }
-    if ([orientations containsObject:@"UIInterfaceOrientationPortraitUpsideDown"]) {
-        supportedOrientations = supportedOrientations | (1 << UIInterfaceOrientationPortraitUpsideDown);
-    }
-    if ([orientations containsObject:@"UIInterfaceOrientationLandscapeLeft"]) {
-        supportedOrientations = supportedOrientations | (1 << UIInterfaceOrientationLandscapeLeft);
-    }
-    if ([orientations containsObject:@"UIInterfaceOrientationLandscapeRight"]) {
-        supportedOrientations = supportedOrientations | (1 << UIInterfaceOrientationLandscapeRight);
-    }
-    
-    return supportedOrientations;
+    // Only allow the orientations of the project settings.
+    return supportedOrientationMask;
 }
 
 - (BOOL)shouldAutorotateToInterfaceOrientation:(UIInterfaceOrientation)interfaceOrientation {
-    // Check the project settings for screen orientation and only allow rotation to the specified
-    // ones.
-    
-    NSArray *orientations;
-    if (UI_USER_INTERFACE_IDIOM() != UIUserInterfaceIdiomPad) {
-        orientations = [[NSBundle mainBundle] objectForInfoDictionaryKey:@"UISupportedInterfaceOrientations"];
-    } else {
-        orientations = [[NSBundle mainBundle] objectForInfoDictionaryKey:@"UISupportedInterfaceOrientations"];
-    }
-    
-    if ([orientations containsObject:@"UIInterfaceOrientationPortrait"]
-		&& interfaceOrientation == UIInterfaceOrientationPortrait) {
-        return YES;
-    } else if ([orientations containsObject:@"UIInterfaceOrientationPortraitUpsideDown"]
-               && interfaceOrientation == UIInterfaceOrientationPortraitUpsideDown) {
-        return YES;
-    } else if ([orientations containsObject:@"UIInterfaceOrientationLandscapeLeft"]
-               && interfaceOrientation == UIInterfaceOrientationLandscapeLeft) {
-        return YES;
-    } else if ([orientations containsObject:@"UIInterfaceOrientationLandscapeRight"]
-               && interfaceOrientation == UIInterfaceOrientationLandscapeRight) {
-        return YES;
-    } else {
-        return NO;
-    }
+    // Only allow rotation to the orientations of the project settings.
+    return (supportedOrientationMask & (1 << interfaceOrientation)) != 0;
 }
 
 - (BOOL)shouldAutorotate {
@@ -0,0 +1,165 @@
+//
+//  Copyright 2010 Mirasense AG
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+//  ScanditSDKScanProfile holds the options of a scan call compiled into plain values. The options
+//  dictionary is validated and parsed once, and the compiled profile is then applied to a barcode
+//  picker without looking at the dictionary again.
+//
+
+#import <Foundation/Foundation.h>
+#import "ScanditSDKBarcodePicker.h"
+#import "ScanditSDKOverlayController.h"
+#import "ScanditSDKSymbologies.h"
+
+// Value of a switch that was not part of the options. The SDK default is kept for these.
+#define SCANDIT_SWITCH_UNSET -1
+
+// Duplicate filter window in milliseconds used when the option is not given.
+#define SCANDIT_DEFAULT_DUPLICATE_FILTER_WINDOW 1000
+
+// Milliseconds without a result after which the fallback symbologies of an adaptive session are
+// enabled, used when the option is not given.
+#define SCANDIT_DEFAULT_FALLBACK_DELAY 3000
+
+// Milliseconds a multi-code scan keeps collecting after its first code, used when the option is
+// not given.
+#define SCANDIT_DEFAULT_MULTI_CODE_WINDOW 800
+
+// Suggestions shown below the search bar at most, used when the option is not given.
+#define SCANDIT_DEFAULT_SUGGESTION_LIMIT 4
+
+typedef struct {
+    CameraFacingDirection facing;
+    
+    // Switches are SCANDIT_SWITCH_UNSET, 0 (disabled) or 1 (enabled).
+    signed char searchBar;
+    signed char scanning1D;
+    signed char scanning2D;
+    signed char ean13AndUpc12;
+    signed char ean8;
+    signed char upce;
+    signed char code39;
+    signed char code128;
+    signed char itf;
+    signed char qr;
+    signed char dataMatrix;
+    signed char pdf417;
+    signed char msiPlessey;
+    signed char inverseRecognition;
+    signed char microDataMatrix;
+    signed char force2d;
+    signed char restrictActiveScanningArea;
+    signed char beep;
+    signed char vibrate;
+    signed char torch;
+    signed char adaptiveSymbologies;
+    
+    BOOL hasMsiPlesseyChecksumType;
+    MsiPlesseyChecksumType msiPlesseyChecksumType;
+    
+    BOOL hasScanningHotspot;
+    float scanningHotspot[2];
+    BOOL hasScanningHotspotHeight;
+    float scanningHotspotHeight;
+    BOOL hasViewfinderSize;
+    float viewfinderSize[4];
+    BOOL hasTorchButtonPositionAndSize;
+    float torchButtonPositionAndSize[4];
+    BOOL hasCameraSwitchVisibility;
+    CameraSwitchVisibility cameraSwitchVisibility;
+    BOOL hasCameraSwitchButtonPositionAndSize;
+    float cameraSwitchButtonPositionAndSize[4];
+    BOOL hasLogoOffsets;
+    float logoOffsets[4];
+    
+    BOOL hasViewfinderColor;
+    float viewfinderColor[3];
+    BOOL hasViewfinderDecodedColor;
+    float viewfinderDecodedColor[3];
+    
+    BOOL hasMinSearchBarBarcodeLength;
+    NSInteger minSearchBarBarcodeLength;
+    BOOL hasMaxSearchBarBarcodeLength;
+    NSInteger maxSearchBarBarcodeLength;
+} ScanditSDKPickerSettings;
+
+typedef struct {
+    BOOL continuous;
+    
+    // Whether the scan screen is presented and dismissed with an animation.
+    BOOL animated;
+    
+    // Whether results carry the timings of the scan stages.
+    BOOL timings;
+    
+    // Whether results are passed as arrays instead of objects.
+    BOOL arrayResults;
+    
+    // Symbologies enabled in addition to the GTIN ones once an adaptive session went
+    // fallbackDelay milliseconds without a result.
+    ScanditSDKSymbologySet fallbackSymbologies;
+    NSInteger fallbackDelay;
+    
+    // Milliseconds during which a barcode that was just reported is not reported again.
+    NSInteger duplicateFilterWindow;
+    
+    // Results of a continuous session are delivered in batches of up to batchSize results, or
+    // after batchInterval milliseconds if fewer were collected. Both at 1 and 0 disable batching.
+    NSInteger batchSize;
+    NSInteger batchInterval;
+    
+    // A scan that is not continuous collects the distinct codes decoded within multiCodeWindow
+    // milliseconds after the first one and delivers them together.
+    BOOL multiCode;
+    NSInteger multiCodeWindow;
+    
+    // Suggestions of the suggestionSource plugin shown at most while typing into the search bar.
+    NSInteger suggestionLimit;
+} ScanditSDKSessionSettings;
+
+@interface ScanditSDKScanProfile : NSObject {
+    @public
+    ScanditSDKPickerSettings picker;
+    ScanditSDKSessionSettings session;
+}
+
+@property (nonatomic, readonly, copy) NSString *searchBarActionButtonCaption;
+@property (nonatomic, readonly, copy) NSString *searchBarCancelButtonCaption;
+@property (nonatomic, readonly, copy) NSString *searchBarPlaceholderText;
+@property (nonatomic, readonly, copy) NSString *toolBarButtonCaption;
+
+// Name of the plugin suggesting codes for the text typed into the search bar, nil for none.
+@property (nonatomic, readonly, copy) NSString *suggestionSource;
+
+/**
+ * Compiles the given scan options (see ScanditSDK.h). The keys of options that are present but
+ * have the wrong type or format are added to invalidKeys, the options themselves are ignored.
+ */
++ (ScanditSDKScanProfile *)profileWithOptions:(NSDictionary *)options
+                                  invalidKeys:(NSMutableArray *)invalidKeys;
+
+/**
+ * Returns YES if a picker configured with the given profile is configured the same way as
+ * one configured with this profile. Options that only affect the scan session are ignored.
+ */
+- (BOOL)hasSamePickerSettingsAs:(ScanditSDKScanProfile *)profile;
+
+/**
+ * Applies the picker settings to a newly created picker.
+ */
+- (void)applyToPicker:(ScanditSDKBarcodePicker *)picker;
+
+@end
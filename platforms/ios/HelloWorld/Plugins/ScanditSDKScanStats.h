@@ -0,0 +1,84 @@
+//
+//  Copyright 2010 Mirasense AG
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+//  ScanditSDKScanStats timestamps the stages of a scan with a monotonic clock and collects the
+//  time from the scan call to every stage into a histogram over all scans.
+//
+
+#import <Foundation/Foundation.h>
+
+typedef enum {
+    SCANDIT_STAGE_SCAN_CALLED = 0,
+    SCANDIT_STAGE_PICKER_READY,
+    SCANDIT_STAGE_PRESENTED,
+    SCANDIT_STAGE_SCANNING_STARTED,
+    SCANDIT_STAGE_FIRST_RESULT,
+    SCANDIT_STAGE_RESULT_DELIVERED,
+    SCANDIT_STAGE_COUNT
+} ScanditSDKScanStage;
+
+// Upper bounds in milliseconds of the histogram buckets, a last bucket holds everything above.
+#define SCANDIT_HISTOGRAM_BOUNDS { 10, 25, 50, 100, 250, 500, 1000, 2500, 5000 }
+#define SCANDIT_HISTOGRAM_BUCKETS 10
+
+typedef struct {
+    NSUInteger count;
+    double min;
+    double max;
+    double sum;
+    NSUInteger buckets[SCANDIT_HISTOGRAM_BUCKETS];
+} ScanditSDKHistogram;
+
+@interface ScanditSDKScanStats : NSObject {
+    uint64_t stamps[SCANDIT_STAGE_COUNT];
+    BOOL scanRecorded;
+    ScanditSDKHistogram histograms[SCANDIT_STAGE_COUNT];
+}
+
+/**
+ * Starts timing a new scan, the scan call stage is stamped with the current time.
+ */
+- (void)beginScan;
+
+/**
+ * Stamps the stage with the current time unless it was already reached during this scan.
+ */
+- (void)markStage:(ScanditSDKScanStage)stage;
+
+/**
+ * Adds the times of the current scan to the histograms once its first result was delivered.
+ * Further calls for the same scan have no effect.
+ */
+- (void)endScan;
+
+/**
+ * Milliseconds from the scan call to every stage the current scan reached so far, keyed by stage
+ * name.
+ */
+- (NSDictionary *)currentTimings;
+
+/**
+ * Count, min, max, mean and histogram bucket counts of every stage over all recorded scans, keyed
+ * by stage name.
+ */
+- (NSDictionary *)statistics;
+
+/**
+ * Clears the histograms.
+ */
+- (void)reset;
+
+@end
@@ -0,0 +1,70 @@
+//
+//  Copyright 2010 Mirasense AG
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+//  ScanditSDKSuggestionList shows codes matching the text typed into the search bar of the scan
+//  screen in a list below it, as the user types. The suggestions come from another plugin.
+//
+
+#import <UIKit/UIKit.h>
+
+@class ScanditSDKSuggestionList;
+
+/**
+ * Implemented by plugins that suggest codes for the search bar, named by the suggestionSource
+ * scan option. Called on a background queue for every change of the text, so it has to be
+ * thread safe and fast, without network. Suggestions are dictionaries of the barcode that is
+ * reported when a suggestion is picked, a title and an optional subtitle.
+ */
+@protocol ScanditSDKSuggestionSource <NSObject>
+
+- (NSArray *)scanditSDKSuggestionsForText:(NSString *)text limit:(NSUInteger)limit;
+
+@end
+
+@protocol ScanditSDKSuggestionListDelegate <NSObject>
+
+/**
+ * The user picked the suggestion of the given barcode.
+ */
+- (void)suggestionList:(ScanditSDKSuggestionList *)suggestionList didSelectBarcode:(NSString *)barcode;
+
+@end
+
+@interface ScanditSDKSuggestionList : NSObject <UITableViewDataSource, UITableViewDelegate>
+
+@property (nonatomic, assign) id<ScanditSDKSuggestionListDelegate> delegate;
+
+/**
+ * A list showing at most limit suggestions of the given source.
+ */
+- (id)initWithSource:(id<ScanditSDKSuggestionSource>)source limit:(NSUInteger)limit;
+
+/**
+ * Starts following the text of the search bar, showing the list in view right below it.
+ */
+- (void)attachToSearchBar:(UISearchBar *)searchBar inView:(UIView *)view;
+
+/**
+ * Stops following the search bar and removes the list.
+ */
+- (void)detach;
+
+/**
+ * Hides the suggestions until the text changes again.
+ */
+- (void)clear;
+
+@end
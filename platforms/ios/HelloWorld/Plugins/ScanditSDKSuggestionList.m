@@ -0,0 +1,170 @@
+//
+//  Copyright 2010 Mirasense AG
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+
+#import "ScanditSDKSuggestionList.h"
+
+#define SCANDIT_SUGGESTION_ROW_HEIGHT 44
+
+
+@interface ScanditSDKSuggestionList () {
+    dispatch_queue_t queue;
+    // Incremented for every change of the text, suggestions for older text are dropped.
+    NSUInteger generation;
+}
+
+@property (nonatomic, retain) id<ScanditSDKSuggestionSource> source;
+@property (nonatomic, assign) NSUInteger limit;
+@property (nonatomic, retain) UISearchBar *searchBar;
+@property (nonatomic, retain) UITableView *tableView;
+@property (nonatomic, retain) NSArray *suggestions;
+
+@end
+
+
+@implementation ScanditSDKSuggestionList
+
+@synthesize delegate;
+@synthesize source;
+@synthesize limit;
+@synthesize searchBar;
+@synthesize tableView;
+@synthesize suggestions;
+
+- (id)initWithSource:(id<ScanditSDKSuggestionSource>)aSource limit:(NSUInteger)aLimit {
+    self = [super init];
+    if (self) {
+        self.source = aSource;
+        self.limit = MAX(aLimit, (NSUInteger)1);
+        self.suggestions = [NSArray array];
+        queue = dispatch_queue_create("com.mirasense.scanditsdk.suggestions", DISPATCH_QUEUE_SERIAL);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    dispatch_release(queue);
+}
+
+- (void)attachToSearchBar:(UISearchBar *)aSearchBar inView:(UIView *)view {
+    [self detach];
+    self.searchBar = aSearchBar;
+    
+    CGRect searchBarFrame = [aSearchBar convertRect:aSearchBar.bounds toView:view];
+    UITableView *list = [[UITableView alloc] initWithFrame:CGRectMake(0, CGRectGetMaxY(searchBarFrame),
+                                                                      view.bounds.size.width, 0)
+                                                     style:UITableViewStylePlain];
+    list.autoresizingMask = UIViewAutoresizingFlexibleWidth;
+    list.rowHeight = SCANDIT_SUGGESTION_ROW_HEIGHT;
+    list.dataSource = self;
+    list.delegate = self;
+    list.hidden = YES;
+    [view addSubview:list];
+    self.tableView = list;
+    
+    // The overlay controller is the delegate of the search bar, so its text field is observed.
+    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(textDidChange:)
+                                                 name:UITextFieldTextDidChangeNotification object:nil];
+}
+
+- (void)detach {
+    [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                    name:UITextFieldTextDidChangeNotification object:nil];
+    [self clear];
+    [self.tableView removeFromSuperview];
+    self.tableView = nil;
+    self.searchBar = nil;
+}
+
+- (void)clear {
+    generation++;
+    [self showSuggestions:[NSArray array]];
+}
+
+- (void)textDidChange:(NSNotification *)notification {
+    UITextField *field = [notification object];
+    if (![field isKindOfClass:[UIView class]] || ![field isDescendantOfView:self.searchBar]) {
+        return;
+    }
+    
+    NSString *text = [field.text stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+    NSUInteger textGeneration = ++generation;
+    if ([text length] == 0) {
+        [self showSuggestions:[NSArray array]];
+        return;
+    }
+    
+    // Searching never holds up typing, and only the answer for the latest text is shown.
+    id<ScanditSDKSuggestionSource> suggestionSource = self.source;
+    NSUInteger suggestionLimit = self.limit;
+    dispatch_async(queue, ^{
+        if (textGeneration != generation) {
+            return;
+        }
+        NSArray *found = [suggestionSource scanditSDKSuggestionsForText:text limit:suggestionLimit];
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (textGeneration == generation) {
+                [self showSuggestions:([found isKindOfClass:[NSArray class]] ? found : [NSArray array])];
+            }
+        });
+    });
+}
+
+- (void)showSuggestions:(NSArray *)found {
+    self.suggestions = found;
+    [self.tableView reloadData];
+    
+    CGRect frame = self.tableView.frame;
+    frame.size.height = MIN([found count], self.limit) * SCANDIT_SUGGESTION_ROW_HEIGHT;
+    self.tableView.frame = frame;
+    self.tableView.hidden = ([found count] == 0);
+}
+
+#pragma mark -
+#pragma mark UITableViewDataSource and UITableViewDelegate methods
+
+- (NSInteger)tableView:(UITableView *)aTableView numberOfRowsInSection:(NSInteger)section {
+    return MIN([self.suggestions count], self.limit);
+}
+
+- (UITableViewCell *)tableView:(UITableView *)aTableView cellForRowAtIndexPath:(NSIndexPath *)indexPath {
+    static NSString *identifier = @"ScanditSDKSuggestion";
+    UITableViewCell *cell = [aTableView dequeueReusableCellWithIdentifier:identifier];
+    if (cell == nil) {
+        cell = [[UITableViewCell alloc] initWithStyle:UITableViewCellStyleSubtitle
+                                      reuseIdentifier:identifier];
+    }
+    
+    NSDictionary *suggestion = [self.suggestions objectAtIndex:indexPath.row];
+    id title = [suggestion objectForKey:@"title"];
+    id subtitle = [suggestion objectForKey:@"subtitle"];
+    cell.textLabel.text = [title isKindOfClass:[NSString class]] ? title : [suggestion objectForKey:@"barcode"];
+    cell.detailTextLabel.text = [subtitle isKindOfClass:[NSString class]] ? subtitle : nil;
+    return cell;
+}
+
+- (void)tableView:(UITableView *)aTableView didSelectRowAtIndexPath:(NSIndexPath *)indexPath {
+    NSString *barcode = [[self.suggestions objectAtIndex:indexPath.row] objectForKey:@"barcode"];
+    [aTableView deselectRowAtIndexPath:indexPath animated:NO];
+    [self.searchBar resignFirstResponder];
+    [self clear];
+    if ([barcode isKindOfClass:[NSString class]]) {
+        [self.delegate suggestionList:self didSelectBarcode:barcode];
+    }
+}
+
+@end
@@ -0,0 +1,84 @@
+//
+//  Copyright 2010 Mirasense AG
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+//  Sets of symbologies as bit masks, used to enable only the symbologies that are actually
+//  needed instead of letting the decoder look for every supported one on each frame.
+//
+
+#import <Foundation/Foundation.h>
+#import "ScanditSDKBarcodePicker.h"
+
+enum {
+    SCANDIT_SYMBOLOGY_EAN13_UPC12 = 1 << 0,
+    SCANDIT_SYMBOLOGY_EAN8 = 1 << 1,
+    SCANDIT_SYMBOLOGY_UPCE = 1 << 2,
+    SCANDIT_SYMBOLOGY_CODE39 = 1 << 3,
+    SCANDIT_SYMBOLOGY_CODE128 = 1 << 4,
+    SCANDIT_SYMBOLOGY_ITF = 1 << 5,
+    SCANDIT_SYMBOLOGY_MSI_PLESSEY = 1 << 6,
+    SCANDIT_SYMBOLOGY_QR = 1 << 7,
+    SCANDIT_SYMBOLOGY_DATA_MATRIX = 1 << 8,
+    SCANDIT_SYMBOLOGY_PDF417 = 1 << 9
+};
+typedef unsigned int ScanditSDKSymbologySet;
+
+// The product codes an adaptive session always starts with.
+#define SCANDIT_SYMBOLOGIES_GTIN \
+    (SCANDIT_SYMBOLOGY_EAN13_UPC12 | SCANDIT_SYMBOLOGY_EAN8 | SCANDIT_SYMBOLOGY_UPCE)
+
+#define SCANDIT_SYMBOLOGIES_2D \
+    (SCANDIT_SYMBOLOGY_QR | SCANDIT_SYMBOLOGY_DATA_MATRIX | SCANDIT_SYMBOLOGY_PDF417)
+
+// Number of past sessions whose symbologies are remembered.
+#define SCANDIT_SYMBOLOGY_HISTORY_SIZE 8
+
+/**
+ * Returns the symbology of a symbology name as reported in scan results ("EAN13", "GS1-QR",
+ * ...), or 0 if it is unknown.
+ */
+ScanditSDKSymbologySet ScanditSDKSymbologyForResultName(NSString *name);
+
+/**
+ * Returns the symbology of an option key that enables it ("ean8", "code128", "qr", ...), or 0 if
+ * it is unknown.
+ */
+ScanditSDKSymbologySet ScanditSDKSymbologyForOptionKey(NSString *key);
+
+/**
+ * Enables exactly the given symbologies on the picker and disables all others.
+ */
+void ScanditSDKApplySymbologies(ScanditSDKBarcodePicker *picker, ScanditSDKSymbologySet symbologies);
+
+
+/**
+ * Remembers which symbologies were scanned in the most recent sessions.
+ */
+@interface ScanditSDKSymbologyHistory : NSObject {
+    ScanditSDKSymbologySet sessions[SCANDIT_SYMBOLOGY_HISTORY_SIZE];
+    NSUInteger next;
+}
+
+/**
+ * Adds the symbologies scanned in a session, replacing the oldest session if the history is full.
+ */
+- (void)recordSession:(ScanditSDKSymbologySet)symbologies;
+
+/**
+ * The symbologies scanned in any of the remembered sessions.
+ */
+- (ScanditSDKSymbologySet)recentSymbologies;
+
+@end
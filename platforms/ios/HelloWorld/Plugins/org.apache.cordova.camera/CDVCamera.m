@@ -22,20 +22,47 @@
 #import <Cordova/NSArray+Comparisons.h>
 #import <Cordova/NSData+Base64.h>
 #import <Cordova/NSDictionary+Extensions.h>
+#import <Cordova/CDVViewController.h>
+#import <Cordova/CDVTrace.h>
 #import <ImageIO/CGImageProperties.h>
 #import <AssetsLibrary/ALAssetRepresentation.h>
 #import <ImageIO/CGImageSource.h>
 #import <ImageIO/CGImageProperties.h>
 #import <ImageIO/CGImageDestination.h>
 #import <MobileCoreServices/UTCoreTypes.h>
+#include <mach/mach_time.h>
 
 #define CDV_PHOTO_PREFIX @"cdv_photo_"
+// Upload bodies get their own prefix, cleanup must not remove those of queued uploads.
+#define CDV_UPLOAD_PREFIX @"cdv_upload_"
+#define CDV_UPLOAD_SESSION_ID @"org.apache.cordova.camera.upload"
+#define CDV_UPLOAD_JPEG_QUALITY 90
+#define CDV_MAX_CONCURRENT_UPLOADS 2
 
 static NSSet* org_apache_cordova_validArrowDirections;
 
-@interface CDVCamera ()
+// CGDataConsumer callback that appends encoded bytes to an open file
+static size_t CDVCameraWriteToFile(void* info, const void* buffer, size_t count)
+{
+    return fwrite(buffer, 1, count, (FILE*)info);
+}
+
+@interface CDVCamera () <NSURLSessionTaskDelegate, CDVMemoryPressureHandler> {
+    // Serial queue that scales, encodes and writes captured images.
+    dispatch_queue_t _processingQueue;
+    // Bumped on the main thread for every new picture; work started for an
+    // older value has been superseded and is abandoned.
+    volatile NSUInteger _processingGeneration;
+    // Background session for postImage uploads, reconnected at load so tasks
+    // that ended while the app was not running still remove their bodies.
+    NSURLSession* _uploadSession;
+    // Bounded upload queue used where NSURLSession is not available.
+    NSOperationQueue* _uploadQueue;
+}
 
 @property (readwrite, assign) BOOL hasPendingOperation;
+// The scaled image waiting for location metadata before it is encoded.
+@property (strong) UIImage* pendingImage;
 
 @end
 
@@ -46,7 +73,52 @@ static NSSet* org_apache_cordova_validArrowDirections;
     org_apache_cordova_validArrowDirections = [[NSSet alloc] initWithObjects:[NSNumber numberWithInt:UIPopoverArrowDirectionUp], [NSNumber numberWithInt:UIPopoverArrowDirectionDown], [NSNumber numberWithInt:UIPopoverArrowDirectionLeft], [NSNumber numberWithInt:UIPopoverArrowDirectionRight], [NSNumber numberWithInt:UIPopoverArrowDirectionAny], nil];
 }
 
-@synthesize hasPendingOperation, pickerController, locationManager;
+@synthesize hasPendingOperation, pickerController, locationManager, pendingImage;
+
+- (void)pluginInitialize
+{
+    if ([self.viewController isKindOfClass:[CDVViewController class]]) {
+        [((CDVViewController*)self.viewController).memoryPressure registerHandler:self
+                                                                            level:CDVMemoryPressureLevelCaches
+                                                                             name:@"Camera images"];
+    }
+    if (NSClassFromString(@"NSURLSession") != nil) {
+        [self uploadSession];
+    }
+}
+
+// Drops the picker, images and metadata left from the last picture while no new one is taken.
+- (void)releaseMemoryForPressureLevel:(CDVMemoryPressureLevel)level
+{
+    if (self.hasPendingOperation) {
+        return;
+    }
+    self.pickerController = nil;
+    self.pendingImage = nil;
+    self.data = nil;
+    self.metadata = nil;
+    // the getter would create one
+    if (locationManager != nil) {
+        [locationManager stopUpdatingLocation];
+        locationManager.delegate = nil;
+        locationManager = nil;
+    }
+}
+
+- (void)dealloc
+{
+    if (_processingQueue != NULL) {
+        dispatch_release(_processingQueue);
+    }
+}
+
+- (dispatch_queue_t)processingQueue
+{
+    if (_processingQueue == NULL) {
+        _processingQueue = dispatch_queue_create("org.apache.cordova.camera.processing", DISPATCH_QUEUE_SERIAL);
+    }
+    return _processingQueue;
+}
 
 - (BOOL)popoverSupported
 {
@@ -75,6 +147,14 @@ static NSSet* org_apache_cordova_validArrowDirections;
     NSArray* arguments = command.arguments;
 
     self.hasPendingOperation = NO;
+    // A retake abandons any picture that is still being processed.
+    _processingGeneration++;
+    if (self.pendingImage != nil) {
+        // still waiting for a location fix
+        self.pendingImage = nil;
+        CDVPluginResult* cancelled = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:@"image processing cancelled"];
+        [self.commandDelegate sendPluginResult:cancelled callbackId:self.pickerController.callbackId];
+    }
 
     NSString* sourceTypeString = [arguments objectAtIndex:2];
     UIImagePickerControllerSourceType sourceType = UIImagePickerControllerSourceTypeCamera; // default
@@ -240,6 +320,101 @@ static NSSet* org_apache_cordova_validArrowDirections;
     [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
 }
 
+#ifdef DEBUG
+
+- (void)benchmarkJpegHeader:(CDVInvokedUrlCommand*)command
+{
+    NSInteger passes = [[command argumentAtIndex:0 withDefault:[NSNumber numberWithInt:1000] andClass:[NSNumber class]] integerValue];
+
+    if ((passes < 1) || (passes > 100000)) {
+        CDVPluginResult* result = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:@"invalid passes"];
+        [self.commandDelegate sendPluginResult:result callbackId:command.callbackId];
+        return;
+    }
+
+    [self.commandDelegate runInBackground:^{
+        // what UIImagePickerControllerMediaMetadata holds for a photo taken with the camera
+        NSDictionary* metadata = [NSDictionary dictionaryWithObjectsAndKeys:
+            [NSDictionary dictionaryWithObjectsAndKeys:
+                @"2013:10:30 12:00:00", @"DateTime",
+                @"Apple", @"Make",
+                @"iPhone 5", @"Model",
+                @"7.0.3", @"Software",
+                @72, @"XResolution",
+                @72, @"YResolution",
+                nil], @"{TIFF}",
+            [NSDictionary dictionaryWithObjectsAndKeys:
+                @1, @"ColorSpace",
+                @"2013:10:30 12:00:00", @"DateTimeDigitized",
+                @"2013:10:30 12:00:00", @"DateTimeOriginal",
+                @0, @"ExposureMode",
+                @2, @"ExposureProgram",
+                @24, @"Flash",
+                @33, @"FocalLenIn35mmFilm",
+                @5, @"MeteringMode",
+                @3264, @"PixelXDimension",
+                @2448, @"PixelYDimension",
+                @1, @"SceneType",
+                @2, @"SensingMethod",
+                @0, @"WhiteBalance",
+                nil], @"{Exif}",
+            nil];
+        // GPS coordinates and seconds, resolutions and a frame rate
+        NSArray* decimals = [NSArray arrayWithObjects:@52.520008, @13.404954, @37.7749295, @122.4194155,
+            @59.9999, @0.333333, @72, @29.97, nil];
+        CDVJpegHeaderWriter* writer = [[CDVJpegHeaderWriter alloc] init];
+        mach_timebase_info_data_t timebase;
+        mach_timebase_info(&timebase);
+
+        NSUInteger headerLength = 0;
+        uint64_t start = mach_absolute_time();
+        for (NSInteger pass = 0; pass < passes; ++pass) {
+            @autoreleasepool {
+                headerLength = [[writer createExifAPP1Data:metadata] length];
+            }
+        }
+        uint64_t headerTicks = mach_absolute_time() - start;
+
+        start = mach_absolute_time();
+        for (NSInteger pass = 0; pass < passes; ++pass) {
+            @autoreleasepool {
+                for (NSNumber* decimal in decimals) {
+                    NSNumber* numerator;
+                    NSNumber* denominator;
+                    [writer decimalToUnsignedRational:decimal withResultNumerator:&numerator withResultDenominator:&denominator];
+                }
+            }
+        }
+        uint64_t rationalTicks = mach_absolute_time() - start;
+
+        // the boxed continued fraction expansion the writer used before, without the step that
+        // turned the terms back into a fraction, so a lower bound of the old cost
+        start = mach_absolute_time();
+        for (NSInteger pass = 0; pass < passes; ++pass) {
+            @autoreleasepool {
+                for (NSNumber* decimal in decimals) {
+                    [writer continuedFraction:[decimal doubleValue] withFractionList:[NSMutableArray array] withHorizon:8];
+                }
+            }
+        }
+        uint64_t continuedFractionTicks = mach_absolute_time() - start;
+
+        double perPass = (double)timebase.numer / timebase.denom / 1000.0 / passes;
+        NSDictionary* report = [NSDictionary dictionaryWithObjectsAndKeys:
+            [NSNumber numberWithInteger:passes], @"passes",
+            [NSNumber numberWithUnsignedInteger:headerLength], @"headerBytes",
+            [NSNumber numberWithUnsignedInteger:[decimals count]], @"decimals",
+            [NSNumber numberWithDouble:headerTicks * perPass], @"headerUs",
+            [NSNumber numberWithDouble:rationalTicks * perPass], @"rationalsUs",
+            [NSNumber numberWithDouble:continuedFractionTicks * perPass], @"continuedFractionsUs",
+            nil];
+        CDVPluginResult* result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:report];
+        [self.commandDelegate sendPluginResult:result callbackId:command.callbackId];
+    }];
+}
+
+#endif
+
 - (void)popoverControllerDidDismissPopover:(id)popoverController
 {
     // [ self imagePickerControllerDidCancel:self.pickerController ];	'
@@ -289,74 +464,8 @@ static NSSet* org_apache_cordova_validArrowDirections;
                 image = [info objectForKey:UIImagePickerControllerOriginalImage];
             }
 
-            if (cameraPicker.correctOrientation) {
-                image = [self imageCorrectedForCaptureOrientation:image];
-            }
-
-            UIImage* scaledImage = nil;
-
-            if ((cameraPicker.targetSize.width > 0) && (cameraPicker.targetSize.height > 0)) {
-                // if cropToSize, resize image and crop to target size, otherwise resize to fit target without cropping
-                if (cameraPicker.cropToSize) {
-                    scaledImage = [self imageByScalingAndCroppingForSize:image toSize:cameraPicker.targetSize];
-                } else {
-                    scaledImage = [self imageByScalingNotCroppingForSize:image toSize:cameraPicker.targetSize];
-                }
-            }
-
-            NSData* data = nil;
-            // returnedImage is the image that is returned to caller and (optionally) saved to photo album
-            UIImage* returnedImage = (scaledImage == nil ? image : scaledImage);
-
-            if (cameraPicker.encodingType == EncodingTypePNG) {
-                data = UIImagePNGRepresentation(returnedImage);
-            } else if ((cameraPicker.allowsEditing==false) && (cameraPicker.targetSize.width <= 0) && (cameraPicker.targetSize.height <= 0) && (cameraPicker.correctOrientation==false)){
-                // use image unedited as requested , don't resize
-                data = UIImageJPEGRepresentation(returnedImage, 1.0);
-            } else {
-                data = UIImageJPEGRepresentation(returnedImage, cameraPicker.quality / 100.0f);
-
-                NSDictionary *controllerMetadata = [info objectForKey:@"UIImagePickerControllerMediaMetadata"];
-                if (controllerMetadata) {
-                    self.data = data;
-                    self.metadata = [[NSMutableDictionary alloc] init];
-                    
-                    NSMutableDictionary *EXIFDictionary = [[controllerMetadata objectForKey:(NSString *)kCGImagePropertyExifDictionary]mutableCopy];
-                    if (EXIFDictionary)	[self.metadata setObject:EXIFDictionary forKey:(NSString *)kCGImagePropertyExifDictionary];
-                    
-                    [[self locationManager] startUpdatingLocation];
-                    return;
-                }
-            }
-            
-            if (cameraPicker.saveToPhotoAlbum) {
-                ALAssetsLibrary *library = [ALAssetsLibrary new];
-                [library writeImageToSavedPhotosAlbum:returnedImage.CGImage orientation:(ALAssetOrientation)(returnedImage.imageOrientation) completionBlock:nil];
-            }
-
-            if (cameraPicker.returnType == DestinationTypeFileUri) {
-                // write to temp directory and return URI
-                // get the temp directory path
-                NSString* docsPath = [NSTemporaryDirectory()stringByStandardizingPath];
-                NSError* err = nil;
-                NSFileManager* fileMgr = [[NSFileManager alloc] init]; // recommended by apple (vs [NSFileManager defaultManager]) to be threadsafe
-                // generate unique file name
-                NSString* filePath;
-
-                int i = 1;
-                do {
-                    filePath = [NSString stringWithFormat:@"%@/%@%03d.%@", docsPath, CDV_PHOTO_PREFIX, i++, cameraPicker.encodingType == EncodingTypePNG ? @"png":@"jpg"];
-                } while ([fileMgr fileExistsAtPath:filePath]);
-
-                // save file
-                if (![data writeToFile:filePath options:NSAtomicWrite error:&err]) {
-                    result = [CDVPluginResult resultWithStatus:CDVCommandStatus_IO_EXCEPTION messageAsString:[err localizedDescription]];
-                } else {
-                    result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsString:[[NSURL fileURLWithPath:filePath] absoluteString]];
-                }
-            } else {
-                result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsString:[data base64EncodedString]];
-            }
+            [self processImage:image fromPicker:cameraPicker metadata:[info objectForKey:@"UIImagePickerControllerMediaMetadata"]];
+            return;
         }
     }
     // NOT IMAGE TYPE (MOVIE)
@@ -373,6 +482,141 @@ static NSSet* org_apache_cordova_validArrowDirections;
     self.pickerController = nil;
 }
 
+/*
+ * Scales, encodes and stores the picked image on the processing queue, then
+ * sends the result from the main thread. Only plain values are captured from
+ * the picker, so it is never released off the main thread.
+ */
+- (void)processImage:(UIImage*)image fromPicker:(CDVCameraPicker*)cameraPicker metadata:(NSDictionary*)controllerMetadata
+{
+    NSUInteger generation = ++_processingGeneration;
+    NSString* callbackId = cameraPicker.callbackId;
+    CGSize targetSize = cameraPicker.targetSize;
+    BOOL cropToSize = cameraPicker.cropToSize;
+    BOOL correctOrientation = cameraPicker.correctOrientation;
+    BOOL saveToPhotoAlbum = cameraPicker.saveToPhotoAlbum;
+    BOOL unedited = (cameraPicker.allowsEditing == false) && (targetSize.width <= 0) && (targetSize.height <= 0) && (correctOrientation == false);
+    NSInteger quality = cameraPicker.quality;
+    CDVEncodingType encodingType = cameraPicker.encodingType;
+    CDVDestinationType returnType = cameraPicker.returnType;
+
+    dispatch_async([self processingQueue], ^{
+        if (generation != _processingGeneration) {
+            [self finishProcessingWithResult:nil callbackId:callbackId generation:generation];
+            return;
+        }
+
+        NSData* data = nil;
+        // returnedImage is the image that is returned to caller and (optionally) saved to photo album.
+        // Orientation, scaling and cropping are applied in a single draw at the final size.
+        UIImage* returnedImage = [self imageByRenderingImage:image toSize:targetSize cropToSize:cropToSize
+                                          correctOrientation:correctOrientation opaque:(encodingType != EncodingTypePNG)];
+
+        if (encodingType == EncodingTypePNG) {
+            CDV_TRACE_SCOPE("CDVCamera encode PNG");
+            data = UIImagePNGRepresentation(returnedImage);
+        } else if (unedited) {
+            CDV_TRACE_SCOPE("CDVCamera encode JPEG");
+            // use image unedited as requested , don't resize
+            data = UIImageJPEGRepresentation(returnedImage, 1.0);
+        } else {
+            if (controllerMetadata) {
+                // Encode once the location is known, so the metadata goes into the same pass.
+                dispatch_async(dispatch_get_main_queue(), ^{
+                    if (generation != _processingGeneration) {
+                        [self finishProcessingWithResult:nil callbackId:callbackId generation:generation];
+                        return;
+                    }
+                    self.pendingImage = returnedImage;
+                    self.metadata = [[NSMutableDictionary alloc] init];
+
+                    NSMutableDictionary *EXIFDictionary = [[controllerMetadata objectForKey:(NSString *)kCGImagePropertyExifDictionary]mutableCopy];
+                    if (EXIFDictionary)	[self.metadata setObject:EXIFDictionary forKey:(NSString *)kCGImagePropertyExifDictionary];
+
+                    [[self locationManager] startUpdatingLocation];
+                });
+                return;
+            }
+
+            data = [self JPEGDataForImage:returnedImage quality:quality metadata:nil];
+        }
+
+        if (generation != _processingGeneration) {
+            [self finishProcessingWithResult:nil callbackId:callbackId generation:generation];
+            return;
+        }
+
+        if (saveToPhotoAlbum) {
+            ALAssetsLibrary *library = [ALAssetsLibrary new];
+            [library writeImageToSavedPhotosAlbum:returnedImage.CGImage orientation:(ALAssetOrientation)(returnedImage.imageOrientation) completionBlock:nil];
+        }
+
+        CDVPluginResult* result = [self resultForImageData:data encodingType:encodingType returnType:returnType];
+        [self finishProcessingWithResult:result callbackId:callbackId generation:generation];
+    });
+}
+
+/*
+ * Writes the encoded image to a temp file, or base64 encodes it, depending on
+ * the requested destination type. Safe to call off the main thread.
+ */
+- (CDVPluginResult*)resultForImageData:(NSData*)data encodingType:(CDVEncodingType)encodingType returnType:(CDVDestinationType)returnType
+{
+    CDV_TRACE_SCOPE("CDVCamera write result");
+    CDVPluginResult* result = nil;
+
+    if (returnType == DestinationTypeFileUri) {
+        // write to temp directory and return URI
+        // get the temp directory path
+        NSString* docsPath = [NSTemporaryDirectory()stringByStandardizingPath];
+        NSError* err = nil;
+        NSFileManager* fileMgr = [[NSFileManager alloc] init]; // recommended by apple (vs [NSFileManager defaultManager]) to be threadsafe
+        // generate unique file name
+        NSString* filePath;
+
+        int i = 1;
+        do {
+            filePath = [NSString stringWithFormat:@"%@/%@%03d.%@", docsPath, CDV_PHOTO_PREFIX, i++, encodingType == EncodingTypePNG ? @"png":@"jpg"];
+        } while ([fileMgr fileExistsAtPath:filePath]);
+
+        // save file
+        if (![data writeToFile:filePath options:NSAtomicWrite error:&err]) {
+            result = [CDVPluginResult resultWithStatus:CDVCommandStatus_IO_EXCEPTION messageAsString:[err localizedDescription]];
+        } else {
+            result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsString:[[NSURL fileURLWithPath:filePath] absoluteString]];
+        }
+    } else {
+        result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsString:[data base64EncodedString]];
+    }
+    return result;
+}
+
+/*
+ * Sends the result on the main thread and resets the pending operation. Work
+ * that was superseded by a retake reports an error to its own callback and
+ * leaves the new operation's state alone.
+ */
+- (void)finishProcessingWithResult:(CDVPluginResult*)result callbackId:(NSString*)callbackId generation:(NSUInteger)generation
+{
+    dispatch_async(dispatch_get_main_queue(), ^{
+        if (generation != _processingGeneration) {
+            CDVPluginResult* cancelled = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:@"image processing cancelled"];
+            [self.commandDelegate sendPluginResult:cancelled callbackId:callbackId];
+            return;
+        }
+
+        if (result) {
+            [self.commandDelegate sendPluginResult:result callbackId:callbackId];
+        }
+
+        self.hasPendingOperation = NO;
+        self.pickerController = nil;
+        self.pendingImage = nil;
+        self.data = nil;
+        self.metadata = nil;
+    });
+}
+
 // older api calls newer didFinishPickingMediaWithInfo
 - (void)imagePickerController:(UIImagePickerController*)picker didFinishPickingImage:(UIImage*)image editingInfo:(NSDictionary*)editingInfo
 {
@@ -399,6 +643,99 @@ static NSSet* org_apache_cordova_validArrowDirections;
     self.pickerController = nil;
 }
 
+/*
+ * Returns the image drawn once at its final size: upright when
+ * correctOrientation is set or a targetSize is given, and scaled to fit (or
+ * with cropToSize, to fill) targetSize. Returns anImage untouched when neither
+ * applies. Safe to call off the main thread.
+ */
+- (UIImage*)imageByRenderingImage:(UIImage*)anImage toSize:(CGSize)targetSize cropToSize:(BOOL)cropToSize
+               correctOrientation:(BOOL)correctOrientation opaque:(BOOL)opaque
+{
+    CDV_TRACE_SCOPE("CDVCamera render");
+    CGSize imageSize = anImage.size; // already accounts for imageOrientation
+    BOOL scale = (targetSize.width > 0) && (targetSize.height > 0);
+
+    if (!scale && !(correctOrientation && (anImage.imageOrientation != UIImageOrientationUp))) {
+        return anImage;
+    }
+
+    CGSize canvasSize = imageSize;
+    CGRect drawRect = CGRectMake(0, 0, imageSize.width, imageSize.height);
+
+    if (scale && !CGSizeEqualToSize(imageSize, targetSize)) {
+        CGFloat widthFactor = targetSize.width / imageSize.width;
+        CGFloat heightFactor = targetSize.height / imageSize.height;
+
+        if (cropToSize) {
+            // fill the target and center the overflow, which the canvas crops
+            CGFloat scaleFactor = MAX(widthFactor, heightFactor);
+            canvasSize = targetSize;
+            drawRect.size = CGSizeMake(imageSize.width * scaleFactor, imageSize.height * scaleFactor);
+            drawRect.origin = CGPointMake((targetSize.width - drawRect.size.width) * 0.5, (targetSize.height - drawRect.size.height) * 0.5);
+        } else {
+            // contain the image within the given bounds
+            CGFloat scaleFactor = MIN(widthFactor, heightFactor);
+            canvasSize = CGSizeMake(MIN(imageSize.width * scaleFactor, targetSize.width), MIN(imageSize.height * scaleFactor, targetSize.height));
+            drawRect.size = canvasSize;
+        }
+    } else if (scale) {
+        canvasSize = targetSize;
+        drawRect.size = targetSize;
+    }
+
+    // JPEG has no alpha, so callers pass opaque to skip blending.
+    UIGraphicsBeginImageContextWithOptions(canvasSize, opaque, 1.0);
+    CGContextSetInterpolationQuality(UIGraphicsGetCurrentContext(), kCGInterpolationHigh);
+    // drawInRect: applies the orientation, so this is the only full-image pass.
+    [anImage drawInRect:drawRect];
+    UIImage* newImage = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+
+    if (newImage == nil) {
+        NSLog(@"could not scale image");
+        return anImage;
+    }
+    return newImage;
+}
+
+/*
+ * ImageIO destination properties for a JPEG of the image: quality, orientation and metadata.
+ */
+- (NSDictionary*)JPEGPropertiesForImage:(UIImage*)anImage quality:(NSInteger)quality metadata:(NSDictionary*)imageMetadata
+{
+    NSMutableDictionary* properties = imageMetadata ? [imageMetadata mutableCopy] : [NSMutableDictionary dictionaryWithCapacity:2];
+    [properties setObject:[NSNumber numberWithFloat:quality / 100.0f] forKey:(NSString*)kCGImageDestinationLossyCompressionQuality];
+    if (anImage.imageOrientation != UIImageOrientationUp) {
+        // Keep the EXIF orientation of images that were not redrawn upright.
+        static const int exifOrientations[] = {1, 3, 8, 6, 2, 4, 5, 7};
+        [properties setObject:[NSNumber numberWithInt:exifOrientations[anImage.imageOrientation]] forKey:(NSString*)kCGImagePropertyOrientation];
+    }
+    return properties;
+}
+
+/*
+ * Encodes the image as JPEG with ImageIO, writing the metadata (if any) in the
+ * same pass, straight into the returned buffer.
+ */
+- (NSData*)JPEGDataForImage:(UIImage*)anImage quality:(NSInteger)quality metadata:(NSDictionary*)imageMetadata
+{
+    CDV_TRACE_SCOPE("CDVCamera encode JPEG");
+    NSMutableData* jpegData = [NSMutableData data];
+    CGImageDestinationRef destination = CGImageDestinationCreateWithData((__bridge CFMutableDataRef)jpegData, kUTTypeJPEG, 1, NULL);
+
+    if (destination == NULL) {
+        return UIImageJPEGRepresentation(anImage, quality / 100.0f);
+    }
+
+    NSDictionary* properties = [self JPEGPropertiesForImage:anImage quality:quality metadata:imageMetadata];
+    CGImageDestinationAddImage(destination, anImage.CGImage, (__bridge CFDictionaryRef)properties);
+    BOOL finalized = CGImageDestinationFinalize(destination);
+    CFRelease(destination);
+
+    return finalized ? jpegData : UIImageJPEGRepresentation(anImage, quality / 100.0f);
+}
+
 - (UIImage*)imageByScalingAndCroppingForSize:(UIImage*)anImage toSize:(CGSize)targetSize
 {
     UIImage* sourceImage = anImage;
@@ -541,10 +878,14 @@ static NSSet* org_apache_cordova_validArrowDirections;
     return newImage;
 }
 
+/*
+ * Uploads the image as a multipart/form-data POST. The JPEG is encoded
+ * straight into a temp file that holds the whole request body, and the
+ * upload is sent from that file, so neither the encoded image nor the body
+ * is ever held in memory.
+ */
 - (void)postImage:(UIImage*)anImage withFilename:(NSString*)filename toUrl:(NSURL*)url
 {
-    self.hasPendingOperation = YES;
-
     NSString* boundary = @"----BOUNDARY_IS_I";
 
     NSMutableURLRequest* req = [NSMutableURLRequest requestWithURL:url];
@@ -553,33 +894,154 @@ static NSSet* org_apache_cordova_validArrowDirections;
     NSString* contentType = [NSString stringWithFormat:@"multipart/form-data; boundary=%@", boundary];
     [req setValue:contentType forHTTPHeaderField:@"Content-type"];
 
-    NSData* imageData = UIImagePNGRepresentation(anImage);
+    dispatch_async([self processingQueue], ^{
+        NSString* bodyPath = [self writeMultipartBodyForImage:anImage withFilename:filename boundary:boundary];
+        if (bodyPath == nil) {
+            NSLog(@"CDVCamera: failed to write upload body for %@", filename);
+            return;
+        }
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self startUploadWithRequest:req fromFile:bodyPath];
+        });
+    });
+}
 
-    // adding the body
-    NSMutableData* postBody = [NSMutableData data];
+/*
+ * Writes the multipart body (part headers, JPEG, closing boundary) to a new
+ * temp file and returns its path, or nil on failure. The JPEG is handed to
+ * the file by the encoder as it is produced.
+ */
+- (NSString*)writeMultipartBodyForImage:(UIImage*)anImage withFilename:(NSString*)filename boundary:(NSString*)boundary
+{
+    CFUUIDRef uuid = CFUUIDCreate(kCFAllocatorDefault);
+    NSString* uuidString = (__bridge_transfer NSString*)CFUUIDCreateString(kCFAllocatorDefault, uuid);
+    CFRelease(uuid);
+    NSString* bodyPath = [[NSTemporaryDirectory() stringByStandardizingPath] stringByAppendingPathComponent:
+        [NSString stringWithFormat:@"%@%@.multipart", CDV_UPLOAD_PREFIX, uuidString]];
+
+    FILE* body = fopen([bodyPath fileSystemRepresentation], "wb");
+    if (body == NULL) {
+        return nil;
+    }
 
-    // first parameter an image
-    [postBody appendData:[[NSString stringWithFormat:@"\r\n--%@\r\n", boundary] dataUsingEncoding:NSUTF8StringEncoding]];
-    [postBody appendData:[[NSString stringWithFormat:@"Content-Disposition: form-data; name=\"upload\"; filename=\"%@\"\r\n", filename] dataUsingEncoding:NSUTF8StringEncoding]];
-    [postBody appendData:[@"Content-Type: image/png\r\n\r\n" dataUsingEncoding : NSUTF8StringEncoding]];
-    [postBody appendData:imageData];
+    NSMutableString* head = [NSMutableString stringWithFormat:@"\r\n--%@\r\n", boundary];
+    [head appendFormat:@"Content-Disposition: form-data; name=\"upload\"; filename=\"%@\"\r\n", filename];
+    [head appendString:@"Content-Type: image/jpeg\r\n\r\n"];
+    NSData* headData = [head dataUsingEncoding:NSUTF8StringEncoding];
+    NSData* tailData = [[NSString stringWithFormat:@"\r\n--%@--\r\n", boundary] dataUsingEncoding:NSUTF8StringEncoding];
+
+    BOOL written = (fwrite([headData bytes], 1, [headData length], body) == [headData length]);
+
+    if (written) {
+        CGDataConsumerCallbacks callbacks = {CDVCameraWriteToFile, NULL};
+        CGDataConsumerRef consumer = CGDataConsumerCreate(body, &callbacks);
+        CGImageDestinationRef destination = consumer ? CGImageDestinationCreateWithDataConsumer(consumer, kUTTypeJPEG, 1, NULL) : NULL;
+        if (destination != NULL) {
+            NSDictionary* properties = [self JPEGPropertiesForImage:anImage quality:CDV_UPLOAD_JPEG_QUALITY metadata:nil];
+            CGImageDestinationAddImage(destination, anImage.CGImage, (__bridge CFDictionaryRef)properties);
+            written = CGImageDestinationFinalize(destination);
+            CFRelease(destination);
+        } else {
+            written = NO;
+        }
+        if (consumer != NULL) {
+            CGDataConsumerRelease(consumer);
+        }
+    }
 
-    //	// second parameter information
-    //	[postBody appendData:[[NSString stringWithFormat:@"\r\n--%@\r\n", boundary] dataUsingEncoding:NSUTF8StringEncoding]];
-    //	[postBody appendData:[@"Content-Disposition: form-data; name=\"some_other_name\"\r\n\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
-    //	[postBody appendData:[@"some_other_value" dataUsingEncoding:NSUTF8StringEncoding]];
-    //	[postBody appendData:[[NSString stringWithFormat:@"\r\n--%@--\r \n",boundary] dataUsingEncoding:NSUTF8StringEncoding]];
+    written = written && (fwrite([tailData bytes], 1, [tailData length], body) == [tailData length]);
+    written = (fclose(body) == 0) && written;
 
-    [req setHTTPBody:postBody];
+    if (!written) {
+        [[[NSFileManager alloc] init] removeItemAtPath:bodyPath error:nil];
+        return nil;
+    }
+    return bodyPath;
+}
 
-    NSURLResponse* response;
-    NSError* error;
-    [NSURLConnection sendSynchronousRequest:req returningResponse:&response error:&error];
+/*
+ * Queues the upload of a body file, which is removed once the upload ends.
+ * With NSURLSession (iOS 7+) uploads go through a background session, so
+ * they carry on while the app is suspended; the session itself keeps at most
+ * CDV_MAX_CONCURRENT_UPLOADS connections open and queues the rest. Older
+ * systems stream the file over NSURLConnection from a bounded queue.
+ */
+- (void)startUploadWithRequest:(NSURLRequest*)request fromFile:(NSString*)bodyPath
+{
+    if (NSClassFromString(@"NSURLSession") != nil) {
+        NSURLSessionUploadTask* task = [[self uploadSession] uploadTaskWithRequest:request fromFile:[NSURL fileURLWithPath:bodyPath]];
+        // the description survives a relaunch of the app, unlike any table kept here
+        task.taskDescription = bodyPath;
+        [task resume];
+        return;
+    }
 
-    //  NSData* result = [NSURLConnection sendSynchronousRequest:req returningResponse:&response error:&error];
-    //	NSString * resultStr =  [[[NSString alloc] initWithData:result encoding:NSUTF8StringEncoding] autorelease];
+    if (_uploadQueue == nil) {
+        _uploadQueue = [[NSOperationQueue alloc] init];
+        [_uploadQueue setMaxConcurrentOperationCount:CDV_MAX_CONCURRENT_UPLOADS];
+    }
 
-    self.hasPendingOperation = NO;
+    NSMutableURLRequest* streamed = [request mutableCopy];
+    NSDictionary* attributes = [[[NSFileManager alloc] init] attributesOfItemAtPath:bodyPath error:nil];
+    [streamed setValue:[[attributes objectForKey:NSFileSize] stringValue] forHTTPHeaderField:@"Content-Length"];
+    [streamed setHTTPBodyStream:[NSInputStream inputStreamWithFileAtPath:bodyPath]];
+
+    [_uploadQueue addOperationWithBlock:^{
+        UIApplication* app = [UIApplication sharedApplication];
+        __block UIBackgroundTaskIdentifier backgroundTask = [app beginBackgroundTaskWithExpirationHandler:^{
+            [app endBackgroundTask:backgroundTask];
+            backgroundTask = UIBackgroundTaskInvalid;
+        }];
+
+        NSURLResponse* response;
+        NSError* error;
+        [NSURLConnection sendSynchronousRequest:streamed returningResponse:&response error:&error];
+        [[[NSFileManager alloc] init] removeItemAtPath:bodyPath error:nil];
+
+        if (backgroundTask != UIBackgroundTaskInvalid) {
+            [app endBackgroundTask:backgroundTask];
+        }
+    }];
+}
+
+- (NSURLSession*)uploadSession
+{
+    if (_uploadSession == nil) {
+        NSURLSessionConfiguration* configuration = [NSURLSessionConfiguration respondsToSelector:@selector(backgroundSessionConfigurationWithIdentifier:)] ?
+            [NSURLSessionConfiguration backgroundSessionConfigurationWithIdentifier:CDV_UPLOAD_SESSION_ID] :
+            [NSURLSessionConfiguration backgroundSessionConfiguration:CDV_UPLOAD_SESSION_ID];
+        configuration.HTTPMaximumConnectionsPerHost = CDV_MAX_CONCURRENT_UPLOADS;
+        _uploadSession = [NSURLSession sessionWithConfiguration:configuration delegate:self delegateQueue:[NSOperationQueue mainQueue]];
+    }
+    return _uploadSession;
+}
+
+- (void)URLSession:(NSURLSession*)session task:(NSURLSessionTask*)task didCompleteWithError:(NSError*)error
+{
+    if (error != nil) {
+        NSLog(@"CDVCamera: upload to %@ failed: %@", task.originalRequest.URL, [error localizedDescription]);
+    }
+    if (task.taskDescription != nil) {
+        [[[NSFileManager alloc] init] removeItemAtPath:task.taskDescription error:nil];
+    }
+}
+
+- (void)URLSessionDidFinishEventsForBackgroundURLSession:(NSURLSession*)session
+{
+    // all events the app was relaunched for have been delivered
+    void (^ completionHandler)(void) = [CDVPlugin takeCompletionHandlerForBackgroundURLSession:CDV_UPLOAD_SESSION_ID];
+
+    if (completionHandler != nil) {
+        completionHandler();
+    }
+}
+
+- (void)dispose
+{
+    // lets queued uploads finish in the background and releases the session's hold on the plugin
+    [_uploadSession finishTasksAndInvalidate];
+    _uploadSession = nil;
+    [super dispose];
 }
 
 
@@ -662,62 +1124,38 @@ static NSSet* org_apache_cordova_validArrowDirections;
 
 - (void)imagePickerControllerReturnImageResult
 {
-    CDVPluginResult* result = nil;
-    
-    if (self.metadata) {
-        CGImageSourceRef sourceImage = CGImageSourceCreateWithData((__bridge_retained CFDataRef)self.data, NULL);
-        CFStringRef sourceType = CGImageSourceGetType(sourceImage);
-        
-        CGImageDestinationRef destinationImage = CGImageDestinationCreateWithData((__bridge CFMutableDataRef)self.data, sourceType, 1, NULL);
-        CGImageDestinationAddImageFromSource(destinationImage, sourceImage, 0, (__bridge CFDictionaryRef)self.metadata);
-        CGImageDestinationFinalize(destinationImage);
-        
-        CFRelease(sourceImage);
-        CFRelease(destinationImage);
-    }
-    
-    if (self.pickerController.saveToPhotoAlbum) {
-        ALAssetsLibrary *library = [ALAssetsLibrary new];
-        [library writeImageDataToSavedPhotosAlbum:self.data metadata:self.metadata completionBlock:nil];
+    if (self.pendingImage == nil) {
+        // the picture was cancelled by a retake
+        return;
     }
-    
-    if (self.pickerController.returnType == DestinationTypeFileUri) {
-        // write to temp directory and return URI
-        // get the temp directory path
-        NSString* docsPath = [NSTemporaryDirectory()stringByStandardizingPath];
-        NSError* err = nil;
-        NSFileManager* fileMgr = [[NSFileManager alloc] init]; // recommended by apple (vs [NSFileManager defaultManager]) to be threadsafe
-        // generate unique file name
-        NSString* filePath;
-        
-        int i = 1;
-        do {
-            filePath = [NSString stringWithFormat:@"%@/%@%03d.%@", docsPath, CDV_PHOTO_PREFIX, i++, self.pickerController.encodingType == EncodingTypePNG ? @"png":@"jpg"];
-        } while ([fileMgr fileExistsAtPath:filePath]);
-        
-        // save file
-        if (![self.data writeToFile:filePath options:NSAtomicWrite error:&err]) {
-            result = [CDVPluginResult resultWithStatus:CDVCommandStatus_IO_EXCEPTION messageAsString:[err localizedDescription]];
+
+    NSUInteger generation = _processingGeneration;
+    UIImage* image = self.pendingImage;
+    NSDictionary* imageMetadata = self.metadata;
+    NSString* callbackId = self.pickerController.callbackId;
+    NSInteger quality = self.pickerController.quality;
+    BOOL saveToPhotoAlbum = self.pickerController.saveToPhotoAlbum;
+    CDVEncodingType encodingType = self.pickerController.encodingType;
+    CDVDestinationType returnType = self.pickerController.returnType;
+
+    self.pendingImage = nil;
+
+    dispatch_async([self processingQueue], ^{
+        if (generation != _processingGeneration) {
+            [self finishProcessingWithResult:nil callbackId:callbackId generation:generation];
+            return;
         }
-        else {
-            result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsString:[[NSURL fileURLWithPath:filePath] absoluteString]];
+
+        NSData* data = [self JPEGDataForImage:image quality:quality metadata:imageMetadata];
+
+        if (saveToPhotoAlbum) {
+            ALAssetsLibrary *library = [ALAssetsLibrary new];
+            [library writeImageDataToSavedPhotosAlbum:data metadata:imageMetadata completionBlock:nil];
         }
-    }
-    else {
-        result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsString:[self.data base64EncodedString]];
-    }
-    if (result) {
-        [self.commandDelegate sendPluginResult:result callbackId:self.pickerController.callbackId];
-    }
-    
-    if (result) {
-        [self.commandDelegate sendPluginResult:result callbackId:self.pickerController.callbackId];
-    }
-    
-    self.hasPendingOperation = NO;
-    self.pickerController = nil;
-    self.data = nil;
-    self.metadata = nil;
+
+        CDVPluginResult* result = [self resultForImageData:data encodingType:encodingType returnType:returnType];
+        [self finishProcessingWithResult:result callbackId:callbackId generation:generation];
+    });
 }
 
 @end
@@ -24,9 +24,15 @@
     NSDictionary * IFD0TagFormatDict;
 }
 
+// largest denominator used when approximating decimals as exif rationals
+@property (nonatomic, assign) uint32_t rationalDenominatorLimit;
+
 - (NSData*) spliceExifBlockIntoJpeg: (NSData*) jpegdata
                       withExifBlock: (NSString*) exifstr;
+- (BOOL) insertExifAPP1: (NSData*) app1
+               intoJpeg: (NSMutableData*) jpegdata;
 - (NSString*) createExifAPP1 : (NSDictionary*) datadict;
+- (NSData*) createExifAPP1Data : (NSDictionary*) datadict;
 - (NSString*) formattedHexStringFromDecimalNumber: (NSNumber*) numb 
                                        withPlaces: (NSNumber*) width;
 - (NSString*) formatNumberWithLeadingZeroes: (NSNumber*) numb 
@@ -74,6 +74,14 @@ for p in $(do_find -type f -print); do
   fi
 done
 
+# Benchmark pages and their data only ship in debug builds.
+if [ "$CONFIGURATION" != "Debug" ]; then
+  rm -rf "$DST_DIR/bench" \
+         "$DST_DIR/bench.html" \
+         "$DST_DIR/js/bench.js" \
+         "$DST_DIR/scanbench.html" \
+         "$DST_DIR/js/scanbench.js"
+fi
 )
 IFS=$ORIG_IFS
 
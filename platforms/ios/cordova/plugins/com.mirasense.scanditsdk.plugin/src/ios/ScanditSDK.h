@@ -25,15 +25,16 @@
     BOOL wasStatusBarHidden;
 	
 	BOOL startAnimationDone;
-	NSDictionary *bufferedResult;
+	
+	BOOL continuousSession;
 	
 	ScanditSDKBarcodePicker *scanditSDKBarcodePicker;
 }
 
 @property (nonatomic, copy) NSString *callbackId;
 @property (readwrite, assign) BOOL hasPendingOperation;
-@property (nonatomic, retain) NSDictionary *bufferedResult;
 @property (nonatomic, retain) ScanditSDKBarcodePicker *scanditSDKBarcodePicker;
+@property (readonly, assign) BOOL continuousSession;
 
 /**
  * Starts the scanning. You call this the following way from java script (success and failure are
@@ -42,6 +43,19 @@
  * cordova.exec(success, failure, "ScanditSDK", "scan", ["___your_app_key___",
  *              {"option1":"value1", "option2":true}]);
  *
+ * Instead of the options dictionary, the name of a profile registered with setProfile can be
+ * passed, which avoids parsing the options on every scan.
+ *
+ * The success callback receives an object with the barcode, its symbology ("UNKNOWN" for manual
+ * entries) and, for EAN and UPC codes with a valid check digit, the code normalized to a 14 digit
+ * GTIN (UPC-E codes are expanded to UPC-A first):
+ *
+ * {"barcode": "0012345678905", "symbology": "EAN13", "gtin": "00012345678905"}
+ *
+ * The GTIN is null for any other code. The failure callback receives "Canceled" when the user
+ * closes the scan screen, "Stopped" when a continuous session is ended with stopSession and
+ * "A scan is in progress" when scan is called before the previous scan has ended.
+ *
  *
  * The available options are:
  *
@@ -188,6 +202,7 @@
  *
  * viewfinderColor: "FFFFFF"
  * Sets the color of the static viewfinder and while tracking before the code has been recognized.
+ * Colors are exactly 6 hex digits, or 8 with a trailing alpha that is ignored.
  *
  * viewfinderDecodedColor: "00FF00"
  * Sets the color of the viewfinder when the code has been recognized.
@@ -197,8 +212,140 @@
  *
  * maxSearchBarBarcodeLength: 100
  * Sets the maximum size a barcode in the manual entry field can have to possibly be valid.
+ *
+ * continuous: false
+ * Keeps the scan screen open after a barcode was recognized. Every barcode is passed to the
+ * success callback as it is decoded, until the user presses the cancel button or the session is
+ * ended with stopSession. Scanned EAN and UPC codes with an invalid check digit are skipped.
+ *
+ * animated: true
+ * Whether the scan screen slides in and out. Scanning starts as soon as the screen is shown either
+ * way, without the animation the camera feed is visible immediately.
+ *
+ * duplicateFilterWindow: 1000
+ * Milliseconds during which a barcode that was just recognized is not reported again. The window
+ * restarts every time the decoder sees the code, so a code that stays in the camera frame is only
+ * reported once. 0 reports every recognition.
+ *
+ * batchSize: 1
+ * batchInterval: 0
+ * In a continuous session, collects results and passes them to the success callback as one array
+ * of results (each as described above) once batchSize results were
+ * collected or batchInterval milliseconds after the first result of the batch, whichever comes
+ * first. Remaining results are delivered when the session ends. With the defaults every result
+ * is passed on its own.
+ *
+ * multiCode: false
+ * multiCodeWindow: 800
+ * For scans that are not continuous, such as of shelf labels or multipacks with several codes in
+ * view. The scan screen stays open for multiCodeWindow milliseconds after the first code and
+ * passes every distinct code decoded until then to the success callback as one array of results.
+ * A batchSize above 1 ends the window as soon as that many codes were collected, and an entered
+ * code ends it right away. The decoder looks for codes closest to the scanningHotspot first, so
+ * codes are in order of their distance to the hotspot, as far as the decoder has seen it. Scanned
+ * EAN and UPC codes with an invalid check digit are skipped.
+ *
+ * adaptiveSymbologies: false
+ * Starts the scan with only the EAN13/UPC12, EAN8 and UPCE symbologies enabled, plus those that
+ * were scanned in any of the last 8 adaptive sessions, instead of the symbologies given by the
+ * other options. Fewer symbologies mean less decoding work per frame.
+ *
+ * fallbackSymbologies: []
+ * fallbackDelay: 3000
+ * Symbologies of an adaptive scan, given by their option names (like ["code128", "qr"]), that are
+ * enabled after fallbackDelay milliseconds without a result. With a delay of 0 they are enabled
+ * from the start.
+ *
+ * timings: false
+ * Adds a timings object to every result with the milliseconds from the scan call to each stage
+ * the scan reached so far: pickerReady, presented, scanningStarted, firstResult and, for later
+ * results of a continuous session, resultDelivered.
+ *
+ * arrayResults: false
+ * Passes every result as an array of the barcode, its symbology, its GTIN and, with the timings
+ * option, the timings, as earlier versions of the plugin did.
+ *
+ * suggestionSource: null
+ * suggestionLimit: 4
+ * Name of a plugin that suggests codes while the user types into the search bar, such as
+ * "Nutritionix" for its offline catalog. Up to suggestionLimit suggestions are listed below the
+ * search bar; picking one reports its code as if it had been entered (see
+ * ScanditSDKSuggestionList.h).
  */
 - (void)scan:(CDVInvokedUrlCommand *)command;
 
+/**
+ * Validates and compiles scan options once and registers them under the given name, such that
+ * they can be passed to scan by name. You call this the following way:
+ *
+ * cordova.exec(success, failure, "ScanditSDK", "setProfile", ["profileName",
+ *              {"option1":"value1", "option2":true}]);
+ *
+ * The failure callback lists options with the wrong type or format, the profile is not registered
+ * in that case.
+ */
+- (void)setProfile:(CDVInvokedUrlCommand *)command;
+
+/**
+ * Prepares the scan engine and the camera for the given app key ahead of the first scan. The
+ * plugin also prepares itself at load time if the app key is set as the "ScanditSDKAppKey"
+ * preference in config.xml, or as "scandit_key" in the app config (the AppConfigFile
+ * preference). You call this the following way:
+ *
+ * cordova.exec(success, failure, "ScanditSDK", "prepare", ["___your_app_key___"]);
+ *
+ * The barcode picker is kept between scans and only rebuilt when the app key or the options
+ * change. It is released on memory warnings while no scan is in progress.
+ */
+- (void)prepare:(CDVInvokedUrlCommand *)command;
+
+/**
+ * Ends a continuous scan session that was started with the "continuous" option. The callback of
+ * the scan call receives a final "Stopped" error. You call this the following way:
+ *
+ * cordova.exec(success, failure, "ScanditSDK", "stopSession", []);
+ */
+- (void)stopSession:(CDVInvokedUrlCommand *)command;
+
+/**
+ * Grabs the next frame of the running scan session and writes it as a JPEG to a temporary file,
+ * for example to photograph a product whose barcode cannot be read. No second camera session is
+ * started and the image does not pass through the bridge. Frames larger than maxDimension
+ * (default 640) on their longer side are scaled down and encoded with the given quality (0 to
+ * 100, default 70). You call this the following way while a scan is running:
+ *
+ * cordova.exec(success, failure, "ScanditSDK", "captureFrame", [640, 70]);
+ *
+ * The success callback receives the file URL of the image. The capture fails if no scan is
+ * running or the scan ends before the frame arrived.
+ */
+- (void)captureFrame:(CDVInvokedUrlCommand *)command;
+
+/**
+ * Returns the latency statistics of all scans since the app started or the last reset, measured
+ * from the scan call to each stage up to the first result being handed to JavaScript. Passing
+ * true resets the statistics after they were returned. You call this the following way:
+ *
+ * cordova.exec(success, failure, "ScanditSDK", "getScanStats", [false]);
+ *
+ * The success callback receives {"bucketBounds": [10, 25, ...], "stages": {"firstResult":
+ * {"count": 3, "min": 410.2, "max": 820.5, "mean": 590.1, "buckets": [0, 0, ...]}, ...}}, where
+ * the last bucket counts everything above the last bound.
+ */
+- (void)getScanStats:(CDVInvokedUrlCommand *)command;
+
+/**
+ * Runs a scan session without the camera, reporting the given codes one after the other, interval
+ * milliseconds apart, as if they had been decoded or, with "manual": true, typed into the search
+ * bar. Results, batching, timings and the end of the session are the same as for scan, which
+ * makes recorded barcodes a repeatable input for benchmarks (see www/scanbench.html). A single
+ * session ends with its first result, a continuous one with a "Stopped" error after the last
+ * code. You call this the following way:
+ *
+ * cordova.exec(success, failure, "ScanditSDK", "replayScan", ["profileName",
+ *              [{"barcode": "0012345678905", "symbology": "EAN13"}], 50]);
+ */
+- (void)replayScan:(CDVInvokedUrlCommand *)command;
+
 
 @end
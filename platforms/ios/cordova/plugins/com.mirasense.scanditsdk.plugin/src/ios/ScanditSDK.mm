@@ -16,32 +16,160 @@
 //
 
 #import "ScanditSDK.h"
+#import "Cordova/CDVViewController.h"
+#import "Cordova/CDVTrace.h"
 #import "ScanditSDKRotatingBarcodePicker.h"
+#import "ScanditSDKScanProfile.h"
+#import "ScanditSDKDuplicateFilter.h"
+#import "ScanditSDKGtin.h"
+#import "ScanditSDKScanStats.h"
+#import "ScanditSDKSymbologies.h"
+#import "ScanditSDKFrameCapture.h"
+#import "ScanditSDKSuggestionList.h"
+
+
+// Longer side in pixels and JPEG quality of captured frames if not given.
+#define SCANDIT_DEFAULT_FRAME_MAX_DIMENSION 640
+#define SCANDIT_DEFAULT_FRAME_QUALITY 70
+
+
+@interface ScanditSDK () <ScanditSDKNextFrameDelegate, ScanditSDKSuggestionListDelegate,
+                          CDVMemoryPressureHandler> {
+    ScanditSDKSessionSettings session;
+    BOOL dismissWhenPresented;
+    
+    BOOL adaptiveSession;
+    ScanditSDKSymbologySet activeSymbologies;
+    ScanditSDKSymbologySet scannedSymbologies;
+    
+    int frameMaxDimension;
+    int frameQuality;
+    
+    BOOL replayingSession;
+    NSTimeInterval replayInterval;
+}
+
+@property (nonatomic, copy) NSString *preparedAppKey;
+@property (nonatomic, copy) NSString *pickerAppKey;
+@property (nonatomic, retain) ScanditSDKScanProfile *pickerProfile;
+@property (nonatomic, retain) NSMutableDictionary *profiles;
+@property (nonatomic, copy) NSDictionary *lastInlineOptions;
+@property (nonatomic, retain) ScanditSDKScanProfile *lastInlineProfile;
+@property (nonatomic, retain) ScanditSDKDuplicateFilter *duplicateFilter;
+@property (nonatomic, retain) NSMutableArray *pendingResults;
+@property (nonatomic, retain) NSTimer *flushTimer;
+@property (nonatomic, retain) ScanditSDKScanStats *scanStats;
+@property (nonatomic, retain) ScanditSDKSymbologyHistory *symbologyHistory;
+@property (nonatomic, retain) NSTimer *fallbackTimer;
+@property (nonatomic, copy) NSString *frameCallbackId;
+@property (nonatomic, retain) NSMutableArray *replayCodes;
+@property (nonatomic, retain) ScanditSDKSuggestionList *suggestionList;
+@property (nonatomic, retain) NSMutableArray *multiCodeResults;
+@property (nonatomic, retain) NSMutableSet *multiCodeKeys;
+@property (nonatomic, retain) NSTimer *multiCodeTimer;
+
+@end
 
 
 @implementation ScanditSDK
 
 @synthesize callbackId;
 @synthesize hasPendingOperation;
-@synthesize bufferedResult;
 @synthesize scanditSDKBarcodePicker;
+@synthesize continuousSession;
+@synthesize preparedAppKey;
+@synthesize pickerAppKey;
+@synthesize pickerProfile;
+@synthesize profiles;
+@synthesize lastInlineOptions;
+@synthesize lastInlineProfile;
+@synthesize duplicateFilter;
+@synthesize pendingResults;
+@synthesize flushTimer;
+@synthesize scanStats;
+@synthesize symbologyHistory;
+@synthesize fallbackTimer;
+@synthesize frameCallbackId;
+@synthesize replayCodes;
+@synthesize suggestionList;
+@synthesize multiCodeResults;
+@synthesize multiCodeKeys;
+@synthesize multiCodeTimer;
+
+- (void)pluginInitialize {
+    [super pluginInitialize];
+    
+    self.profiles = [NSMutableDictionary dictionary];
+    self.duplicateFilter = [[ScanditSDKDuplicateFilter alloc] init];
+    self.pendingResults = [NSMutableArray array];
+    self.multiCodeResults = [NSMutableArray array];
+    self.multiCodeKeys = [NSMutableSet set];
+    self.scanStats = [[ScanditSDKScanStats alloc] init];
+    self.symbologyHistory = [[ScanditSDKSymbologyHistory alloc] init];
+    
+    // Prepare the engine at plugin load if the app key is known from config.xml or the app config,
+    // such that the camera is already warm when the first scan is started.
+    NSString *appKey = [self.commandDelegate.settings objectForKey:@"scanditsdkappkey"];
+    if (appKey == nil && [self.viewController isKindOfClass:[CDVViewController class]]) {
+        appKey = [((CDVViewController *)self.viewController).appConfig objectForKey:@"scandit_key"];
+    }
+    if ([appKey isKindOfClass:[NSString class]]) {
+        [self prepareWithAppKey:appKey cameraFacingPreference:CAMERA_FACING_BACK];
+    }
+    
+    if ([self.viewController isKindOfClass:[CDVViewController class]]) {
+        [((CDVViewController *)self.viewController).memoryPressure registerHandler:self
+                                                                             level:CDVMemoryPressureLevelWarmObjects
+                                                                              name:@"ScanditSDK picker"];
+    }
+}
+
+- (void)releaseMemoryForPressureLevel:(CDVMemoryPressureLevel)level {
+    // The picker is only kept between scans to start faster, release it while it is not shown.
+    if (!self.hasPendingOperation && self.scanditSDKBarcodePicker != nil) {
+        [self.scanditSDKBarcodePicker forceRelease];
+        self.scanditSDKBarcodePicker = nil;
+        self.pickerAppKey = nil;
+        self.pickerProfile = nil;
+    }
+}
 
 - (void)scan:(CDVInvokedUrlCommand *)command {
     NSLog(@"scanning");
     if (self.hasPendingOperation) {
+        // Answer the call, its callbacks would otherwise never fire.
+        CDVPluginResult *pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR
+                                                          messageAsString:@"A scan is in progress"];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
         return;
     }
-    self.hasPendingOperation = YES;
     
+    // Validate the arguments before the scan counts as pending, so a malformed call does not
+    // block every later one.
     NSUInteger argc = [command.arguments count];
     if (argc < 2) {
         NSLog(@"The scan call received too few arguments and has to return without starting.");
+        CDVPluginResult *pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR
+                                                          messageAsString:@"Expected an app key and options"];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
         return;
     }
-    self.callbackId = command.callbackId;
-    
     NSString *appKey = [command.arguments objectAtIndex:0];
-	NSDictionary *options = [command.arguments objectAtIndex:1];
+    ScanditSDKScanProfile *profile = [self profileForArgument:[command.arguments objectAtIndex:1]];
+    if (profile == nil) {
+        CDVPluginResult *pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR
+                                                          messageAsString:@"Unknown profile"];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+        return;
+    }
+    
+    self.hasPendingOperation = YES;
+    [self.scanStats beginScan];
+    self.callbackId = command.callbackId;
+    session = profile->session;
+    continuousSession = session.continuous;
+    self.duplicateFilter.window = session.duplicateFilterWindow / 1000.0;
+    [self.duplicateFilter reset];
     
     // Hide the status bar to get a bigger area of the video feed. We have to set this before we add
     // GUI elements to the overview, such that the views are aware of the fact that there is no
@@ -53,306 +181,580 @@
         [[UIApplication sharedApplication] setStatusBarHidden:YES withAnimation:UIStatusBarAnimationNone];
     }
 	
-	CameraFacingDirection facing = CAMERA_FACING_BACK;
-    NSObject *preferFrontCamera = [options objectForKey:@"preferFrontCamera"];
-    if (preferFrontCamera && [preferFrontCamera isKindOfClass:[NSNumber class]]) {
-        if ([((NSNumber *)preferFrontCamera) boolValue]) {
-			facing = CAMERA_FACING_FRONT;
-		}
+    // Reuse the picker of the previous scan as long as it was built with the same key and picker
+    // settings. Its camera is kept in standby between scans, which makes the next start much faster.
+    if (self.scanditSDKBarcodePicker == nil
+            || ![appKey isEqualToString:self.pickerAppKey]
+            || ![profile hasSamePickerSettingsAs:self.pickerProfile]) {
+        CameraFacingDirection facing = profile->picker.facing;
+        [self prepareWithAppKey:appKey cameraFacingPreference:facing];
+        
+        ScanditSDKBarcodePicker *picker = [[ScanditSDKRotatingBarcodePicker alloc]
+                                           initWithAppKey:appKey
+                                           cameraFacingPreference:facing];
+        [profile applyToPicker:picker];
+        
+        // Show the toolbar that contains a cancel button.
+        [picker.overlayController showToolBar:YES];
+        
+        self.scanditSDKBarcodePicker = picker;
+        self.pickerAppKey = appKey;
+        self.pickerProfile = profile;
+    } else {
+        [scanditSDKBarcodePicker.overlayController resetUI];
     }
     
-    scanditSDKBarcodePicker = [[ScanditSDKRotatingBarcodePicker alloc]
-							   initWithAppKey:appKey
-							   cameraFacingPreference:facing];
+    adaptiveSession = (profile->picker.adaptiveSymbologies == 1);
+    if (adaptiveSession) {
+        [self beginAdaptiveSession];
+    }
+    [self.scanStats markStage:SCANDIT_STAGE_PICKER_READY];
 	
+    // Set this class as the delegate for the overlay controller. It will now receive events when
+    // a barcode was successfully scanned, manually entered or the cancel button was pressed.
+	scanditSDKBarcodePicker.overlayController.delegate = self;
     
+	startAnimationDone = NO;
+	dismissWhenPresented = NO;
 	
-    NSObject *searchBar = [options objectForKey:@"searchBar"];
-    if (searchBar && [searchBar isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker.overlayController showSearchBar:[((NSNumber *)searchBar) boolValue]];
-    }
+	// Present the barcode picker modally and start scanning.
+	if ([self.viewController respondsToSelector:@selector(presentViewController:animated:completion:)]) {
+		[self.viewController presentViewController:scanditSDKBarcodePicker animated:session.animated
+                                        completion:^{
+			startAnimationDone = YES;
+			[self.scanStats markStage:SCANDIT_STAGE_PRESENTED];
+			if (dismissWhenPresented) {
+				[self dismissPicker];
+			}
+		}];
+	} else {
+		[self.viewController presentModalViewController:scanditSDKBarcodePicker animated:NO];
+		startAnimationDone = YES;
+		[self.scanStats markStage:SCANDIT_STAGE_PRESENTED];
+	}
 	
-    // Set the options.
-    NSObject *scanning1D = [options objectForKey:@"1DScanning"];
-    if (scanning1D && [scanning1D isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker set1DScanningEnabled:[((NSNumber *)scanning1D) boolValue]];
+	// The view of the picker is loaded by presenting it, so the camera can start right away and
+	// results are already decoded while the presentation is animated.
+	[scanditSDKBarcodePicker startScanning];
+	[self.scanStats markStage:SCANDIT_STAGE_SCANNING_STARTED];
+    
+    [self attachSuggestionsOfSource:profile.suggestionSource];
+}
+
+/**
+ * Lists the suggestions of the named plugin below the search bar while the user types.
+ */
+- (void)attachSuggestionsOfSource:(NSString *)sourceName {
+    UISearchBar *searchBar = self.scanditSDKBarcodePicker.overlayController.manualSearchBar;
+    if (sourceName == nil || searchBar.superview == nil || searchBar.hidden) {
+        return;
     }
-    NSObject *scanning2D = [options objectForKey:@"2DScanning"];
-    if (scanning2D && [scanning2D isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker set2DScanningEnabled:[((NSNumber *)scanning2D) boolValue]];
+    id source = [self.commandDelegate getCommandInstance:sourceName];
+    if (![source respondsToSelector:@selector(scanditSDKSuggestionsForText:limit:)]) {
+        NSLog(@"The suggestion source %@ is not a plugin that suggests codes.", sourceName);
+        return;
     }
     
-    NSObject *ean13AndUpc12 = [options objectForKey:@"ean13AndUpc12"];
-    if (ean13AndUpc12 && [ean13AndUpc12 isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker setEan13AndUpc12Enabled:[((NSNumber *)ean13AndUpc12) boolValue]];
+    self.suggestionList = [[ScanditSDKSuggestionList alloc] initWithSource:source
+                                                                     limit:session.suggestionLimit];
+    self.suggestionList.delegate = self;
+    [self.suggestionList attachToSearchBar:searchBar
+                                    inView:self.scanditSDKBarcodePicker.overlayController.view];
+}
+
+/**
+ * Prepares the engine and the camera for the given app key. Preparing is only done once per app
+ * key since the Scandit SDK keeps the prepared camera around.
+ */
+- (void)prepareWithAppKey:(NSString *)appKey cameraFacingPreference:(CameraFacingDirection)facing {
+    if ([appKey length] == 0 || [appKey isEqualToString:self.preparedAppKey]) {
+        return;
     }
-    NSObject *ean8 = [options objectForKey:@"ean8"];
-    if (ean8 && [ean8 isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker setEan8Enabled:[((NSNumber *)ean8) boolValue]];
+    [ScanditSDKBarcodePicker prepareWithAppKey:appKey cameraFacingPreference:facing];
+    self.preparedAppKey = appKey;
+}
+
+/**
+ * Returns the compiled profile for the options argument of a scan call, which is either the name
+ * of a profile registered with setProfile or an options dictionary.
+ */
+- (ScanditSDKScanProfile *)profileForArgument:(id)argument {
+    if ([argument isKindOfClass:[NSString class]]) {
+        return [self.profiles objectForKey:argument];
     }
-    NSObject *upce = [options objectForKey:@"upce"];
-    if (upce && [upce isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker setUpceEnabled:[((NSNumber *)upce) boolValue]];
+    if (![argument isKindOfClass:[NSDictionary class]]) {
+        return nil;
     }
-    NSObject *code39 = [options objectForKey:@"code39"];
-    if (code39 && [code39 isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker setCode39Enabled:[((NSNumber *)code39) boolValue]];
+    
+    // Inline options are typically the same on every call, so the last compiled ones are kept.
+    if (self.lastInlineProfile == nil || ![argument isEqualToDictionary:self.lastInlineOptions]) {
+        NSMutableArray *invalidKeys = [NSMutableArray array];
+        self.lastInlineProfile = [ScanditSDKScanProfile profileWithOptions:argument
+                                                               invalidKeys:invalidKeys];
+        self.lastInlineOptions = argument;
+        if ([invalidKeys count] > 0) {
+            NSLog(@"Ignoring invalid scan options: %@", [invalidKeys componentsJoinedByString:@", "]);
+        }
     }
-    NSObject *code128 = [options objectForKey:@"code128"];
-    if (code128 && [code128 isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker setCode128Enabled:[((NSNumber *)code128) boolValue]];
+    return self.lastInlineProfile;
+}
+
+- (void)setProfile:(CDVInvokedUrlCommand *)command {
+    NSString *name = [command argumentAtIndex:0 withDefault:nil andClass:[NSString class]];
+    NSDictionary *options = [command argumentAtIndex:1 withDefault:nil andClass:[NSDictionary class]];
+    if (name == nil || options == nil) {
+        CDVPluginResult *pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR
+                                                          messageAsString:@"Expected a profile name and options"];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+        return;
     }
-    NSObject *itf = [options objectForKey:@"itf"];
-    if (itf && [itf isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker setItfEnabled:[((NSNumber *)itf) boolValue]];
+    
+    NSMutableArray *invalidKeys = [NSMutableArray array];
+    ScanditSDKScanProfile *profile = [ScanditSDKScanProfile profileWithOptions:options
+                                                                   invalidKeys:invalidKeys];
+    if ([invalidKeys count] > 0) {
+        NSString *message = [NSString stringWithFormat:@"Invalid options: %@",
+                             [invalidKeys componentsJoinedByString:@", "]];
+        CDVPluginResult *pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR
+                                                          messageAsString:message];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+        return;
     }
-    NSObject *qr = [options objectForKey:@"qr"];
-    if (qr && [qr isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker setQrEnabled:[((NSNumber *)qr) boolValue]];
+    
+    [self.profiles setObject:profile forKey:name];
+    
+    CDVPluginResult *pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+    [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+}
+
+- (void)prepare:(CDVInvokedUrlCommand *)command {
+    NSString *appKey = [command argumentAtIndex:0 withDefault:nil andClass:[NSString class]];
+    if (appKey == nil) {
+        CDVPluginResult *pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR
+                                                          messageAsString:@"Missing app key"];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+        return;
     }
-    NSObject *dataMatrix = [options objectForKey:@"dataMatrix"];
-    if (dataMatrix && [dataMatrix isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker setDataMatrixEnabled:[((NSNumber *)dataMatrix) boolValue]];
+    
+    [self prepareWithAppKey:appKey cameraFacingPreference:CAMERA_FACING_BACK];
+    
+    CDVPluginResult *pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+    [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+}
+
+- (void)stopSession:(CDVInvokedUrlCommand *)command {
+    if (!self.hasPendingOperation || !continuousSession) {
+        CDVPluginResult *pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR
+                                                          messageAsString:@"No continuous session"];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+        return;
     }
-    NSObject *pdf417 = [options objectForKey:@"pdf417"];
-    if (pdf417 && [pdf417 isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker setPdf417Enabled:[((NSNumber *)pdf417) boolValue]];
+    
+    [self dismissPicker];
+    
+    // Release the kept-alive callback of the scan call.
+    [self sendScanError:@"Stopped"];
+    
+    CDVPluginResult *pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+    [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+}
+
+- (void)captureFrame:(CDVInvokedUrlCommand *)command {
+    NSString *error = nil;
+    if (!self.hasPendingOperation || self.scanditSDKBarcodePicker == nil || dismissWhenPresented
+            || replayingSession) {
+        error = @"No scan session";
+    } else if (self.frameCallbackId != nil) {
+        error = @"A frame is already being captured";
+    }
+    if (error != nil) {
+        CDVPluginResult *pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR
+                                                          messageAsString:error];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+        return;
     }
-    NSObject *msiPlessey = [options objectForKey:@"msiPlessey"];
-    if (msiPlessey && [msiPlessey isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker setMsiPlesseyEnabled:[((NSNumber *)msiPlessey) boolValue]];
+    
+    self.frameCallbackId = command.callbackId;
+    frameMaxDimension = [[command argumentAtIndex:0
+                                      withDefault:[NSNumber numberWithInt:SCANDIT_DEFAULT_FRAME_MAX_DIMENSION]
+                                         andClass:[NSNumber class]] intValue];
+    frameQuality = [[command argumentAtIndex:1
+                                 withDefault:[NSNumber numberWithInt:SCANDIT_DEFAULT_FRAME_QUALITY]
+                                    andClass:[NSNumber class]] intValue];
+    
+    // The frame is taken from the running scan session instead of starting a second one.
+    [self.scanditSDKBarcodePicker sendNextFrameToDelegate:self];
+}
+
+/**
+ * Enables the product code symbologies and those scanned in recent sessions on the picker. The
+ * fallback symbologies are added once the session goes without a result for a while.
+ */
+- (void)beginAdaptiveSession {
+    activeSymbologies = SCANDIT_SYMBOLOGIES_GTIN | [self.symbologyHistory recentSymbologies];
+    if (session.fallbackDelay == 0) {
+        activeSymbologies |= session.fallbackSymbologies;
+    }
+    scannedSymbologies = 0;
+    ScanditSDKApplySymbologies(self.scanditSDKBarcodePicker, activeSymbologies);
+    [self scheduleSymbologyFallback];
+}
+
+/**
+ * (Re)starts the countdown to the symbology fallback, unless all fallback symbologies are
+ * already enabled.
+ */
+- (void)scheduleSymbologyFallback {
+    [self.fallbackTimer invalidate];
+    self.fallbackTimer = nil;
+    if ((session.fallbackSymbologies & ~activeSymbologies) == 0) {
+        return;
     }
+    self.fallbackTimer = [NSTimer scheduledTimerWithTimeInterval:session.fallbackDelay / 1000.0
+                                                          target:self
+                                                        selector:@selector(enableFallbackSymbologies)
+                                                        userInfo:nil
+                                                         repeats:NO];
+}
+
+- (void)enableFallbackSymbologies {
+    self.fallbackTimer = nil;
+    activeSymbologies |= session.fallbackSymbologies;
+    ScanditSDKApplySymbologies(self.scanditSDKBarcodePicker, activeSymbologies);
+}
+
+/**
+ * Stops the symbology fallback and remembers which symbologies the session scanned.
+ */
+- (void)endAdaptiveSession {
+    [self.fallbackTimer invalidate];
+    self.fallbackTimer = nil;
+    if (scannedSymbologies != 0) {
+        [self.symbologyHistory recordSession:scannedSymbologies];
+    }
+    adaptiveSession = NO;
+}
+
+/**
+ * Restores the status bar and dismisses the scan screen.
+ */
+- (void)dismissPicker {
+    // Results that are still collected for a batch are delivered before the session ends.
+    [self flushPendingResults];
+    // Codes of a multi-code scan that was canceled are dropped.
+    [self resetMultiCodeCapture];
     
-    NSObject *msiPlesseyChecksum = [options objectForKey:@"msiPlesseyChecksumType"];
-    if (msiPlesseyChecksum && [msiPlesseyChecksum isKindOfClass:[NSString class]]) {
-        NSString *msiPlesseyChecksumString = (NSString *)msiPlesseyChecksum;
-        if ([msiPlesseyChecksumString isEqualToString:@"none"]) {
-			[scanditSDKBarcodePicker setMsiPlesseyChecksumType:NONE];
-        } else if ([msiPlesseyChecksumString isEqualToString:@"mod11"]) {
-			[scanditSDKBarcodePicker setMsiPlesseyChecksumType:CHECKSUM_MOD_11];
-		} else if ([msiPlesseyChecksumString isEqualToString:@"mod1010"]) {
-			[scanditSDKBarcodePicker setMsiPlesseyChecksumType:CHECKSUM_MOD_1010];
-		} else if ([msiPlesseyChecksumString isEqualToString:@"mod1110"]) {
-			[scanditSDKBarcodePicker setMsiPlesseyChecksumType:CHECKSUM_MOD_1110];
-		} else {
-			[scanditSDKBarcodePicker setMsiPlesseyChecksumType:CHECKSUM_MOD_10];
-		}
+    // The picker itself is kept for the next scan, only the decoder is stopped.
+    [self.scanditSDKBarcodePicker stopScanning];
+    [self.suggestionList detach];
+    self.suggestionList = nil;
+    continuousSession = NO;
+    if (adaptiveSession) {
+        [self endAdaptiveSession];
+    }
+    if (self.frameCallbackId != nil) {
+        CDVPluginResult *pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR
+                                                          messageAsString:@"Scan session ended"];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:self.frameCallbackId];
+        self.frameCallbackId = nil;
     }
     
-    NSObject *inverseRecognition = [options objectForKey:@"inverseRecognition"];
-    if (inverseRecognition && [inverseRecognition isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker setInverseDetectionEnabled:[((NSNumber *)inverseRecognition) boolValue]];
+    // Nothing was presented for a replayed session.
+    if (replayingSession) {
+        replayingSession = NO;
+        [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(replayNextCode)
+                                                   object:nil];
+        self.replayCodes = nil;
+        self.hasPendingOperation = NO;
+        return;
     }
-    NSObject *microDataMatrix = [options objectForKey:@"microDataMatrix"];
-    if (microDataMatrix && [microDataMatrix isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker setMicroDataMatrixEnabled:[((NSNumber *)microDataMatrix) boolValue]];
+    
+    // A view controller cannot be dismissed while it is still being presented. Results are
+    // reported right away anyway, only the dismissal waits for the presentation to finish.
+    if (!startAnimationDone) {
+        dismissWhenPresented = YES;
+        return;
     }
-    NSObject *force2d = [options objectForKey:@"force2d"];
-    if (force2d && [force2d isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker force2dRecognition:[((NSNumber *)force2d) boolValue]];
+    dismissWhenPresented = NO;
+    
+    if (!wasStatusBarHidden) {
+        [[UIApplication sharedApplication] setStatusBarHidden:NO withAnimation:UIStatusBarAnimationNone];
     }
-	
-    NSObject *restrictActiveScanningArea = [options objectForKey:@"restrictActiveScanningArea"];
-    if (restrictActiveScanningArea && [restrictActiveScanningArea isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker
-		 restrictActiveScanningArea:[((NSNumber *)restrictActiveScanningArea) boolValue]];
-    }
-    
-    NSObject *scanningHotspot = [options objectForKey:@"scanningHotspot"];
-    if (scanningHotspot && [scanningHotspot isKindOfClass:[NSString class]]) {
-        NSArray *split = [((NSString *) scanningHotspot) componentsSeparatedByString:@"/"];
-        if ([split count] == 2) {
-            float x = [[split objectAtIndex:0] floatValue];
-            float y = [[split objectAtIndex:1] floatValue];
-            [scanditSDKBarcodePicker setScanningHotSpotToX:x andY:y];
-        }
+    [self.viewController dismissModalViewControllerAnimated:session.animated];
+    self.hasPendingOperation = NO;
+}
+
+/**
+ * Whether results of the current session are collected and delivered in batches.
+ */
+- (BOOL)isBatchingResults {
+    return continuousSession && (session.batchSize > 1 || session.batchInterval > 0);
+}
+
+/**
+ * Passes a result of a continuous session to JavaScript, or adds it to the current batch. A batch
+ * is delivered as soon as it is full or its interval has passed, whichever comes first.
+ */
+- (void)sendContinuousResult:(id)result {
+    if (![self isBatchingResults]) {
+        [self sendScanResult:result keepCallback:YES];
+        return;
     }
-    NSObject *scanningHotspotHeight = [options objectForKey:@"scanningHotspotHeight"];
-    if (scanningHotspotHeight && [scanningHotspotHeight isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker setScanningHotSpotHeight:[((NSNumber *)scanningHotspotHeight) floatValue]];
-    }
-    NSObject *viewfinderSize = [options objectForKey:@"viewfinderSize"];
-    if (viewfinderSize && [viewfinderSize isKindOfClass:[NSString class]]) {
-        NSArray *split = [((NSString *) viewfinderSize) componentsSeparatedByString:@"/"];
-        if ([split count] == 4) {
-            float width = [[split objectAtIndex:0] floatValue];
-            float height = [[split objectAtIndex:1] floatValue];
-            float landscapeWidth = [[split objectAtIndex:2] floatValue];
-            float landscapeHeight = [[split objectAtIndex:3] floatValue];
-            [scanditSDKBarcodePicker.overlayController setViewfinderHeight:height
-																	 width:width
-														   landscapeHeight:landscapeHeight
-															landscapeWidth:landscapeWidth];
-        }
+    
+    [self.pendingResults addObject:result];
+    if ((NSInteger)[self.pendingResults count] >= session.batchSize) {
+        [self flushPendingResults];
+    } else if (self.flushTimer == nil && session.batchInterval > 0) {
+        self.flushTimer = [NSTimer scheduledTimerWithTimeInterval:session.batchInterval / 1000.0
+                                                           target:self
+                                                         selector:@selector(flushPendingResults)
+                                                         userInfo:nil
+                                                          repeats:NO];
+    }
+}
+
+/**
+ * Adds a result of a multi-code scan unless its code was already collected.
+ */
+- (void)addMultiCodeResult:(id)result barcode:(NSString *)barcode symbology:(NSString *)symbology {
+    NSString *key = [NSString stringWithFormat:@"%@:%@", symbology, barcode];
+    if (![self.multiCodeKeys containsObject:key]) {
+        [self.multiCodeKeys addObject:key];
+        [self.multiCodeResults addObject:result];
     }
+}
+
+/**
+ * Adds a decoded result of a multi-code scan. The first code starts the capture window, and its
+ * end or a full batch end the scan.
+ */
+- (void)collectMultiCodeResult:(id)result barcode:(NSString *)barcode
+                     symbology:(NSString *)symbology {
+    [self addMultiCodeResult:result barcode:barcode symbology:symbology];
     
-    NSObject *beep = [options objectForKey:@"beep"];
-    if (beep && [beep isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker.overlayController setBeepEnabled:[((NSNumber *)beep) boolValue]];
+    if (session.batchSize > 1 && (NSInteger)[self.multiCodeResults count] >= session.batchSize) {
+        [self finishMultiCodeCapture];
+    } else if (self.multiCodeTimer == nil) {
+        self.multiCodeTimer = [NSTimer scheduledTimerWithTimeInterval:session.multiCodeWindow / 1000.0
+                                                               target:self
+                                                             selector:@selector(finishMultiCodeCapture)
+                                                             userInfo:nil
+                                                              repeats:NO];
     }
-    NSObject *vibrate = [options objectForKey:@"vibrate"];
-    if (vibrate && [vibrate isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker.overlayController setVibrateEnabled:[((NSNumber *)vibrate) boolValue]];
+}
+
+/**
+ * Ends a multi-code scan with all codes collected in its window, in the order they were decoded.
+ */
+- (void)finishMultiCodeCapture {
+    NSArray *results = [NSArray arrayWithArray:self.multiCodeResults];
+    [self dismissPicker];
+    [self sendScanResult:results keepCallback:NO];
+}
+
+/**
+ * Stops the capture window and drops the codes collected in it.
+ */
+- (void)resetMultiCodeCapture {
+    [self.multiCodeTimer invalidate];
+    self.multiCodeTimer = nil;
+    [self.multiCodeResults removeAllObjects];
+    [self.multiCodeKeys removeAllObjects];
+}
+
+/**
+ * Delivers all collected results of the current batch as one array of results.
+ */
+- (void)flushPendingResults {
+    [self.flushTimer invalidate];
+    self.flushTimer = nil;
+    if ([self.pendingResults count] == 0) {
+        return;
     }
-	
     
-    NSObject *torch = [options objectForKey:@"torch"];
-    if (torch && [torch isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker.overlayController setTorchEnabled:[((NSNumber *)torch) boolValue]];
-    }
-    NSObject *torchButtonPositionAndSize = [options objectForKey:@"torchButtonPositionAndSize"];
-    if (torchButtonPositionAndSize && [torchButtonPositionAndSize isKindOfClass:[NSString class]]) {
-        NSArray *split = [((NSString *) torchButtonPositionAndSize) componentsSeparatedByString:@"/"];
-        if ([split count] == 4) {
-            float x = [[split objectAtIndex:0] floatValue];
-            float y = [[split objectAtIndex:1] floatValue];
-            int width = [[split objectAtIndex:2] intValue];
-            int height = [[split objectAtIndex:3] intValue];
-            [scanditSDKBarcodePicker.overlayController setTorchButtonRelativeX:x
-																	 relativeY:y
-																		 width:width
-																		height:height];
-        }
+    NSArray *batch = [NSArray arrayWithArray:self.pendingResults];
+    [self.pendingResults removeAllObjects];
+    
+    [self sendScanResult:batch keepCallback:YES];
+}
+
+/**
+ * Passes a result or a batch of results to the success callback of the scan call.
+ */
+- (void)sendScanResult:(id)result keepCallback:(BOOL)keepCallback {
+    CDVPluginResult *pluginResult;
+    if ([result isKindOfClass:[NSDictionary class]]) {
+        pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK
+                                     messageAsDictionary:result];
+    } else {
+        pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsArray:result];
     }
-    NSObject *cameraSwitchVisibility = [options objectForKey:@"cameraSwitchVisibility"];
-    if (cameraSwitchVisibility && [cameraSwitchVisibility isKindOfClass:[NSString class]]) {
-        NSString *cameraSwitchVisibilityString = (NSString *)cameraSwitchVisibility;
-        if ([cameraSwitchVisibilityString isEqualToString:@"tablet"]) {
-			[scanditSDKBarcodePicker.overlayController setCameraSwitchVisibility:CAMERA_SWITCH_ON_TABLET];
-		} else if ([cameraSwitchVisibilityString isEqualToString:@"always"]) {
-			[scanditSDKBarcodePicker.overlayController setCameraSwitchVisibility:CAMERA_SWITCH_ALWAYS];
-		} else {
-			[scanditSDKBarcodePicker.overlayController setCameraSwitchVisibility:CAMERA_SWITCH_NEVER];
-		}
-    }
-    NSObject *cameraSwitchButton = [options objectForKey:@"cameraSwitchButtonPositionAndSize"];
-    if (cameraSwitchButton && [cameraSwitchButton isKindOfClass:[NSString class]]) {
-        NSArray *split = [((NSString *) cameraSwitchButton) componentsSeparatedByString:@"/"];
-        if ([split count] == 4) {
-            float x = [[split objectAtIndex:0] floatValue];
-            float y = [[split objectAtIndex:1] floatValue];
-            int width = [[split objectAtIndex:2] intValue];
-            int height = [[split objectAtIndex:3] intValue];
-            [scanditSDKBarcodePicker.overlayController setCameraSwitchButtonRelativeInverseX:x
-																				   relativeY:y
-																					   width:width
-																					  height:height];
+    [pluginResult setKeepCallbackAsBool:keepCallback];
+    [self.commandDelegate sendPluginResult:pluginResult callbackId:self.callbackId];
+    [self didDeliverResult];
+}
+
+/**
+ * Ends the scan call with its failure callback, releasing the callback.
+ */
+- (void)sendScanError:(NSString *)message {
+    CDVPluginResult *pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR
+                                                      messageAsString:message];
+    [self.commandDelegate sendPluginResult:pluginResult callbackId:self.callbackId];
+}
+
+/**
+ * Builds the result passed to JavaScript: the barcode, its symbology, its GTIN or null and, if
+ * requested with the timings option, the timings of the scan so far. Results are objects keyed
+ * barcode, symbology, gtin and timings, or arrays in that order with the arrayResults option.
+ */
+- (id)resultWithBarcode:(NSString *)barcode symbology:(NSString *)symbology
+                   gtin:(NSString *)gtin {
+    id gtinValue = (gtin != nil ? (id)gtin : [NSNull null]);
+    if (session.arrayResults) {
+        NSMutableArray *result = [NSMutableArray arrayWithObjects:barcode, symbology, gtinValue, nil];
+        if (session.timings) {
+            [result addObject:[self.scanStats currentTimings]];
         }
+        return result;
     }
-	
-    NSObject *logoOffsets = [options objectForKey:@"logoOffsets"];
-    if (logoOffsets && [logoOffsets isKindOfClass:[NSString class]]) {
-        NSArray *split = [((NSString *) logoOffsets) componentsSeparatedByString:@"/"];
-        if ([split count] == 4) {
-            int xOffset = [[split objectAtIndex:0] floatValue];
-            int yOffset = [[split objectAtIndex:1] floatValue];
-            int landscapeXOffset = [[split objectAtIndex:2] intValue];
-            int landscapeYOffset = [[split objectAtIndex:3] intValue];
-            [scanditSDKBarcodePicker.overlayController setLogoXOffset:xOffset
-															  yOffset:yOffset
-													 landscapeXOffset:landscapeXOffset
-													 landscapeYOffset:landscapeYOffset];
-        }
+    
+    NSMutableDictionary *result = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+                                   barcode, @"barcode", symbology, @"symbology",
+                                   gtinValue, @"gtin", nil];
+    if (session.timings) {
+        [result setObject:[self.scanStats currentTimings] forKey:@"timings"];
     }
-	
-    NSObject *t5 = [options objectForKey:@"searchBarActionButtonCaption"];
-    if (t5 && [t5 isKindOfClass:[NSString class]]) {
-        [scanditSDKBarcodePicker.overlayController setSearchBarActionButtonCaption:((NSString *) t5)];
-    }
-    NSObject *t6 = [options objectForKey:@"searchBarCancelButtonCaption"];
-    if (t6 && [t6 isKindOfClass:[NSString class]]) {
-        [scanditSDKBarcodePicker.overlayController setSearchBarCancelButtonCaption:((NSString *) t6)];
-    }
-    NSObject *t7 = [options objectForKey:@"searchBarPlaceholderText"];
-    if (t7 && [t7 isKindOfClass:[NSString class]]) {
-        [scanditSDKBarcodePicker.overlayController setSearchBarPlaceholderText:((NSString *) t7)];
-    }
-    NSObject *t8 = [options objectForKey:@"toolBarButtonCaption"];
-    if (t8 && [t8 isKindOfClass:[NSString class]]) {
-        [scanditSDKBarcodePicker.overlayController setToolBarButtonCaption:((NSString *) t8)];
-    }
-    
-    
-    NSObject *color1 = [options objectForKey:@"viewfinderColor"];
-    if (color1 && [color1 isKindOfClass:[NSString class]]) {
-        NSString *color1String = (NSString *)color1;
-        if ([color1String length] == 6) {
-            unsigned int redInt;
-            NSScanner *redScanner = [NSScanner scannerWithString:[color1String substringToIndex:2]];
-            [redScanner scanHexInt:&redInt];
-            float red = ((float) redInt) / 256.0;
-            
-            unsigned int greenInt;
-            NSScanner *greenScanner = [NSScanner scannerWithString:[[color1String substringFromIndex:2] substringToIndex:2]];
-            [greenScanner scanHexInt:&greenInt];
-            float green = ((float) greenInt) / 256.0;
-            
-            unsigned int blueInt;
-            NSScanner *blueScanner = [NSScanner scannerWithString:[color1String substringFromIndex:4]];
-            [blueScanner scanHexInt:&blueInt];
-            float blue = ((float) blueInt) / 256.0;
-            
-            [scanditSDKBarcodePicker.overlayController setViewfinderColor:red green:green blue:blue];
-        }
+    return result;
+}
+
+/**
+ * Records that a result was handed to JavaScript, the first one completes the timing of the scan.
+ */
+- (void)didDeliverResult {
+    [self.scanStats markStage:SCANDIT_STAGE_RESULT_DELIVERED];
+    [self.scanStats endScan];
+}
+
+- (void)getScanStats:(CDVInvokedUrlCommand *)command {
+    NSDictionary *statistics = [self.scanStats statistics];
+    if ([[command argumentAtIndex:0 withDefault:nil andClass:[NSNumber class]] boolValue]) {
+        [self.scanStats reset];
     }
-    NSObject *color2 = [options objectForKey:@"viewfinderDecodedColor"];
-    if (color2 && [color2 isKindOfClass:[NSString class]]) {
-        NSString *color2String = (NSString *)color2;
-        if ([color2String length] == 6) {
-            unsigned int redInt;
-            NSScanner *redScanner = [NSScanner scannerWithString:[color2String substringToIndex:2]];
-            [redScanner scanHexInt:&redInt];
-            float red = ((float) redInt) / 256.0;
-            
-            unsigned int greenInt;
-            NSScanner *greenScanner = [NSScanner scannerWithString:[[color2String substringFromIndex:2] substringToIndex:2]];
-            [greenScanner scanHexInt:&greenInt];
-            float green = ((float) greenInt) / 256.0;
-            
-            unsigned int blueInt;
-            NSScanner *blueScanner = [NSScanner scannerWithString:[color2String substringFromIndex:4]];
-            [blueScanner scanHexInt:&blueInt];
-            float blue = ((float) blueInt) / 256.0;
-            
-            [scanditSDKBarcodePicker.overlayController setViewfinderDecodedColor:red green:green blue:blue];
-        }
+    
+    CDVPluginResult *pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK
+                                                  messageAsDictionary:statistics];
+    [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+}
+
+- (void)replayScan:(CDVInvokedUrlCommand *)command {
+    ScanditSDKScanProfile *profile = [self profileForArgument:[command argumentAtIndex:0]];
+    NSArray *codes = [command argumentAtIndex:1 withDefault:nil andClass:[NSArray class]];
+    NSNumber *interval = [command argumentAtIndex:2 withDefault:nil andClass:[NSNumber class]];
+    NSString *error = nil;
+    if (self.hasPendingOperation) {
+        error = @"A scan is in progress";
+    } else if (profile == nil) {
+        error = @"Unknown profile";
+    } else if ([codes count] == 0) {
+        error = @"Expected barcodes to replay";
+    }
+    if (error != nil) {
+        CDVPluginResult *pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR
+                                                          messageAsString:error];
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:command.callbackId];
+        return;
     }
     
-    NSObject *minManual = [options objectForKey:@"minSearchBarBarcodeLength"];
-    if (minManual && [minManual isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker.overlayController setMinSearchBarBarcodeLength:[((NSNumber *) minManual) integerValue]];
+    self.hasPendingOperation = YES;
+    [self.scanStats beginScan];
+    self.callbackId = command.callbackId;
+    session = profile->session;
+    continuousSession = session.continuous;
+    self.duplicateFilter.window = session.duplicateFilterWindow / 1000.0;
+    [self.duplicateFilter reset];
+    
+    // No picker is shown and the symbologies are given by the codes, so the stages up to scanning
+    // are reached right away.
+    replayingSession = YES;
+    adaptiveSession = NO;
+    startAnimationDone = YES;
+    dismissWhenPresented = NO;
+    [self.scanStats markStage:SCANDIT_STAGE_PICKER_READY];
+    [self.scanStats markStage:SCANDIT_STAGE_PRESENTED];
+    [self.scanStats markStage:SCANDIT_STAGE_SCANNING_STARTED];
+    
+    self.replayCodes = [NSMutableArray arrayWithArray:codes];
+    replayInterval = MAX([interval doubleValue], 0) / 1000.0;
+    [self replayNextCode];
+}
+
+/**
+ * Reports the next code of a replayed session as the overlay controller would, and schedules the
+ * one after it. A replay that runs out of codes ends like stopSession.
+ */
+- (void)replayNextCode {
+    if (!replayingSession) {
+        return;
     }
-    NSObject *maxManual = [options objectForKey:@"maxSearchBarBarcodeLength"];
-    if (maxManual && [maxManual isKindOfClass:[NSNumber class]]) {
-        [scanditSDKBarcodePicker.overlayController setMaxSearchBarBarcodeLength:[((NSNumber *) maxManual) integerValue]];
+    if ([self.replayCodes count] == 0) {
+        [self dismissPicker];
+        [self sendScanError:@"Stopped"];
+        return;
     }
     
-    // Show the toolbar that contains a cancel button.
-    [scanditSDKBarcodePicker.overlayController showToolBar:YES];
-	
-    // Set this class as the delegate for the overlay controller. It will now receive events when
-    // a barcode was successfully scanned, manually entered or the cancel button was pressed.
-	scanditSDKBarcodePicker.overlayController.delegate = self;
+    NSDictionary *code = [self.replayCodes objectAtIndex:0];
+    [self.replayCodes removeObjectAtIndex:0];
+    if ([code isKindOfClass:[NSDictionary class]]
+            && [[code objectForKey:@"barcode"] isKindOfClass:[NSString class]]) {
+        if ([[code objectForKey:@"manual"] boolValue]) {
+            [self scanditSDKOverlayController:nil didManualSearch:[code objectForKey:@"barcode"]];
+        } else {
+            NSString *symbology = [code objectForKey:@"symbology"];
+            NSDictionary *barcodeResult = [NSDictionary dictionaryWithObjectsAndKeys:
+                                           [code objectForKey:@"barcode"], @"barcode",
+                                           ([symbology isKindOfClass:[NSString class]] ? symbology : @"UNKNOWN"),
+                                           @"symbology", nil];
+            [self scanditSDKOverlayController:nil didScanBarcode:barcodeResult];
+        }
+    }
     
-	startAnimationDone = NO;
-	self.bufferedResult = nil;
-	
-	// Present the barcode picker modally and start scanning.
-	if ([self.viewController respondsToSelector:@selector(presentViewController:animated:completion:)]) {
-		[self.viewController presentViewController:scanditSDKBarcodePicker animated:YES completion:^{
-			startAnimationDone = YES;
-			if (self.bufferedResult != nil) {
-				[self scanditSDKOverlayController:scanditSDKBarcodePicker.overlayController
-								   didScanBarcode:self.bufferedResult];
-				self.bufferedResult = nil;
-			}
-		}];
-	} else {
-		[self.viewController presentModalViewController:scanditSDKBarcodePicker animated:NO];
-		startAnimationDone = YES;
-	}
-	
-	[scanditSDKBarcodePicker performSelector:@selector(startScanning) withObject:nil afterDelay:0.1];
+    // Reporting the code may have ended the session.
+    if (replayingSession) {
+        [self performSelector:@selector(replayNextCode) withObject:nil afterDelay:replayInterval];
+    }
+}
+
+#pragma mark -
+#pragma mark ScanditSDKNextFrameDelegate methods
+
+- (void)scanditSDKBarcodePicker:(ScanditSDKBarcodePicker *)scanditSDKBarcodePicker
+                didCaptureImage:(NSData *)image
+                     withHeight:(int)height
+                      withWidth:(int)width {
+    CDV_TRACE_SCOPE("ScanditSDK didCaptureImage");
+    NSString *captureCallbackId = self.frameCallbackId;
+    self.frameCallbackId = nil;
+    if (captureCallbackId == nil) {
+        return;
+    }
+    int maxDimension = frameMaxDimension;
+    float quality = MIN(MAX(frameQuality, 0), 100) / 100.0f;
+    
+    // Scaling and writing the file would otherwise stall the camera preview.
+    [self.commandDelegate runInBackground:^{
+        NSError *error = nil;
+        NSString *path = ScanditSDKWriteFrame(image, maxDimension, quality, &error);
+        CDVPluginResult *pluginResult;
+        if (path == nil) {
+            pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_IO_EXCEPTION
+                                             messageAsString:[error localizedDescription]];
+        } else {
+            pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK
+                                             messageAsString:[[NSURL fileURLWithPath:path] absoluteString]];
+        }
+        [self.commandDelegate sendPluginResult:pluginResult callbackId:captureCallbackId];
+    }];
 }
 
 #pragma mark -
@@ -366,30 +768,51 @@
  */
 - (void)scanditSDKOverlayController:(ScanditSDKOverlayController *)scanditSDKOverlayController1
                      didScanBarcode:(NSDictionary *)barcodeResult {
-	if (!startAnimationDone) {
-		// If the initial animation hasn't finished yet we buffer the result and return it as soon
-		// as the animation finishes.
-		self.bufferedResult = barcodeResult;
+    CDV_TRACE_SCOPE("ScanditSDK didScanBarcode");
+	if (dismissWhenPresented) {
+		// The scan already ended while the picker was still being presented.
 		return;
 	}
 	
-    if (!wasStatusBarHidden) {
-        [[UIApplication sharedApplication] setStatusBarHidden:NO withAnimation:UIStatusBarAnimationNone];
-    }
-	
 	NSString *symbology = [barcodeResult objectForKey:@"symbology"];
 	NSString *barcode = [barcodeResult objectForKey:@"barcode"];
     
-    [self.viewController dismissModalViewControllerAnimated:YES];
-	self.scanditSDKBarcodePicker = nil;
-	
-    NSArray *result = [[NSArray alloc] initWithObjects:barcode, symbology, nil];
+    // The decoder reports a code many times per second while it stays in frame. Only the first
+    // report is passed on to JavaScript.
+    if ([self.duplicateFilter isDuplicateBarcode:barcode symbology:symbology]) {
+        return;
+    }
     
-    CDVPluginResult *pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK
-													   messageAsArray:result];
-	
-    [self writeJavascript:[pluginResult toSuccessCallbackString:self.callbackId]];
-    self.hasPendingOperation = NO;
+    if (adaptiveSession) {
+        scannedSymbologies |= ScanditSDKSymbologyForResultName(symbology);
+        [self scheduleSymbologyFallback];
+    }
+    
+    // Product codes are validated here such that codes with a wrong check digit never reach a
+    // lookup, and the lookup gets one canonical GTIN-14 per product.
+    NSString *gtin = ScanditSDKNormalizedGtin(barcode, symbology);
+    if (gtin == nil && (continuousSession || session.multiCode)
+            && ScanditSDKIsGtinSymbology(symbology)) {
+        return;
+    }
+    // Only a code that is reported counts, dropped duplicates and invalid codes would skew the
+    // time to the first result.
+    [self.scanStats markStage:SCANDIT_STAGE_FIRST_RESULT];
+    id result = [self resultWithBarcode:barcode symbology:symbology gtin:gtin];
+    
+    if (continuousSession) {
+        // Leave the picker running and keep the callback alive for the next barcode.
+        [self sendContinuousResult:result];
+        return;
+    }
+    if (session.multiCode) {
+        // Keep decoding until the capture window of the first code has passed.
+        [self collectMultiCodeResult:result barcode:barcode symbology:symbology];
+        return;
+    }
+    
+    [self dismissPicker];
+    [self sendScanResult:result keepCallback:NO];
 }
 
 /**
@@ -400,18 +823,11 @@
  */
 - (void)scanditSDKOverlayController:(ScanditSDKOverlayController *)scanditSDKOverlayController1
                 didCancelWithStatus:(NSDictionary *)status {
+    CDV_TRACE_SCOPE("ScanditSDK didCancelWithStatus");
 	
-    if (!wasStatusBarHidden) {
-        [[UIApplication sharedApplication] setStatusBarHidden:NO withAnimation:UIStatusBarAnimationNone];
-    }
-    
-    [self.viewController dismissModalViewControllerAnimated:YES];
-	self.scanditSDKBarcodePicker = nil;
+    [self dismissPicker];
     
-	CDVPluginResult *pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK
-                                                      messageAsString:@"Canceled"];
-    [self writeJavascript:[pluginResult toErrorCallbackString:self.callbackId]];
-    self.hasPendingOperation = NO;
+    [self sendScanError:@"Canceled"];
 }
 
 /**
@@ -422,21 +838,39 @@
  */
 - (void)scanditSDKOverlayController:(ScanditSDKOverlayController *)scanditSDKOverlayController
                     didManualSearch:(NSString *)input {
+    CDV_TRACE_SCOPE("ScanditSDK didManualSearch");
 	
-    if (!wasStatusBarHidden) {
-        [[UIApplication sharedApplication] setStatusBarHidden:NO withAnimation:UIStatusBarAnimationNone];
-    }
-	
-    [self.viewController dismissModalViewControllerAnimated:YES];
-	self.scanditSDKBarcodePicker = nil;
+    NSString *gtin = ScanditSDKNormalizedGtin(input, @"UNKNOWN");
+    [self.scanStats markStage:SCANDIT_STAGE_FIRST_RESULT];
+    id result = [self resultWithBarcode:input symbology:@"UNKNOWN" gtin:gtin];
     
-	
-    NSArray *result = [[NSArray alloc] initWithObjects:input, @"UNKNOWN", nil];
+    if (continuousSession) {
+        [self sendContinuousResult:result];
+        [self.scanditSDKBarcodePicker.overlayController resetUI];
+        [self.suggestionList clear];
+        return;
+    }
+    if (session.multiCode) {
+        // An entered code is taken as the last one of the scan.
+        [self addMultiCodeResult:result barcode:input symbology:@"UNKNOWN"];
+        [self finishMultiCodeCapture];
+        return;
+    }
     
-    CDVPluginResult *pluginResult = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK
-													   messageAsArray:result];
-    [self writeJavascript:[pluginResult toSuccessCallbackString:self.callbackId]];
-    self.hasPendingOperation = NO;
+    [self dismissPicker];
+    [self sendScanResult:result keepCallback:NO];
+}
+
+#pragma mark -
+#pragma mark ScanditSDKSuggestionListDelegate methods
+
+/**
+ * A picked suggestion is reported like a code typed into the search bar, so it is validated and
+ * normalized to a GTIN the same way.
+ */
+- (void)suggestionList:(ScanditSDKSuggestionList *)list didSelectBarcode:(NSString *)barcode {
+    [self scanditSDKOverlayController:self.scanditSDKBarcodePicker.overlayController
+                      didManualSearch:barcode];
 }
 
 
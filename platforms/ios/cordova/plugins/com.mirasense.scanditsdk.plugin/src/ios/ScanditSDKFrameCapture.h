@@ -0,0 +1,28 @@
+//
+//  Copyright 2010 Mirasense AG
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+//  Writing of frames grabbed from the running scan session to temporary files.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Writes the JPEG encoded frame to a new file in the temporary directory and returns its path,
+ * or nil with error set if it could not be written. Frames larger than maxDimension on their
+ * longer side are decoded at a reduced size and encoded again with the given quality (0 to 1),
+ * smaller ones are written as they are. A maxDimension of 0 never scales.
+ */
+NSString *ScanditSDKWriteFrame(NSData *jpeg, int maxDimension, float quality, NSError **error);
@@ -0,0 +1,96 @@
+//
+//  Copyright 2010 Mirasense AG
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+
+#import "ScanditSDKFrameCapture.h"
+#import <ImageIO/ImageIO.h>
+#import <MobileCoreServices/MobileCoreServices.h>
+
+#define SCANDIT_FRAME_PREFIX @"scandit_frame_"
+
+static NSString *ScanditSDKNewFramePath(void) {
+    NSString *directory = [NSTemporaryDirectory() stringByStandardizingPath];
+    CFUUIDRef uuid = CFUUIDCreate(NULL);
+    NSString *name = (__bridge_transfer NSString *) CFUUIDCreateString(NULL, uuid);
+    CFRelease(uuid);
+    return [NSString stringWithFormat:@"%@/%@%@.jpg", directory, SCANDIT_FRAME_PREFIX, name];
+}
+
+/**
+ * Decodes the JPEG at a size that fits into maxDimension and encodes it again. ImageIO decodes
+ * straight to the reduced size, the full frame is never held in memory as a bitmap.
+ */
+static NSData *ScanditSDKDownscaledJpeg(NSData *jpeg, int maxDimension, float quality) {
+    CGImageSourceRef source = CGImageSourceCreateWithData((__bridge CFDataRef) jpeg, NULL);
+    if (source == NULL) {
+        return nil;
+    }
+    
+    NSData *result = nil;
+    NSDictionary *properties = (__bridge_transfer NSDictionary *)
+        CGImageSourceCopyPropertiesAtIndex(source, 0, NULL);
+    int width = [[properties objectForKey:(__bridge NSString *) kCGImagePropertyPixelWidth] intValue];
+    int height = [[properties objectForKey:(__bridge NSString *) kCGImagePropertyPixelHeight] intValue];
+    if (maxDimension <= 0 || MAX(width, height) <= maxDimension) {
+        CFRelease(source);
+        return jpeg;
+    }
+    
+    NSDictionary *thumbnailOptions = [NSDictionary dictionaryWithObjectsAndKeys:
+        (id) kCFBooleanTrue, (__bridge NSString *) kCGImageSourceCreateThumbnailFromImageAlways,
+        (id) kCFBooleanTrue, (__bridge NSString *) kCGImageSourceCreateThumbnailWithTransform,
+        [NSNumber numberWithInt:maxDimension], (__bridge NSString *) kCGImageSourceThumbnailMaxPixelSize,
+        nil];
+    CGImageRef image = CGImageSourceCreateThumbnailAtIndex(source, 0,
+                                                           (__bridge CFDictionaryRef) thumbnailOptions);
+    CFRelease(source);
+    if (image == NULL) {
+        return nil;
+    }
+    
+    NSMutableData *data = [NSMutableData data];
+    CGImageDestinationRef destination = CGImageDestinationCreateWithData(
+        (__bridge CFMutableDataRef) data, kUTTypeJPEG, 1, NULL);
+    if (destination != NULL) {
+        NSDictionary *encodingOptions = [NSDictionary dictionaryWithObject:[NSNumber numberWithFloat:quality]
+                                                                    forKey:(__bridge NSString *) kCGImageDestinationLossyCompressionQuality];
+        CGImageDestinationAddImage(destination, image, (__bridge CFDictionaryRef) encodingOptions);
+        if (CGImageDestinationFinalize(destination)) {
+            result = data;
+        }
+        CFRelease(destination);
+    }
+    CGImageRelease(image);
+    return result;
+}
+
+NSString *ScanditSDKWriteFrame(NSData *jpeg, int maxDimension, float quality, NSError **error) {
+    NSData *data = ScanditSDKDownscaledJpeg(jpeg, maxDimension, quality);
+    if (data == nil) {
+        if (error != NULL) {
+            *error = [NSError errorWithDomain:@"ScanditSDK" code:0 userInfo:
+                      [NSDictionary dictionaryWithObject:@"The frame could not be scaled"
+                                                  forKey:NSLocalizedDescriptionKey]];
+        }
+        return nil;
+    }
+    
+    NSString *path = ScanditSDKNewFramePath();
+    if (![data writeToFile:path options:NSAtomicWrite error:error]) {
+        return nil;
+    }
+    return path;
+}
@@ -0,0 +1,34 @@
+//
+//  Copyright 2010 Mirasense AG
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+//  Validation and normalization of the GTIN family of product codes (EAN-8, EAN-13, UPC-A and
+//  UPC-E) to the 14 digit GTIN used as one canonical key per product.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Returns YES for the symbologies whose codes are GTINs, that is "EAN8", "EAN13", "UPC12" and
+ * "UPCE".
+ */
+BOOL ScanditSDKIsGtinSymbology(NSString *symbology);
+
+/**
+ * Returns the 14 digit GTIN of the code, or nil if the code is not a GTIN or its check digit is
+ * wrong. UPC-E codes are expanded to UPC-A first. For manually entered codes ("UNKNOWN"
+ * symbology) the type is inferred from the number of digits.
+ */
+NSString *ScanditSDKNormalizedGtin(NSString *barcode, NSString *symbology);
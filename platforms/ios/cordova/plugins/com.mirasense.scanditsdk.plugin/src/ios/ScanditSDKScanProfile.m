@@ -0,0 +1,495 @@
+//
+//  Copyright 2010 Mirasense AG
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+
+#import "ScanditSDKScanProfile.h"
+#include <ctype.h>
+#include <stdlib.h>
+
+// Options that only affect the scan session and not the configuration of the picker.
+static NSArray *ScanditSDKSessionOptionKeys(void) {
+    static NSArray *keys = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        keys = [[NSArray alloc] initWithObjects:@"continuous", @"animated", @"duplicateFilterWindow",
+                @"batchSize", @"batchInterval", @"multiCode", @"multiCodeWindow",
+                @"timings", @"arrayResults",
+                @"fallbackSymbologies", @"fallbackDelay", @"suggestionSource", @"suggestionLimit", nil];
+    });
+    return keys;
+}
+
+static signed char ScanditSDKSwitchOption(NSDictionary *options, NSString *key,
+                                          NSMutableArray *invalidKeys) {
+    id value = [options objectForKey:key];
+    if (value == nil) {
+        return SCANDIT_SWITCH_UNSET;
+    }
+    if (![value isKindOfClass:[NSNumber class]]) {
+        [invalidKeys addObject:key];
+        return SCANDIT_SWITCH_UNSET;
+    }
+    return [value boolValue] ? 1 : 0;
+}
+
+static NSString *ScanditSDKStringOption(NSDictionary *options, NSString *key,
+                                        NSMutableArray *invalidKeys) {
+    id value = [options objectForKey:key];
+    if (value != nil && ![value isKindOfClass:[NSString class]]) {
+        [invalidKeys addObject:key];
+        return nil;
+    }
+    return value;
+}
+
+static BOOL ScanditSDKIntegerOption(NSDictionary *options, NSString *key, NSInteger *result,
+                                    NSMutableArray *invalidKeys) {
+    id value = [options objectForKey:key];
+    if (value == nil) {
+        return NO;
+    }
+    if (![value isKindOfClass:[NSNumber class]]) {
+        [invalidKeys addObject:key];
+        return NO;
+    }
+    *result = [value integerValue];
+    return YES;
+}
+
+/**
+ * Parses a list of symbology option keys (like ["code128", "qr"]) into a set of symbologies.
+ */
+static ScanditSDKSymbologySet ScanditSDKSymbologiesOption(NSDictionary *options, NSString *key,
+                                                          NSMutableArray *invalidKeys) {
+    id value = [options objectForKey:key];
+    if (value == nil) {
+        return 0;
+    }
+    ScanditSDKSymbologySet symbologies = 0;
+    if ([value isKindOfClass:[NSArray class]]) {
+        for (id name in value) {
+            ScanditSDKSymbologySet symbology = 0;
+            if ([name isKindOfClass:[NSString class]]) {
+                symbology = ScanditSDKSymbologyForOptionKey(name);
+            }
+            if (symbology == 0) {
+                [invalidKeys addObject:key];
+                return 0;
+            }
+            symbologies |= symbology;
+        }
+        return symbologies;
+    }
+    [invalidKeys addObject:key];
+    return 0;
+}
+
+/**
+ * Parses exactly count numbers separated by '/' (like "0.5/0.5") into values.
+ */
+static BOOL ScanditSDKFloatsOption(NSDictionary *options, NSString *key, float *values, int count,
+                                   NSMutableArray *invalidKeys) {
+    id value = [options objectForKey:key];
+    if (value == nil) {
+        return NO;
+    }
+    if ([value isKindOfClass:[NSString class]]) {
+        const char *cursor = [value UTF8String];
+        int i = 0;
+        while (i < count) {
+            char *end = NULL;
+            values[i] = strtof(cursor, &end);
+            if (end == cursor) {
+                break;
+            }
+            cursor = end;
+            while (*cursor == ' ') {
+                ++cursor;
+            }
+            ++i;
+            if (i < count) {
+                if (*cursor != '/') {
+                    break;
+                }
+                ++cursor;
+            }
+        }
+        if (i == count && *cursor == '\0') {
+            return YES;
+        }
+    }
+    [invalidKeys addObject:key];
+    return NO;
+}
+
+/**
+ * Parses a hex color of the form "RRGGBB" or "RRGGBBAA" into red, green and blue components. The
+ * viewfinder has no alpha, so an alpha component is accepted but ignored. Anything other than
+ * exactly 6 or 8 hex digits, such as a "0x" prefix, a sign or whitespace, is rejected.
+ */
+static BOOL ScanditSDKColorOption(NSDictionary *options, NSString *key, float *rgb,
+                                  NSMutableArray *invalidKeys) {
+    id value = [options objectForKey:key];
+    if (value == nil) {
+        return NO;
+    }
+    if ([value isKindOfClass:[NSString class]] && ([value length] == 6 || [value length] == 8)) {
+        const char *hex = [value UTF8String];
+        size_t length = strlen(hex);
+        BOOL digitsOnly = (length == [value length]);
+        for (size_t i = 0; digitsOnly && i < length; i++) {
+            digitsOnly = isxdigit((unsigned char) hex[i]) != 0;
+        }
+        char *end = NULL;
+        unsigned long color = digitsOnly ? strtoul(hex, &end, 16) : 0;
+        if (digitsOnly && end == hex + length) {
+            if (length == 8) {
+                color >>= 8;
+            }
+            rgb[0] = ((float) ((color >> 16) & 0xFF)) / 256.0;
+            rgb[1] = ((float) ((color >> 8) & 0xFF)) / 256.0;
+            rgb[2] = ((float) (color & 0xFF)) / 256.0;
+            return YES;
+        }
+    }
+    [invalidKeys addObject:key];
+    return NO;
+}
+
+
+@interface ScanditSDKScanProfile ()
+
+@property (nonatomic, readwrite, copy) NSString *searchBarActionButtonCaption;
+@property (nonatomic, readwrite, copy) NSString *searchBarCancelButtonCaption;
+@property (nonatomic, readwrite, copy) NSString *searchBarPlaceholderText;
+@property (nonatomic, readwrite, copy) NSString *toolBarButtonCaption;
+@property (nonatomic, readwrite, copy) NSString *suggestionSource;
+@property (nonatomic, copy) NSDictionary *pickerOptions;
+
+@end
+
+
+@implementation ScanditSDKScanProfile
+
+@synthesize searchBarActionButtonCaption;
+@synthesize searchBarCancelButtonCaption;
+@synthesize searchBarPlaceholderText;
+@synthesize toolBarButtonCaption;
+@synthesize suggestionSource;
+@synthesize pickerOptions;
+
++ (ScanditSDKScanProfile *)profileWithOptions:(NSDictionary *)options
+                                  invalidKeys:(NSMutableArray *)invalidKeys {
+    ScanditSDKScanProfile *profile = [[ScanditSDKScanProfile alloc] init];
+    ScanditSDKPickerSettings *p = &profile->picker;
+    
+    p->facing = CAMERA_FACING_BACK;
+    if (ScanditSDKSwitchOption(options, @"preferFrontCamera", invalidKeys) == 1) {
+        p->facing = CAMERA_FACING_FRONT;
+    }
+    
+    p->searchBar = ScanditSDKSwitchOption(options, @"searchBar", invalidKeys);
+    p->scanning1D = ScanditSDKSwitchOption(options, @"1DScanning", invalidKeys);
+    p->scanning2D = ScanditSDKSwitchOption(options, @"2DScanning", invalidKeys);
+    p->ean13AndUpc12 = ScanditSDKSwitchOption(options, @"ean13AndUpc12", invalidKeys);
+    p->ean8 = ScanditSDKSwitchOption(options, @"ean8", invalidKeys);
+    p->upce = ScanditSDKSwitchOption(options, @"upce", invalidKeys);
+    p->code39 = ScanditSDKSwitchOption(options, @"code39", invalidKeys);
+    p->code128 = ScanditSDKSwitchOption(options, @"code128", invalidKeys);
+    p->itf = ScanditSDKSwitchOption(options, @"itf", invalidKeys);
+    p->qr = ScanditSDKSwitchOption(options, @"qr", invalidKeys);
+    p->dataMatrix = ScanditSDKSwitchOption(options, @"dataMatrix", invalidKeys);
+    p->pdf417 = ScanditSDKSwitchOption(options, @"pdf417", invalidKeys);
+    p->msiPlessey = ScanditSDKSwitchOption(options, @"msiPlessey", invalidKeys);
+    p->inverseRecognition = ScanditSDKSwitchOption(options, @"inverseRecognition", invalidKeys);
+    p->microDataMatrix = ScanditSDKSwitchOption(options, @"microDataMatrix", invalidKeys);
+    p->force2d = ScanditSDKSwitchOption(options, @"force2d", invalidKeys);
+    p->adaptiveSymbologies = ScanditSDKSwitchOption(options, @"adaptiveSymbologies", invalidKeys);
+    p->restrictActiveScanningArea = ScanditSDKSwitchOption(options, @"restrictActiveScanningArea",
+                                                           invalidKeys);
+    p->beep = ScanditSDKSwitchOption(options, @"beep", invalidKeys);
+    p->vibrate = ScanditSDKSwitchOption(options, @"vibrate", invalidKeys);
+    p->torch = ScanditSDKSwitchOption(options, @"torch", invalidKeys);
+    
+    NSString *msiPlesseyChecksum = ScanditSDKStringOption(options, @"msiPlesseyChecksumType",
+                                                          invalidKeys);
+    if (msiPlesseyChecksum != nil) {
+        p->hasMsiPlesseyChecksumType = YES;
+        if ([msiPlesseyChecksum isEqualToString:@"none"]) {
+            p->msiPlesseyChecksumType = NONE;
+        } else if ([msiPlesseyChecksum isEqualToString:@"mod11"]) {
+            p->msiPlesseyChecksumType = CHECKSUM_MOD_11;
+        } else if ([msiPlesseyChecksum isEqualToString:@"mod1010"]) {
+            p->msiPlesseyChecksumType = CHECKSUM_MOD_1010;
+        } else if ([msiPlesseyChecksum isEqualToString:@"mod1110"]) {
+            p->msiPlesseyChecksumType = CHECKSUM_MOD_1110;
+        } else {
+            p->msiPlesseyChecksumType = CHECKSUM_MOD_10;
+        }
+    }
+    
+    p->hasScanningHotspot = ScanditSDKFloatsOption(options, @"scanningHotspot",
+                                                   p->scanningHotspot, 2, invalidKeys);
+    NSNumber *scanningHotspotHeight = [options objectForKey:@"scanningHotspotHeight"];
+    if (scanningHotspotHeight != nil) {
+        if ([scanningHotspotHeight isKindOfClass:[NSNumber class]]) {
+            p->hasScanningHotspotHeight = YES;
+            p->scanningHotspotHeight = [scanningHotspotHeight floatValue];
+        } else {
+            [invalidKeys addObject:@"scanningHotspotHeight"];
+        }
+    }
+    p->hasViewfinderSize = ScanditSDKFloatsOption(options, @"viewfinderSize",
+                                                  p->viewfinderSize, 4, invalidKeys);
+    p->hasTorchButtonPositionAndSize = ScanditSDKFloatsOption(options, @"torchButtonPositionAndSize",
+                                                              p->torchButtonPositionAndSize, 4,
+                                                              invalidKeys);
+    
+    NSString *cameraSwitchVisibility = ScanditSDKStringOption(options, @"cameraSwitchVisibility",
+                                                              invalidKeys);
+    if (cameraSwitchVisibility != nil) {
+        p->hasCameraSwitchVisibility = YES;
+        if ([cameraSwitchVisibility isEqualToString:@"tablet"]) {
+            p->cameraSwitchVisibility = CAMERA_SWITCH_ON_TABLET;
+        } else if ([cameraSwitchVisibility isEqualToString:@"always"]) {
+            p->cameraSwitchVisibility = CAMERA_SWITCH_ALWAYS;
+        } else {
+            p->cameraSwitchVisibility = CAMERA_SWITCH_NEVER;
+        }
+    }
+    p->hasCameraSwitchButtonPositionAndSize = ScanditSDKFloatsOption(options,
+                                                                     @"cameraSwitchButtonPositionAndSize",
+                                                                     p->cameraSwitchButtonPositionAndSize,
+                                                                     4, invalidKeys);
+    p->hasLogoOffsets = ScanditSDKFloatsOption(options, @"logoOffsets", p->logoOffsets, 4,
+                                               invalidKeys);
+    
+    profile.searchBarActionButtonCaption = ScanditSDKStringOption(options,
+                                                                  @"searchBarActionButtonCaption",
+                                                                  invalidKeys);
+    profile.searchBarCancelButtonCaption = ScanditSDKStringOption(options,
+                                                                  @"searchBarCancelButtonCaption",
+                                                                  invalidKeys);
+    profile.searchBarPlaceholderText = ScanditSDKStringOption(options, @"searchBarPlaceholderText",
+                                                              invalidKeys);
+    profile.toolBarButtonCaption = ScanditSDKStringOption(options, @"toolBarButtonCaption",
+                                                          invalidKeys);
+    
+    p->hasViewfinderColor = ScanditSDKColorOption(options, @"viewfinderColor",
+                                                  p->viewfinderColor, invalidKeys);
+    p->hasViewfinderDecodedColor = ScanditSDKColorOption(options, @"viewfinderDecodedColor",
+                                                         p->viewfinderDecodedColor, invalidKeys);
+    
+    p->hasMinSearchBarBarcodeLength = ScanditSDKIntegerOption(options, @"minSearchBarBarcodeLength",
+                                                              &p->minSearchBarBarcodeLength,
+                                                              invalidKeys);
+    p->hasMaxSearchBarBarcodeLength = ScanditSDKIntegerOption(options, @"maxSearchBarBarcodeLength",
+                                                              &p->maxSearchBarBarcodeLength,
+                                                              invalidKeys);
+    
+    ScanditSDKSessionSettings *s = &profile->session;
+    s->continuous = (ScanditSDKSwitchOption(options, @"continuous", invalidKeys) == 1);
+    s->animated = (ScanditSDKSwitchOption(options, @"animated", invalidKeys) != 0);
+    s->timings = (ScanditSDKSwitchOption(options, @"timings", invalidKeys) == 1);
+    s->arrayResults = (ScanditSDKSwitchOption(options, @"arrayResults", invalidKeys) == 1);
+    s->fallbackSymbologies = ScanditSDKSymbologiesOption(options, @"fallbackSymbologies",
+                                                         invalidKeys);
+    if (!ScanditSDKIntegerOption(options, @"fallbackDelay", &s->fallbackDelay, invalidKeys)
+            || s->fallbackDelay < 0) {
+        s->fallbackDelay = SCANDIT_DEFAULT_FALLBACK_DELAY;
+    }
+    if (!ScanditSDKIntegerOption(options, @"duplicateFilterWindow", &s->duplicateFilterWindow,
+                                 invalidKeys)) {
+        s->duplicateFilterWindow = SCANDIT_DEFAULT_DUPLICATE_FILTER_WINDOW;
+    }
+    if (!ScanditSDKIntegerOption(options, @"batchSize", &s->batchSize, invalidKeys)
+            || s->batchSize < 1) {
+        s->batchSize = 1;
+    }
+    if (!ScanditSDKIntegerOption(options, @"batchInterval", &s->batchInterval, invalidKeys)
+            || s->batchInterval < 0) {
+        s->batchInterval = 0;
+    }
+    // Continuous sessions already report every code.
+    s->multiCode = (ScanditSDKSwitchOption(options, @"multiCode", invalidKeys) == 1) && !s->continuous;
+    if (!ScanditSDKIntegerOption(options, @"multiCodeWindow", &s->multiCodeWindow, invalidKeys)
+            || s->multiCodeWindow < 0) {
+        s->multiCodeWindow = SCANDIT_DEFAULT_MULTI_CODE_WINDOW;
+    }
+    profile.suggestionSource = ScanditSDKStringOption(options, @"suggestionSource", invalidKeys);
+    if (!ScanditSDKIntegerOption(options, @"suggestionLimit", &s->suggestionLimit, invalidKeys)
+            || s->suggestionLimit < 1) {
+        s->suggestionLimit = SCANDIT_DEFAULT_SUGGESTION_LIMIT;
+    }
+    
+    NSMutableDictionary *compiledPickerOptions = [NSMutableDictionary dictionaryWithDictionary:options];
+    [compiledPickerOptions removeObjectsForKeys:ScanditSDKSessionOptionKeys()];
+    profile.pickerOptions = compiledPickerOptions;
+    
+    return profile;
+}
+
+- (BOOL)hasSamePickerSettingsAs:(ScanditSDKScanProfile *)profile {
+    if (profile == nil) {
+        return NO;
+    }
+    return profile == self || [self.pickerOptions isEqualToDictionary:profile.pickerOptions];
+}
+
+- (void)applyToPicker:(ScanditSDKBarcodePicker *)scanditSDKBarcodePicker {
+    const ScanditSDKPickerSettings *p = &picker;
+    ScanditSDKOverlayController *overlay = scanditSDKBarcodePicker.overlayController;
+    
+    if (p->searchBar != SCANDIT_SWITCH_UNSET) {
+        [overlay showSearchBar:p->searchBar];
+    }
+    
+    if (p->scanning1D != SCANDIT_SWITCH_UNSET) {
+        [scanditSDKBarcodePicker set1DScanningEnabled:p->scanning1D];
+    }
+    if (p->scanning2D != SCANDIT_SWITCH_UNSET) {
+        [scanditSDKBarcodePicker set2DScanningEnabled:p->scanning2D];
+    }
+    if (p->ean13AndUpc12 != SCANDIT_SWITCH_UNSET) {
+        [scanditSDKBarcodePicker setEan13AndUpc12Enabled:p->ean13AndUpc12];
+    }
+    if (p->ean8 != SCANDIT_SWITCH_UNSET) {
+        [scanditSDKBarcodePicker setEan8Enabled:p->ean8];
+    }
+    if (p->upce != SCANDIT_SWITCH_UNSET) {
+        [scanditSDKBarcodePicker setUpceEnabled:p->upce];
+    }
+    if (p->code39 != SCANDIT_SWITCH_UNSET) {
+        [scanditSDKBarcodePicker setCode39Enabled:p->code39];
+    }
+    if (p->code128 != SCANDIT_SWITCH_UNSET) {
+        [scanditSDKBarcodePicker setCode128Enabled:p->code128];
+    }
+    if (p->itf != SCANDIT_SWITCH_UNSET) {
+        [scanditSDKBarcodePicker setItfEnabled:p->itf];
+    }
+    if (p->qr != SCANDIT_SWITCH_UNSET) {
+        [scanditSDKBarcodePicker setQrEnabled:p->qr];
+    }
+    if (p->dataMatrix != SCANDIT_SWITCH_UNSET) {
+        [scanditSDKBarcodePicker setDataMatrixEnabled:p->dataMatrix];
+    }
+    if (p->pdf417 != SCANDIT_SWITCH_UNSET) {
+        [scanditSDKBarcodePicker setPdf417Enabled:p->pdf417];
+    }
+    if (p->msiPlessey != SCANDIT_SWITCH_UNSET) {
+        [scanditSDKBarcodePicker setMsiPlesseyEnabled:p->msiPlessey];
+    }
+    if (p->hasMsiPlesseyChecksumType) {
+        [scanditSDKBarcodePicker setMsiPlesseyChecksumType:p->msiPlesseyChecksumType];
+    }
+    
+    if (p->inverseRecognition != SCANDIT_SWITCH_UNSET) {
+        [scanditSDKBarcodePicker setInverseDetectionEnabled:p->inverseRecognition];
+    }
+    if (p->microDataMatrix != SCANDIT_SWITCH_UNSET) {
+        [scanditSDKBarcodePicker setMicroDataMatrixEnabled:p->microDataMatrix];
+    }
+    if (p->adaptiveSymbologies == 1) {
+        // The plugin enables the symbologies of an adaptive session when it starts.
+        ScanditSDKApplySymbologies(scanditSDKBarcodePicker, SCANDIT_SYMBOLOGIES_GTIN);
+    }
+    if (p->force2d != SCANDIT_SWITCH_UNSET) {
+        [scanditSDKBarcodePicker force2dRecognition:p->force2d];
+    }
+    if (p->restrictActiveScanningArea != SCANDIT_SWITCH_UNSET) {
+        [scanditSDKBarcodePicker restrictActiveScanningArea:p->restrictActiveScanningArea];
+    }
+    
+    if (p->hasScanningHotspot) {
+        [scanditSDKBarcodePicker setScanningHotSpotToX:p->scanningHotspot[0]
+                                                   andY:p->scanningHotspot[1]];
+    }
+    if (p->hasScanningHotspotHeight) {
+        [scanditSDKBarcodePicker setScanningHotSpotHeight:p->scanningHotspotHeight];
+    }
+    if (p->hasViewfinderSize) {
+        [overlay setViewfinderHeight:p->viewfinderSize[1]
+                               width:p->viewfinderSize[0]
+                     landscapeHeight:p->viewfinderSize[3]
+                      landscapeWidth:p->viewfinderSize[2]];
+    }
+    
+    if (p->beep != SCANDIT_SWITCH_UNSET) {
+        [overlay setBeepEnabled:p->beep];
+    }
+    if (p->vibrate != SCANDIT_SWITCH_UNSET) {
+        [overlay setVibrateEnabled:p->vibrate];
+    }
+    
+    if (p->torch != SCANDIT_SWITCH_UNSET) {
+        [overlay setTorchEnabled:p->torch];
+    }
+    if (p->hasTorchButtonPositionAndSize) {
+        [overlay setTorchButtonRelativeX:p->torchButtonPositionAndSize[0]
+                               relativeY:p->torchButtonPositionAndSize[1]
+                                   width:(int) p->torchButtonPositionAndSize[2]
+                                  height:(int) p->torchButtonPositionAndSize[3]];
+    }
+    if (p->hasCameraSwitchVisibility) {
+        [overlay setCameraSwitchVisibility:p->cameraSwitchVisibility];
+    }
+    if (p->hasCameraSwitchButtonPositionAndSize) {
+        [overlay setCameraSwitchButtonRelativeInverseX:p->cameraSwitchButtonPositionAndSize[0]
+                                             relativeY:p->cameraSwitchButtonPositionAndSize[1]
+                                                 width:(int) p->cameraSwitchButtonPositionAndSize[2]
+                                                height:(int) p->cameraSwitchButtonPositionAndSize[3]];
+    }
+    if (p->hasLogoOffsets) {
+        [overlay setLogoXOffset:(int) p->logoOffsets[0]
+                        yOffset:(int) p->logoOffsets[1]
+               landscapeXOffset:(int) p->logoOffsets[2]
+               landscapeYOffset:(int) p->logoOffsets[3]];
+    }
+    
+    if (self.searchBarActionButtonCaption != nil) {
+        [overlay setSearchBarActionButtonCaption:self.searchBarActionButtonCaption];
+    }
+    if (self.searchBarCancelButtonCaption != nil) {
+        [overlay setSearchBarCancelButtonCaption:self.searchBarCancelButtonCaption];
+    }
+    if (self.searchBarPlaceholderText != nil) {
+        [overlay setSearchBarPlaceholderText:self.searchBarPlaceholderText];
+    }
+    if (self.toolBarButtonCaption != nil) {
+        [overlay setToolBarButtonCaption:self.toolBarButtonCaption];
+    }
+    
+    if (p->hasViewfinderColor) {
+        [overlay setViewfinderColor:p->viewfinderColor[0]
+                              green:p->viewfinderColor[1]
+                               blue:p->viewfinderColor[2]];
+    }
+    if (p->hasViewfinderDecodedColor) {
+        [overlay setViewfinderDecodedColor:p->viewfinderDecodedColor[0]
+                                     green:p->viewfinderDecodedColor[1]
+                                      blue:p->viewfinderDecodedColor[2]];
+    }
+    
+    if (p->hasMinSearchBarBarcodeLength) {
+        [overlay setMinSearchBarBarcodeLength:p->minSearchBarBarcodeLength];
+    }
+    if (p->hasMaxSearchBarBarcodeLength) {
+        [overlay setMaxSearchBarBarcodeLength:p->maxSearchBarBarcodeLength];
+    }
+}
+
+@end
@@ -0,0 +1,141 @@
+//
+//  Copyright 2010 Mirasense AG
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+
+#import "ScanditSDKScanStats.h"
+#import "Cordova/CDVMetrics.h"
+#include <mach/mach_time.h>
+
+static NSString *const ScanditSDKStageNames[SCANDIT_STAGE_COUNT] = {
+    @"scanCalled",
+    @"pickerReady",
+    @"presented",
+    @"scanningStarted",
+    @"firstResult",
+    @"resultDelivered"
+};
+
+static const double ScanditSDKHistogramBounds[SCANDIT_HISTOGRAM_BUCKETS - 1] =
+    SCANDIT_HISTOGRAM_BOUNDS;
+
+static double ScanditSDKMillisecondsBetween(uint64_t start, uint64_t end) {
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+    return (double) (end - start) * timebase.numer / timebase.denom / 1e6;
+}
+
+static void ScanditSDKHistogramAdd(ScanditSDKHistogram *histogram, double value) {
+    if (histogram->count == 0 || value < histogram->min) {
+        histogram->min = value;
+    }
+    if (histogram->count == 0 || value > histogram->max) {
+        histogram->max = value;
+    }
+    histogram->count++;
+    histogram->sum += value;
+    
+    int bucket = 0;
+    while (bucket < SCANDIT_HISTOGRAM_BUCKETS - 1 && value > ScanditSDKHistogramBounds[bucket]) {
+        bucket++;
+    }
+    histogram->buckets[bucket]++;
+}
+
+
+@implementation ScanditSDKScanStats
+
+- (void)beginScan {
+    memset(stamps, 0, sizeof(stamps));
+    stamps[SCANDIT_STAGE_SCAN_CALLED] = mach_absolute_time();
+    scanRecorded = NO;
+}
+
+- (void)markStage:(ScanditSDKScanStage)stage {
+    if (stamps[SCANDIT_STAGE_SCAN_CALLED] != 0 && stamps[stage] == 0) {
+        stamps[stage] = mach_absolute_time();
+    }
+}
+
+- (void)endScan {
+    if (scanRecorded || stamps[SCANDIT_STAGE_RESULT_DELIVERED] == 0) {
+        return;
+    }
+    for (int stage = SCANDIT_STAGE_SCAN_CALLED + 1; stage < SCANDIT_STAGE_COUNT; stage++) {
+        if (stamps[stage] != 0) {
+            ScanditSDKHistogramAdd(&histograms[stage], ScanditSDKMillisecondsBetween(
+                    stamps[SCANDIT_STAGE_SCAN_CALLED], stamps[stage]));
+        }
+    }
+    
+    // The fleet-wide latency, in microseconds, of the stages the user waits for.
+    if (stamps[SCANDIT_STAGE_FIRST_RESULT] != 0) {
+        CDV_METRICS_RECORD("scan.firstResult.us", (int64_t)(1000 * ScanditSDKMillisecondsBetween(
+                stamps[SCANDIT_STAGE_SCAN_CALLED], stamps[SCANDIT_STAGE_FIRST_RESULT])));
+    }
+    CDV_METRICS_RECORD("scan.resultDelivered.us", (int64_t)(1000 * ScanditSDKMillisecondsBetween(
+            stamps[SCANDIT_STAGE_SCAN_CALLED], stamps[SCANDIT_STAGE_RESULT_DELIVERED])));
+    scanRecorded = YES;
+}
+
+- (NSDictionary *)currentTimings {
+    NSMutableDictionary *timings = [NSMutableDictionary dictionaryWithCapacity:SCANDIT_STAGE_COUNT];
+    for (int stage = SCANDIT_STAGE_SCAN_CALLED + 1; stage < SCANDIT_STAGE_COUNT; stage++) {
+        if (stamps[stage] != 0) {
+            double ms = ScanditSDKMillisecondsBetween(stamps[SCANDIT_STAGE_SCAN_CALLED],
+                                                      stamps[stage]);
+            [timings setObject:[NSNumber numberWithDouble:ms] forKey:ScanditSDKStageNames[stage]];
+        }
+    }
+    return timings;
+}
+
+- (NSDictionary *)statistics {
+    NSMutableArray *bounds = [NSMutableArray arrayWithCapacity:SCANDIT_HISTOGRAM_BUCKETS - 1];
+    for (int i = 0; i < SCANDIT_HISTOGRAM_BUCKETS - 1; i++) {
+        [bounds addObject:[NSNumber numberWithDouble:ScanditSDKHistogramBounds[i]]];
+    }
+    
+    NSMutableDictionary *stages = [NSMutableDictionary dictionaryWithCapacity:SCANDIT_STAGE_COUNT];
+    for (int stage = SCANDIT_STAGE_SCAN_CALLED + 1; stage < SCANDIT_STAGE_COUNT; stage++) {
+        ScanditSDKHistogram *histogram = &histograms[stage];
+        NSMutableArray *buckets = [NSMutableArray arrayWithCapacity:SCANDIT_HISTOGRAM_BUCKETS];
+        for (int i = 0; i < SCANDIT_HISTOGRAM_BUCKETS; i++) {
+            [buckets addObject:[NSNumber numberWithUnsignedInteger:histogram->buckets[i]]];
+        }
+        double mean = (histogram->count > 0) ? histogram->sum / histogram->count : 0;
+        NSDictionary *entry = [NSDictionary dictionaryWithObjectsAndKeys:
+                               [NSNumber numberWithUnsignedInteger:histogram->count], @"count",
+                               [NSNumber numberWithDouble:histogram->min], @"min",
+                               [NSNumber numberWithDouble:histogram->max], @"max",
+                               [NSNumber numberWithDouble:mean], @"mean",
+                               buckets, @"buckets",
+                               nil];
+        [stages setObject:entry forKey:ScanditSDKStageNames[stage]];
+    }
+    
+    return [NSDictionary dictionaryWithObjectsAndKeys:
+            stages, @"stages",
+            bounds, @"bucketBounds",
+            nil];
+}
+
+- (void)reset {
+    memset(histograms, 0, sizeof(histograms));
+}
+
+@end
@@ -0,0 +1,97 @@
+//
+//  Copyright 2010 Mirasense AG
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+
+#import "ScanditSDKSymbologies.h"
+
+ScanditSDKSymbologySet ScanditSDKSymbologyForResultName(NSString *name) {
+    static NSDictionary *symbologies = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        symbologies = [[NSDictionary alloc] initWithObjectsAndKeys:
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_EAN13_UPC12], @"EAN13",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_EAN13_UPC12], @"UPC12",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_EAN8], @"EAN8",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_UPCE], @"UPCE",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_CODE39], @"CODE39",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_CODE128], @"CODE128",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_CODE128], @"GS1-128",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_ITF], @"ITF",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_MSI_PLESSEY], @"MSI",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_QR], @"QR",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_QR], @"GS1-QR",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_DATA_MATRIX], @"DATAMATRIX",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_DATA_MATRIX], @"GS1-DATAMATRIX",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_PDF417], @"PDF417",
+                       nil];
+    });
+    return [[symbologies objectForKey:name] unsignedIntValue];
+}
+
+ScanditSDKSymbologySet ScanditSDKSymbologyForOptionKey(NSString *key) {
+    static NSDictionary *symbologies = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        symbologies = [[NSDictionary alloc] initWithObjectsAndKeys:
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_EAN13_UPC12], @"ean13AndUpc12",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_EAN8], @"ean8",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_UPCE], @"upce",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_CODE39], @"code39",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_CODE128], @"code128",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_ITF], @"itf",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_MSI_PLESSEY], @"msiPlessey",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_QR], @"qr",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_DATA_MATRIX], @"dataMatrix",
+                       [NSNumber numberWithUnsignedInt:SCANDIT_SYMBOLOGY_PDF417], @"pdf417",
+                       nil];
+    });
+    return [[symbologies objectForKey:key] unsignedIntValue];
+}
+
+void ScanditSDKApplySymbologies(ScanditSDKBarcodePicker *picker, ScanditSDKSymbologySet symbologies) {
+    [picker setEan13AndUpc12Enabled:(symbologies & SCANDIT_SYMBOLOGY_EAN13_UPC12) != 0];
+    [picker setEan8Enabled:(symbologies & SCANDIT_SYMBOLOGY_EAN8) != 0];
+    [picker setUpceEnabled:(symbologies & SCANDIT_SYMBOLOGY_UPCE) != 0];
+    [picker setCode39Enabled:(symbologies & SCANDIT_SYMBOLOGY_CODE39) != 0];
+    [picker setCode128Enabled:(symbologies & SCANDIT_SYMBOLOGY_CODE128) != 0];
+    [picker setItfEnabled:(symbologies & SCANDIT_SYMBOLOGY_ITF) != 0];
+    [picker setMsiPlesseyEnabled:(symbologies & SCANDIT_SYMBOLOGY_MSI_PLESSEY) != 0];
+    [picker setQrEnabled:(symbologies & SCANDIT_SYMBOLOGY_QR) != 0];
+    [picker setDataMatrixEnabled:(symbologies & SCANDIT_SYMBOLOGY_DATA_MATRIX) != 0];
+    [picker setPdf417Enabled:(symbologies & SCANDIT_SYMBOLOGY_PDF417) != 0];
+    
+    // The 2D decoder is skipped entirely on frames when no 2D symbology is needed.
+    [picker set1DScanningEnabled:(symbologies & ~SCANDIT_SYMBOLOGIES_2D) != 0];
+    [picker set2DScanningEnabled:(symbologies & SCANDIT_SYMBOLOGIES_2D) != 0];
+}
+
+
+@implementation ScanditSDKSymbologyHistory
+
+- (void)recordSession:(ScanditSDKSymbologySet)symbologies {
+    sessions[next] = symbologies;
+    next = (next + 1) % SCANDIT_SYMBOLOGY_HISTORY_SIZE;
+}
+
+- (ScanditSDKSymbologySet)recentSymbologies {
+    ScanditSDKSymbologySet symbologies = 0;
+    for (int i = 0; i < SCANDIT_SYMBOLOGY_HISTORY_SIZE; i++) {
+        symbologies |= sessions[i];
+    }
+    return symbologies;
+}
+
+@end
@@ -0,0 +1,70 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import <Cordova/CDVPlugin.h>
+
+/*
+ * Native side of the Nutritionix item lookups made by the app.
+ *
+ *   configure(appId, appKey[, timeout[, itemURL]])
+ *                                        - API credentials, the request timeout in seconds and the
+ *                                          item endpoint, such as a local stub server (debug builds only)
+ *   lookup(gtin[, session])              - the trimmed item, from the cache or the API
+ *   lookupBatch([gtin, ...][, session])  - {gtin, item} or {gtin, error} for each code as its answer arrives
+ *   watchReplay()                        - {gtin, item} for each journaled scan found later
+ *   cacheGet(gtin)                       - the cached item, or null on a miss
+ *   cachePut(gtin, item[, ttl])          - caches the item for ttl seconds (default a week)
+ *   cacheClear()
+ *   catalogUpdate(url)                   - downloads and installs the offline catalog, {version, count};
+ *                                          "{version}" in the URL is replaced by the installed version
+ *   catalogSearch(text[, limit])         - [{gtin, name, brand}, ...] of the catalog matching the typed text,
+ *                                          10 by default and 100 at most
+ *   catalogInfo()                        - {version, count} of the installed catalog, 0 for none
+ *
+ * Scans are journaled before they are looked up. Those that fail for lack of
+ * network are looked up again, with backoff, once the app becomes active or
+ * a lookup gets through.
+ *
+ * session is the sequence number of the scan the lookups are made for, the
+ * same for all batches of a continuous session. The first lookup of a higher
+ * number cancels those of lower ones, which then fail with "a newer scan was
+ * made" but stay journaled and are looked up again by the replay. Lookups of
+ * the newest scan go ahead of replays and prefetches.
+ *
+ * The plugin is a suggestion source for the search bar of the scan screen: with
+ * the ScanditSDK option "suggestionSource": "Nutritionix", the catalog is
+ * searched as the user types, without network (see NutritionixCatalog.h).
+ */
+@interface Nutritionix : CDVPlugin
+
+- (void)configure:(CDVInvokedUrlCommand*)command;
+- (void)lookup:(CDVInvokedUrlCommand*)command;
+- (void)lookupBatch:(CDVInvokedUrlCommand*)command;
+- (void)watchReplay:(CDVInvokedUrlCommand*)command;
+- (void)cacheGet:(CDVInvokedUrlCommand*)command;
+- (void)cachePut:(CDVInvokedUrlCommand*)command;
+- (void)cacheClear:(CDVInvokedUrlCommand*)command;
+- (void)catalogUpdate:(CDVInvokedUrlCommand*)command;
+- (void)catalogSearch:(CDVInvokedUrlCommand*)command;
+- (void)catalogInfo:(CDVInvokedUrlCommand*)command;
+
+// Catalog items matching text as {barcode, title, subtitle}, for the search bar of the ScanditSDK plugin.
+- (NSArray*)scanditSDKSuggestionsForText:(NSString*)text limit:(NSUInteger)limit;
+
+@end
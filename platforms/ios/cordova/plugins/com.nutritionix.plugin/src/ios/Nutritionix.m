@@ -0,0 +1,442 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import "Nutritionix.h"
+#import <Cordova/CDVViewController.h>
+#import "NutritionixCache.h"
+#import "NutritionixCatalog.h"
+#import "NutritionixClient.h"
+#import "NutritionixJournal.h"
+
+#define NUTRITIONIX_DEFAULT_TTL (7 * 24 * 60 * 60)
+// journaled scans looked up per replay round
+#define NUTRITIONIX_REPLAY_BATCH 16
+// seconds before a failed replay is retried, doubled on every further failure
+#define NUTRITIONIX_REPLAY_MIN_DELAY 5
+#define NUTRITIONIX_REPLAY_MAX_DELAY (5 * 60)
+#define NUTRITIONIX_CATALOG_SEARCH_LIMIT 10
+// suggestions a catalogSearch returns at most, whatever limit it's given
+#define NUTRITIONIX_CATALOG_MAX_SEARCH_LIMIT 100
+#define NUTRITIONIX_CATALOG_TIMEOUT 60
+
+// Whether the lookup may succeed later: the network or the API was unavailable, or the queue was full.
+static BOOL NutritionixShouldRetry(NSError* error)
+{
+    if (error == nil) {
+        return NO;
+    }
+    if ([[error domain] isEqualToString:NSURLErrorDomain]) {
+        return YES;
+    }
+    return [[error domain] isEqualToString:kNutritionixErrorDomain] && (([error code] == 0) || ([error code] >= 500));
+}
+
+// The scan session of a lookup command, 0 if it is not tied to one.
+static NSUInteger NutritionixSessionArgument(CDVInvokedUrlCommand* command, NSUInteger index)
+{
+    id session = [command.arguments count] > index ? [command.arguments objectAtIndex:index] : nil;
+
+    return ([session isKindOfClass:[NSNumber class]] && ([session integerValue] > 0)) ? [session unsignedIntegerValue] : 0;
+}
+
+@interface Nutritionix () <CDVMemoryPressureHandler> {
+    // replay state, only touched on _replayQueue
+    dispatch_queue_t _replayQueue;
+    NSTimeInterval _replayDelay;
+    BOOL _replaying;
+    BOOL _replayScheduled;
+    NSString* _replayCallbackId;
+    // catalog downloads end and are installed here, off the command queue lookups and searches use
+    NSOperationQueue* _catalogQueue;
+}
+@end
+
+@implementation Nutritionix
+
+// The cache does file I/O, so commands are kept off the main thread.
++ (BOOL)runsCommandsInBackground
+{
+    return YES;
+}
+
+- (void)pluginInitialize
+{
+    _replayQueue = dispatch_queue_create("com.nutritionix.replay", DISPATCH_QUEUE_SERIAL);
+    _replayDelay = NUTRITIONIX_REPLAY_MIN_DELAY;
+    _catalogQueue = [[NSOperationQueue alloc] init];
+    [_catalogQueue setMaxConcurrentOperationCount:1];
+
+    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(onAppDidBecomeActive:)
+                                                 name:UIApplicationDidBecomeActiveNotification object:nil];
+    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(onAppWillResignActive:)
+                                                 name:UIApplicationWillResignActiveNotification object:nil];
+
+    if ([self.viewController isKindOfClass:[CDVViewController class]]) {
+        [((CDVViewController*)self.viewController).memoryPressure registerHandler:self
+                                                                            level:CDVMemoryPressureLevelDataCaches
+                                                                             name:@"Nutritionix cache"];
+    }
+}
+
+- (void)releaseMemoryForPressureLevel:(CDVMemoryPressureLevel)level
+{
+    [[NutritionixCache sharedCache] releaseMemory];
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    if (_replayQueue != NULL) {
+        dispatch_release(_replayQueue);
+    }
+}
+
+- (void)configure:(CDVInvokedUrlCommand*)command
+{
+    NutritionixClient* client = [NutritionixClient sharedClient];
+    id timeout = [command.arguments count] > 2 ? [command.arguments objectAtIndex:2] : nil;
+
+    client.appId = [command.arguments objectAtIndex:0];
+    client.appKey = [command.arguments objectAtIndex:1];
+    if ([timeout isKindOfClass:[NSNumber class]] && ([timeout doubleValue] > 0)) {
+        client.timeout = [timeout doubleValue];
+    }
+#ifdef DEBUG
+    // only the benchmark harness points the client at another endpoint
+    id itemURL = [command.arguments count] > 3 ? [command.arguments objectAtIndex:3] : nil;
+    if ([itemURL isKindOfClass:[NSString class]] && ([itemURL length] > 0)) {
+        client.itemURL = itemURL;
+    }
+#endif
+    [self.commandDelegate sendPluginResult:[CDVPluginResult resultWithStatus:CDVCommandStatus_OK] callbackId:command.callbackId];
+
+    // scans left over from an earlier run can be looked up now
+    [self replaySoon:YES];
+}
+
+// Journals the scan, looks it up and resolves it unless the lookup has to be retried later.
+// Lookups cancelled by a newer scan stay journaled, the replay still looks them up.
+- (void)lookupAndJournalGtin:(NSString*)gtin session:(NSUInteger)session completion:(void (^)(NSDictionary* item, NSString* message))completion
+{
+    BOOL journaled = [[NutritionixJournal sharedJournal] appendGtin:gtin];
+
+    [[NutritionixClient sharedClient] lookupGtin:gtin session:session completion:^(NSDictionary* item, NSError* error) {
+        if ([[error domain] isEqualToString:kNutritionixErrorDomain] && ([error code] == kNutritionixErrorCancelled)) {
+            completion(nil, [error localizedDescription]);
+            if (journaled) {
+                [self replaySoon:NO];
+            }
+            return;
+        }
+        if (journaled && NutritionixShouldRetry(error)) {
+            completion(nil, [NSString stringWithFormat:@"%@, the scan is looked up later", [error localizedDescription]]);
+            [self replaySoon:NO];
+            return;
+        }
+        [[NutritionixJournal sharedJournal] resolveGtin:gtin];
+        completion(item, [error localizedDescription]);
+        // the API is reachable again
+        [self replaySoon:YES];
+    }];
+}
+
+- (void)lookup:(CDVInvokedUrlCommand*)command
+{
+    NSString* gtin = [command.arguments objectAtIndex:0];
+    NSString* callbackId = command.callbackId;
+
+    if (![gtin isKindOfClass:[NSString class]] || ([gtin length] != 14)) {
+        CDVPluginResult* result = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:@"invalid GTIN"];
+        [self.commandDelegate sendPluginResult:result callbackId:callbackId];
+        return;
+    }
+
+    [self lookupAndJournalGtin:gtin session:NutritionixSessionArgument(command, 1) completion:^(NSDictionary* item, NSString* message) {
+        CDVPluginResult* result;
+        if (item != nil) {
+            result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:item];
+        } else {
+            result = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:message];
+        }
+        [self.commandDelegate sendPluginResult:result callbackId:callbackId];
+    }];
+}
+
+- (void)lookupBatch:(CDVInvokedUrlCommand*)command
+{
+    NSArray* gtins = [command.arguments objectAtIndex:0];
+    NSUInteger session = NutritionixSessionArgument(command, 1);
+    NSString* callbackId = command.callbackId;
+
+    if (![gtins isKindOfClass:[NSArray class]] || ([gtins count] == 0)) {
+        CDVPluginResult* result = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:@"no GTINs"];
+        [self.commandDelegate sendPluginResult:result callbackId:callbackId];
+        return;
+    }
+
+    // the callback is kept until the last code has been answered
+    __block NSUInteger remaining = [gtins count];
+    NSObject* lock = [[NSObject alloc] init];
+    void (^send)(NSDictionary*) = ^(NSDictionary* message) {
+        CDVPluginResult* result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:message];
+        @synchronized(lock) {
+            [result setKeepCallbackAsBool:(--remaining > 0)];
+            [self.commandDelegate sendPluginResult:result callbackId:callbackId];
+        }
+    };
+
+    for (id gtin in gtins) {
+        if (![gtin isKindOfClass:[NSString class]] || ([gtin length] != 14)) {
+            send([NSDictionary dictionaryWithObjectsAndKeys:[gtin description], @"gtin", @"invalid GTIN", @"error", nil]);
+            continue;
+        }
+        [self lookupAndJournalGtin:gtin session:session completion:^(NSDictionary* item, NSString* message) {
+            if (item != nil) {
+                send([NSDictionary dictionaryWithObjectsAndKeys:gtin, @"gtin", item, @"item", nil]);
+            } else {
+                send([NSDictionary dictionaryWithObjectsAndKeys:gtin, @"gtin", message, @"error", nil]);
+            }
+        }];
+    }
+}
+
+- (void)watchReplay:(CDVInvokedUrlCommand*)command
+{
+    NSString* callbackId = command.callbackId;
+
+    dispatch_async(_replayQueue, ^{
+        _replayCallbackId = callbackId;
+    });
+}
+
+#pragma mark -
+#pragma mark Replay
+
+// Replays the journal on the replay queue; now skips the backoff, else a failed round waits for it.
+- (void)replaySoon:(BOOL)now
+{
+    dispatch_async(_replayQueue, ^{
+        if (now) {
+            _replayDelay = NUTRITIONIX_REPLAY_MIN_DELAY;
+            [self replayJournal];
+        } else {
+            [self scheduleReplay];
+        }
+    });
+}
+
+- (void)scheduleReplay
+{
+    if (_replayScheduled) {
+        return;
+    }
+    _replayScheduled = YES;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(_replayDelay * NSEC_PER_SEC)), _replayQueue, ^{
+        _replayScheduled = NO;
+        [self replayJournal];
+    });
+    _replayDelay = MIN(_replayDelay * 2, NUTRITIONIX_REPLAY_MAX_DELAY);
+}
+
+// Looks up the oldest pending scans; the round ends when all of them are answered.
+- (void)replayJournal
+{
+    if (_replaying || ([NutritionixClient sharedClient].appId == nil)) {
+        return;
+    }
+    NSArray* gtins = [[NutritionixJournal sharedJournal] pendingGtinsWithLimit:NUTRITIONIX_REPLAY_BATCH];
+    if ([gtins count] == 0) {
+        return;
+    }
+
+    __block NSUInteger remaining = [gtins count];
+    __block BOOL failed = NO;
+    _replaying = YES;
+
+    for (NSString* gtin in gtins) {
+        [[NutritionixClient sharedClient] lookupGtin:gtin completion:^(NSDictionary* item, NSError* error) {
+            BOOL retry = NutritionixShouldRetry(error);
+            if (!retry) {
+                [[NutritionixJournal sharedJournal] resolveGtin:gtin];
+            }
+            dispatch_async(_replayQueue, ^{
+                if ((item != nil) && (_replayCallbackId != nil)) {
+                    CDVPluginResult* result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK
+                                                            messageAsDictionary:[NSDictionary dictionaryWithObjectsAndKeys:gtin, @"gtin", item, @"item", nil]];
+                    [result setKeepCallbackAsBool:YES];
+                    [self.commandDelegate sendPluginResult:result callbackId:_replayCallbackId];
+                }
+                failed = failed || retry;
+                if (--remaining == 0) {
+                    _replaying = NO;
+                    if (failed) {
+                        [self scheduleReplay];
+                    } else {
+                        // every scan of the round was resolved, go on with the next ones
+                        _replayDelay = NUTRITIONIX_REPLAY_MIN_DELAY;
+                        [self replayJournal];
+                    }
+                }
+            });
+        }];
+    }
+}
+
+#pragma mark -
+#pragma mark Notification handlers
+
+- (void)onAppDidBecomeActive:(NSNotification*)notification
+{
+    // connectivity often comes back while the app was in the background
+    [self replaySoon:YES];
+}
+
+- (void)onAppWillResignActive:(NSNotification*)notification
+{
+    __block UIBackgroundTaskIdentifier backgroundTaskID = UIBackgroundTaskInvalid;
+
+    backgroundTaskID = [[UIApplication sharedApplication] beginBackgroundTaskWithExpirationHandler:^{
+            [[UIApplication sharedApplication] endBackgroundTask:backgroundTaskID];
+            backgroundTaskID = UIBackgroundTaskInvalid;
+        }];
+    [self.commandDelegate runInBackground:^{
+        [[NutritionixJournal sharedJournal] sync];
+
+        [[UIApplication sharedApplication] endBackgroundTask:backgroundTaskID];
+        backgroundTaskID = UIBackgroundTaskInvalid;
+    }];
+}
+
+#pragma mark -
+#pragma mark Catalog
+
+- (NSDictionary*)catalogInfo
+{
+    NutritionixCatalog* catalog = [NutritionixCatalog sharedCatalog];
+
+    return [NSDictionary dictionaryWithObjectsAndKeys:[NSNumber numberWithUnsignedInt:catalog.version], @"version",
+        [NSNumber numberWithUnsignedInteger:catalog.count], @"count", nil];
+}
+
+- (void)catalogUpdate:(CDVInvokedUrlCommand*)command
+{
+    NSString* url = [command argumentAtIndex:0 withDefault:nil andClass:[NSString class]];
+    NutritionixCatalog* catalog = [NutritionixCatalog sharedCatalog];
+
+    if ([url length] == 0) {
+        [self.commandDelegate sendPluginResult:[CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:@"no catalog URL"]
+                                    callbackId:command.callbackId];
+        return;
+    }
+
+    // the server answers with a patch against the installed version, a full snapshot, or 304 if it is current
+    url = [url stringByReplacingOccurrencesOfString:@"{version}" withString:[NSString stringWithFormat:@"%u", catalog.version]];
+    NSURLRequest* request = [NSURLRequest requestWithURL:[NSURL URLWithString:url]
+                                             cachePolicy:NSURLRequestReloadIgnoringLocalCacheData
+                                         timeoutInterval:NUTRITIONIX_CATALOG_TIMEOUT];
+    // the download must not hold up the lookups and searches queued behind this command; searches
+    // keep using the installed snapshot until the new one is swapped in
+    [NSURLConnection sendAsynchronousRequest:request queue:_catalogQueue completionHandler:^(NSURLResponse* response, NSData* data, NSError* error) {
+        NSInteger statusCode = [response isKindOfClass:[NSHTTPURLResponse class]] ? [(NSHTTPURLResponse*)response statusCode] : 0;
+        CDVPluginResult* result = nil;
+
+        if (data == nil) {
+            result = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:[error localizedDescription]];
+        } else if (statusCode == 304) {
+            result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:[self catalogInfo]];
+        } else if (statusCode != 200) {
+            result = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR
+                                       messageAsString:[NSString stringWithFormat:@"catalog download failed with status %d", (int)statusCode]];
+        } else if (![catalog installData:data error:&error]) {
+            result = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:[error localizedDescription]];
+        } else {
+            result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:[self catalogInfo]];
+        }
+        [self.commandDelegate sendPluginResult:result callbackId:command.callbackId];
+    }];
+}
+
+- (void)catalogSearch:(CDVInvokedUrlCommand*)command
+{
+    NSString* text = [command argumentAtIndex:0 withDefault:@"" andClass:[NSString class]];
+    NSNumber* limit = [command argumentAtIndex:1 withDefault:[NSNumber numberWithInt:NUTRITIONIX_CATALOG_SEARCH_LIMIT] andClass:[NSNumber class]];
+    NSInteger count = MIN(MAX([limit integerValue], 0), NUTRITIONIX_CATALOG_MAX_SEARCH_LIMIT);
+    NSArray* items = [[NutritionixCatalog sharedCatalog] itemsMatchingText:text limit:count];
+
+    [self.commandDelegate sendPluginResult:[CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsArray:items]
+                                callbackId:command.callbackId];
+}
+
+- (void)catalogInfo:(CDVInvokedUrlCommand*)command
+{
+    [self.commandDelegate sendPluginResult:[CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:[self catalogInfo]]
+                                callbackId:command.callbackId];
+}
+
+- (NSArray*)scanditSDKSuggestionsForText:(NSString*)text limit:(NSUInteger)limit
+{
+    NSArray* items = [[NutritionixCatalog sharedCatalog] itemsMatchingText:text limit:limit];
+    NSMutableArray* suggestions = [NSMutableArray arrayWithCapacity:[items count]];
+
+    for (NSDictionary* item in items) {
+        [suggestions addObject:[NSDictionary dictionaryWithObjectsAndKeys:[item objectForKey:@"gtin"], @"barcode",
+            [item objectForKey:@"name"], @"title", [item objectForKey:@"brand"], @"subtitle", nil]];
+    }
+    return suggestions;
+}
+
+#pragma mark -
+#pragma mark Cache
+
+- (void)cacheGet:(CDVInvokedUrlCommand*)command
+{
+    NSDictionary* item = [[NutritionixCache sharedCache] itemForGtin:[command.arguments objectAtIndex:0]];
+    CDVPluginResult* result;
+
+    if (item != nil) {
+        result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK messageAsDictionary:item];
+    } else {
+        result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+    }
+    [self.commandDelegate sendPluginResult:result callbackId:command.callbackId];
+}
+
+- (void)cachePut:(CDVInvokedUrlCommand*)command
+{
+    NSString* gtin = [command.arguments objectAtIndex:0];
+    NSDictionary* item = [command.arguments objectAtIndex:1];
+    id ttl = [command.arguments count] > 2 ? [command.arguments objectAtIndex:2] : nil;
+    NSTimeInterval seconds = [ttl isKindOfClass:[NSNumber class]] ? [ttl doubleValue] : NUTRITIONIX_DEFAULT_TTL;
+    CDVPluginResult* result;
+
+    if ([item isKindOfClass:[NSDictionary class]] && [[NutritionixCache sharedCache] setItem:item forGtin:gtin ttl:seconds]) {
+        result = [CDVPluginResult resultWithStatus:CDVCommandStatus_OK];
+    } else {
+        result = [CDVPluginResult resultWithStatus:CDVCommandStatus_ERROR messageAsString:@"item could not be cached"];
+    }
+    [self.commandDelegate sendPluginResult:result callbackId:command.callbackId];
+}
+
+- (void)cacheClear:(CDVInvokedUrlCommand*)command
+{
+    [[NutritionixCache sharedCache] removeAllItems];
+    [self.commandDelegate sendPluginResult:[CDVPluginResult resultWithStatus:CDVCommandStatus_OK] callbackId:command.callbackId];
+}
+
+@end
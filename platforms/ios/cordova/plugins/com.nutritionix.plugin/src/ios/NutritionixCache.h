@@ -0,0 +1,54 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+/*
+ * Persistent cache of Nutritionix items keyed by 14 digit GTIN.
+ *
+ * Items are appended as JSON to a data file; a memory-mapped index of fixed
+ * size records (open addressing on the GTIN) points into it, so a lookup is a
+ * probe in the mapping plus one read. Entries expire after their TTL, and the
+ * least recently used ones are evicted once the entry or byte budget is hit.
+ * All methods are thread safe.
+ */
+@interface NutritionixCache : NSObject
+
+// Most entries kept, at most three quarters of the index slots.
+@property (nonatomic, assign) NSUInteger maxEntries;
+// Bytes of live items the data file may hold before old entries are evicted.
+@property (nonatomic, assign) NSUInteger maxDataBytes;
+
++ (NutritionixCache*)sharedCache;
+
+// Opens (or creates) the cache files in directory.
+- (id)initWithDirectory:(NSString*)directory;
+
+// Returns the cached item, or nil if there is none or it expired.
+- (NSDictionary*)itemForGtin:(NSString*)gtin;
+// Stores the item for ttl seconds. Returns NO if gtin is not 14 digits or the item can't be written.
+- (BOOL)setItem:(NSDictionary*)item forGtin:(NSString*)gtin ttl:(NSTimeInterval)ttl;
+// GTINs starting with prefix whose entries are expired or expire within interval seconds, at most limit.
+- (NSArray*)gtinsWithPrefix:(NSString*)prefix expiringWithin:(NSTimeInterval)interval limit:(NSUInteger)limit;
+- (void)removeItemForGtin:(NSString*)gtin;
+- (void)removeAllItems;
+// Drops the index pages held in memory; they are read back from disk when needed.
+- (void)releaseMemory;
+
+@end
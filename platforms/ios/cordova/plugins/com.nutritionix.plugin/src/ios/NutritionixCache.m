@@ -0,0 +1,460 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import "NutritionixCache.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define NUTRITIONIX_CACHE_MAGIC 0x4e584331 // 'NXC1'
+#define NUTRITIONIX_CACHE_SLOTS 4096       // a power of two
+#define NUTRITIONIX_GTIN_LENGTH 14
+
+typedef struct {
+    uint32_t magic;
+    uint32_t slotCount;
+    uint32_t entryCount;
+    uint32_t clock;      // bumped on every access, orders the entries for LRU eviction
+    uint64_t liveBytes;  // bytes of the data file referenced by entries
+} NutritionixCacheHeader;
+
+typedef struct {
+    uint64_t key;        // the GTIN as a number, 0 marks an empty slot
+    uint64_t offset;     // position of the item's JSON in the data file
+    uint32_t length;
+    uint32_t expires;    // seconds since 1970
+    uint32_t lastUsed;   // header clock at the last access
+    uint32_t reserved;
+} NutritionixCacheSlot;
+
+// 14 digits as a number, or 0 if gtin is anything else
+static uint64_t NutritionixCacheKey(NSString* gtin)
+{
+    if (![gtin isKindOfClass:[NSString class]] || ([gtin length] != NUTRITIONIX_GTIN_LENGTH)) {
+        return 0;
+    }
+    uint64_t key = 0;
+    for (NSUInteger i = 0; i < NUTRITIONIX_GTIN_LENGTH; i++) {
+        unichar c = [gtin characterAtIndex:i];
+        if ((c < '0') || (c > '9')) {
+            return 0;
+        }
+        key = key * 10 + (c - '0');
+    }
+    // the all zero GTIN is no product, and 0 marks empty slots
+    return key;
+}
+
+static inline uint32_t NutritionixCacheHome(uint64_t key, uint32_t mask)
+{
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+}
+
+@interface NutritionixCache () {
+    NSString* _dataPath;
+    NSString* _indexPath;
+    int _dataFile;
+    int _indexFile;
+    off_t _dataLength;
+    size_t _mappedLength;
+    NutritionixCacheHeader* _header;
+    NutritionixCacheSlot* _slots;
+}
+@end
+
+@implementation NutritionixCache
+
+@synthesize maxEntries, maxDataBytes;
+
++ (NutritionixCache*)sharedCache
+{
+    static NutritionixCache* sharedCache = nil;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        NSString* cachesFolder = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) objectAtIndex:0];
+        sharedCache = [[NutritionixCache alloc] initWithDirectory:[cachesFolder stringByAppendingPathComponent:@"Nutritionix"]];
+    });
+    return sharedCache;
+}
+
+- (id)initWithDirectory:(NSString*)directory
+{
+    self = [super init];
+    if (self) {
+        self.maxEntries = NUTRITIONIX_CACHE_SLOTS / 4 * 3;
+        self.maxDataBytes = 4 * 1024 * 1024;
+        _dataFile = -1;
+        _indexFile = -1;
+
+        [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:nil];
+        _dataPath = [directory stringByAppendingPathComponent:@"items.data"];
+        _indexPath = [directory stringByAppendingPathComponent:@"items.index"];
+        if (![self openFiles]) {
+            NSLog(@"NutritionixCache: could not open the cache in %@, caching is disabled", directory);
+        }
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [self closeFiles];
+}
+
+- (BOOL)openFiles
+{
+    _mappedLength = sizeof(NutritionixCacheHeader) + NUTRITIONIX_CACHE_SLOTS * sizeof(NutritionixCacheSlot);
+
+    _dataFile = open([_dataPath fileSystemRepresentation], O_RDWR | O_CREAT, 0644);
+    _indexFile = open([_indexPath fileSystemRepresentation], O_RDWR | O_CREAT, 0644);
+
+    struct stat dataStat, indexStat;
+    if ((_dataFile < 0) || (_indexFile < 0) || (fstat(_dataFile, &dataStat) != 0) || (fstat(_indexFile, &indexStat) != 0)) {
+        [self closeFiles];
+        return NO;
+    }
+    if ((indexStat.st_size != (off_t)_mappedLength) && (ftruncate(_indexFile, _mappedLength) != 0)) {
+        [self closeFiles];
+        return NO;
+    }
+
+    void* mapping = mmap(NULL, _mappedLength, PROT_READ | PROT_WRITE, MAP_SHARED, _indexFile, 0);
+    if (mapping == MAP_FAILED) {
+        [self closeFiles];
+        return NO;
+    }
+    _header = mapping;
+    _slots = (NutritionixCacheSlot*)((char*)mapping + sizeof(NutritionixCacheHeader));
+    _dataLength = dataStat.st_size;
+
+    if ((_header->magic != NUTRITIONIX_CACHE_MAGIC) || (_header->slotCount != NUTRITIONIX_CACHE_SLOTS)) {
+        // new, or written by another version
+        [self resetFiles];
+    }
+    return YES;
+}
+
+- (void)closeFiles
+{
+    if (_header != NULL) {
+        munmap(_header, _mappedLength);
+        _header = NULL;
+        _slots = NULL;
+    }
+    if (_dataFile >= 0) {
+        close(_dataFile);
+        _dataFile = -1;
+    }
+    if (_indexFile >= 0) {
+        close(_indexFile);
+        _indexFile = -1;
+    }
+}
+
+- (void)resetFiles
+{
+    memset(_header, 0, _mappedLength);
+    _header->magic = NUTRITIONIX_CACHE_MAGIC;
+    _header->slotCount = NUTRITIONIX_CACHE_SLOTS;
+    ftruncate(_dataFile, 0);
+    _dataLength = 0;
+}
+
+#pragma mark -
+#pragma mark Index
+
+- (NSInteger)slotForKey:(uint64_t)key
+{
+    uint32_t mask = NUTRITIONIX_CACHE_SLOTS - 1;
+    uint32_t i = NutritionixCacheHome(key, mask);
+
+    for (uint32_t probes = 0; probes < NUTRITIONIX_CACHE_SLOTS; probes++) {
+        if (_slots[i].key == key) {
+            return i;
+        }
+        if (_slots[i].key == 0) {
+            return -1;
+        }
+        i = (i + 1) & mask;
+    }
+    return -1;
+}
+
+// Empties slot i, and shifts later entries of the probe run back so no lookup stops early.
+- (void)removeSlot:(uint32_t)i
+{
+    uint32_t mask = NUTRITIONIX_CACHE_SLOTS - 1;
+
+    _header->entryCount--;
+    _header->liveBytes -= _slots[i].length;
+    _slots[i].key = 0;
+
+    for (uint32_t j = (i + 1) & mask; _slots[j].key != 0; j = (j + 1) & mask) {
+        uint32_t home = NutritionixCacheHome(_slots[j].key, mask);
+        // entry j may move to i if its home is not within (i, j], cyclically
+        BOOL canMove = (i <= j) ? ((home <= i) || (home > j)) : ((home <= i) && (home > j));
+        if (canMove) {
+            _slots[i] = _slots[j];
+            _slots[j].key = 0;
+            i = j;
+        }
+    }
+}
+
+- (void)insertKey:(uint64_t)key offset:(uint64_t)offset length:(uint32_t)length expires:(uint32_t)expires
+{
+    uint32_t mask = NUTRITIONIX_CACHE_SLOTS - 1;
+    uint32_t i = NutritionixCacheHome(key, mask);
+
+    while (_slots[i].key != 0) {
+        i = (i + 1) & mask;
+    }
+    _slots[i].key = key;
+    _slots[i].offset = offset;
+    _slots[i].length = length;
+    _slots[i].expires = expires;
+    _slots[i].lastUsed = ++_header->clock;
+    _header->entryCount++;
+    _header->liveBytes += length;
+}
+
+// Evicts an expired entry if there is one, else the least recently used.
+- (void)evictOne
+{
+    uint32_t now = (uint32_t)time(NULL);
+    NSInteger victim = -1;
+
+    for (uint32_t i = 0; i < NUTRITIONIX_CACHE_SLOTS; i++) {
+        if (_slots[i].key == 0) {
+            continue;
+        }
+        if (_slots[i].expires <= now) {
+            victim = i;
+            break;
+        }
+        if ((victim < 0) || (_slots[i].lastUsed < _slots[victim].lastUsed)) {
+            victim = i;
+        }
+    }
+    if (victim >= 0) {
+        [self removeSlot:(uint32_t)victim];
+    }
+}
+
+// Rewrites the data file with only the live items, dropping the ones that were replaced or evicted.
+- (BOOL)compactData
+{
+    NSString* tempPath = [_dataPath stringByAppendingPathExtension:@"tmp"];
+    int tempFile = open([tempPath fileSystemRepresentation], O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+    if (tempFile < 0) {
+        return NO;
+    }
+
+    uint64_t* offsets = calloc(NUTRITIONIX_CACHE_SLOTS, sizeof(uint64_t));
+    NSMutableData* buffer = [NSMutableData data];
+    off_t position = 0;
+    BOOL ok = (offsets != NULL);
+
+    for (uint32_t i = 0; ok && i < NUTRITIONIX_CACHE_SLOTS; i++) {
+        if (_slots[i].key == 0) {
+            continue;
+        }
+        [buffer setLength:_slots[i].length];
+        ok = (pread(_dataFile, [buffer mutableBytes], _slots[i].length, _slots[i].offset) == (ssize_t)_slots[i].length) &&
+            (pwrite(tempFile, [buffer bytes], _slots[i].length, position) == (ssize_t)_slots[i].length);
+        offsets[i] = position;
+        position += _slots[i].length;
+    }
+
+    ok = ok && (rename([tempPath fileSystemRepresentation], [_dataPath fileSystemRepresentation]) == 0);
+    if (ok) {
+        // the index only points into the new file once it has replaced the old one
+        for (uint32_t i = 0; i < NUTRITIONIX_CACHE_SLOTS; i++) {
+            if (_slots[i].key != 0) {
+                _slots[i].offset = offsets[i];
+            }
+        }
+        close(_dataFile);
+        _dataFile = tempFile;
+        _dataLength = position;
+    } else {
+        close(tempFile);
+        unlink([tempPath fileSystemRepresentation]);
+    }
+    free(offsets);
+    return ok;
+}
+
+#pragma mark -
+#pragma mark Public interface
+
+- (NSDictionary*)itemForGtin:(NSString*)gtin
+{
+    uint64_t key = NutritionixCacheKey(gtin);
+
+    if (key == 0) {
+        return nil;
+    }
+
+    @synchronized(self) {
+        if (_header == NULL) {
+            return nil;
+        }
+        NSInteger i = [self slotForKey:key];
+        if (i < 0) {
+            return nil;
+        }
+
+        NutritionixCacheSlot* slot = &_slots[i];
+        if ((slot->expires <= (uint32_t)time(NULL)) || (slot->offset + slot->length > (uint64_t)_dataLength)) {
+            [self removeSlot:(uint32_t)i];
+            return nil;
+        }
+
+        NSMutableData* json = [NSMutableData dataWithLength:slot->length];
+        if (pread(_dataFile, [json mutableBytes], slot->length, slot->offset) != (ssize_t)slot->length) {
+            return nil;
+        }
+        NSDictionary* item = [NSJSONSerialization JSONObjectWithData:json options:0 error:nil];
+        if (![item isKindOfClass:[NSDictionary class]]) {
+            [self removeSlot:(uint32_t)i];
+            return nil;
+        }
+        slot->lastUsed = ++_header->clock;
+        return item;
+    }
+}
+
+- (BOOL)setItem:(NSDictionary*)item forGtin:(NSString*)gtin ttl:(NSTimeInterval)ttl
+{
+    uint64_t key = NutritionixCacheKey(gtin);
+
+    if ((key == 0) || ![NSJSONSerialization isValidJSONObject:item]) {
+        return NO;
+    }
+    NSData* json = [NSJSONSerialization dataWithJSONObject:item options:0 error:nil];
+    if ((json == nil) || ([json length] > self.maxDataBytes)) {
+        return NO;
+    }
+    uint32_t length = (uint32_t)[json length];
+    uint32_t expires = (uint32_t)(time(NULL) + MAX(ttl, 0));
+
+    @synchronized(self) {
+        if (_header == NULL) {
+            return NO;
+        }
+        NSInteger existing = [self slotForKey:key];
+        if (existing >= 0) {
+            [self removeSlot:(uint32_t)existing];
+        }
+
+        NSUInteger entryLimit = MIN(self.maxEntries, NUTRITIONIX_CACHE_SLOTS / 4 * 3);
+        while ((_header->entryCount > 0) && ((_header->entryCount >= entryLimit) || (_header->liveBytes + length > self.maxDataBytes))) {
+            [self evictOne];
+        }
+        // replaced and evicted items stay in the data file until it is compacted
+        if ((_dataLength + length > 2 * (off_t)self.maxDataBytes) && ![self compactData]) {
+            return NO;
+        }
+
+        if (pwrite(_dataFile, [json bytes], length, _dataLength) != (ssize_t)length) {
+            return NO;
+        }
+        [self insertKey:key offset:_dataLength length:length expires:expires];
+        _dataLength += length;
+        return YES;
+    }
+}
+
+- (NSArray*)gtinsWithPrefix:(NSString*)prefix expiringWithin:(NSTimeInterval)interval limit:(NSUInteger)limit
+{
+    NSUInteger prefixLength = [prefix length];
+    uint64_t divisor = 1;
+    NSMutableArray* gtins = [NSMutableArray array];
+
+    if ((prefixLength == 0) || (prefixLength > NUTRITIONIX_GTIN_LENGTH) ||
+        ([prefix rangeOfCharacterFromSet:[[NSCharacterSet decimalDigitCharacterSet] invertedSet]].location != NSNotFound)) {
+        return gtins;
+    }
+    for (NSUInteger i = prefixLength; i < NUTRITIONIX_GTIN_LENGTH; i++) {
+        divisor *= 10;
+    }
+    // pad the prefix to a full GTIN so it parses like a key
+    uint64_t prefixKey = NutritionixCacheKey([prefix stringByPaddingToLength:NUTRITIONIX_GTIN_LENGTH withString:@"0" startingAtIndex:0]) / divisor;
+    uint32_t horizon = (uint32_t)(time(NULL) + MAX(interval, 0));
+
+    @synchronized(self) {
+        for (uint32_t i = 0; (_slots != NULL) && (i < NUTRITIONIX_CACHE_SLOTS) && ([gtins count] < limit); i++) {
+            uint64_t key = _slots[i].key;
+            if ((key != 0) && (key / divisor == prefixKey) && (_slots[i].expires <= horizon)) {
+                [gtins addObject:[NSString stringWithFormat:@"%014llu", (unsigned long long)key]];
+            }
+        }
+    }
+    return gtins;
+}
+
+- (void)removeItemForGtin:(NSString*)gtin
+{
+    uint64_t key = NutritionixCacheKey(gtin);
+
+    @synchronized(self) {
+        NSInteger i = (key != 0 && _header != NULL) ? [self slotForKey:key] : -1;
+        if (i >= 0) {
+            [self removeSlot:(uint32_t)i];
+        }
+    }
+}
+
+- (void)removeAllItems
+{
+    @synchronized(self) {
+        if (_header != NULL) {
+            [self resetFiles];
+        }
+    }
+}
+
+- (void)releaseMemory
+{
+    @synchronized(self) {
+        if (_header == NULL) {
+            return;
+        }
+        // a fresh mapping starts without resident pages, they are read back from the file on use
+        msync(_header, _mappedLength, MS_SYNC);
+        munmap(_header, _mappedLength);
+        _header = NULL;
+        _slots = NULL;
+
+        void* mapping = mmap(NULL, _mappedLength, PROT_READ | PROT_WRITE, MAP_SHARED, _indexFile, 0);
+        if (mapping == MAP_FAILED) {
+            NSLog(@"NutritionixCache: could not map the index again, caching is disabled");
+            [self closeFiles];
+            return;
+        }
+        _header = mapping;
+        _slots = (NutritionixCacheSlot*)((char*)mapping + sizeof(NutritionixCacheHeader));
+    }
+}
+
+@end
@@ -0,0 +1,59 @@
+/*
+ Licensed to the Apache Software Foundation (ASF) under one
+ or more contributor license agreements.  See the NOTICE file
+ distributed with this work for additional information
+ regarding copyright ownership.  The ASF licenses this file
+ to you under the Apache License, Version 2.0 (the
+ "License"); you may not use this file except in compliance
+ with the License.  You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing,
+ software distributed under the License is distributed on an
+ "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ KIND, either express or implied.  See the License for the
+ specific language governing permissions and limitations
+ under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+/*
+ * Offline catalog of the most scanned items, searched while the user types.
+ *
+ * The catalog is a single snapshot file that is memory-mapped and read in
+ * place; opening it only checks the header. Records are sorted by GTIN, with
+ * the digits each GTIN shares with the one before it left out, and restart
+ * every 16 records so a record is found by its GTIN or position without
+ * decoding the ones ahead of it. A trigram index over the words of the item
+ * and brand names finds the records matching typed words. The format is
+ * described in cordova/lib/nutritionix-catalog, which builds the files.
+ *
+ * New versions arrive as full snapshots or as patches against the installed
+ * version, which are merged into a new snapshot. All methods are thread safe,
+ * searches keep using the old snapshot while a new one is installed.
+ */
+@interface NutritionixCatalog : NSObject
+
++ (NutritionixCatalog*)sharedCatalog;
+
+// Opens the snapshot at path, if there is one.
+- (id)initWithPath:(NSString*)path;
+
+// Version of the installed snapshot, 0 without one.
+@property (nonatomic, readonly) uint32_t version;
+// Items in the installed snapshot.
+@property (nonatomic, readonly) NSUInteger count;
+
+// {gtin, name, brand} of the item with the 14 digit GTIN, nil if the catalog does not list it.
+- (NSDictionary*)itemForGtin:(NSString*)gtin;
+// Items, as itemForGtin returns them, whose GTIN starts with the typed digits (given as a GTIN-14,
+// EAN-13 or UPC-A) or with a word of the name or brand starting with every typed word, most
+// popular first, at most limit. Words need at least three letters between them to match anything.
+- (NSArray*)itemsMatchingText:(NSString*)text limit:(NSUInteger)limit;
+// Installs a snapshot, or merges a patch into the installed version. Data that is corrupt or a
+// patch for another version fail with an error, the installed snapshot is kept then.
+- (BOOL)installData:(NSData*)data error:(NSError**)error;
+
+@end
@@ -806,7 +806,10 @@ var cordova = require('cordova'),
         IFRAME_NAV: 0,
         XHR_NO_PAYLOAD: 1,
         XHR_WITH_PAYLOAD: 2,
-        XHR_OPTIONAL_PAYLOAD: 3
+        XHR_OPTIONAL_PAYLOAD: 3,
+        // Sends the queued commands in the URL of a gap://exec iframe
+        // navigation, so native doesn't have to call back for them.
+        IFRAME_WITH_PAYLOAD: 4
     },
     bridgeMode,
     execIframe,
@@ -838,6 +841,43 @@ function shouldBundleCommandJson() {
     return false;
 }
 
+// Payloads longer than this go the regular IFRAME_NAV way instead.
+var MAX_IFRAME_PAYLOAD_LENGTH = 65536;
+
+function pokeNativeWithPayload() {
+    execIframe = execIframe || createExecIframe();
+    var payload = encodeURIComponent(commandQueue.join(','));
+    if (payload.length > MAX_IFRAME_PAYLOAD_LENGTH) {
+        execIframe.src = "gap://ready";
+        return;
+    }
+    commandQueue.length = 0;
+    // The navigation is handed to the webview delegate as soon as src is
+    // assigned, so the queue is always empty again by the next exec().
+    execIframe.src = "gap://exec#%5B" + payload + "%5D";
+}
+
+// ArrayBuffers at least this large are uploaded to the native side as raw
+// bytes rather than being base64 encoded into the command JSON.
+var BLOB_THRESHOLD = 32768;
+
+// Posts the buffer to CDVURLProtocol and returns the token it was stored
+// under, or null if the upload failed (the caller falls back to base64).
+function uploadBlob(buffer) {
+    try {
+        var xhr = new XMLHttpRequest();
+        xhr.open('POST', "/!gap_blob?" + (+new Date()), false);
+        if (!vcHeaderValue) {
+            vcHeaderValue = /.*\((.*)\)/.exec(navigator.userAgent)[1];
+        }
+        xhr.setRequestHeader('vc', vcHeaderValue);
+        xhr.send(new Uint8Array(buffer));
+        return xhr.status == 200 && xhr.responseText ? xhr.responseText : null;
+    } catch (e) {
+        return null;
+    }
+}
+
 function massageArgsJsToNative(args) {
     if (!args || utils.typeName(args) != 'Array') {
         return args;
@@ -845,10 +885,18 @@ function massageArgsJsToNative(args) {
     var ret = [];
     args.forEach(function(arg, i) {
         if (utils.typeName(arg) == 'ArrayBuffer') {
-            ret.push({
-                'CDVType': 'ArrayBuffer',
-                'data': base64.fromArrayBuffer(arg)
-            });
+            var token = arg.byteLength >= BLOB_THRESHOLD ? uploadBlob(arg) : null;
+            if (token) {
+                ret.push({
+                    'CDVType': 'Blob',
+                    'token': token
+                });
+            } else {
+                ret.push({
+                    'CDVType': 'ArrayBuffer',
+                    'data': base64.fromArrayBuffer(arg)
+                });
+            }
         } else {
             ret.push(arg);
         }
@@ -869,6 +917,9 @@ function massageMessageNativeToJs(message) {
             return stringToArrayBuffer(atob(b64));
         };
         message = base64ToArrayBuffer(message.data);
+    } else if (message.CDVType == 'Blob') {
+        // The URL can be loaded once, e.g. as an <img> src or with XHR.
+        message = message.url;
     }
     return message;
 }
@@ -947,7 +998,9 @@ function iOSExec() {
     // Also, if there is already a command in the queue, then we've already
     // poked the native side, so there is no reason to do so again.
     if (!isInContextOfEvalJs && commandQueue.length == 1) {
-        if (bridgeMode != jsToNativeModes.IFRAME_NAV) {
+        if (bridgeMode == jsToNativeModes.IFRAME_WITH_PAYLOAD) {
+            pokeNativeWithPayload();
+        } else if (bridgeMode != jsToNativeModes.IFRAME_NAV) {
             // This prevents sending an XHR when there is already one being sent.
             // This should happen only in rare circumstances (refer to unit tests).
             if (execXhr && execXhr.readyState != 4) {
@@ -1239,10 +1292,34 @@ exports.reset();
 // file: lib/ios/platform.js
 define("cordova/platform", function(require, exports, module) {
 
+// Tells CDVWebViewDelegate how far the page has loaded, so it never has to poll for it.
+// The gap://pageload navigation is handed over as soon as src is assigned.
+function pushLoadState(state) {
+    var iframe = document.createElement("iframe");
+    iframe.style.display = 'none';
+    document.body.appendChild(iframe);
+    iframe.src = "gap://pageload#" + state;
+    document.body.removeChild(iframe);
+}
+
 module.exports = {
     id: 'ios',
     bootstrap: function() {
-        require('cordova/channel').onNativeReady.fire();
+        var channel = require('cordova/channel');
+        channel.onNativeReady.fire();
+
+        channel.onDOMContentLoaded.subscribe(function() {
+            pushLoadState('interactive');
+        });
+        if (document.readyState == 'complete') {
+            channel.onDOMContentLoaded.subscribe(function() {
+                pushLoadState('complete');
+            });
+        } else {
+            window.addEventListener('load', function() {
+                pushLoadState('complete');
+            }, false);
+        }
     }
 };
 
@@ -0,0 +1,267 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+// Bridge benchmark, run from bench.html against the native BridgeBenchmark
+// plugin (CordovaLib/Classes/CDVBridgeBenchmark.h). To run it, point
+// <content src> in config.xml at bench.html.
+//
+// Every series runs a fixed number of calls after a fixed warm up, one call at
+// a time, with payloads that have the same content on every run, so reports
+// from different builds on the same device can be compared directly.
+var bench = {
+    // Payload sizes in bytes, from 10 B to 1 MB.
+    sizes: [10, 100, 1024, 10 * 1024, 100 * 1024, 1024 * 1024],
+    types: ['string', 'arraybuffer'],
+    warmup: 5,
+    burstCount: 500,
+    // Input sizes and passes of the native codec timings, which are reported
+    // as they come from the plugin instead of as table rows.
+    codecSizes: [1024, 64 * 1024, 1024 * 1024, 5 * 1024 * 1024, 10 * 1024 * 1024],
+    codecPasses: 20,
+
+    // Calls per series, fewer for the large payloads so a full run stays
+    // under a few minutes.
+    iterations: function(size) {
+        if (size <= 10 * 1024) {
+            return 200;
+        }
+        return size <= 100 * 1024 ? 50 : 10;
+    },
+
+    now: (window.performance && window.performance.now) ?
+        function() { return window.performance.now(); } :
+        function() { return Date.now(); },
+
+    exec: function(win, fail, action, args) {
+        cordova.exec(win, fail, 'BridgeBenchmark', action, args);
+    },
+
+    // 'a' to 'z' repeated, the same content the native side generates.
+    payload: function(type, size) {
+        var i;
+        if (type === 'arraybuffer') {
+            var bytes = new Uint8Array(size);
+            for (i = 0; i < size; i++) {
+                bytes[i] = 97 + (i % 26);
+            }
+            return bytes.buffer;
+        }
+        var alphabet = 'abcdefghijklmnopqrstuvwxyz';
+        var s = '';
+        while (s.length < size) {
+            s += s.length > 0 && s.length * 2 <= size ? s : alphabet;
+        }
+        return s.substring(0, size);
+    },
+
+    // Summarizes samples (in milliseconds) as count, mean and percentiles.
+    summarize: function(samples) {
+        var sorted = samples.slice(0).sort(function(a, b) { return a - b; });
+        var sum = 0;
+        for (var i = 0; i < sorted.length; i++) {
+            sum += sorted[i];
+        }
+        function percentile(p) {
+            var rank = Math.ceil(p / 100 * sorted.length) - 1;
+            return sorted[Math.max(0, Math.min(sorted.length - 1, rank))];
+        }
+        return {
+            count: sorted.length,
+            mean: sum / sorted.length,
+            p50: percentile(50),
+            p90: percentile(90),
+            p99: percentile(99),
+            max: sorted[sorted.length - 1]
+        };
+    },
+
+    // Calls call(done) warmup + n times, one after the other, and passes the
+    // durations of the last n calls to callback.
+    series: function(n, call, callback) {
+        var samples = [];
+        var remaining = bench.warmup + n;
+        function next() {
+            if (remaining === 0) {
+                callback(samples);
+                return;
+            }
+            var start = bench.now();
+            call(function() {
+                if (remaining <= n) {
+                    samples.push(bench.now() - start);
+                }
+                remaining--;
+                // Let the bridge drain before the next call starts.
+                setTimeout(next, 0);
+            });
+        }
+        next();
+    },
+
+    // Round trip of a payload from JS to native and back.
+    echoSeries: function(type, size, callback) {
+        var payload = bench.payload(type, size);
+        bench.series(bench.iterations(size), function(done) {
+            bench.exec(done, bench.fail, 'echo', [payload]);
+        }, callback);
+    },
+
+    // A small call answered with a payload from native.
+    generateSeries: function(type, size, callback) {
+        bench.series(bench.iterations(size), function(done) {
+            bench.exec(done, bench.fail, 'generate', [type, size, 1]);
+        }, callback);
+    },
+
+    // Issues burstCount echo calls without waiting and records when each one
+    // was answered, measured from the start of the burst.
+    echoBurst: function(callback) {
+        var payload = bench.payload('string', 10);
+        var samples = [];
+        var start = bench.now();
+        function answered() {
+            samples.push(bench.now() - start);
+            if (samples.length === bench.burstCount) {
+                callback(samples, samples[samples.length - 1]);
+            }
+        }
+        for (var i = 0; i < bench.burstCount; i++) {
+            bench.exec(answered, bench.fail, 'echo', [payload]);
+        }
+    },
+
+    // Has native send burstCount results as fast as it can.
+    generateBurst: function(callback) {
+        var samples = [];
+        var start = bench.now();
+        bench.exec(function() {
+            samples.push(bench.now() - start);
+            if (samples.length === bench.burstCount) {
+                callback(samples, samples[samples.length - 1]);
+            }
+        }, bench.fail, 'generate', ['string', 10, bench.burstCount]);
+    },
+
+    fail: function(message) {
+        bench.status('failed: ' + message);
+    },
+
+    status: function(text) {
+        document.getElementById('status').textContent = text;
+    },
+
+    addRow: function(result) {
+        var row = document.createElement('tr');
+        var cells = [result.name, result.type || '', result.size !== undefined ? result.size : '',
+                     result.count, result.p50.toFixed(2), result.p90.toFixed(2),
+                     result.p99.toFixed(2), result.max.toFixed(2),
+                     result.perSecond !== undefined ? Math.round(result.perSecond) : ''];
+        for (var i = 0; i < cells.length; i++) {
+            var cell = document.createElement('td');
+            cell.textContent = cells[i];
+            row.appendChild(cell);
+        }
+        document.getElementById('results').appendChild(row);
+    },
+
+    // Runs every series and reports them as one JSON object, which is also
+    // logged so it can be collected from the device console.
+    run: function() {
+        var report = {
+            environment: null,
+            config: {sizes: bench.sizes, warmup: bench.warmup, burstCount: bench.burstCount,
+                     codecSizes: bench.codecSizes, codecPasses: bench.codecPasses},
+            results: [],
+            codecs: []
+        };
+        var steps = [];
+
+        function record(result, samples) {
+            var summary = bench.summarize(samples);
+            for (var key in summary) {
+                result[key] = summary[key];
+            }
+            report.results.push(result);
+            bench.addRow(result);
+        }
+
+        bench.types.forEach(function(type) {
+            bench.sizes.forEach(function(size) {
+                steps.push(function(next) {
+                    bench.status('echo ' + type + ' ' + size + ' B');
+                    bench.echoSeries(type, size, function(samples) {
+                        record({name: 'echo', type: type, size: size}, samples);
+                        next();
+                    });
+                });
+                steps.push(function(next) {
+                    bench.status('generate ' + type + ' ' + size + ' B');
+                    bench.generateSeries(type, size, function(samples) {
+                        record({name: 'generate', type: type, size: size}, samples);
+                        next();
+                    });
+                });
+            });
+        });
+        [['echoBurst', bench.echoBurst], ['generateBurst', bench.generateBurst]].forEach(function(burst) {
+            steps.push(function(next) {
+                bench.status(burst[0]);
+                burst[1](function(samples, total) {
+                    record({name: burst[0], type: 'string', size: 10,
+                            perSecond: samples.length / total * 1000}, samples);
+                    next();
+                });
+            });
+        });
+
+        bench.codecSizes.forEach(function(size) {
+            steps.push(function(next) {
+                bench.status('base64 ' + size + ' B');
+                bench.exec(function(timings) {
+                    timings.name = 'base64';
+                    report.codecs.push(timings);
+                    next();
+                }, bench.fail, 'base64', [size, bench.codecPasses]);
+            });
+        });
+        // the EXIF header writer lives in the camera plugin
+        steps.push(function(next) {
+            bench.status('jpegHeader');
+            cordova.exec(function(timings) {
+                timings.name = 'jpegHeader';
+                report.codecs.push(timings);
+                next();
+            }, bench.fail, 'Camera', 'benchmarkJpegHeader', [1000]);
+        });
+
+        document.getElementById('results').innerHTML = '';
+        bench.exec(function(environment) {
+            report.environment = environment;
+            (function next() {
+                if (steps.length === 0) {
+                    var json = JSON.stringify(report);
+                    document.getElementById('report').textContent = json;
+                    console.log('bridge benchmark: ' + json);
+                    bench.status('done');
+                    return;
+                }
+                setTimeout(function() { steps.shift()(next); }, 0);
+            })();
+        }, bench.fail, 'getEnvironment', []);
+    }
+};
@@ -0,0 +1,225 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+// Scan to display benchmark, run from scanbench.html. Uses the helpers of
+// bench.js.
+//
+// Recorded codes (bench/scan-fixtures.json) are fed through the ScanditSDK
+// plugin with replayScan, which reports them through the same delegate
+// callbacks as the camera. Lookups go to the Nutritionix stub server
+// (cordova/lib/nutritionix-stub-server); start it on the Mac and set its URL
+// below, localhost works from the simulator. Each code is taken through the
+// whole pipeline: result, bridge, lookup, cache and the update of #item_name
+// and #brand_name, once with a cleared cache and then from the cache.
+var scanbench = {
+    stubURL: 'http://localhost:8787/v1_1/item',
+    // Scans of every code from the cache, after the one with a cleared cache.
+    warmPasses: 4,
+    // Milliseconds between the codes of the continuous session.
+    interval: 50,
+
+    nutritionix: function(win, fail, action, args) {
+        cordova.exec(win, fail, 'Nutritionix', action, args);
+    },
+
+    scandit: function(win, fail, action, args) {
+        cordova.exec(win, fail, 'ScanditSDK', action, args);
+    },
+
+    loadFixtures: function(callback) {
+        var request = new XMLHttpRequest();
+        request.open('GET', 'bench/scan-fixtures.json', true);
+        request.onreadystatechange = function() {
+            if (request.readyState === 4) {
+                callback(JSON.parse(request.responseText).codes);
+            }
+        };
+        request.send(null);
+    },
+
+    setup: function(callback) {
+        var url = document.getElementById('stub').value;
+        scanbench.nutritionix(null, bench.fail, 'configure', ['bench', 'bench', 10, url]);
+        scanbench.scandit(null, bench.fail, 'setProfile', ['benchSingle',
+            {animated: false, timings: true, duplicateFilterWindow: 0}]);
+        scanbench.scandit(null, bench.fail, 'setProfile', ['benchContinuous',
+            {continuous: true, animated: false, timings: true, duplicateFilterWindow: 0,
+             batchSize: 4, batchInterval: 100}]);
+        scanbench.loadFixtures(callback);
+    },
+
+    // Updates the page as index.html does and forces the layout, so the
+    // time includes what the user waits for.
+    showItem: function(item) {
+        document.getElementById('item_name').textContent = item.item_name;
+        document.getElementById('brand_name').textContent = item.brand_name;
+        return document.body.offsetHeight;
+    },
+
+    // A single session for one code, from the replayScan call to the updated
+    // page. Durations are added to samples by stage.
+    scanOne: function(code, samples, done) {
+        function add(stage, value) {
+            (samples[stage] = samples[stage] || []).push(value);
+        }
+        var start = bench.now();
+        scanbench.scandit(function(result) {
+            var scanned = bench.now();
+            add('result', scanned - start);
+            if (result.timings && result.timings.firstResult !== undefined) {
+                add('nativeResult', result.timings.firstResult);
+            }
+            if (!result.gtin) {
+                done();
+                return;
+            }
+            scanbench.nutritionix(function(item) {
+                var answered = bench.now();
+                scanbench.showItem(item);
+                var shown = bench.now();
+                add('lookup', answered - scanned);
+                add('display', shown - answered);
+                add('total', shown - start);
+                done();
+            }, function(message) {
+                document.getElementById('error').textContent = message;
+                add('lookupFailed', bench.now() - scanned);
+                done();
+            }, 'lookup', [result.gtin]);
+        }, function(message) {
+            bench.fail(message);
+            done();
+        }, 'replayScan', ['benchSingle', [code], 0]);
+    },
+
+    // Every code once, one session after the other.
+    scanAll: function(codes, samples, callback) {
+        var i = 0;
+        (function next() {
+            if (i === codes.length) {
+                callback();
+                return;
+            }
+            scanbench.scanOne(codes[i++], samples, function() {
+                setTimeout(next, 0);
+            });
+        })();
+    },
+
+    // One continuous session of all codes, their batches looked up with
+    // lookupBatch. Returns the milliseconds from the replayScan call until
+    // the last item was shown.
+    scanContinuous: function(codes, callback) {
+        var sent = 0, answered = 0, stopped = false, last = 0;
+        var start = bench.now();
+        function finish() {
+            if (stopped && answered === sent) {
+                callback(last - start);
+            }
+        }
+        scanbench.scandit(function(batch) {
+            var gtins = [];
+            (batch instanceof Array ? batch : [batch]).forEach(function(result) {
+                if (result.gtin) {
+                    gtins.push(result.gtin);
+                }
+            });
+            if (gtins.length === 0) {
+                return;
+            }
+            sent += gtins.length;
+            scanbench.nutritionix(function(answer) {
+                if (answer.item) {
+                    scanbench.showItem(answer.item);
+                }
+                answered++;
+                last = bench.now();
+                finish();
+            }, bench.fail, 'lookupBatch', [gtins]);
+        }, function(message) {
+            // The replay ends with "Stopped" once every code was reported.
+            stopped = true;
+            last = last || bench.now();
+            finish();
+        }, 'replayScan', ['benchContinuous', codes, scanbench.interval]);
+    },
+
+    addRow: function(name, cache, summary) {
+        var row = document.createElement('tr');
+        [name, cache, summary.count, summary.p50.toFixed(1), summary.p90.toFixed(1),
+         summary.p99.toFixed(1), summary.max.toFixed(1)].forEach(function(value) {
+            var cell = document.createElement('td');
+            cell.textContent = value;
+            row.appendChild(cell);
+        });
+        document.getElementById('results').appendChild(row);
+    },
+
+    run: function() {
+        document.getElementById('results').innerHTML = '';
+        scanbench.setup(function(codes) {
+            var report = {config: {stubURL: document.getElementById('stub').value,
+                                   codes: codes.length, warmPasses: scanbench.warmPasses,
+                                   interval: scanbench.interval},
+                          results: []};
+            var cold = {}, warm = {};
+            var passes = scanbench.warmPasses;
+
+            function summarize(cache, samples) {
+                for (var stage in samples) {
+                    var summary = bench.summarize(samples[stage]);
+                    summary.stage = stage;
+                    summary.cache = cache;
+                    report.results.push(summary);
+                    scanbench.addRow(stage, cache, summary);
+                }
+            }
+            function warmPass() {
+                if (passes-- === 0) {
+                    summarize('cold', cold);
+                    summarize('warm', warm);
+                    continuous();
+                    return;
+                }
+                bench.status('warm pass ' + (scanbench.warmPasses - passes));
+                scanbench.scanAll(codes, warm, warmPass);
+            }
+            function continuous() {
+                bench.status('continuous session');
+                scanbench.nutritionix(function() {
+                    scanbench.scanContinuous(codes, function(total) {
+                        report.continuousTotal = total;
+                        var json = JSON.stringify(report);
+                        document.getElementById('report').textContent =
+                            'continuous session, cold cache: ' + total.toFixed(1) + ' ms\n' + json;
+                        console.log('scan benchmark: ' + json);
+                        bench.status('done');
+                    });
+                }, bench.fail, 'cacheClear', []);
+            }
+
+            bench.exec(function(environment) {
+                report.environment = environment;
+                bench.status('cold pass');
+                scanbench.nutritionix(function() {
+                    scanbench.scanAll(codes, cold, warmPass);
+                }, bench.fail, 'cacheClear', []);
+            }, bench.fail, 'getEnvironment', []);
+        });
+    }
+};
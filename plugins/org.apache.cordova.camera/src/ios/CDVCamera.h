@@ -87,6 +87,18 @@ typedef NSUInteger CDVMediaType;
 - (void)postImage:(UIImage*)anImage withFilename:(NSString*)filename toUrl:(NSURL*)url;
 - (void)cleanup:(CDVInvokedUrlCommand*)command;
 - (void)repositionPopover:(CDVInvokedUrlCommand*)command;
+#ifdef DEBUG
+/*
+ * benchmarkJpegHeader, debug builds only, for www/bench.html
+ *
+ * arguments:
+ *	1: passes, 1000 by default
+ * Times the EXIF APP1 header of typical camera metadata and the rational approximation of a
+ * set of decimals on a background thread. Returns { passes, headerBytes, decimals, headerUs,
+ * rationalsUs, continuedFractionsUs }, times in microseconds per pass.
+ */
+- (void)benchmarkJpegHeader:(CDVInvokedUrlCommand*)command;
+#endif
 
 - (void)imagePickerController:(UIImagePickerController*)picker didFinishPickingMediaWithInfo:(NSDictionary*)info;
 - (void)imagePickerController:(UIImagePickerController*)picker didFinishPickingImage:(UIImage*)image editingInfo:(NSDictionary*)editingInfo;
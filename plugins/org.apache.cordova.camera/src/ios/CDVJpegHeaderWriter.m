@@ -36,12 +36,108 @@ const uint mExif = 0x45786966; // ASCII 'Exif', first characters of valid exif h
 const uint mMotorallaByteAlign = 0x4d4d; // 'MM', motorola byte align, msb first or 'sane'
 const uint mIntelByteAlgin = 0x4949; // 'II', Intel byte align, lsb first or 'batshit crazy reverso world'
 const uint mTiffLength = 0x2a; // after byte align bits, next to bits are 0x002a(MM) or 0x2a00(II), tiff version number
+const uint32_t kCDVDefaultRationalDenominatorLimit = 1000000; // keeps gps seconds to well below a centimetre
 
 
+// append big endian ('MM') integers to a TIFF byte buffer
+static inline void CDVAppendUInt16(NSMutableData* data, uint16_t value)
+{
+    uint8_t bytes[2] = {(uint8_t)(value >> 8), (uint8_t)value};
+    [data appendBytes:bytes length:2];
+}
+
+static inline void CDVAppendUInt32(NSMutableData* data, uint32_t value)
+{
+    uint8_t bytes[4] = {(uint8_t)(value >> 24), (uint8_t)(value >> 16), (uint8_t)(value >> 8), (uint8_t)value};
+    [data appendBytes:bytes length:4];
+}
+
+static inline uint16_t CDVReadUInt16(const uint8_t* bytes)
+{
+    return (uint16_t)((bytes[0] << 8) | bytes[1]);
+}
+
+// IFD entry is 2 bytes tag, 2 bytes type, 4 bytes count, 4 bytes value or offset to value
+static const NSUInteger kIFDEntryWidth = 12;
+
+// byte length of an IFD: entry count, entries, next IFD offset, then values wider than 4 bytes (word aligned)
+static NSUInteger CDVIFDByteLength(NSArray* entries)
+{
+    NSUInteger length = 2 + kIFDEntryWidth * [entries count] + 4;
+
+    for (NSArray* entry in entries) {
+        NSUInteger valueLength = [[entry objectAtIndex:3] length];
+        if (valueLength > 4) {
+            length += valueLength + (valueLength & 1);
+        }
+    }
+    return length;
+}
+
+// upper bound on the number of continued fraction terms, enough to exhaust a double
+#define CDV_RATIONAL_MAX_TERMS 32
+
+/**
+ * approximate a non negative decimal with the closest rational whose denominator is at most maxDenominator
+ *   walks the continued fraction convergents in place, then checks the last semiconvergent.
+ *   the numerator is kept within 32 bits as well, so the result is always a valid exif RATIONAL
+ */
+static void CDVUnsignedRationalFromDouble(double value, uint32_t maxDenominator, uint32_t* numerator, uint32_t* denominator)
+{
+    if (!(value > 0) || isinf(value) || (value >= UINT32_MAX)) {
+        *numerator = (value >= UINT32_MAX) ? UINT32_MAX : 0;
+        *denominator = 1;
+        return;
+    }
+
+    // keep the numerator representable as well as the denominator
+    uint64_t bound = maxDenominator ? maxDenominator : 1;
+    if ((value > 1) && ((uint64_t)(UINT32_MAX / value) < bound)) {
+        bound = MAX((uint64_t)(UINT32_MAX / value), 1);
+    }
+
+    // (p0/q0) is the previous convergent and (p1/q1) the current one
+    uint64_t p0 = 0, q0 = 1, p1 = 1, q1 = 0;
+    double x = value;
+    for (int i = 0; i < CDV_RATIONAL_MAX_TERMS; i++) {
+        double a = floor(x);
+        uint64_t q2 = q0 + (uint64_t)a * q1;
+        if (q2 > bound) {
+            break;
+        }
+        uint64_t p2 = p0 + (uint64_t)a * p1;
+        p0 = p1; q0 = q1;
+        p1 = p2; q1 = q2;
+        double remainder = x - a;
+        if (remainder < 1e-12) {
+            break; // exact fraction found, avoids recip/0
+        }
+        x = 1 / remainder;
+    }
+
+    if (q1 == 0) {
+        *numerator = 0;
+        *denominator = 1;
+        return;
+    }
+
+    // the best bounded approximation may be the semiconvergent between the last two convergents
+    uint64_t k = (bound - q0) / q1;
+    uint64_t sp = p0 + k * p1;
+    uint64_t sq = q0 + k * q1;
+    if ((sq > 0) && (fabs((double)sp / sq - value) < fabs((double)p1 / q1 - value))) {
+        p1 = sp;
+        q1 = sq;
+    }
+    *numerator = (uint32_t)p1;
+    *denominator = (uint32_t)q1;
+}
+
 @implementation CDVJpegHeaderWriter
 
 - (id) init {    
     self = [super init];
+    self.rationalDenominatorLimit = kCDVDefaultRationalDenominatorLimit;
     // supported tags for exif IFD
     IFD0TagFormatDict = [[NSDictionary alloc] initWithObjectsAndKeys:
                   //      TAGINF(@"010e", [NSNumber numberWithInt:EDT_ASCII_STRING], @0), @"ImageDescription",
@@ -102,281 +198,234 @@ const uint mTiffLength = 0x2a; // after byte align bits, next to bits are 0x002a
 }
 
 - (NSData*) spliceExifBlockIntoJpeg: (NSData*) jpegdata withExifBlock: (NSString*) exifstr {
-    
-    CDVJpegHeaderWriter * exifWriter = [[CDVJpegHeaderWriter alloc] init];
-    
-    NSMutableData * exifdata = [NSMutableData dataWithCapacity: [exifstr length]/2];
-    int idx;
-    for (idx = 0; idx+1 < [exifstr length]; idx+=2) {
-        NSRange range = NSMakeRange(idx, 2);
-        NSString* hexStr = [exifstr substringWithRange:range];
-        NSScanner* scanner = [NSScanner scannerWithString:hexStr];
-        unsigned int intValue;
-        [scanner scanHexInt:&intValue];
-        [exifdata appendBytes:&intValue length:1];
-    }
-    
-    NSMutableData * ddata = [NSMutableData dataWithCapacity: [jpegdata length]];
-    NSMakeRange(0,4);
-    int loc = 0;
-    bool done = false;
-    // read the jpeg data until we encounter the app1==0xFFE1 marker
-    while (loc+1 < [jpegdata length]) {
-        NSData * blag = [jpegdata subdataWithRange: NSMakeRange(loc,2)];
-        if( [[blag description] isEqualToString : @"<ffe1>"]) {
-            // read the APP1 block size bits
-            NSString * the = [exifWriter hexStringFromData:[jpegdata subdataWithRange: NSMakeRange(loc+2,2)]];
-            NSNumber * app1width = [exifWriter numericFromHexString:the];
-            //consume the original app1 block
-            [ddata appendData:exifdata];
-            // advance our loc marker past app1
-            loc += [app1width intValue] + 2;
-            done = true;
-        } else {
-            if(!done) {
-                [ddata appendData:blag];
-                loc += 2;
-            } else {
-                break;
-            }
-        }
+    // legacy entry point, the hex string is decoded once and spliced into a single mutable copy of the jpeg
+    NSUInteger hexlen = [exifstr length];
+    const char* hex = [exifstr UTF8String];
+    NSMutableData * exifdata = [NSMutableData dataWithLength: hexlen/2];
+    uint8_t* out = [exifdata mutableBytes];
+    for (NSUInteger idx = 0; idx+1 < hexlen; idx+=2) {
+        char pair[3] = {hex[idx], hex[idx+1], 0};
+        out[idx/2] = (uint8_t)strtoul(pair, NULL, 16);
     }
-    // copy the remaining data
-    [ddata appendData:[jpegdata subdataWithRange: NSMakeRange(loc,[jpegdata length]-loc)]];
+
+    NSMutableData * ddata = [jpegdata mutableCopy];
+    [self insertExifAPP1: exifdata intoJpeg: ddata];
     return ddata;
 }
 
+/**
+ * Writes an APP1 block into the jpeg held in jpegdata, in place
+ *   an existing Exif APP1 block is replaced, otherwise the block is inserted after SOI and any APP0 (JFIF) segments,
+ *   so only the bytes following the insertion point are moved and the image data is never duplicated
+ *
+ *   returns NO if jpegdata does not start with a jpeg SOI marker
+ */
+- (BOOL) insertExifAPP1: (NSData*) app1 intoJpeg: (NSMutableData*) jpegdata {
+    const uint8_t* bytes = [jpegdata bytes];
+    NSUInteger length = [jpegdata length];
+
+    if (length < 4 || CDVReadUInt16(bytes) != mJpegId || [app1 length] < 4) {
+        return NO;
+    }
+
+    NSUInteger loc = 2;
+    NSRange target = NSMakeRange(2, 0);
+    // walk the APPn segments at the head of the file, they all precede the frame and scan data
+    while (loc + 4 <= length) {
+        uint16_t marker = CDVReadUInt16(bytes + loc);
+        if (marker < 0xffe0 || marker > 0xffef) {
+            break;
+        }
+        NSUInteger segmentLength = 2 + CDVReadUInt16(bytes + loc + 2);
+        if (loc + segmentLength > length) {
+            break;
+        }
+        if (marker == mExifMarker && segmentLength >= 10 && memcmp(bytes + loc + 4, "Exif\0\0", 6) == 0) {
+            target = NSMakeRange(loc, segmentLength);
+            break;
+        }
+        loc += segmentLength;
+        if (marker == 0xffe0) {
+            // JFIF requires APP0 to come first, so a new APP1 goes after it
+            target = NSMakeRange(loc, 0);
+        }
+    }
 
+    [jpegdata replaceBytesInRange: target withBytes: [app1 bytes] length: [app1 length]];
+    return YES;
+}
 
 /**
  * Create the Exif data block as a hex string
+ *   kept for existing callers, see createExifAPP1Data: which writes the bytes directly
+ */
+- (NSString*) createExifAPP1 : (NSDictionary*) datadict {
+    NSData * app1 = [self createExifAPP1Data: datadict];
+    if (!app1) {
+        return nil;
+    }
+
+    static const char digits[] = "0123456789abcdef";
+    const uint8_t* bytes = [app1 bytes];
+    NSUInteger length = [app1 length];
+    NSMutableData * hex = [NSMutableData dataWithLength: length * 2];
+    char* out = [hex mutableBytes];
+    for (NSUInteger i = 0; i < length; i++) {
+        out[2*i] = digits[bytes[i] >> 4];
+        out[2*i+1] = digits[bytes[i] & 0x0f];
+    }
+    return [[NSString alloc] initWithData: hex encoding: NSASCIIStringEncoding];
+}
+
+/**
+ * Create the Exif APP1 data block
  *   jpeg uses Application Markers (APP's) as markers for application data
  *   APP1 is the application marker reserved for exif data
  *
  *   (NSDictionary*) datadict - with subdictionaries marked '{TIFF}' and '{EXIF}' as returned by imagePickerController with a valid
  *                              didFinishPickingMediaWithInfo data dict, under key @"UIImagePickerControllerMediaMetadata"
  *
- *   the following constructs a hex string to Exif specifications, and is therefore brittle
- *   altering the order of arguments to the string constructors, modifying field sizes or formats,
- *   and any other minor change will likely prevent the exif data from being read
+ *   the block is marker, size, 'Exif\0\0', then a big endian tiff header followed by IFD0 and the exif sub IFD.
+ *   all offsets inside the tiff structure are relative to the start of the tiff header.
+ *   returns nil if the block would not fit in a single jpeg segment
  */
-- (NSString*) createExifAPP1 : (NSDictionary*) datadict {
-    NSMutableString * app1; // holds finalized product
-    NSString * exifIFD; // exif information file directory
-    NSString * subExifIFD; // subexif information file directory
-    
-    // FFE1 is the hex APP1 marker code, and will allow client apps to read the data
-    NSString * app1marker = @"ffe1";
-    // SSSS size, to be determined
-    // EXIF ascii characters followed by 2bytes of zeros
-    NSString * exifmarker = @"457869660000";
-    // Tiff header: 4d4d is motorolla byte align (big endian), 002a is hex for 42
-    NSString * tiffheader = @"4d4d002a";
-    //first IFD offset from the Tiff header to IFD0. Since we are writing it, we know it's address 0x08
-    NSString * ifd0offset = @"00000008";
-    // current offset to next data area
-    int currentDataOffset = 0;
-    
+- (NSData*) createExifAPP1Data : (NSDictionary*) datadict {
     //data labeled as TIFF in UIImagePickerControllerMediaMetaData is part of the EXIF IFD0 portion of APP1
-    exifIFD = [self createExifIFDFromDict: [datadict objectForKey:@"{TIFF}"] withFormatDict: IFD0TagFormatDict isIFD0:YES currentDataOffset:&currentDataOffset];
-
+    NSMutableArray * ifd0 = [self IFDEntriesFromDict: [datadict objectForKey:@"{TIFF}"] withFormatDict: IFD0TagFormatDict];
     //data labeled as EXIF in UIImagePickerControllerMediaMetaData is part of the EXIF Sub IFD portion of APP1
-    subExifIFD = [self createExifIFDFromDict: [datadict objectForKey:@"{Exif}"] withFormatDict: SubIFDTagFormatDict isIFD0:NO currentDataOffset:&currentDataOffset];
-    /*
-    NSLog(@"SUB EXIF IFD %@  WITH SIZE: %d",exifIFD,[exifIFD length]);
-    
-    NSLog(@"SUB EXIF IFD %@  WITH SIZE: %d",subExifIFD,[subExifIFD length]);
-    */
-    // construct the complete app1 data block
-    app1 = [[NSMutableString alloc] initWithFormat: @"%@%04x%@%@%@%@%@",
-            app1marker,
-            16 + ([exifIFD length]/2) + ([subExifIFD length]/2) /*16+[exifIFD length]/2*/,
-            exifmarker,
-            tiffheader,
-            ifd0offset,
-            exifIFD,
-            subExifIFD];
-     
+    NSMutableArray * subifd = [self IFDEntriesFromDict: [datadict objectForKey:@"{Exif}"] withFormatDict: SubIFDTagFormatDict];
+
+    // the sub IFD directly follows IFD0, whose size includes its own ExifOffset (0x8769) entry
+    const uint32_t ifd0offset = 8;
+    NSMutableData * placeholder = [NSMutableData dataWithLength:4];
+    [ifd0 addObject: [NSArray arrayWithObjects: @0x8769, [NSNumber numberWithInt:EDT_ULONG], @1, placeholder, nil]];
+    uint32_t subifdoffset = ifd0offset + (uint32_t)CDVIFDByteLength(ifd0);
+    [ifd0 removeLastObject];
+    NSMutableData * exifOffset = [NSMutableData dataWithCapacity:4];
+    CDVAppendUInt32(exifOffset, subifdoffset);
+    [ifd0 addObject: [NSArray arrayWithObjects: @0x8769, [NSNumber numberWithInt:EDT_ULONG], @1, exifOffset, nil]];
+
+    NSUInteger tiffLength = subifdoffset + CDVIFDByteLength(subifd);
+    // segment size counts itself (2 bytes) and 'Exif\0\0' (6 bytes) but not the marker
+    NSUInteger segmentLength = 2 + 6 + tiffLength;
+    if (segmentLength > 0xffff) {
+        return nil;
+    }
+
+    NSMutableData * app1 = [NSMutableData dataWithCapacity: 2 + segmentLength];
+    // FFE1 is the APP1 marker code, and will allow client apps to read the data
+    CDVAppendUInt16(app1, mExifMarker);
+    CDVAppendUInt16(app1, (uint16_t)segmentLength);
+    // EXIF ascii characters followed by 2bytes of zeros
+    [app1 appendBytes: "Exif\0\0" length: 6];
+
+    NSUInteger tiffStart = [app1 length];
+    // Tiff header: 4d4d is motorolla byte align (big endian), 002a is 42, then the offset to IFD0
+    CDVAppendUInt16(app1, mMotorallaByteAlign);
+    CDVAppendUInt16(app1, mTiffLength);
+    CDVAppendUInt32(app1, ifd0offset);
+
+    [self appendIFDEntries: ifd0 toData: app1 tiffStart: tiffStart];
+    [self appendIFDEntries: subifd toData: app1 tiffStart: tiffStart];
     return app1;
 }
 
-// returns hex string representing a valid exif information file directory constructed from the datadict and formatdict
-- (NSString*) createExifIFDFromDict : (NSDictionary*) datadict
-                     withFormatDict : (NSDictionary*) formatdict
-                             isIFD0 : (BOOL) ifd0flag
-                  currentDataOffset : (int*) dataoffset {
-    NSArray * datakeys = [datadict allKeys]; // all known data keys
-    NSArray * knownkeys = [formatdict  allKeys]; // only keys in knowkeys are considered for entry in this IFD
-    NSMutableArray * ifdblock = [[NSMutableArray alloc] initWithCapacity: [datadict count]]; // all ifd entries
-    NSMutableArray * ifddatablock = [[NSMutableArray alloc] initWithCapacity: [datadict count]]; // data block entries
- //   ifd0flag = NO; // ifd0 requires a special flag and has offset to next ifd appended to end
-    
-    // iterate through known provided data keys
-    for (int i = 0; i < [datakeys count]; i++) {
-        NSString * key = [datakeys objectAtIndex:i];
+// collects IFD entries [tag, type, count, value bytes] for the keys of datadict present in formatdict, sorted by tag as tiff requires
+- (NSMutableArray*) IFDEntriesFromDict : (NSDictionary*) datadict
+                        withFormatDict : (NSDictionary*) formatdict {
+    NSMutableArray * entries = [[NSMutableArray alloc] initWithCapacity: [datadict count] + 1];
+
+    for (NSString * key in datadict) {
+        NSArray * format = [formatdict objectForKey:key];
         // don't muck about with unknown keys
-        if ([knownkeys indexOfObject: key] != NSNotFound) {
-            // create new IFD entry
-            NSString * entry = [self  createIFDElement: key
-                                            withFormat: [formatdict objectForKey:key]
-                                      withElementData: [datadict objectForKey:key]];
-            // create the IFD entry's data block
-            NSString * data = [self createIFDElementDataWithFormat: [formatdict objectForKey:key]
-                                                   withData: [datadict objectForKey:key]];
-            if (entry) {
-                [ifdblock addObject:entry];
-                if(!data) {
-                    [ifdblock addObject:@""];
-                } else {
-                    [ifddatablock addObject:data];
-                }
-            }
+        if (!format) {
+            continue;
         }
-    }
-    
-    NSMutableString * exifstr = [[NSMutableString alloc] initWithCapacity: [ifdblock count] * 24];
-    NSMutableString * dbstr = [[NSMutableString alloc] initWithCapacity: 100];
-    
-    int addr=*dataoffset; // current offset/address in datablock
-    if (ifd0flag) {
-        // calculate offset to datablock based on ifd file entry count
-        addr += 14+(12*([ifddatablock count]+1)); // +1 for tag 0x8769, exifsubifd offset
-    } else {
-        // current offset + numSubIFDs (2-bytes) + 12*numSubIFDs + endMarker (4-bytes)
-        addr += 2+(12*[ifddatablock count])+4;
-    }
-    
-    for (int i = 0; i < [ifdblock count]; i++) {
-        NSString * entry = [ifdblock objectAtIndex:i];
-        NSString * data = [ifddatablock objectAtIndex:i];
-        
-        // check if the data fits into 4 bytes
-        if( [data length] <= 8) {
-            // concatenate the entry and the (4byte) data entry into the final IFD entry and append to exif ifd string
-            [exifstr appendFormat : @"%@%@", entry, data];
-        } else {
-            [exifstr appendFormat : @"%@%08x", entry, addr];
-            [dbstr appendFormat: @"%@", data];
-            addr+= [data length] / 2;
-            /*
-            NSLog(@"=====data-length[%i]=======",[data length]);
-            NSLog(@"addr-offset[%i]",addr);
-            NSLog(@"entry[%@]",entry);
-            NSLog(@"data[%@]",data);
-             */
+        uint32_t count = 0;
+        NSData * value = [self IFDValueWithFormat: format withData: [datadict objectForKey:key] componentCount: &count];
+        if (value) {
+            NSNumber * tag = [NSNumber numberWithUnsignedLong: strtoul([[format objectAtIndex:0] UTF8String], NULL, 16)];
+            [entries addObject: [NSArray arrayWithObjects: tag, [format objectAtIndex:1], [NSNumber numberWithUnsignedInt:count], value, nil]];
         }
     }
-    
-    // calculate IFD0 terminal offset tags, currently ExifSubIFD
-    int entrycount = [ifdblock count];
-    if (ifd0flag) {
-        // 18 accounts for 8769's width + offset to next ifd, 8 accounts for start of header
-        NSNumber * offset = [NSNumber numberWithInt:[exifstr length] / 2 + [dbstr length] / 2 + 18+8];
-        
-        [self appendExifOffsetTagTo: exifstr
-                        withOffset : offset];
-        entrycount++;
-    }
-    *dataoffset = addr;
-    return [[NSString alloc] initWithFormat: @"%04x%@%@%@",
-            entrycount,
-            exifstr,
-            @"00000000", // offset to next IFD, 0 since there is none
-            dbstr]; // lastly, the datablock
+
+    [entries sortUsingComparator:^NSComparisonResult (NSArray * a, NSArray * b) {
+        return [[a objectAtIndex:0] compare: [b objectAtIndex:0]];
+    }];
+    return entries;
 }
 
-// Creates an exif formatted exif information file directory entry
-- (NSString*) createIFDElement: (NSString*) elementName withFormat: (NSArray*) formtemplate withElementData: (NSString*) data  {
-    //NSArray * fielddata = [formatdict objectForKey: elementName];// format data of desired field
-    if (formtemplate) {
-        // format string @"%@%@%@%@", tag number, data format, components, value
-        NSNumber * dataformat = [formtemplate objectAtIndex:1];
-        NSNumber * components = [formtemplate objectAtIndex:2];
-        if([components intValue] == 0) {
-            components = [NSNumber numberWithInt: [data length] * DataTypeToWidth[[dataformat intValue]-1]];            
+// writes one IFD at the end of data: entries, a zero next IFD offset, then the values too wide to fit in an entry
+- (void) appendIFDEntries: (NSArray*) entries toData: (NSMutableData*) data tiffStart: (NSUInteger) tiffStart {
+    uint32_t valueOffset = (uint32_t)([data length] - tiffStart + 2 + kIFDEntryWidth * [entries count] + 4);
+
+    CDVAppendUInt16(data, (uint16_t)[entries count]);
+    for (NSArray * entry in entries) {
+        NSData * value = [entry objectAtIndex:3];
+        CDVAppendUInt16(data, [[entry objectAtIndex:0] unsignedShortValue]);
+        CDVAppendUInt16(data, [[entry objectAtIndex:1] unsignedShortValue]);
+        CDVAppendUInt32(data, [[entry objectAtIndex:2] unsignedIntValue]);
+        if ([value length] <= 4) {
+            // values of 4 bytes or less are stored left justified in the entry itself
+            uint8_t inlined[4] = {0, 0, 0, 0};
+            memcpy(inlined, [value bytes], [value length]);
+            [data appendBytes: inlined length: 4];
+        } else {
+            CDVAppendUInt32(data, valueOffset);
+            valueOffset += [value length] + ([value length] & 1);
+        }
+    }
+    // offset to next IFD, 0 since there is none
+    CDVAppendUInt32(data, 0);
+
+    for (NSArray * entry in entries) {
+        NSData * value = [entry objectAtIndex:3];
+        if ([value length] > 4) {
+            [data appendData: value];
+            if ([value length] & 1) {
+                [data increaseLengthBy:1];
+            }
         }
-
-        return [[NSString alloc] initWithFormat: @"%@%@%08x",
-                                                [formtemplate objectAtIndex:0], // the field code
-                                                [self formatNumberWithLeadingZeroes: dataformat withPlaces: @4], // the data type code
-                                                [components intValue]]; // number of components
     }
-    return NULL;
-}
-
-/**
- * appends exif IFD0 tag 8769 "ExifOffset" to the string provided
- * (NSMutableString*) str - string you wish to append the 8769 tag to: APP1 or IFD0 hex data string 
- *  //  TAGINF(@"8769", [NSNumber numberWithInt:EDT_ULONG], @1), @"ExifOffset",
- */
-- (void) appendExifOffsetTagTo: (NSMutableString*) str withOffset : (NSNumber*) offset {
-    NSArray * format = TAGINF(@"8769", [NSNumber numberWithInt:EDT_ULONG], @1);
-    
-    NSString * entry = [self  createIFDElement: @"ExifOffset"
-                                withFormat: format
-                               withElementData: [offset stringValue]];
-    
-    NSString * data = [self createIFDElementDataWithFormat: format
-                                                  withData: [offset stringValue]];
-    [str appendFormat:@"%@%@", entry, data];
 }
 
-// formats the Information File Directory Data to exif format
-- (NSString*) createIFDElementDataWithFormat: (NSArray*) dataformat withData: (NSString*) data {
-    NSMutableString * datastr = nil;
-    NSNumber * tmp = nil;
-    NSNumber * formatcode = [dataformat objectAtIndex:1];
-    NSUInteger formatItemsCount = [dataformat count];
-    NSNumber * num = @0;
-    NSNumber * denom = @0;
-    
-    switch ([formatcode intValue]) {
-        case EDT_UBYTE:
-            break;
-        case EDT_ASCII_STRING:
-            datastr = [[NSMutableString alloc] init];
-            for (int i = 0; i < [data length]; i++) {
-                [datastr appendFormat:@"%02x",[data characterAtIndex:i]];
-            }
-            if (formatItemsCount > 3) {
-                // We have additional data to append.
-                // currently used by Date format to append final 0x00 but can be used by other data types as well in the future
-                [datastr appendString:[dataformat objectAtIndex:3]];
-            }
-            if ([datastr length] < 8) {
-                NSString * format = [NSString stringWithFormat:@"%%0%dd", 8 - [datastr length]];
-                [datastr appendFormat:format,0];
-            }
-            return datastr;
+// formats the Information File Directory value bytes to exif format, count receives the number of components
+- (NSData*) IFDValueWithFormat: (NSArray*) dataformat withData: (id) data componentCount: (uint32_t*) count {
+    NSMutableData * value = nil;
+    uint32_t num = 0;
+    uint32_t denom = 1;
+
+    switch ([[dataformat objectAtIndex:1] intValue]) {
+        case EDT_ASCII_STRING: {
+            NSString * str = [data isKindOfClass:[NSString class]] ? data : [data description];
+            value = [[str dataUsingEncoding: NSASCIIStringEncoding allowLossyConversion: YES] mutableCopy];
+            // ascii values are null terminated, and the count includes the terminator
+            [value increaseLengthBy:1];
+            *count = (uint32_t)[value length];
+            return value;
+        }
         case EDT_USHORT:
-            return [[NSString alloc] initWithFormat : @"%@%@",
-                    [self formattedHexStringFromDecimalNumber: [NSNumber numberWithInt: [data intValue]] withPlaces: @4],
-                    @"0000"];
+            value = [NSMutableData dataWithCapacity:2];
+            CDVAppendUInt16(value, (uint16_t)[data intValue]);
+            *count = 1;
+            return value;
         case EDT_ULONG:
-            tmp = [NSNumber numberWithUnsignedLong:[data intValue]];
-            return [NSString stringWithFormat : @"%@",
-                    [self formattedHexStringFromDecimalNumber: tmp withPlaces: @8]];
+            value = [NSMutableData dataWithCapacity:4];
+            CDVAppendUInt32(value, (uint32_t)[data intValue]);
+            *count = 1;
+            return value;
         case EDT_URATIONAL:
-            return [self decimalToUnsignedRational: [NSNumber numberWithDouble:[data doubleValue]]
-                               withResultNumerator: &num
-                             withResultDenominator: &denom];
-        case EDT_SBYTE:
-            
-            break;
-        case EDT_UNDEFINED:
-            break;     // 8 bits
-        case EDT_SSHORT:
-            break;
-        case EDT_SLONG:
-            break;          // 32bit signed integer (2's complement)
-        case EDT_SRATIONAL:
-            break;     // 2 SLONGS, first long is numerator, second is denominator
-        case EDT_SINGLEFLOAT:
-            break;
-        case EDT_DOUBLEFLOAT:
+            CDVUnsignedRationalFromDouble(fabs([data doubleValue]), self.rationalDenominatorLimit, &num, &denom);
+            value = [NSMutableData dataWithCapacity:8];
+            CDVAppendUInt32(value, num);
+            CDVAppendUInt32(value, denom);
+            *count = 1;
+            return value;
+        default:
+            // remaining exif types are not used by any supported tag
             break;
     }
-    return datastr;
+    return nil;
 }
 
 //======================================================================================================================
@@ -399,44 +448,34 @@ const uint mTiffLength = 0x2a; // after byte align bits, next to bits are 0x002a
     return [formatter stringFromNumber:numb];
 }
 
-// approximate a decimal with a rational by method of continued fraction
-// can be collasped into decimalToUnsignedRational after testing
+// approximate a decimal with a rational bounded by rationalDenominatorLimit
 - (void) decimalToRational: (NSNumber *) numb
        withResultNumerator: (NSNumber**) numerator
      withResultDenominator: (NSNumber**) denominator {
-    NSMutableArray * fractionlist = [[NSMutableArray alloc] initWithCapacity:8];
-    
-    [self continuedFraction: [numb doubleValue]
-           withFractionList: fractionlist
-                withHorizon: 8];
-    
-    // simplify complex fraction represented by partial fraction list
-    [self expandContinuedFraction: fractionlist
-              withResultNumerator: numerator
-            withResultDenominator: denominator];
+    double val = [numb doubleValue];
+    uint32_t num = 0;
+    uint32_t den = 1;
 
+    CDVUnsignedRationalFromDouble(fabs(val), self.rationalDenominatorLimit, &num, &den);
+    *numerator = [NSNumber numberWithLongLong: val < 0 ? -(long long)num : (long long)num];
+    *denominator = [NSNumber numberWithUnsignedInt: den];
 }
 
-// approximate a decimal with an unsigned rational by method of continued fraction
+// approximate a decimal with an unsigned rational, returned as an exif formatted hex string
 - (NSString*) decimalToUnsignedRational: (NSNumber *) numb
                           withResultNumerator: (NSNumber**) numerator
                         withResultDenominator: (NSNumber**) denominator {
-    NSMutableArray * fractionlist = [[NSMutableArray alloc] initWithCapacity:8];
-    
-    // generate partial fraction list
-    [self continuedFraction: [numb doubleValue]
-           withFractionList: fractionlist
-                withHorizon: 8];
-    
-    // simplify complex fraction represented by partial fraction list
-    [self expandContinuedFraction: fractionlist
-              withResultNumerator: numerator
-            withResultDenominator: denominator];
-    
-    return [self formatFractionList: fractionlist];
+    uint32_t num = 0;
+    uint32_t den = 1;
+
+    CDVUnsignedRationalFromDouble([numb doubleValue], self.rationalDenominatorLimit, &num, &den);
+    *numerator = [NSNumber numberWithUnsignedInt: num];
+    *denominator = [NSNumber numberWithUnsignedInt: den];
+    return [self formatRationalWithNumerator: *numerator withDenominator: *denominator asSigned: false];
 }
 
 // recursive implementation of decimal approximation by continued fraction
+// no longer used by the writer, see CDVUnsignedRationalFromDouble
 - (void) continuedFraction: (double) val
           withFractionList: (NSMutableArray*) fractionlist
                withHorizon: (int) horizon {
@@ -460,51 +499,6 @@ const uint mTiffLength = 0x2a; // after byte align bits, next to bits are 0x002a
     
 }
 
-// expand continued fraction list, creating a single level rational approximation
--(void) expandContinuedFraction: (NSArray*) fractionlist
-                  withResultNumerator: (NSNumber**) numerator
-                withResultDenominator: (NSNumber**) denominator {
-    int i = 0;
-    int den = 0;
-    int num = 0;
-    if ([fractionlist count] == 1) {
-        *numerator = [NSNumber numberWithInt:[[fractionlist objectAtIndex:0] intValue]];
-        *denominator = @1;
-        return;
-    }
-    
-    //begin at the end of the list
-    i = [fractionlist count] - 1;
-    num = 1;
-    den = [[fractionlist objectAtIndex:i] intValue];
-    
-    while (i > 0) {
-        int t = [[fractionlist objectAtIndex: i-1] intValue];
-        num = t * den + num;
-        if (i==1) {
-            break;
-        } else {
-            t = num;
-            num = den;
-            den = t;
-        }
-        i--;
-    }
-    // set result parameters values
-    *numerator = [NSNumber numberWithInt: num];
-    *denominator = [NSNumber numberWithInt: den];
-}
-
-// formats expanded fraction list to string matching exif specification
-- (NSString*) formatFractionList: (NSArray *) fractionlist {
-    NSMutableString * str = [[NSMutableString alloc] initWithCapacity:16];
-    
-    if ([fractionlist count] == 1){
-        [str appendFormat: @"%08x00000001", [[fractionlist objectAtIndex:0] intValue]];
-    }
-    return str;
-}
-
 // format rational as
 - (NSString*) formatRationalWithNumerator: (NSNumber*) numerator withDenominator: (NSNumber*) denominator asSigned: (Boolean) signedFlag {
     NSMutableString * str = [[NSMutableString alloc] initWithCapacity:16];
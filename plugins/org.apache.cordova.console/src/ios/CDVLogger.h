@@ -22,5 +22,6 @@
 @interface CDVLogger : CDVPlugin
 
 - (void)logLevel:(CDVInvokedUrlCommand*)command;
+- (void)logBatch:(CDVInvokedUrlCommand*)command;
 
 @end
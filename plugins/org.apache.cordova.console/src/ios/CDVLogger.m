@@ -19,20 +19,174 @@
 
 #import "CDVLogger.h"
 #import <Cordova/CDV.h>
+#include <libkern/OSAtomic.h>
+
+// slots in the ring buffer, a power of two
+#define CDV_LOG_RING_CAPACITY 1024
+// the log file is rotated to console.1.log when it grows past this size
+#define CDV_LOG_FILE_MAX_BYTES (512 * 1024)
+
+@interface CDVLogger () {
+    // Single producer, single consumer ring of retained CFStringRef lines. Only the
+    // plugin's command queue writes _tail, and only _drainQueue writes _head.
+    CFStringRef _ring[CDV_LOG_RING_CAPACITY];
+    volatile int64_t _head;
+    volatile int64_t _tail;
+    volatile int32_t _drainScheduled;
+    volatile int32_t _dropped;
+    dispatch_queue_t _drainQueue;
+    FILE* _logFile;
+    NSString* _logPath;
+}
+@end
 
 @implementation CDVLogger
 
+// Logging only queues lines for the drain queue, so it is kept off the main thread.
++ (BOOL)runsCommandsInBackground
+{
+    return YES;
+}
+
+- (void)pluginInitialize
+{
+    NSString* cachesFolder = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) objectAtIndex:0];
+    NSString* logFolder = [cachesFolder stringByAppendingPathComponent:@"Logs"];
+
+    [[NSFileManager defaultManager] createDirectoryAtPath:logFolder withIntermediateDirectories:YES attributes:nil error:nil];
+    _logPath = [logFolder stringByAppendingPathComponent:@"console.log"];
+    _drainQueue = dispatch_queue_create("org.apache.cordova.console.drain", DISPATCH_QUEUE_SERIAL);
+}
+
+- (void)dealloc
+{
+    // pending drain blocks retain the plugin, so none can be running here
+    [self drain];
+    if (_drainQueue != NULL) {
+        dispatch_release(_drainQueue);
+    }
+    if (_logFile != NULL) {
+        fclose(_logFile);
+    }
+}
+
 /* log a message */
 - (void)logLevel:(CDVInvokedUrlCommand*)command
 {
-    id level = [command.arguments objectAtIndex:0];
-    id message = [command.arguments objectAtIndex:1];
+    [self enqueueLevel:[command.arguments objectAtIndex:0] message:[command.arguments objectAtIndex:1]];
+    [self scheduleDrain];
+}
 
-    if ([level isEqualToString:@"LOG"]) {
-        NSLog(@"%@", message);
+/* log a batch of [level, message] pairs collected by logger.js */
+- (void)logBatch:(CDVInvokedUrlCommand*)command
+{
+    NSArray* entries = [command.arguments objectAtIndex:0];
+
+    if (![entries isKindOfClass:[NSArray class]]) {
+        return;
+    }
+    for (NSArray* entry in entries) {
+        if ([entry isKindOfClass:[NSArray class]] && ([entry count] >= 2)) {
+            [self enqueueLevel:[entry objectAtIndex:0] message:[entry objectAtIndex:1]];
+        }
+    }
+    [self scheduleDrain];
+}
+
+- (void)enqueueLevel:(id)level message:(id)message
+{
+    NSString* line;
+
+    if ([level isEqual:@"LOG"]) {
+        line = [NSString stringWithFormat:@"%@", message];
     } else {
-        NSLog(@"%@: %@", level, message);
+        line = [NSString stringWithFormat:@"%@: %@", level, message];
+    }
+
+    int64_t tail = _tail;
+    if (tail - _head >= CDV_LOG_RING_CAPACITY) {
+        // full: drop the line rather than block the bridge, the drain reports the count
+        OSAtomicIncrement32Barrier(&_dropped);
+        return;
+    }
+    _ring[tail & (CDV_LOG_RING_CAPACITY - 1)] = CFBridgingRetain(line);
+    // publish the slot before the new tail
+    OSMemoryBarrier();
+    _tail = tail + 1;
+}
+
+- (void)scheduleDrain
+{
+    if (OSAtomicCompareAndSwap32Barrier(0, 1, &_drainScheduled)) {
+        dispatch_async(_drainQueue, ^{
+            _drainScheduled = 0;
+            OSMemoryBarrier();
+            [self drain];
+        });
+    }
+}
+
+// Runs on _drainQueue: writes every published line to the log file, rotating it when it gets too big.
+- (void)drain
+{
+    int64_t head = _head;
+    int64_t tail = _tail;
+
+    // read the slots only after the tail that published them
+    OSMemoryBarrier();
+
+    if (head == tail) {
+        return;
+    }
+
+    FILE* file = [self logFile];
+    for (; head < tail; head++) {
+        CFStringRef slot = _ring[head & (CDV_LOG_RING_CAPACITY - 1)];
+        NSString* line = CFBridgingRelease(slot);
+#ifdef DEBUG
+        NSLog(@"%@", line);
+#endif
+        if (file != NULL) {
+            const char* utf8 = [line UTF8String];
+            fputs(utf8 ? utf8 : "", file);
+            fputc('\n', file);
+        }
     }
+
+    // hand the slots back to the producer
+    OSMemoryBarrier();
+    _head = head;
+
+    int32_t dropped = _dropped;
+    if ((dropped > 0) && OSAtomicCompareAndSwap32Barrier(dropped, 0, &_dropped) && (file != NULL)) {
+        fprintf(file, "CDVLogger: %d log lines dropped\n", dropped);
+    }
+
+    if (file != NULL) {
+        fflush(file);
+        if (ftell(file) > CDV_LOG_FILE_MAX_BYTES) {
+            [self rotateLogFile];
+        }
+    }
+}
+
+// Runs on _drainQueue.
+- (FILE*)logFile
+{
+    if ((_logFile == NULL) && (_logPath != nil)) {
+        _logFile = fopen([_logPath fileSystemRepresentation], "a");
+    }
+    return _logFile;
+}
+
+// Runs on _drainQueue: keeps one previous log file, console.1.log.
+- (void)rotateLogFile
+{
+    fclose(_logFile);
+    _logFile = NULL;
+
+    NSString* previousPath = [[_logPath stringByDeletingPathExtension] stringByAppendingString:@".1.log"];
+    rename([_logPath fileSystemRepresentation], [previousPath fileSystemRepresentation]);
 }
 
 @end
@@ -37,13 +37,15 @@
 // info(message,...)            - logs a message at level INFO
 // debug(message,...)           - logs a message at level DEBUG
 // logLevel(level,message,...)  - logs a message specified level
+// flush()                      - sends batched messages to the native logger
 //
 //------------------------------------------------------------------------------
 
 var logger = exports;
 
-var exec    = require('cordova/exec');
-var utils   = require('cordova/utils');
+var exec     = require('cordova/exec');
+var utils    = require('cordova/utils');
+var platform = require('cordova/platform');
 
 var UseConsole   = false;
 var UseLogger    = true;
@@ -51,6 +53,14 @@ var Queued       = [];
 var DeviceReady  = false;
 var CurrentLevel;
 
+// messages for the native logger are sent in batches, as one bridge command,
+// on platforms whose native side implements logBatch
+var Batched      = platform.id == "ios";
+var Batch        = [];
+var BatchTimer   = null;
+var BATCH_SIZE   = 50;  // messages
+var BATCH_DELAY  = 100; // ms
+
 var originalConsole = console;
 
 /**
@@ -207,17 +217,18 @@ function formatStringForMessage(message) {
  * the message with utils.format()
  */
 logger.logLevel = function(level /* , ... */) {
-    // format the message with the parameters
-    var formatArgs = [].slice.call(arguments, 1);
-    formatArgs.unshift(formatStringForMessage(formatArgs[0])); // add formatString
-    var message    = logger.format.apply(logger.format, formatArgs);
-
-    if (LevelsMap[level] === null) {
+    if (LevelsMap[level] === undefined) {
         throw new Error("invalid logging level: " + level);
     }
 
+    // filter before formatting, so disabled levels cost nothing
     if (LevelsMap[level] > CurrentLevel) return;
 
+    // format the message with the parameters
+    var formatArgs = [].slice.call(arguments, 1);
+    formatArgs.unshift(formatStringForMessage(formatArgs[0])); // add formatString
+    var message    = logger.format.apply(logger.format, formatArgs);
+
     // queue the message if not yet at deviceready
     if (!DeviceReady && !UseConsole) {
         Queued.push([level, message]);
@@ -226,7 +237,16 @@ logger.logLevel = function(level /* , ... */) {
 
     // Log using the native logger if that is enabled
     if (UseLogger) {
-        exec(null, null, "Console", "logLevel", [level, message]);
+        if (Batched) {
+            Batch.push([level, message]);
+            if (Batch.length >= BATCH_SIZE) {
+                logger.flush();
+            } else if (!BatchTimer) {
+                BatchTimer = setTimeout(logger.flush, BATCH_DELAY);
+            }
+        } else {
+            exec(null, null, "Console", "logLevel", [level, message]);
+        }
     }
 
     // Log using the console if that is enabled
@@ -248,6 +268,21 @@ logger.logLevel = function(level /* , ... */) {
 };
 
 
+/**
+ * Sends the messages batched for the native logger now.
+ */
+logger.flush = function() {
+    if (BatchTimer) {
+        clearTimeout(BatchTimer);
+        BatchTimer = null;
+    }
+    if (!Batch.length) return;
+
+    var entries = Batch;
+    Batch = [];
+    exec(null, null, "Console", "logBatch", [entries]);
+};
+
 /**
  * Formats a string and arguments following it ala console.log()
  *
@@ -349,3 +384,6 @@ logger.__onDeviceReady = function() {
 
 // add a deviceready event to log queued messages
 document.addEventListener("deviceready", logger.__onDeviceReady, false);
+
+// don't hold batched messages while the app is in the background
+document.addEventListener("pause", logger.flush, false);